@@ -0,0 +1,101 @@
+#include "allocation_counter.h"
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+static std::atomic<bool> g_counting(false);
+static std::atomic<uint64_t> g_allocation_count(0);
+static thread_local uint64_t t_allocation_count = 0;
+
+static void* counted_malloc(size_t size)
+{
+	if (g_counting.load(std::memory_order_relaxed))
+	{
+		g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+		t_allocation_count++;
+	}
+
+	return malloc(size ? size : 1);
+}
+
+static void* counted_new(size_t size)
+{
+	void* ptr;
+
+	while (!(ptr = counted_malloc(size)))
+	{
+		std::new_handler handler = std::get_new_handler();
+
+		if (!handler)
+			throw std::bad_alloc();
+
+		handler();
+	}
+
+	return ptr;
+}
+
+void set_allocation_counting(bool enabled)
+{
+	g_counting.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t allocation_count()
+{
+	return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t thread_allocation_count()
+{
+	return t_allocation_count;
+}
+
+void* operator new(size_t size)
+{
+	return counted_new(size);
+}
+
+void* operator new[](size_t size)
+{
+	return counted_new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return counted_malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return counted_malloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	free(ptr);
+}
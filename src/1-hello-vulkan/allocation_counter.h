@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+// Global operator new/delete are replaced to count heap allocations, so a frame loop can be shown
+// to be allocation free. Only C++ allocations are seen; direct malloc() calls (C libraries, the
+// driver) are not. Counting is off until enabled, so code that only links this in pays a single
+// relaxed load per allocation.
+
+extern void set_allocation_counting(bool enabled);
+
+// Allocations since startup on all threads.
+extern uint64_t allocation_count();
+// Allocations since startup on the calling thread.
+extern uint64_t thread_allocation_count();
@@ -1,18 +1,36 @@
 #include "application.h"
 #include "const.h"
 #include "vulkan_backend.h"
+#include <string>
+#include <string.h>
+#include <chrono>
+#include <algorithm>
 
-bool Application::keys[1024];
-bool Application::mouse[5];
+InputState Application::s_input;
 
-static void window_resize_callback(GLFWwindow* window, int width, int height) {
+// Set from the GLFW callbacks on the main thread and handled by whichever thread renders, since the
+// backend is only ever touched from that one.
+static std::atomic<bool>	 g_resize_pending(false);
+static std::atomic<uint32_t> g_screenshot_requests(0);
+static std::atomic<uint32_t> g_video_toggles(0);
+
+static double now_seconds()
+{
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void framebuffer_resize_callback(GLFWwindow* window, int width, int height) {
 	if (width == 0 || height == 0) return;
-	vulkan_backend::recreate_swap_chain();
+	vulkan_backend::set_framebuffer_size(width, height);
+	g_resize_pending = true;
 }
 
-Application::Application()
+Application::Application() : m_window(nullptr), m_render_thread_enabled(false), m_timestep(DW_FIXED_TIMESTEP), m_accumulator(0.0), m_last_time(0.0), m_sim_time(0.0), m_step(0), m_quit(false)
 {
-
+	memset(&s_input, 0, sizeof(s_input));
+	memset(&m_step_input, 0, sizeof(m_step_input));
+	memset(m_frames, 0, sizeof(m_frames));
 }
 
 Application::~Application()
@@ -27,31 +45,121 @@ bool Application::init_internal()
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 	glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
-	_window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, nullptr, nullptr);
-
-	glfwSetKeyCallback(_window, key_callback);
-	glfwSetCursorPosCallback(_window, mouse_callback);
-	glfwSetScrollCallback(_window, scroll_callback);
-	glfwSetWindowSizeCallback(_window, window_resize_callback);
+	m_window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, nullptr, nullptr);
 
-	if (!_window)
+	if (!m_window)
 		return false;
 
-	return vulkan_backend::initialize(_window);
+	glfwSetKeyCallback(m_window, key_callback);
+	glfwSetMouseButtonCallback(m_window, mouse_button_callback);
+	glfwSetCursorPosCallback(m_window, mouse_callback);
+	glfwSetScrollCallback(m_window, scroll_callback);
+	glfwSetFramebufferSizeCallback(m_window, framebuffer_resize_callback);
+
+	return vulkan_backend::initialize(m_window);
 }
 
 void Application::shutdown_internal()
 {
 	vulkan_backend::shutdown();
-	glfwDestroyWindow(_window);
+	glfwDestroyWindow(m_window);
 	glfwTerminate();
 }
 
-void Application::update()
+void Application::poll_events()
 {
 	glfwPollEvents();
 }
 
+void Application::publish_internal(double now)
+{
+	uint32_t slot = m_snapshots.write_slot();
+
+	publish(slot);
+
+	FrameInfo& frame = m_frames[slot];
+	frame.slot = slot;
+	frame.alpha = m_accumulator / m_timestep;
+	frame.time = m_sim_time;
+	frame.step = m_step;
+	frame.input = m_step_input;
+	frame.published_at = now;
+
+	m_snapshots.publish();
+}
+
+double Application::simulate_internal()
+{
+	double now = now_seconds();
+
+	m_accumulator += std::min(now - m_last_time, (double)DW_MAX_FRAME_TIME);
+	m_last_time = now;
+
+	bool stepped = false;
+
+	while (m_accumulator >= m_timestep)
+	{
+		// Every step of a batch sees the same input; events are only polled between batches.
+		m_step_input = s_input;
+
+		simulate(m_timestep);
+
+		m_accumulator -= m_timestep;
+		m_sim_time += m_timestep;
+		m_step++;
+		stepped = true;
+	}
+
+	if (stepped)
+		publish_internal(now);
+
+	return m_timestep - m_accumulator;
+}
+
+void Application::begin_render()
+{
+	if (g_resize_pending.exchange(false))
+		vulkan_backend::recreate_swap_chain();
+
+	// F12 saves a screenshot of the next frame, F11 toggles raw video capture.
+	static uint32_t screenshot_index = 0;
+
+	for (uint32_t i = g_screenshot_requests.exchange(0); i > 0; i--)
+		vulkan_backend::capture().screenshot("screenshot_" + std::to_string(screenshot_index++) + ".png");
+
+	if (g_video_toggles.exchange(0) & 1)
+	{
+		if (vulkan_backend::capture().video_active())
+			vulkan_backend::capture().stop_video();
+		else
+			vulkan_backend::capture().start_video("capture.raw");
+	}
+
+	vulkan_backend::begin_frame();
+}
+
+void Application::end_render()
+{
+	m_snapshots.acquire();
+
+	FrameInfo frame = m_frames[m_snapshots.read_slot()];
+
+	// The snapshot may have waited since it was published, the render thread runs at its own rate.
+	frame.alpha = std::min(frame.alpha + (now_seconds() - frame.published_at) / m_timestep, 1.0);
+
+	render(frame);
+	vulkan_backend::draw();
+}
+
+void Application::render_loop()
+{
+	while (!m_quit.load())
+	{
+		begin_render();
+		end_render();
+	}
+}
+
 void Application::run()
 {
 	if (!init_internal())
@@ -60,11 +168,43 @@ void Application::run()
 	if (!init())
 		return;
 
-	while (!glfwWindowShouldClose(_window))
+	// The initial state, so there is something to draw before the first step.
+	m_last_time = now_seconds();
+	m_step_input = s_input;
+	publish_internal(m_last_time);
+
+	if (m_render_thread_enabled)
 	{
-		update();
-		render();
-		vulkan_backend::draw();
+		// Input is sampled here while the render thread paces itself, so sampling just in time for its
+		// presents would only delay frames.
+		vulkan_backend::set_just_in_time_pacing(false);
+
+		m_quit = false;
+		m_render_thread = std::thread(&Application::render_loop, this);
+
+		// GLFW events have to be handled on the main thread, so it keeps simulating and sleeps in between.
+		while (!glfwWindowShouldClose(m_window))
+		{
+			poll_events();
+
+			double wait = simulate_internal();
+
+			if (wait > 0.0)
+				std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+		}
+
+		m_quit = true;
+		m_render_thread.join();
+	}
+	else
+	{
+		while (!glfwWindowShouldClose(m_window))
+		{
+			begin_render();
+			poll_events();
+			simulate_internal();
+			end_render();
+		}
 	}
 
 	shutdown();
@@ -75,21 +215,36 @@ void Application::key_callback(GLFWwindow* window, int key, int scancode, int ac
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
+
+	if (key == GLFW_KEY_F12 && action == GLFW_PRESS)
+		g_screenshot_requests++;
+
+	if (key == GLFW_KEY_F11 && action == GLFW_PRESS)
+		g_video_toggles++;
+
 	if (key >= 0 && key < 1024)
 	{
 		if (action == GLFW_PRESS)
-			keys[key] = true;
+			s_input.keys[key] = true;
 		else if (action == GLFW_RELEASE)
-			keys[key] = false;
+			s_input.keys[key] = false;
 	}
 }
 
-void Application::mouse_callback(GLFWwindow* window, double xpos, double ypos)
+void Application::mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
+	if (button >= 0 && button < 5)
+		s_input.mouse[button] = action == GLFW_PRESS;
+}
 
+void Application::mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+	s_input.cursor_x = xpos;
+	s_input.cursor_y = ypos;
 }
 
 void Application::scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-
+	s_input.scroll_x += xoffset;
+	s_input.scroll_y += yoffset;
 }
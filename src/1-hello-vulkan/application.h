@@ -2,6 +2,16 @@
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+#include "snapshot_mailbox.h"
+
+// Simulation rate. Rendering runs at whatever rate presentation allows and interpolates in between.
+#define DW_FIXED_TIMESTEP (1.0 / 60.0)
+// After a stall (debugger, window drag) at most this much time is simulated rather than catching up.
+#define DW_MAX_FRAME_TIME 0.25
 
 #define EXPERIMENT_DECLARE_MAIN(x)								\
 int main()														\
@@ -12,6 +22,42 @@ int main()														\
 	return 0;													\
 }																\
 
+struct InputState
+{
+	bool   keys[1024];
+	bool   mouse[5];
+	double cursor_x;
+	double cursor_y;
+	// Accumulated since startup; take differences between steps.
+	double scroll_x;
+	double scroll_y;
+};
+
+// What render() gets besides the application's own snapshot in the same slot.
+struct FrameInfo
+{
+	// Index of the snapshot to read, see publish().
+	uint32_t   slot;
+	// How far rendering is between the previous and the latest simulation step, in [0, 1]. 1 means
+	// the next step is overdue and the latest state should be drawn as is.
+	double	   alpha;
+	// Simulated time and step count of the latest step.
+	double	   time;
+	uint64_t   step;
+	// Input as seen by the latest step.
+	InputState input;
+	// Wall clock time of the publish, to advance alpha by however long the snapshot waited.
+	double	   published_at;
+};
+
+// Runs the simulation at a fixed timestep on the main thread and renders interpolated snapshots of
+// it, either right after simulating or on a separate render thread. With the render thread,
+// blocking in acquire/present no longer holds back the simulation and both get their own core.
+//
+// Simulation and rendering only share snapshots: after the steps of a frame, publish(slot) copies
+// whatever render() needs (typically the previous and the current state, to interpolate with
+// FrameInfo::alpha) into the application's own storage at slot, DW_SNAPSHOT_SLOTS entries.
+// render() then reads the slot in FrameInfo::slot; the slot is never written while it is read.
 class Application
 {
 public:
@@ -19,23 +65,54 @@ public:
 	virtual ~Application();
 	void run();
 
+protected:
+	// Call from init(). Takes effect when the loop starts.
+	inline void set_render_thread(bool enabled) { m_render_thread_enabled = enabled; }
+	inline void set_timestep(double seconds) { m_timestep = seconds; }
+
+	// Input for the current simulation step. Only valid in simulate().
+	inline const InputState& input() const { return m_step_input; }
+
 private:
 	bool init_internal();
 	void shutdown_internal();
-	void update();
+	void poll_events();
+	// Runs the steps that are due and publishes a snapshot if any ran. Returns the time to the next step.
+	double simulate_internal();
+	void publish_internal(double now);
+	// Split around polling and simulation so the single threaded loop samples input right after
+	// begin_frame(), like the frame pacer expects.
+	void begin_render();
+	void end_render();
+	void render_loop();
 
 	static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
+	static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 	static void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 	static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
 	virtual bool init() = 0;
-	virtual void render() = 0;
+	// Advances the simulation by exactly dt seconds; called zero or more times per frame.
+	virtual void simulate(double dt) {}
+	// Copies the state render() needs into the application's snapshot storage at slot.
+	virtual void publish(uint32_t slot) {}
+	// Submits the frame's draws for the snapshot in frame.slot. Runs on the render thread if enabled.
+	virtual void render(const FrameInfo& frame) = 0;
 	virtual void shutdown() = 0;
 
-public:
-	static bool keys[1024];
-	static bool	mouse[5];
-
 private:
-	GLFWwindow* _window;
+	GLFWwindow*		  m_window;
+	bool			  m_render_thread_enabled;
+	double			  m_timestep;
+	double			  m_accumulator;
+	double			  m_last_time;
+	double			  m_sim_time;
+	uint64_t		  m_step;
+	// Written by the GLFW callbacks, copied into m_step_input before each batch of steps.
+	static InputState s_input;
+	InputState		  m_step_input;
+	SnapshotMailbox	  m_snapshots;
+	FrameInfo		  m_frames[DW_SNAPSHOT_SLOTS];
+	std::thread		  m_render_thread;
+	std::atomic<bool> m_quit;
 };
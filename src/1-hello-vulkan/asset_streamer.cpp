@@ -0,0 +1,681 @@
+#include "asset_streamer.h"
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#if defined(_WIN32)
+#define DW_ASSET_STREAMER_STDIO
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define DW_ASSET_STREAMER_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#endif
+#endif
+
+// --------------------------------------------------------------------------------------------
+// io_uring, driven through the raw syscalls so there is no dependency on liburing.
+// --------------------------------------------------------------------------------------------
+
+struct IoUring
+{
+	int fd;
+#if defined(DW_ASSET_STREAMER_IO_URING)
+	uint32_t*		 sq_head;
+	uint32_t*		 sq_tail;
+	uint32_t*		 sq_mask;
+	uint32_t*		 sq_array;
+	io_uring_sqe*	 sqes;
+	uint32_t*		 cq_head;
+	uint32_t*		 cq_tail;
+	uint32_t*		 cq_mask;
+	io_uring_cqe*	 cqes;
+	void*			 sq_ptr;
+	size_t			 sq_size;
+	void*			 cq_ptr;
+	size_t			 cq_size;
+	size_t			 sqes_size;
+	uint32_t		 to_submit;
+#endif
+};
+
+#if defined(DW_ASSET_STREAMER_IO_URING)
+
+static bool io_uring_create(IoUring& ring, uint32_t entries)
+{
+	io_uring_params params = {};
+
+	ring.fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+
+	// ENOSYS on old kernels, EPERM when disabled by seccomp or sysctl: caller falls back to pread.
+	if (ring.fd < 0)
+		return false;
+
+	ring.sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	ring.cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+	if (single_mmap)
+		ring.sq_size = ring.cq_size = std::max(ring.sq_size, ring.cq_size);
+
+	ring.sq_ptr = mmap(nullptr, ring.sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+
+	if (ring.sq_ptr == MAP_FAILED)
+	{
+		close(ring.fd);
+		return false;
+	}
+
+	if (single_mmap)
+		ring.cq_ptr = ring.sq_ptr;
+	else
+	{
+		ring.cq_ptr = mmap(nullptr, ring.cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+
+		if (ring.cq_ptr == MAP_FAILED)
+		{
+			munmap(ring.sq_ptr, ring.sq_size);
+			close(ring.fd);
+			return false;
+		}
+	}
+
+	ring.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	ring.sqes = (io_uring_sqe*)mmap(nullptr, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+
+	if (ring.sqes == MAP_FAILED)
+	{
+		if (!single_mmap)
+			munmap(ring.cq_ptr, ring.cq_size);
+		munmap(ring.sq_ptr, ring.sq_size);
+		close(ring.fd);
+		return false;
+	}
+
+	uint8_t* sq = (uint8_t*)ring.sq_ptr;
+	uint8_t* cq = (uint8_t*)ring.cq_ptr;
+
+	ring.sq_head = (uint32_t*)(sq + params.sq_off.head);
+	ring.sq_tail = (uint32_t*)(sq + params.sq_off.tail);
+	ring.sq_mask = (uint32_t*)(sq + params.sq_off.ring_mask);
+	ring.sq_array = (uint32_t*)(sq + params.sq_off.array);
+	ring.cq_head = (uint32_t*)(cq + params.cq_off.head);
+	ring.cq_tail = (uint32_t*)(cq + params.cq_off.tail);
+	ring.cq_mask = (uint32_t*)(cq + params.cq_off.ring_mask);
+	ring.cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+	ring.to_submit = 0;
+
+	return true;
+}
+
+static void io_uring_destroy(IoUring& ring)
+{
+	munmap(ring.sqes, ring.sqes_size);
+
+	if (ring.cq_ptr != ring.sq_ptr)
+		munmap(ring.cq_ptr, ring.cq_size);
+
+	munmap(ring.sq_ptr, ring.sq_size);
+	close(ring.fd);
+}
+
+static void io_uring_queue_readv(IoUring& ring, int fd, const iovec* iov, uint64_t offset, uint64_t user_data)
+{
+	// Single producer: only the IO thread touches the submission tail.
+	uint32_t tail = *ring.sq_tail;
+	uint32_t index = tail & *ring.sq_mask;
+
+	io_uring_sqe* sqe = &ring.sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = fd;
+	sqe->off = offset;
+	sqe->addr = (uint64_t)(uintptr_t)iov;
+	sqe->len = 1;
+	sqe->user_data = user_data;
+
+	ring.sq_array[index] = index;
+	__atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring.to_submit++;
+}
+
+static int io_uring_submit_and_wait(IoUring& ring, uint32_t wait_count)
+{
+	int result = (int)syscall(__NR_io_uring_enter, ring.fd, ring.to_submit, wait_count, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+	if (result >= 0)
+		ring.to_submit -= std::min((uint32_t)result, ring.to_submit);
+
+	return result;
+}
+
+#endif
+
+// --------------------------------------------------------------------------------------------
+// Blocking whole-file read, used by the pread workers.
+// --------------------------------------------------------------------------------------------
+
+static bool read_whole_file(const std::string& path, std::vector<uint8_t>& data)
+{
+#if defined(DW_ASSET_STREAMER_STDIO)
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open())
+		return false;
+
+	data.resize((size_t)file.tellg());
+	file.seekg(0);
+	file.read((char*)data.data(), data.size());
+
+	return file.good() || data.empty();
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	data.resize((size_t)st.st_size);
+	size_t offset = 0;
+
+	while (offset < data.size())
+	{
+		ssize_t result = pread(fd, data.data() + offset, data.size() - offset, (off_t)offset);
+
+		if (result <= 0)
+			break;
+
+		offset += (size_t)result;
+	}
+
+	close(fd);
+
+	return offset == data.size();
+#endif
+}
+
+// --------------------------------------------------------------------------------------------
+// AssetStreamer
+// --------------------------------------------------------------------------------------------
+
+AssetStreamer::AssetStreamer() : m_running(false), m_completions(0), m_io_uring(false), m_ring(nullptr), m_next_id(1), m_completed(DW_ASSET_COMPLETION_QUEUE_SIZE)
+{
+	m_camera_position[0] = m_camera_position[1] = m_camera_position[2] = 0.0f;
+}
+
+AssetStreamer::~AssetStreamer()
+{
+	shutdown();
+}
+
+bool AssetStreamer::initialize(uint32_t io_threads)
+{
+	m_running = true;
+
+#if defined(DW_ASSET_STREAMER_IO_URING)
+	m_ring = new IoUring();
+
+	if (io_uring_create(*m_ring, DW_ASSET_IO_URING_DEPTH))
+	{
+		// One thread keeps up to DW_ASSET_IO_URING_DEPTH reads in flight.
+		m_io_uring = true;
+		m_threads.emplace_back(&AssetStreamer::io_uring_worker, this);
+
+		std::cout << "Asset streamer : io_uring backend" << std::endl;
+		return true;
+	}
+
+	delete m_ring;
+	m_ring = nullptr;
+#endif
+
+	for (uint32_t i = 0; i < std::max(1u, io_threads); i++)
+		m_threads.emplace_back(&AssetStreamer::pread_worker, this);
+
+	std::cout << "Asset streamer : pread backend, " << m_threads.size() << " threads" << std::endl;
+
+	return true;
+}
+
+void AssetStreamer::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (!m_running)
+			return;
+
+		m_running = false;
+		m_pending.clear();
+	}
+
+	m_condition.notify_all();
+	m_completion.notify_all();
+
+	for (auto& thread : m_threads)
+		thread.join();
+
+	m_threads.clear();
+
+#if defined(DW_ASSET_STREAMER_IO_URING)
+	if (m_ring)
+	{
+		io_uring_destroy(*m_ring);
+		delete m_ring;
+		m_ring = nullptr;
+	}
+#endif
+
+	for (auto orphaned : m_orphaned)
+		delete orphaned;
+
+	m_orphaned.clear();
+
+	LoadedAsset* asset = nullptr;
+
+	while (m_completed.pop(asset))
+		delete asset;
+
+	for (auto deferred : m_deferred)
+		delete deferred;
+
+	m_deferred.clear();
+}
+
+float AssetStreamer::positional_priority(const Request& request) const
+{
+	float dx = request.position[0] - m_camera_position[0];
+	float dy = request.position[1] - m_camera_position[1];
+	float dz = request.position[2] - m_camera_position[2];
+
+	return request.priority_bias - sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+AssetId AssetStreamer::enqueue(Request& request)
+{
+	request.id = m_next_id++;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (request.positional)
+			request.priority = positional_priority(request);
+
+		m_pending.push_back(request);
+		std::push_heap(m_pending.begin(), m_pending.end(), request_less);
+	}
+
+	m_condition.notify_one();
+
+	return request.id;
+}
+
+AssetId AssetStreamer::request(const char* path, uint32_t type, float priority)
+{
+	Request request = {};
+	request.type = type;
+	request.path = path;
+	request.priority = priority;
+
+	return enqueue(request);
+}
+
+AssetId AssetStreamer::request_at(const char* path, uint32_t type, const float* position, float priority_bias)
+{
+	Request request = {};
+	request.type = type;
+	request.path = path;
+	request.positional = true;
+	request.priority_bias = priority_bias;
+	memcpy(request.position, position, sizeof(request.position));
+
+	return enqueue(request);
+}
+
+void AssetStreamer::set_camera_position(const float* position)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	memcpy(m_camera_position, position, sizeof(m_camera_position));
+
+	for (auto& request : m_pending)
+	{
+		if (request.positional)
+			request.priority = positional_priority(request);
+	}
+
+	std::make_heap(m_pending.begin(), m_pending.end(), request_less);
+}
+
+bool AssetStreamer::pop_request(Request& request, bool block)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (block)
+		m_condition.wait(lock, [this]() { return !m_running || !m_pending.empty(); });
+
+	if (!m_running || m_pending.empty())
+		return false;
+
+	std::pop_heap(m_pending.begin(), m_pending.end(), request_less);
+	request = std::move(m_pending.back());
+	m_pending.pop_back();
+
+	return true;
+}
+
+void AssetStreamer::complete(LoadedAsset* asset)
+{
+	// Back-pressure: if the render thread falls behind, IO stops rather than growing memory.
+	while (!m_completed.push(asset))
+	{
+		if (!m_running)
+		{
+			delete asset;
+			return;
+		}
+
+		std::this_thread::yield();
+	}
+
+	{
+		// Under the lock, so a wait() that just found the queue empty is already sleeping.
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_completions++;
+	}
+
+	m_completion.notify_all();
+}
+
+void AssetStreamer::pread_worker()
+{
+	Request request;
+
+	while (pop_request(request, true))
+	{
+		LoadedAsset* asset = new LoadedAsset();
+		asset->id = request.id;
+		asset->type = request.type;
+		asset->path = request.path;
+		asset->success = read_whole_file(request.path, asset->data);
+
+		complete(asset);
+	}
+}
+
+void AssetStreamer::io_uring_worker()
+{
+#if defined(DW_ASSET_STREAMER_IO_URING)
+	struct InFlight
+	{
+		LoadedAsset* asset;
+		int			 fd;
+		size_t		 offset;
+		iovec		 iov;
+	};
+
+	InFlight slots[DW_ASSET_IO_URING_DEPTH];
+	uint32_t free_slots[DW_ASSET_IO_URING_DEPTH];
+	uint32_t free_count = DW_ASSET_IO_URING_DEPTH;
+
+	for (uint32_t i = 0; i < DW_ASSET_IO_URING_DEPTH; i++)
+		free_slots[i] = DW_ASSET_IO_URING_DEPTH - 1 - i;
+
+	IoUring& ring = *m_ring;
+
+	auto finish = [&](uint32_t slot, bool success)
+	{
+		close(slots[slot].fd);
+		slots[slot].asset->success = success;
+		complete(slots[slot].asset);
+		free_slots[free_count++] = slot;
+	};
+
+	auto queue_read = [&](uint32_t slot)
+	{
+		InFlight& f = slots[slot];
+		f.iov.iov_base = f.asset->data.data() + f.offset;
+		f.iov.iov_len = f.asset->data.size() - f.offset;
+		io_uring_queue_readv(ring, f.fd, &f.iov, f.offset, slot);
+	};
+
+	while (true)
+	{
+		// Top up the ring. Only block for new work when nothing is in flight.
+		Request request;
+
+		while (free_count > 0 && pop_request(request, free_count == DW_ASSET_IO_URING_DEPTH))
+		{
+			LoadedAsset* asset = new LoadedAsset();
+			asset->id = request.id;
+			asset->type = request.type;
+			asset->path = request.path;
+			asset->success = false;
+
+			int fd = open(request.path.c_str(), O_RDONLY);
+			struct stat st;
+
+			if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0)
+			{
+				asset->success = fd >= 0 && st.st_size == 0;
+
+				if (fd >= 0)
+					close(fd);
+
+				complete(asset);
+				continue;
+			}
+
+			asset->data.resize((size_t)st.st_size);
+
+			uint32_t slot = free_slots[--free_count];
+			slots[slot].asset = asset;
+			slots[slot].fd = fd;
+			slots[slot].offset = 0;
+			queue_read(slot);
+		}
+
+		if (free_count == DW_ASSET_IO_URING_DEPTH)
+		{
+			if (!m_running)
+				break;
+
+			continue;
+		}
+
+		int error = io_uring_submit_and_wait(ring, 1) < 0 ? errno : 0;
+
+		// EINTR, EAGAIN and EBUSY (completion queue full) are transient: reap and submit again.
+		if (error != 0 && error != EINTR && error != EAGAIN && error != EBUSY)
+		{
+			// The ring is unusable. Reads still in the submission queue never started, but the ones the
+			// kernel took may still write into their buffers, so those are waited for before anything is
+			// handed back. Everything in flight is then read again with pread, which also serves all
+			// further requests on this thread.
+			bool in_flight[DW_ASSET_IO_URING_DEPTH];
+			bool in_kernel[DW_ASSET_IO_URING_DEPTH];
+			uint32_t kernel_count = 0;
+
+			for (uint32_t i = 0; i < DW_ASSET_IO_URING_DEPTH; i++)
+				in_flight[i] = in_kernel[i] = std::find(free_slots, free_slots + free_count, i) == free_slots + free_count;
+
+			for (uint32_t sq = __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE); sq != *ring.sq_tail; sq++)
+				in_kernel[ring.sqes[ring.sq_array[sq & *ring.sq_mask]].user_data] = false;
+
+			for (uint32_t i = 0; i < DW_ASSET_IO_URING_DEPTH; i++)
+				kernel_count += in_kernel[i] ? 1 : 0;
+
+			while (kernel_count > 0)
+			{
+				uint32_t head = *ring.cq_head;
+
+				for (; head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE); head++)
+				{
+					uint32_t slot = (uint32_t)ring.cqes[head & *ring.cq_mask].user_data;
+
+					if (in_kernel[slot])
+					{
+						in_kernel[slot] = false;
+						kernel_count--;
+					}
+				}
+
+				__atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+				if (kernel_count > 0 && syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+					break;
+			}
+
+			for (uint32_t i = 0; i < DW_ASSET_IO_URING_DEPTH; i++)
+			{
+				if (!in_flight[i])
+					continue;
+
+				close(slots[i].fd);
+
+				LoadedAsset* asset = slots[i].asset;
+
+				// Could not be waited for either: the buffer stays alive until the ring is destroyed.
+				if (in_kernel[i])
+				{
+					m_orphaned.push_back(asset);
+
+					asset = new LoadedAsset();
+					asset->id = slots[i].asset->id;
+					asset->type = slots[i].asset->type;
+					asset->path = slots[i].asset->path;
+				}
+
+				asset->success = read_whole_file(asset->path, asset->data);
+				complete(asset);
+			}
+
+			std::cout << "Asset streamer : io_uring failed (" << strerror(error) << "), falling back to pread" << std::endl;
+
+			pread_worker();
+			return;
+		}
+
+		uint32_t head = *ring.cq_head;
+
+		while (head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE))
+		{
+			const io_uring_cqe& cqe = ring.cqes[head & *ring.cq_mask];
+			uint32_t slot = (uint32_t)cqe.user_data;
+			InFlight& f = slots[slot];
+
+			if (cqe.res < 0)
+				finish(slot, false);
+			else if (cqe.res == 0)
+			{
+				// File shrank since fstat.
+				f.asset->data.resize(f.offset);
+				finish(slot, true);
+			}
+			else
+			{
+				f.offset += (size_t)cqe.res;
+
+				if (f.offset < f.asset->data.size())
+					queue_read(slot);
+				else
+					finish(slot, true);
+			}
+
+			head++;
+		}
+
+		__atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+	}
+#endif
+}
+
+uint32_t AssetStreamer::process_completed(size_t byte_budget, const std::function<void(LoadedAsset&)>& handler)
+{
+	uint32_t count = 0;
+	size_t bytes = 0;
+
+	while (count == 0 || bytes < byte_budget)
+	{
+		LoadedAsset* asset = nullptr;
+
+		if (!m_deferred.empty())
+		{
+			asset = m_deferred.front();
+			m_deferred.pop_front();
+		}
+		else if (!m_completed.pop(asset))
+			break;
+
+		// Counted before the handler, which may take the data.
+		bytes += asset->data.size();
+		count++;
+
+		handler(*asset);
+
+		delete asset;
+	}
+
+	return count;
+}
+
+bool AssetStreamer::wait(AssetId id, LoadedAsset& asset)
+{
+	if (id == DW_INVALID_ASSET_ID || id >= m_next_id)
+		return false;
+
+	for (auto it = m_deferred.begin(); it != m_deferred.end(); it++)
+	{
+		if ((*it)->id == id)
+		{
+			asset = std::move(**it);
+			delete *it;
+			m_deferred.erase(it);
+			return true;
+		}
+	}
+
+	while (m_running)
+	{
+		// Read before popping: a completion pushed after a failed pop bumps the count past it.
+		uint64_t seen = m_completions;
+		LoadedAsset* completed = nullptr;
+
+		if (!m_completed.pop(completed))
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_completion.wait(lock, [&]() { return !m_running || m_completions != seen; });
+			continue;
+		}
+
+		if (completed->id == id)
+		{
+			asset = std::move(*completed);
+			delete completed;
+			return true;
+		}
+
+		m_deferred.push_back(completed);
+	}
+
+	return false;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+#include "lock_free_queue.h"
+
+#define DW_INVALID_ASSET_ID 0
+#define DW_ASSET_COMPLETION_QUEUE_SIZE 1024
+#define DW_ASSET_IO_URING_DEPTH 32
+
+namespace AssetType
+{
+	enum
+	{
+		MESH,
+		TEXTURE,
+		SHADER
+	};
+}
+
+typedef uint32_t AssetId;
+
+struct IoUring;
+
+struct LoadedAsset
+{
+	AssetId				 id;
+	uint32_t			 type;
+	bool				 success;
+	std::string			 path;
+	std::vector<uint8_t> data;
+};
+
+// Background file loading. Requests are kept in a priority queue (explicit priority, or distance to
+// the camera for positional requests) and served by IO threads, either through a single io_uring
+// instance on Linux or through blocking pread() on a small thread pool. Finished loads are handed
+// back to the render thread through a lock-free queue. wait() blocks for one of them (the backend
+// reads its SPIR-V this way while the instance and device are created); process_completed() hands
+// them out with a per-frame byte budget, so a burst of completions never turns into one long frame.
+class AssetStreamer
+{
+public:
+	AssetStreamer();
+	~AssetStreamer();
+
+	bool initialize(uint32_t io_threads = 2);
+	void shutdown();
+
+	// Higher priority is served first.
+	AssetId request(const char* path, uint32_t type, float priority);
+	// Priority is priority_bias minus the distance to the camera, updated whenever the camera moves.
+	AssetId request_at(const char* path, uint32_t type, const float* position, float priority_bias = 0.0f);
+	void set_camera_position(const float* position);
+
+	// Render thread only. Hands completed loads to handler until byte_budget is used up (at least one
+	// asset is always processed). Returns the number of assets processed.
+	uint32_t process_completed(size_t byte_budget, const std::function<void(LoadedAsset&)>& handler);
+
+	// Render thread only. Sleeps until the given request has completed.
+	bool wait(AssetId id, LoadedAsset& asset);
+
+	inline bool using_io_uring() const { return m_io_uring; }
+	inline uint32_t pending_count() { std::lock_guard<std::mutex> lock(m_mutex); return (uint32_t)m_pending.size(); }
+
+private:
+	struct Request
+	{
+		AssetId		id;
+		uint32_t	type;
+		bool		positional;
+		float		priority;
+		float		priority_bias;
+		float		position[3];
+		std::string path;
+	};
+
+	AssetId enqueue(Request& request);
+	float positional_priority(const Request& request) const;
+	bool pop_request(Request& request, bool block);
+	void complete(LoadedAsset* asset);
+	void pread_worker();
+	void io_uring_worker();
+
+	static bool request_less(const Request& a, const Request& b) { return a.priority < b.priority; }
+
+private:
+	std::mutex					  m_mutex;
+	std::condition_variable		  m_condition;
+	// Signalled after each completion is pushed, for wait().
+	std::condition_variable		  m_completion;
+	std::vector<Request>		  m_pending;
+	float						  m_camera_position[3];
+	// Read by the IO threads and wait() without the lock, written under it.
+	std::atomic<bool>			  m_running;
+	// Completions pushed so far, incremented under the lock.
+	std::atomic<uint64_t>		  m_completions;
+	bool						  m_io_uring;
+	IoUring*					  m_ring;
+	std::atomic<AssetId>		  m_next_id;
+	std::vector<std::thread>	  m_threads;
+	LockFreeQueue<LoadedAsset*>	  m_completed;
+	// Completions popped by wait() while looking for another id, handed out by later waits or process_completed().
+	std::deque<LoadedAsset*>	  m_deferred;
+	// Reads the io_uring worker gave up on while the kernel may still write into them, freed after
+	// the ring is destroyed.
+	std::vector<LoadedAsset*>	  m_orphaned;
+};
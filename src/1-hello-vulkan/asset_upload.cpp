@@ -0,0 +1,66 @@
+#include "asset_upload.h"
+#include "mesh_upload.h"
+#include <iostream>
+
+bool upload_asset(gfx::Device& device, const LoadedAsset& asset, UploadedAsset& uploaded)
+{
+	uploaded = UploadedAsset();
+	uploaded.id = asset.id;
+	uploaded.type = asset.type;
+
+	if (!asset.success || asset.data.empty())
+	{
+		std::cout << "Failed to load asset : " << asset.path << std::endl;
+		return false;
+	}
+
+	if (asset.type == AssetType::MESH)
+	{
+		// The cache is validated in place; its sections are copied straight from the loaded data.
+		mesh::MeshCache cache;
+
+		if (!mesh::read_mesh_cache(asset.data.data(), asset.data.size(), cache))
+		{
+			std::cout << "Invalid or outdated mesh cache : " << asset.path << std::endl;
+			return false;
+		}
+
+		uploaded.mesh_count = cache.header->mesh_count;
+
+		return mesh::upload_mesh_cache(device, cache, uploaded.vertex_buffer, uploaded.index_buffer, true);
+	}
+
+	if (asset.type == AssetType::TEXTURE)
+	{
+		gfx::BufferCreateDesc desc = {};
+		desc.size = asset.data.size();
+		desc.usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		desc.usage = gfx::BufferUsage::STATIC;
+		desc.data = asset.data.data();
+		desc.streamable = true;
+		desc.texels = true;
+
+		uploaded.texel_buffer = device.CreateBuffer(desc);
+
+		if (!uploaded.texel_buffer.valid())
+			std::cout << "Failed to upload texture : " << asset.path << std::endl;
+
+		return uploaded.texel_buffer.valid();
+	}
+
+	return false;
+}
+
+void destroy_uploaded_asset(gfx::Device& device, UploadedAsset& uploaded)
+{
+	if (uploaded.vertex_buffer.valid())
+		device.DestroyBuffer(uploaded.vertex_buffer);
+
+	if (uploaded.index_buffer.valid())
+		device.DestroyBuffer(uploaded.index_buffer);
+
+	if (uploaded.texel_buffer.valid())
+		device.DestroyBuffer(uploaded.texel_buffer);
+
+	uploaded = UploadedAsset();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "asset_streamer.h"
+#include "gfx_device.h"
+
+// GPU side of a streamed asset. Meshes are mesh caches (see mesh_cache.h) and get a vertex and an
+// index buffer; textures are raw texel data staged into one buffer, ready to be copied into an image.
+struct UploadedAsset
+{
+	AssetId			  id;
+	uint32_t		  type;
+	uint32_t		  mesh_count;
+	gfx::BufferHandle vertex_buffer;
+	gfx::BufferHandle index_buffer;
+	gfx::BufferHandle texel_buffer;
+};
+
+// Turns a finished load into staged GPU uploads, e.g. from an AssetStreamer::process_completed()
+// handler. The buffers are streamable, so the device's residency manager can demote them. False if the
+// load failed, the data is invalid or not uploadable (shaders), or a buffer could not be created.
+extern bool upload_asset(gfx::Device& device, const LoadedAsset& asset, UploadedAsset& uploaded);
+extern void destroy_uploaded_asset(gfx::Device& device, UploadedAsset& uploaded);
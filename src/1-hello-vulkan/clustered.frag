@@ -0,0 +1,96 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Forward shading with the lights binned by cluster_bin.comp: the pixel and its view depth give the
+// cluster, and only that cluster's lights are evaluated. Lambert plus Blinn-Phong with a windowed
+// inverse square falloff that reaches zero at the light's range.
+
+struct Light {
+    vec3 position;
+    float range;
+    vec3 color;
+    uint type;
+    vec3 direction;
+    float cosInner;
+    float cosOuter;
+    float padding0;
+    float padding1;
+    float padding2;
+};
+
+layout(set = 0, binding = 0) uniform ClusterParams {
+    mat4 view;
+    vec4 cameraPosition;
+    vec4 projection;
+    // x: slice scale, y: slice bias, zw: tile size in pixels
+    vec4 slicing;
+    // xyz: grid dimensions, w: light count
+    uvec4 grid;
+    // x: light indices per cluster
+    uvec4 limits;
+} params;
+
+layout(set = 0, binding = 1) readonly buffer Lights {
+    Light lights[];
+};
+
+layout(set = 0, binding = 2) readonly buffer ClusterCounts {
+    uint clusterCounts[];
+};
+
+layout(set = 0, binding = 3) readonly buffer ClusterLights {
+    uint clusterLights[];
+};
+
+layout(location = 0) in vec3 fragPosition;
+layout(location = 1) in vec3 fragNormal;
+layout(location = 2) in vec3 fragAlbedo;
+// Distance along the view direction, positive in front of the camera.
+layout(location = 3) in float fragViewDepth;
+
+layout(location = 0) out vec4 outColor;
+
+#define LIGHT_SPOT 1u
+#define AMBIENT 0.03
+#define SHININESS 32.0
+
+uint cluster_index() {
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / params.slicing.zw), params.grid.xy - 1);
+    float slice = floor(log(max(fragViewDepth, params.projection.z)) * params.slicing.x + params.slicing.y);
+    uint z = uint(clamp(slice, 0.0, float(params.grid.z - 1)));
+
+    return tile.x + params.grid.x * (tile.y + params.grid.y * z);
+}
+
+void main() {
+    vec3 n = normalize(fragNormal);
+    vec3 v = normalize(params.cameraPosition.xyz - fragPosition);
+
+    uint cluster = cluster_index();
+    uint count = clusterCounts[cluster];
+    uint first = cluster * params.limits.x;
+
+    vec3 color = fragAlbedo * AMBIENT;
+
+    for (uint i = 0; i < count; i++) {
+        Light light = lights[clusterLights[first + i]];
+
+        vec3 toLight = light.position - fragPosition;
+        float distanceSquared = dot(toLight, toLight);
+        vec3 l = toLight * inversesqrt(max(distanceSquared, 1e-8));
+
+        float ratio = distanceSquared / (light.range * light.range);
+        float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+        float attenuation = window * window / (distanceSquared + 1.0);
+
+        if (light.type == LIGHT_SPOT)
+            attenuation *= smoothstep(light.cosOuter, light.cosInner, dot(-l, light.direction));
+
+        float diffuse = max(dot(n, l), 0.0);
+        float specular = diffuse > 0.0 ? pow(max(dot(n, normalize(l + v)), 0.0), SHININESS) : 0.0;
+
+        color += (fragAlbedo * diffuse + specular) * light.color * attenuation;
+    }
+
+    outColor = vec4(color, 1.0);
+}
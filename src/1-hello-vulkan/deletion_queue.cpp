@@ -0,0 +1,183 @@
+#include "deletion_queue.h"
+
+DeletionQueue::DeletionQueue() : m_device(VK_NULL_HANDLE), m_frame(0)
+{
+
+}
+
+void DeletionQueue::initialize(VkDevice device)
+{
+	m_device = device;
+}
+
+void DeletionQueue::push(Object& object, uint32_t type)
+{
+	object.type = type;
+	object.frame = m_frame;
+	m_objects.push_back(object);
+}
+
+void DeletionQueue::destroy_framebuffer(VkFramebuffer framebuffer)
+{
+	Object object = {};
+	object.framebuffer = framebuffer;
+	push(object, DeferredType::FRAMEBUFFER);
+}
+
+void DeletionQueue::destroy_image_view(VkImageView view)
+{
+	Object object = {};
+	object.image_view = view;
+	push(object, DeferredType::IMAGE_VIEW);
+}
+
+void DeletionQueue::destroy_image(VkImage image)
+{
+	Object object = {};
+	object.image = image;
+	push(object, DeferredType::IMAGE);
+}
+
+void DeletionQueue::destroy_buffer(VkBuffer buffer)
+{
+	Object object = {};
+	object.buffer = buffer;
+	push(object, DeferredType::BUFFER);
+}
+
+void DeletionQueue::free_memory(VkDeviceMemory memory)
+{
+	Object object = {};
+	object.memory = memory;
+	push(object, DeferredType::MEMORY);
+}
+
+void DeletionQueue::destroy_pipeline(VkPipeline pipeline)
+{
+	Object object = {};
+	object.pipeline = pipeline;
+	push(object, DeferredType::PIPELINE);
+}
+
+void DeletionQueue::destroy_pipeline_layout(VkPipelineLayout layout)
+{
+	Object object = {};
+	object.pipeline_layout = layout;
+	push(object, DeferredType::PIPELINE_LAYOUT);
+}
+
+void DeletionQueue::destroy_render_pass(VkRenderPass render_pass)
+{
+	Object object = {};
+	object.render_pass = render_pass;
+	push(object, DeferredType::RENDER_PASS);
+}
+
+void DeletionQueue::destroy_shader_module(VkShaderModule module)
+{
+	Object object = {};
+	object.shader_module = module;
+	push(object, DeferredType::SHADER_MODULE);
+}
+
+void DeletionQueue::destroy_swapchain(VkSwapchainKHR swapchain)
+{
+	Object object = {};
+	object.swapchain = swapchain;
+	push(object, DeferredType::SWAPCHAIN);
+}
+
+void DeletionQueue::free_command_buffer(VkCommandPool pool, VkCommandBuffer cmd)
+{
+	Object object = {};
+	object.pool = pool;
+	object.command_buffer = cmd;
+	push(object, DeferredType::COMMAND_BUFFER);
+}
+
+void DeletionQueue::destroy_semaphore(VkSemaphore semaphore)
+{
+	Object object = {};
+	object.semaphore = semaphore;
+	push(object, DeferredType::SEMAPHORE);
+}
+
+void DeletionQueue::destroy_fence(VkFence fence)
+{
+	Object object = {};
+	object.fence = fence;
+	push(object, DeferredType::FENCE);
+}
+
+void DeletionQueue::destroy_descriptor_pool(VkDescriptorPool pool)
+{
+	Object object = {};
+	object.descriptor_pool = pool;
+	push(object, DeferredType::DESCRIPTOR_POOL);
+}
+
+void DeletionQueue::release(const Object& object)
+{
+	switch (object.type)
+	{
+	case DeferredType::FRAMEBUFFER:
+		vkDestroyFramebuffer(m_device, object.framebuffer, nullptr);
+		break;
+	case DeferredType::IMAGE_VIEW:
+		vkDestroyImageView(m_device, object.image_view, nullptr);
+		break;
+	case DeferredType::IMAGE:
+		vkDestroyImage(m_device, object.image, nullptr);
+		break;
+	case DeferredType::BUFFER:
+		vkDestroyBuffer(m_device, object.buffer, nullptr);
+		break;
+	case DeferredType::MEMORY:
+		vkFreeMemory(m_device, object.memory, nullptr);
+		break;
+	case DeferredType::PIPELINE:
+		vkDestroyPipeline(m_device, object.pipeline, nullptr);
+		break;
+	case DeferredType::PIPELINE_LAYOUT:
+		vkDestroyPipelineLayout(m_device, object.pipeline_layout, nullptr);
+		break;
+	case DeferredType::RENDER_PASS:
+		vkDestroyRenderPass(m_device, object.render_pass, nullptr);
+		break;
+	case DeferredType::SHADER_MODULE:
+		vkDestroyShaderModule(m_device, object.shader_module, nullptr);
+		break;
+	case DeferredType::SWAPCHAIN:
+		vkDestroySwapchainKHR(m_device, object.swapchain, nullptr);
+		break;
+	case DeferredType::COMMAND_BUFFER:
+		vkFreeCommandBuffers(m_device, object.pool, 1, &object.command_buffer);
+		break;
+	case DeferredType::SEMAPHORE:
+		vkDestroySemaphore(m_device, object.semaphore, nullptr);
+		break;
+	case DeferredType::FENCE:
+		vkDestroyFence(m_device, object.fence, nullptr);
+		break;
+	case DeferredType::DESCRIPTOR_POOL:
+		vkDestroyDescriptorPool(m_device, object.descriptor_pool, nullptr);
+		break;
+	}
+}
+
+void DeletionQueue::collect(uint64_t completed_frame)
+{
+	while (!m_objects.empty() && m_objects.front().frame <= completed_frame)
+	{
+		release(m_objects.front());
+		m_objects.pop_front();
+	}
+}
+
+void DeletionQueue::flush()
+{
+	for (const auto& object : m_objects)
+		release(object);
+
+	m_objects.clear();
+}
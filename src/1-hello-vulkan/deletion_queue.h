@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <deque>
+
+namespace DeferredType
+{
+	enum
+	{
+		FRAMEBUFFER,
+		IMAGE_VIEW,
+		IMAGE,
+		BUFFER,
+		MEMORY,
+		PIPELINE,
+		PIPELINE_LAYOUT,
+		RENDER_PASS,
+		SHADER_MODULE,
+		SWAPCHAIN,
+		COMMAND_BUFFER,
+		SEMAPHORE,
+		FENCE,
+		DESCRIPTOR_POOL
+	};
+}
+
+// Defers destruction of Vulkan objects until the GPU can no longer be using them. Each Destroy* call
+// records the handle with the queue timeline point of the last submission that may use it; collect()
+// is given the completed point and frees everything tagged at or before it. This replaces device-wide
+// idle waits whenever resources are replaced at runtime (e.g. swap chain recreation).
+class DeletionQueue
+{
+public:
+	DeletionQueue();
+
+	void initialize(VkDevice device);
+
+	// Timeline point the next Destroy* calls will be tagged with (see QueueTimeline). Monotonically increasing.
+	inline void set_frame(uint64_t frame) { m_frame = frame; }
+
+	void destroy_framebuffer(VkFramebuffer framebuffer);
+	void destroy_image_view(VkImageView view);
+	void destroy_image(VkImage image);
+	void destroy_buffer(VkBuffer buffer);
+	void free_memory(VkDeviceMemory memory);
+	void destroy_pipeline(VkPipeline pipeline);
+	void destroy_pipeline_layout(VkPipelineLayout layout);
+	void destroy_render_pass(VkRenderPass render_pass);
+	void destroy_shader_module(VkShaderModule module);
+	void destroy_swapchain(VkSwapchainKHR swapchain);
+	void free_command_buffer(VkCommandPool pool, VkCommandBuffer cmd);
+	void destroy_semaphore(VkSemaphore semaphore);
+	void destroy_fence(VkFence fence);
+	// Frees the sets allocated from it along with it.
+	void destroy_descriptor_pool(VkDescriptorPool pool);
+
+	// Frees every object tagged with completed_frame or earlier.
+	void collect(uint64_t completed_frame);
+
+	// Frees everything regardless of frame. Only valid once the device is idle (e.g. at shutdown).
+	void flush();
+
+	inline size_t pending_count() const { return m_objects.size(); }
+
+private:
+	struct Object
+	{
+		uint32_t type;
+		uint64_t frame;
+		VkCommandPool pool;
+
+		union
+		{
+			VkFramebuffer	 framebuffer;
+			VkImageView		 image_view;
+			VkImage			 image;
+			VkBuffer		 buffer;
+			VkDeviceMemory	 memory;
+			VkPipeline		 pipeline;
+			VkPipelineLayout pipeline_layout;
+			VkRenderPass	 render_pass;
+			VkShaderModule	 shader_module;
+			VkSwapchainKHR	 swapchain;
+			VkCommandBuffer	 command_buffer;
+			VkSemaphore		 semaphore;
+			VkFence			 fence;
+			VkDescriptorPool descriptor_pool;
+		};
+	};
+
+	void push(Object& object, uint32_t type);
+	void release(const Object& object);
+
+private:
+	VkDevice		   m_device;
+	uint64_t		   m_frame;
+	// Ordered by tag since points only move forward, so collect() only ever pops from the front.
+	std::deque<Object> m_objects;
+};
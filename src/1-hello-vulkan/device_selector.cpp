@@ -0,0 +1,326 @@
+#include "device_selector.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <iostream>
+#include <string>
+#include <algorithm>
+
+// Base score per VkPhysicalDeviceType. Type dominates; the other terms only break ties within a type.
+static const int64_t g_DeviceTypeScore[] =
+{
+	20000,	// OTHER
+	30000,	// INTEGRATED_GPU
+	40000,	// DISCRETE_GPU
+	10000,	// VIRTUAL_GPU
+	0		// CPU
+};
+
+static const char* g_DeviceTypeNames[] =
+{
+	"other",
+	"integrated",
+	"discrete",
+	"virtual",
+	"cpu"
+};
+
+const char* vendor_name(uint32_t vendor_id)
+{
+	switch (vendor_id)
+	{
+	case VkVendorID::AMD:
+		return "AMD";
+	case VkVendorID::IMAGINATION:
+		return "IMAGINATION";
+	case VkVendorID::NVIDIA:
+		return "NVIDIA";
+	case VkVendorID::ARM:
+		return "ARM";
+	case VkVendorID::QUALCOMM:
+		return "QUALCOMM";
+	case VkVendorID::INTEL:
+		return "INTEL";
+	default:
+		return "Unknown";
+	}
+}
+
+const char* device_type_name(VkPhysicalDeviceType type)
+{
+	return (uint32_t)type < sizeof(g_DeviceTypeNames) / sizeof(g_DeviceTypeNames[0]) ? g_DeviceTypeNames[type] : g_DeviceTypeNames[0];
+}
+
+static bool check_extensions(VkPhysicalDevice device, const DeviceRequirements& requirements)
+{
+	uint32_t count = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
+
+	std::vector<VkExtensionProperties> available(count);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &count, available.data());
+
+	for (uint32_t i = 0; i < requirements.extension_count; i++)
+	{
+		bool found = false;
+
+		for (const auto& extension : available)
+		{
+			if (strcmp(extension.extensionName, requirements.extensions[i]) == 0)
+			{
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+			return false;
+	}
+
+	return true;
+}
+
+static int64_t score_device(const DeviceCapabilities& caps)
+{
+	int64_t score = g_DeviceTypeScore[std::min((uint32_t)caps.properties.deviceType, (uint32_t)VK_PHYSICAL_DEVICE_TYPE_CPU)];
+
+	// 100 points per GiB of device local memory, capped so memory never outweighs the device type.
+	score += std::min<int64_t>((int64_t)(caps.device_local_bytes >> 30) * 100, 6400);
+
+	// Dedicated queues allow uploads and async compute to overlap graphics work.
+	if (caps.transfer_family >= 0)
+		score += 500;
+	if (caps.compute_family >= 0)
+		score += 500;
+
+	// Graphics and present on the same family avoids concurrent sharing of swap chain images.
+	if (caps.present_family >= 0 && caps.present_family == caps.graphics_family)
+		score += 200;
+
+	const VkPhysicalDeviceFeatures& f = caps.features;
+
+	score += f.samplerAnisotropy ? 100 : 0;
+	score += (f.textureCompressionBC || f.textureCompressionASTC_LDR || f.textureCompressionETC2) ? 100 : 0;
+	score += f.multiDrawIndirect ? 100 : 0;
+	score += f.fillModeNonSolid ? 50 : 0;
+	score += f.depthClamp ? 50 : 0;
+
+	score += caps.properties.limits.maxImageDimension2D / 1024;
+
+	return score;
+}
+
+void query_device_capabilities(VkPhysicalDevice device, uint32_t index, const DeviceRequirements& requirements, DeviceCapabilities& caps)
+{
+	caps.device = device;
+	caps.index = index;
+
+	vkGetPhysicalDeviceProperties(device, &caps.properties);
+	vkGetPhysicalDeviceFeatures(device, &caps.features);
+	vkGetPhysicalDeviceMemoryProperties(device, &caps.memory);
+
+	caps.device_local_bytes = 0;
+
+	for (uint32_t i = 0; i < caps.memory.memoryHeapCount; i++)
+	{
+		if (caps.memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+			caps.device_local_bytes += caps.memory.memoryHeaps[i].size;
+	}
+
+	uint32_t family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count, nullptr);
+	caps.families.resize(family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count, caps.families.data());
+
+	caps.graphics_family = -1;
+	caps.present_family = -1;
+	caps.compute_family = -1;
+	caps.transfer_family = -1;
+
+	for (uint32_t i = 0; i < family_count; i++)
+	{
+		const VkQueueFamilyProperties& family = caps.families[i];
+
+		if (family.queueCount == 0)
+			continue;
+
+		VkQueueFlags bits = family.queueFlags;
+
+		if ((bits & VK_QUEUE_GRAPHICS_BIT) && caps.graphics_family < 0)
+			caps.graphics_family = i;
+
+		if (!(bits & VK_QUEUE_GRAPHICS_BIT) && (bits & VK_QUEUE_COMPUTE_BIT) && caps.compute_family < 0)
+			caps.compute_family = i;
+
+		if (!(bits & VK_QUEUE_GRAPHICS_BIT) && !(bits & VK_QUEUE_COMPUTE_BIT) && (bits & VK_QUEUE_TRANSFER_BIT) && caps.transfer_family < 0)
+			caps.transfer_family = i;
+
+		if (requirements.surface != VK_NULL_HANDLE)
+		{
+			VkBool32 present_support = VK_FALSE;
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, requirements.surface, &present_support);
+
+			// Prefer presenting from the graphics family.
+			if (present_support && (caps.present_family < 0 || (int32_t)i == caps.graphics_family))
+				caps.present_family = i;
+		}
+	}
+
+	caps.extensions_supported = check_extensions(device, requirements);
+	caps.swap_chain_adequate = true;
+
+	if (requirements.surface != VK_NULL_HANDLE && caps.extensions_supported)
+	{
+		uint32_t format_count = 0;
+		uint32_t present_mode_count = 0;
+		vkGetPhysicalDeviceSurfaceFormatsKHR(device, requirements.surface, &format_count, nullptr);
+		vkGetPhysicalDeviceSurfacePresentModesKHR(device, requirements.surface, &present_mode_count, nullptr);
+
+		caps.swap_chain_adequate = format_count > 0 && present_mode_count > 0;
+	}
+
+	caps.suitable = caps.graphics_family >= 0 &&
+					(requirements.surface == VK_NULL_HANDLE || caps.present_family >= 0) &&
+					caps.extensions_supported &&
+					caps.swap_chain_adequate;
+
+	caps.score = caps.suitable ? score_device(caps) : -1;
+}
+
+void print_capability_report(const DeviceCapabilities& caps)
+{
+	const VkPhysicalDeviceProperties& p = caps.properties;
+
+	std::cout << std::endl;
+	std::cout << "Device " << caps.index << " : " << p.deviceName << std::endl;
+	std::cout << "Vendor : " << vendor_name(p.vendorID) << ", Type : " << device_type_name(p.deviceType) << std::endl;
+	std::cout << "API : " << VK_VERSION_MAJOR(p.apiVersion) << "." << VK_VERSION_MINOR(p.apiVersion) << "." << VK_VERSION_PATCH(p.apiVersion) << ", Driver : " << p.driverVersion << std::endl;
+	std::cout << "Device local memory : " << (caps.device_local_bytes >> 20) << " MiB" << std::endl;
+
+	for (uint32_t i = 0; i < caps.memory.memoryHeapCount; i++)
+	{
+		const VkMemoryHeap& heap = caps.memory.memoryHeaps[i];
+		std::cout << "  Heap " << i << " : " << (heap.size >> 20) << " MiB" << ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "") << std::endl;
+	}
+
+	for (size_t i = 0; i < caps.families.size(); i++)
+	{
+		VkQueueFlags bits = caps.families[i].queueFlags;
+
+		std::cout << "  Queue family " << i << " : " << caps.families[i].queueCount << " queues,"
+				  << ((bits & VK_QUEUE_GRAPHICS_BIT) ? " graphics" : "")
+				  << ((bits & VK_QUEUE_COMPUTE_BIT) ? " compute" : "")
+				  << ((bits & VK_QUEUE_TRANSFER_BIT) ? " transfer" : "")
+				  << ((int32_t)i == caps.transfer_family ? " [dedicated transfer]" : "")
+				  << ((int32_t)i == caps.compute_family ? " [async compute]" : "")
+				  << ((int32_t)i == caps.present_family ? " [present]" : "") << std::endl;
+	}
+
+	std::cout << "Features : anisotropy " << caps.features.samplerAnisotropy
+			  << ", BC " << caps.features.textureCompressionBC
+			  << ", ASTC " << caps.features.textureCompressionASTC_LDR
+			  << ", ETC2 " << caps.features.textureCompressionETC2
+			  << ", multiDrawIndirect " << caps.features.multiDrawIndirect << std::endl;
+
+	if (caps.suitable)
+		std::cout << "Score : " << caps.score << std::endl;
+	else
+	{
+		std::cout << "Not suitable :"
+				  << (caps.graphics_family < 0 ? " no graphics queue" : "")
+				  << (!caps.extensions_supported ? " missing extensions" : "")
+				  << (!caps.swap_chain_adequate ? " no surface formats/present modes" : "") << std::endl;
+	}
+}
+
+static std::string to_lower(const char* str)
+{
+	std::string result(str);
+
+	for (auto& c : result)
+		c = (char)tolower((unsigned char)c);
+
+	return result;
+}
+
+// Returns the index into caps of the device DW_VK_DEVICE refers to, or -1.
+static int32_t find_override(const std::vector<DeviceCapabilities>& caps, const char* value)
+{
+	char* end = nullptr;
+	unsigned long index = strtoul(value, &end, 10);
+
+	if (end != value && *end == '\0')
+		return index < caps.size() ? (int32_t)index : -1;
+
+	std::string wanted = to_lower(value);
+	int32_t best = -1;
+
+	// Type keywords pick the best scoring device of that type.
+	for (size_t i = 0; i < caps.size(); i++)
+	{
+		if (wanted == device_type_name(caps[i].properties.deviceType) && caps[i].suitable)
+		{
+			if (best < 0 || caps[i].score > caps[best].score)
+				best = (int32_t)i;
+		}
+	}
+
+	if (best >= 0)
+		return best;
+
+	for (size_t i = 0; i < caps.size(); i++)
+	{
+		if (to_lower(caps[i].properties.deviceName).find(wanted) != std::string::npos)
+			return (int32_t)i;
+	}
+
+	return -1;
+}
+
+VkPhysicalDevice select_physical_device(VkInstance instance, const DeviceRequirements& requirements, DeviceCapabilities* selected, bool report)
+{
+	uint32_t device_count = 0;
+	vkEnumeratePhysicalDevices(instance, &device_count, nullptr);
+
+	if (device_count == 0)
+		return VK_NULL_HANDLE;
+
+	std::vector<VkPhysicalDevice> devices(device_count);
+	vkEnumeratePhysicalDevices(instance, &device_count, devices.data());
+
+	std::vector<DeviceCapabilities> caps(device_count);
+	int32_t best = -1;
+
+	for (uint32_t i = 0; i < device_count; i++)
+	{
+		query_device_capabilities(devices[i], i, requirements, caps[i]);
+
+		if (report)
+			print_capability_report(caps[i]);
+
+		if (caps[i].suitable && (best < 0 || caps[i].score > caps[best].score))
+			best = (int32_t)i;
+	}
+
+	const char* env = getenv(DW_VK_DEVICE_ENV);
+
+	if (env && env[0] != '\0')
+	{
+		int32_t forced = find_override(caps, env);
+
+		if (forced >= 0 && caps[forced].suitable)
+			best = forced;
+		else
+			std::cout << DW_VK_DEVICE_ENV << "=" << env << " does not match a suitable device, using the highest scoring one" << std::endl;
+	}
+
+	if (best < 0)
+		return VK_NULL_HANDLE;
+
+	if (report)
+		std::cout << std::endl << "Selected Device : " << caps[best].properties.deviceName << " (" << device_type_name(caps[best].properties.deviceType) << ")" << std::endl;
+
+	if (selected)
+		*selected = caps[best];
+
+	return caps[best].device;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+
+// Overrides the scored choice. Either a device index ("1"), a device type ("discrete", "integrated",
+// "virtual", "cpu") or a case-insensitive substring of the device name ("lavapipe", "RTX").
+#define DW_VK_DEVICE_ENV "DW_VK_DEVICE"
+
+namespace VkVendorID
+{
+	enum
+	{
+		AMD = 0x1002,
+		IMAGINATION = 0x1010,
+		NVIDIA = 0x10DE,
+		ARM = 0x13B5,
+		QUALCOMM = 0x5143,
+		INTEL = 0x8086,
+	};
+}
+
+// What a device has to support to be considered at all. A null surface skips the present and swap
+// chain checks, for headless use.
+struct DeviceRequirements
+{
+	VkSurfaceKHR	   surface;
+	const char* const* extensions;
+	uint32_t		   extension_count;
+};
+
+struct DeviceCapabilities
+{
+	VkPhysicalDevice				 device;
+	uint32_t						 index;
+	VkPhysicalDeviceProperties		 properties;
+	VkPhysicalDeviceFeatures		 features;
+	VkPhysicalDeviceMemoryProperties memory;
+	VkDeviceSize					 device_local_bytes;
+	std::vector<VkQueueFamilyProperties> families;
+	// -1 if not available. compute_family and transfer_family are only set for dedicated families,
+	// i.e. ones that can run alongside the graphics queue.
+	int32_t							 graphics_family;
+	int32_t							 present_family;
+	int32_t							 compute_family;
+	int32_t							 transfer_family;
+	bool							 extensions_supported;
+	bool							 swap_chain_adequate;
+	bool							 suitable;
+	int64_t							 score;
+};
+
+extern const char* vendor_name(uint32_t vendor_id);
+extern const char* device_type_name(VkPhysicalDeviceType type);
+
+extern void query_device_capabilities(VkPhysicalDevice device, uint32_t index, const DeviceRequirements& requirements, DeviceCapabilities& caps);
+extern void print_capability_report(const DeviceCapabilities& caps);
+
+// Enumerates, scores and reports every device, then returns the best suitable one (or the one picked
+// through DW_VK_DEVICE). Returns VK_NULL_HANDLE if no device meets the requirements.
+extern VkPhysicalDevice select_physical_device(VkInstance instance, const DeviceRequirements& requirements, DeviceCapabilities* selected = nullptr, bool report = true);
@@ -0,0 +1,75 @@
+#include "draw_recorder.h"
+
+void record_draw_stream(VkCommandBuffer cmd, const DrawStream& stream, size_t begin, size_t end, const DrawBindings& bindings, DrawStreamStats& stats)
+{
+	// Nothing is assumed to be bound on entry.
+	uint32_t pipeline = DW_DRAW_NO_RESOURCE;
+	uint32_t material = DW_DRAW_NO_RESOURCE;
+	uint32_t vertex_buffer = DW_DRAW_NO_RESOURCE;
+	uint32_t index_buffer = DW_DRAW_NO_RESOURCE;
+	uint32_t index_flags = 0;
+	VkPipelineLayout layout = VK_NULL_HANDLE;
+	uint32_t binds_needed = 0;
+	uint32_t binds_issued = 0;
+
+	for (size_t i = begin; i < end; i++)
+	{
+		const DrawPacket& packet = stream.packet(i);
+		bool indexed = packet.index_buffer != DW_DRAW_NO_RESOURCE;
+
+		binds_needed += 1 + (packet.material != DW_DRAW_NO_RESOURCE) + (packet.vertex_buffer != DW_DRAW_NO_RESOURCE) + indexed;
+
+		if (packet.pipeline != pipeline)
+		{
+			vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, bindings.pipelines[packet.pipeline]);
+			pipeline = packet.pipeline;
+			stats.pipeline_binds++;
+			binds_issued++;
+
+			// Sets stay bound across pipelines with the same layout, but not necessarily otherwise.
+			if (bindings.pipeline_layouts[pipeline] != layout)
+			{
+				layout = bindings.pipeline_layouts[pipeline];
+				material = DW_DRAW_NO_RESOURCE;
+			}
+		}
+
+		if (packet.material != DW_DRAW_NO_RESOURCE && packet.material != material)
+		{
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &bindings.materials[packet.material], 0, nullptr);
+			material = packet.material;
+			stats.descriptor_binds++;
+			binds_issued++;
+		}
+
+		if (packet.vertex_buffer != DW_DRAW_NO_RESOURCE && packet.vertex_buffer != vertex_buffer)
+		{
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(cmd, 0, 1, &bindings.vertex_buffers[packet.vertex_buffer], &offset);
+			vertex_buffer = packet.vertex_buffer;
+			stats.vertex_buffer_binds++;
+			binds_issued++;
+		}
+
+		if (indexed)
+		{
+			uint32_t flags = packet.flags & DrawFlags::INDEX_32;
+
+			if (packet.index_buffer != index_buffer || flags != index_flags)
+			{
+				vkCmdBindIndexBuffer(cmd, bindings.index_buffers[packet.index_buffer], 0, flags ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16);
+				index_buffer = packet.index_buffer;
+				index_flags = flags;
+				stats.index_buffer_binds++;
+				binds_issued++;
+			}
+
+			vkCmdDrawIndexed(cmd, packet.count, packet.instance_count, packet.first, packet.vertex_offset, packet.first_instance);
+		}
+		else
+			vkCmdDraw(cmd, packet.count, packet.instance_count, packet.first, packet.first_instance);
+	}
+
+	stats.draws += (uint32_t)(end - begin);
+	stats.binds_eliminated += binds_needed - binds_issued;
+}
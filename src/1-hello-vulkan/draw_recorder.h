@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+
+#include "draw_stream.h"
+
+// Vulkan objects the ids in DrawPacket refer to. Owned by whoever fills the stream.
+struct DrawBindings
+{
+	std::vector<VkPipeline>		  pipelines;
+	// Parallel to pipelines. Materials are bound as set 0 of the pipeline's layout.
+	std::vector<VkPipelineLayout> pipeline_layouts;
+	std::vector<VkDescriptorSet>  materials;
+	std::vector<VkBuffer>		  vertex_buffers;
+	std::vector<VkBuffer>		  index_buffers;
+};
+
+struct DrawStreamStats
+{
+	uint32_t draws;
+	uint32_t pipeline_binds;
+	uint32_t descriptor_binds;
+	uint32_t vertex_buffer_binds;
+	uint32_t index_buffer_binds;
+	// Binds that binding everything per draw would have issued, but that were skipped because the
+	// state was already bound.
+	uint32_t binds_eliminated;
+};
+
+// Records the sorted packets [begin, end) into cmd, which must be inside a render pass. State is
+// only bound when it differs from the previous packet's, so the better the keys group state, the
+// fewer binds are issued. Adds to stats rather than resetting it.
+extern void record_draw_stream(VkCommandBuffer cmd, const DrawStream& stream, size_t begin, size_t end, const DrawBindings& bindings, DrawStreamStats& stats);
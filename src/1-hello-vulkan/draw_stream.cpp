@@ -0,0 +1,210 @@
+#include "draw_stream.h"
+#include <string.h>
+#include <algorithm>
+
+#define DW_RADIX_BITS 8
+#define DW_RADIX_BUCKETS (1 << DW_RADIX_BITS)
+#define DW_RADIX_PASSES (64 / DW_RADIX_BITS)
+
+RadixSorter::RadixSorter() : m_quit(false), m_job(0), m_items(nullptr), m_scratch(nullptr), m_count(0), m_participants(1), m_in_scratch(false), m_arrived(0), m_generation(0)
+{
+
+}
+
+RadixSorter::~RadixSorter()
+{
+	shutdown();
+}
+
+void RadixSorter::initialize(uint32_t thread_count)
+{
+	if (thread_count == 0)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+	thread_count = std::min(thread_count, (uint32_t)DW_DRAW_SORT_MAX_THREADS);
+
+	m_quit = false;
+	m_histograms.resize(thread_count * DW_RADIX_BUCKETS);
+
+	for (uint32_t i = 1; i < thread_count; i++)
+		m_threads.emplace_back(&RadixSorter::worker, this, i);
+}
+
+void RadixSorter::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+
+	m_wake.notify_all();
+
+	for (auto& thread : m_threads)
+		thread.join();
+
+	m_threads.clear();
+}
+
+void RadixSorter::barrier()
+{
+	uint32_t generation = m_generation.load(std::memory_order_acquire);
+
+	if (m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_participants)
+	{
+		m_arrived.store(0, std::memory_order_relaxed);
+		m_generation.fetch_add(1, std::memory_order_release);
+	}
+	else
+	{
+		// Phases are a few microseconds at most, not worth sleeping for.
+		while (m_generation.load(std::memory_order_acquire) == generation)
+			std::this_thread::yield();
+	}
+}
+
+void RadixSorter::worker(uint32_t thread)
+{
+	uint64_t seen = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_quit || m_job != seen; });
+
+			if (m_quit)
+				return;
+
+			seen = m_job;
+		}
+
+		sort_chunk(thread);
+	}
+}
+
+void RadixSorter::sort_chunk(uint32_t thread)
+{
+	size_t begin = m_count * thread / m_participants;
+	size_t end = m_count * (thread + 1) / m_participants;
+
+	DrawSortItem* src = m_items;
+	DrawSortItem* dst = m_scratch;
+	uint32_t* histogram = &m_histograms[thread * DW_RADIX_BUCKETS];
+
+	for (uint32_t pass = 0; pass < DW_RADIX_PASSES; pass++)
+	{
+		uint32_t shift = pass * DW_RADIX_BITS;
+
+		memset(histogram, 0, sizeof(uint32_t) * DW_RADIX_BUCKETS);
+
+		for (size_t i = begin; i < end; i++)
+			histogram[(src[i].key >> shift) & (DW_RADIX_BUCKETS - 1)]++;
+
+		barrier();
+
+		// Every thread derives the same totals, so they all agree on skipping without talking.
+		size_t offsets[DW_RADIX_BUCKETS];
+		size_t running = 0;
+		bool skip = false;
+
+		for (uint32_t digit = 0; digit < DW_RADIX_BUCKETS; digit++)
+		{
+			size_t total = 0;
+
+			for (uint32_t t = 0; t < m_participants; t++)
+			{
+				if (t == thread)
+					offsets[digit] = running + total;
+
+				total += m_histograms[t * DW_RADIX_BUCKETS + digit];
+			}
+
+			if (total == m_count)
+				skip = true;
+
+			running += total;
+		}
+
+		if (!skip)
+		{
+			for (size_t i = begin; i < end; i++)
+				dst[offsets[(src[i].key >> shift) & (DW_RADIX_BUCKETS - 1)]++] = src[i];
+		}
+
+		// The next pass reads what the other threads scattered and overwrites the histograms.
+		barrier();
+
+		if (!skip)
+			std::swap(src, dst);
+	}
+
+	if (thread == 0)
+		m_in_scratch = src == m_scratch;
+}
+
+void RadixSorter::sort(std::vector<DrawSortItem>& items)
+{
+	if (items.size() < 2)
+		return;
+
+	// Usable without initialize(), single threaded.
+	if (m_histograms.empty())
+		m_histograms.resize(DW_RADIX_BUCKETS);
+
+	m_scratch_storage.resize(items.size());
+
+	m_items = items.data();
+	m_scratch = m_scratch_storage.data();
+	m_count = items.size();
+	m_participants = items.size() < DW_DRAW_SORT_PARALLEL_THRESHOLD ? 1 : thread_count();
+
+	if (m_participants > 1)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_job++;
+		}
+
+		m_wake.notify_all();
+	}
+
+	// The calling thread takes the first chunk. The last barrier inside means all chunks are done.
+	sort_chunk(0);
+
+	if (m_in_scratch)
+		items.swap(m_scratch_storage);
+}
+
+void DrawStream::clear()
+{
+	m_packets.clear();
+	m_order.clear();
+}
+
+void DrawStream::reserve(size_t count)
+{
+	m_packets.reserve(count);
+	m_order.reserve(count);
+}
+
+void DrawStream::push(const DrawPacket& packet)
+{
+	DrawSortItem item = { packet.key, (uint32_t)m_packets.size(), 0 };
+
+	m_packets.push_back(packet);
+	m_order.push_back(item);
+}
+
+void DrawStream::sort(RadixSorter& sorter)
+{
+	sorter.sort(m_order);
+}
+
+void DrawStream::pass_range(uint32_t pass, size_t& begin, size_t& end) const
+{
+	auto first = std::lower_bound(m_order.begin(), m_order.end(), pass, [](const DrawSortItem& item, uint32_t p) { return draw_key_pass(item.key) < p; });
+	auto last = std::upper_bound(first, m_order.end(), pass, [](uint32_t p, const DrawSortItem& item) { return p < draw_key_pass(item.key); });
+
+	begin = first - m_order.begin();
+	end = last - m_order.begin();
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Sort key layout, most significant first. Opaque passes sort by state and then front to back,
+// translucent ones by depth only (back to front), see make_draw_key() and make_draw_key_back_to_front().
+#define DW_DRAW_KEY_PASS_BITS 4
+#define DW_DRAW_KEY_PIPELINE_BITS 12
+#define DW_DRAW_KEY_MATERIAL_BITS 16
+#define DW_DRAW_KEY_DEPTH_BITS 32
+
+#define DW_DRAW_KEY_PASS_SHIFT (64 - DW_DRAW_KEY_PASS_BITS)
+#define DW_DRAW_KEY_PIPELINE_SHIFT (DW_DRAW_KEY_PASS_SHIFT - DW_DRAW_KEY_PIPELINE_BITS)
+#define DW_DRAW_KEY_MATERIAL_SHIFT (DW_DRAW_KEY_PIPELINE_SHIFT - DW_DRAW_KEY_MATERIAL_BITS)
+
+// Marks an unused resource slot in a packet, e.g. no vertex buffer for draws that generate vertices.
+#define DW_DRAW_NO_RESOURCE 0xFFFF
+// Streams shorter than this are sorted on the calling thread; waking the workers costs more.
+#define DW_DRAW_SORT_PARALLEL_THRESHOLD 8192
+#define DW_DRAW_SORT_MAX_THREADS 8
+
+namespace DrawFlags
+{
+	enum
+	{
+		// Index buffer holds 32 bit indices instead of 16 bit.
+		INDEX_32 = 1
+	};
+}
+
+// One draw, independent of the graphics API. Resources are indices into the backend's tables
+// (see DrawBindings), so a packet is a plain 40 byte POD that is cheap to sort and copy.
+struct DrawPacket
+{
+	uint64_t key;
+	uint16_t pipeline;
+	uint16_t material;
+	uint16_t vertex_buffer;
+	// DW_DRAW_NO_RESOURCE for non-indexed draws.
+	uint16_t index_buffer;
+	// Index count, or vertex count for non-indexed draws.
+	uint32_t count;
+	uint32_t instance_count;
+	// First index, or first vertex for non-indexed draws.
+	uint32_t first;
+	int32_t	 vertex_offset;
+	uint32_t first_instance;
+	uint32_t flags;
+};
+
+// What gets sorted: the key plus where the packet lives, so the packets themselves never move.
+struct DrawSortItem
+{
+	uint64_t key;
+	uint32_t index;
+	uint32_t padding;
+};
+
+// Maps a float to a uint32_t with the same ordering, negative values included.
+inline uint32_t draw_depth_bits(float depth)
+{
+	union { float f; uint32_t u; } bits;
+	bits.f = depth;
+
+	return bits.u & 0x80000000 ? ~bits.u : bits.u | 0x80000000;
+}
+
+inline uint64_t make_draw_key(uint32_t pass, uint32_t pipeline, uint32_t material, float depth)
+{
+	return ((uint64_t)(pass & ((1 << DW_DRAW_KEY_PASS_BITS) - 1)) << DW_DRAW_KEY_PASS_SHIFT) |
+		   ((uint64_t)(pipeline & ((1 << DW_DRAW_KEY_PIPELINE_BITS) - 1)) << DW_DRAW_KEY_PIPELINE_SHIFT) |
+		   ((uint64_t)(material & ((1 << DW_DRAW_KEY_MATERIAL_BITS) - 1)) << DW_DRAW_KEY_MATERIAL_SHIFT) |
+		   (uint64_t)draw_depth_bits(depth);
+}
+
+// Blending needs far to near order, so depth takes the place of the state bits.
+inline uint64_t make_draw_key_back_to_front(uint32_t pass, float depth)
+{
+	return ((uint64_t)(pass & ((1 << DW_DRAW_KEY_PASS_BITS) - 1)) << DW_DRAW_KEY_PASS_SHIFT) |
+		   ((uint64_t)~draw_depth_bits(depth) << (DW_DRAW_KEY_PASS_SHIFT - DW_DRAW_KEY_DEPTH_BITS));
+}
+
+inline uint32_t draw_key_pass(uint64_t key)
+{
+	return (uint32_t)(key >> DW_DRAW_KEY_PASS_SHIFT);
+}
+
+// Stable LSD radix sort over 8 bit digits. Large inputs are split across persistent worker threads,
+// each building a histogram of its chunk and scattering it to offsets derived from all histograms.
+// Digits that are the same for every key (unused pass bits, a single pipeline...) are skipped.
+class RadixSorter
+{
+public:
+	RadixSorter();
+	~RadixSorter();
+
+	// 0 picks one thread per core, capped at DW_DRAW_SORT_MAX_THREADS. The calling thread counts as one.
+	void initialize(uint32_t thread_count = 0);
+	void shutdown();
+
+	void sort(std::vector<DrawSortItem>& items);
+
+	inline uint32_t thread_count() const { return (uint32_t)m_threads.size() + 1; }
+
+private:
+	void worker(uint32_t thread);
+	void sort_chunk(uint32_t thread);
+	void barrier();
+
+private:
+	std::vector<std::thread> m_threads;
+	std::mutex				 m_mutex;
+	std::condition_variable	 m_wake;
+	bool					 m_quit;
+	uint64_t				 m_job;
+	// Current job, read by the workers after they are woken.
+	DrawSortItem*			 m_items;
+	DrawSortItem*			 m_scratch;
+	size_t					 m_count;
+	uint32_t				 m_participants;
+	// Whether the sorted result ended up in m_scratch.
+	bool					 m_in_scratch;
+	std::vector<uint32_t>	 m_histograms;
+	std::vector<DrawSortItem> m_scratch_storage;
+	std::atomic<uint32_t>	 m_arrived;
+	std::atomic<uint32_t>	 m_generation;
+};
+
+// A frame's worth of draws. Filled in any order, sorted once, then translated by the backend.
+class DrawStream
+{
+public:
+	void clear();
+	void reserve(size_t count);
+	void push(const DrawPacket& packet);
+
+	// Orders the packets by key. Packets with equal keys keep their submission order.
+	void sort(RadixSorter& sorter);
+
+	// Range of sorted packets [begin, end) belonging to pass. Only valid after sort().
+	void pass_range(uint32_t pass, size_t& begin, size_t& end) const;
+
+	inline size_t size() const { return m_packets.size(); }
+	inline bool empty() const { return m_packets.empty(); }
+	// i-th packet in sorted order (submission order before sort()).
+	inline const DrawPacket& packet(size_t i) const { return m_packets[m_order[i].index]; }
+
+private:
+	std::vector<DrawPacket>	  m_packets;
+	std::vector<DrawSortItem> m_order;
+};
@@ -0,0 +1,138 @@
+#include "frame_arena.h"
+#include <atomic>
+#include <new>
+#include <algorithm>
+
+struct ArenaBlock
+{
+	ArenaBlock* next;
+	size_t		capacity;
+	size_t		offset;
+	size_t		padding;
+};
+
+static std::atomic<uint64_t> g_arena_frame(0);
+
+struct ThreadArenas
+{
+	LinearArena arenas[DW_FRAME_ARENA_SLOTS];
+	uint64_t	frames[DW_FRAME_ARENA_SLOTS];
+
+	ThreadArenas()
+	{
+		for (uint32_t i = 0; i < DW_FRAME_ARENA_SLOTS; i++)
+			frames[i] = UINT64_MAX;
+	}
+};
+
+static inline uint8_t* block_data(ArenaBlock* block)
+{
+	return (uint8_t*)(block + 1);
+}
+
+LinearArena::LinearArena(size_t capacity) : m_head(nullptr), m_capacity(0), m_used(0), m_high_water(0), m_overflows(0)
+{
+	m_head = allocate_block(capacity, nullptr);
+}
+
+LinearArena::~LinearArena()
+{
+	free_blocks();
+}
+
+ArenaBlock* LinearArena::allocate_block(size_t capacity, ArenaBlock* next)
+{
+	// Through operator new so arena growth shows up in the allocation counts like any other.
+	ArenaBlock* block = (ArenaBlock*)::operator new(sizeof(ArenaBlock) + capacity);
+
+	block->next = next;
+	block->capacity = capacity;
+	block->offset = 0;
+
+	m_capacity += capacity;
+
+	return block;
+}
+
+void LinearArena::free_blocks()
+{
+	while (m_head)
+	{
+		ArenaBlock* next = m_head->next;
+		::operator delete(m_head);
+		m_head = next;
+	}
+
+	m_capacity = 0;
+}
+
+void* LinearArena::allocate(size_t size, size_t alignment)
+{
+	uintptr_t base = (uintptr_t)block_data(m_head);
+	uintptr_t aligned = (base + m_head->offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+	if (aligned + size > base + m_head->capacity)
+	{
+		// Sized for the request, or for another head-sized run of small allocations.
+		m_head = allocate_block(std::max(m_head->capacity, size + alignment), m_head);
+		m_overflows++;
+
+		base = (uintptr_t)block_data(m_head);
+		aligned = (base + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	}
+
+	size_t end = aligned + size - base;
+
+	m_used += end - m_head->offset;
+	m_head->offset = end;
+	m_high_water = std::max(m_high_water, m_used);
+
+	return (void*)aligned;
+}
+
+void LinearArena::deallocate(void* ptr, size_t size)
+{
+	uint8_t* top = block_data(m_head) + m_head->offset;
+
+	if ((uint8_t*)ptr + size == top)
+	{
+		m_head->offset -= size;
+		m_used -= size;
+	}
+}
+
+void LinearArena::reset()
+{
+	if (m_head->next)
+	{
+		// Grow into one block that would have held the whole frame.
+		size_t capacity = m_capacity;
+
+		free_blocks();
+		m_head = allocate_block(capacity, nullptr);
+	}
+
+	m_head->offset = 0;
+	m_used = 0;
+}
+
+void frame_arena_next_frame()
+{
+	g_arena_frame.fetch_add(1, std::memory_order_release);
+}
+
+LinearArena& frame_arena()
+{
+	static thread_local ThreadArenas thread_arenas;
+
+	uint64_t frame = g_arena_frame.load(std::memory_order_acquire);
+	uint32_t slot = frame % DW_FRAME_ARENA_SLOTS;
+
+	if (thread_arenas.frames[slot] != frame)
+	{
+		thread_arenas.arenas[slot].reset();
+		thread_arenas.frames[slot] = frame;
+	}
+
+	return thread_arenas.arenas[slot];
+}
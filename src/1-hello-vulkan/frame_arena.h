@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Initial size of each of a thread's per-frame arenas.
+#define DW_FRAME_ARENA_SIZE (256 * 1024)
+// Arenas per thread, used round robin. Frame data stays valid until DW_FRAME_ARENA_SLOTS frames later,
+// which covers a frame being consumed (e.g. by a render thread) while the next one is built.
+#define DW_FRAME_ARENA_SLOTS 2
+
+struct ArenaBlock;
+
+// Bump pointer allocator, freed all at once by reset(). Allocations that don't fit go into extra
+// blocks; the next reset() replaces them with a single block big enough for the whole frame, so a
+// steady frame loop stops touching the heap after the first few frames.
+class LinearArena
+{
+public:
+	explicit LinearArena(size_t capacity = DW_FRAME_ARENA_SIZE);
+	~LinearArena();
+
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment = alignof(max_align_t));
+	// Only gives the memory back if it was the most recent allocation (e.g. a vector that grew).
+	void deallocate(void* ptr, size_t size);
+	void reset();
+
+	// Bytes handed out since the last reset, including alignment padding.
+	inline size_t used() const { return m_used; }
+	inline size_t capacity() const { return m_capacity; }
+	// Most bytes used in any single frame so far.
+	inline size_t high_water() const { return m_high_water; }
+	// Allocations that needed a new block. Stops increasing once the arena has grown to fit a frame.
+	inline uint64_t overflows() const { return m_overflows; }
+
+private:
+	ArenaBlock* allocate_block(size_t capacity, ArenaBlock* next);
+	void free_blocks();
+
+private:
+	// Newest block first; only the head is allocated from.
+	ArenaBlock* m_head;
+	size_t		m_capacity;
+	size_t		m_used;
+	size_t		m_high_water;
+	uint64_t	m_overflows;
+};
+
+// Starts a new frame for the arenas of every thread. Each thread's arena for the new slot is reset
+// lazily, the first time that thread allocates in the frame.
+extern void frame_arena_next_frame();
+// The calling thread's arena for the current frame.
+extern LinearArena& frame_arena();
+
+// STL allocator on top of a LinearArena, the calling thread's frame arena by default. Containers using
+// it must not outlive the frame (or the arena).
+template <typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	ArenaAllocator() : m_arena(&frame_arena()) {}
+	explicit ArenaAllocator(LinearArena& arena) : m_arena(&arena) {}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.arena()) {}
+
+	inline T* allocate(size_t count) { return (T*)m_arena->allocate(count * sizeof(T), alignof(T)); }
+	inline void deallocate(T* ptr, size_t count) { m_arena->deallocate(ptr, count * sizeof(T)); }
+
+	inline LinearArena* arena() const { return m_arena; }
+
+private:
+	LinearArena* m_arena;
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() == b.arena(); }
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena() != b.arena(); }
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
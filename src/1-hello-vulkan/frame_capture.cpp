@@ -0,0 +1,514 @@
+#include "frame_capture.h"
+#include "image_writer.h"
+#include <string.h>
+#include <iostream>
+#include <algorithm>
+
+uint32_t capture_format_size(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+	case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+	case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+		return 4;
+	case VK_FORMAT_R16G16B16A16_SFLOAT:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+static bool is_bgra8(VkFormat format)
+{
+	return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+static bool is_rgba8(VkFormat format)
+{
+	return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+FrameCapture::FrameCapture() : m_device(VK_NULL_HANDLE), m_command_pool(VK_NULL_HANDLE), m_non_coherent_atom_size(1), m_next_slot(0),
+							   m_video(false), m_video_stream(0), m_ended_stream(0), m_running(false), m_video_file(nullptr), m_open_stream(0), m_closed_stream(0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	for (uint32_t i = 0; i < DW_CAPTURE_RING_SIZE; i++)
+	{
+		m_slots[i].buffer = VK_NULL_HANDLE;
+		m_slots[i].memory = VK_NULL_HANDLE;
+		m_slots[i].size = 0;
+		m_slots[i].mapped = nullptr;
+		m_slots[i].cmd = VK_NULL_HANDLE;
+		m_slots[i].busy = false;
+		m_slots[i].video = false;
+		m_slots[i].stream = 0;
+	}
+}
+
+FrameCapture::~FrameCapture()
+{
+	shutdown();
+}
+
+bool FrameCapture::initialize(VkPhysicalDevice physical_device, VkDevice device, uint32_t queue_family)
+{
+	m_device = device;
+	m_memory_policy.Init(physical_device);
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+	m_non_coherent_atom_size = properties.limits.nonCoherentAtomSize;
+
+	VkCommandPoolCreateInfo pool_info = {};
+	pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.queueFamilyIndex = queue_family;
+	pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+	if (vkCreateCommandPool(m_device, &pool_info, nullptr, &m_command_pool) != VK_SUCCESS)
+		return false;
+
+	for (uint32_t i = 0; i < DW_CAPTURE_RING_SIZE; i++)
+	{
+		VkCommandBufferAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		alloc_info.commandPool = m_command_pool;
+		alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		alloc_info.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(m_device, &alloc_info, &m_slots[i].cmd) != VK_SUCCESS)
+			return false;
+	}
+
+	m_running = true;
+	m_thread = std::thread(&FrameCapture::writer, this);
+
+	return true;
+}
+
+void FrameCapture::shutdown()
+{
+	if (!m_running)
+		return;
+
+	// Everything still on the GPU has finished by now.
+	collect(UINT64_MAX);
+	stop_video();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_running = false;
+	}
+
+	m_condition.notify_all();
+	m_thread.join();
+
+	for (uint32_t i = 0; i < DW_CAPTURE_RING_SIZE; i++)
+		release(m_slots[i]);
+
+	vkDestroyCommandPool(m_device, m_command_pool, nullptr);
+	m_command_pool = VK_NULL_HANDLE;
+
+	std::cout << "Frame capture : " << m_stats.captured << " captured, " << m_stats.dropped << " dropped, " << m_stats.written << " written ("
+			  << (m_stats.bytes_written >> 20) << " MiB)" << std::endl;
+}
+
+void FrameCapture::screenshot(const std::string& path, uint32_t format)
+{
+	m_screenshots.push_back(std::make_pair(path, format));
+}
+
+void FrameCapture::start_video(const std::string& path)
+{
+	if (m_video)
+		stop_video();
+
+	m_video = true;
+	m_video_path = path;
+	m_video_stream++;
+}
+
+void FrameCapture::stop_video()
+{
+	if (!m_video)
+		return;
+
+	m_video = false;
+
+	// Readbacks of the stream may still be in flight; the stream ends once they are collected.
+	m_stopped_streams.push_back(m_video_stream);
+	end_finished_streams();
+}
+
+void FrameCapture::end_finished_streams()
+{
+	while (!m_stopped_streams.empty())
+	{
+		uint32_t stream = m_stopped_streams.front();
+
+		for (uint32_t i = 0; i < DW_CAPTURE_RING_SIZE; i++)
+		{
+			if (m_slots[i].busy && m_slots[i].video && m_slots[i].stream == stream)
+				return;
+		}
+
+		m_stopped_streams.pop_front();
+		m_ended_stream = stream;
+
+		// Queued behind the stream's last frames, so the writer closes the file once they are out.
+		Job* job = new Job();
+		job->end_video = true;
+		job->video = true;
+		job->stream = stream;
+		push(job);
+	}
+}
+
+void FrameCapture::release(Slot& slot)
+{
+	if (slot.mapped)
+		vkUnmapMemory(m_device, slot.memory);
+
+	if (slot.buffer != VK_NULL_HANDLE)
+		vkDestroyBuffer(m_device, slot.buffer, nullptr);
+
+	if (slot.memory != VK_NULL_HANDLE)
+		vkFreeMemory(m_device, slot.memory, nullptr);
+
+	slot.buffer = VK_NULL_HANDLE;
+	slot.memory = VK_NULL_HANDLE;
+	slot.mapped = nullptr;
+	slot.size = 0;
+}
+
+bool FrameCapture::ensure_size(Slot& slot, VkDeviceSize size)
+{
+	if (slot.size >= size)
+		return true;
+
+	// The slot is not busy, so the GPU is done with the old buffer.
+	release(slot);
+
+	VkBufferCreateInfo buffer_info = {};
+	buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_info.size = size;
+	buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateBuffer(m_device, &buffer_info, nullptr, &slot.buffer) != VK_SUCCESS)
+		return false;
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(m_device, slot.buffer, &requirements);
+
+	gfx::MemoryPlacement placement;
+
+	if (!m_memory_policy.Choose(gfx::BufferUsage::READBACK, requirements.memoryTypeBits, placement))
+	{
+		release(slot);
+		return false;
+	}
+
+	VkMemoryAllocateInfo alloc_info = {};
+	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc_info.allocationSize = requirements.size;
+	alloc_info.memoryTypeIndex = placement.memoryType;
+
+	if (vkAllocateMemory(m_device, &alloc_info, nullptr, &slot.memory) != VK_SUCCESS ||
+		vkBindBufferMemory(m_device, slot.buffer, slot.memory, 0) != VK_SUCCESS ||
+		vkMapMemory(m_device, slot.memory, 0, VK_WHOLE_SIZE, 0, &slot.mapped) != VK_SUCCESS)
+	{
+		release(slot);
+		return false;
+	}
+
+	slot.size = size;
+	slot.coherent = (placement.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+	return true;
+}
+
+VkCommandBuffer FrameCapture::record(VkImage image, VkFormat format, VkExtent2D extent, VkImageLayout layout, VkPipelineStageFlags src_stage, VkAccessFlags src_access, uint64_t frame)
+{
+	if (!wants_frame())
+		return VK_NULL_HANDLE;
+
+	uint32_t texel_size = capture_format_size(format);
+	Slot& slot = m_slots[m_next_slot];
+
+	// Dropping keeps the render thread from ever waiting on a readback.
+	if (texel_size == 0 || slot.busy || !ensure_size(slot, (VkDeviceSize)extent.width * extent.height * texel_size))
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stats.dropped++;
+		return VK_NULL_HANDLE;
+	}
+
+	m_next_slot = (m_next_slot + 1) % DW_CAPTURE_RING_SIZE;
+
+	slot.busy = true;
+	slot.frame = frame;
+	slot.width = extent.width;
+	slot.height = extent.height;
+	slot.format = format;
+
+	if (!m_screenshots.empty())
+	{
+		slot.path = m_screenshots.front().first;
+		slot.output = m_screenshots.front().second;
+		slot.video = false;
+		m_screenshots.pop_front();
+	}
+	else
+	{
+		slot.path = m_video_path;
+		slot.output = CaptureFormat::RAW;
+		slot.video = true;
+		slot.stream = m_video_stream;
+	}
+
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(slot.cmd, &begin_info);
+
+	VkImageMemoryBarrier to_transfer = {};
+	to_transfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	to_transfer.srcAccessMask = src_access;
+	to_transfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	to_transfer.oldLayout = layout;
+	to_transfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	to_transfer.image = image;
+	to_transfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	to_transfer.subresourceRange.levelCount = 1;
+	to_transfer.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(slot.cmd, src_stage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &to_transfer);
+
+	VkBufferImageCopy region = {};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = { extent.width, extent.height, 1 };
+
+	vkCmdCopyImageToBuffer(slot.cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+	VkImageMemoryBarrier to_original = to_transfer;
+	to_original.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	to_original.dstAccessMask = 0;
+	to_original.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	to_original.newLayout = layout;
+
+	VkBufferMemoryBarrier to_host = {};
+	to_host.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	to_host.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	to_host.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	to_host.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	to_host.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	to_host.buffer = slot.buffer;
+	to_host.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(slot.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &to_original);
+	vkCmdPipelineBarrier(slot.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &to_host, 0, nullptr);
+
+	vkEndCommandBuffer(slot.cmd);
+
+	return slot.cmd;
+}
+
+void FrameCapture::collect(uint64_t completed_frame)
+{
+	// Oldest first, so a stopped stream's last frames are queued before it ends and before any
+	// frame of the stream that follows it.
+	Slot* ready[DW_CAPTURE_RING_SIZE];
+	uint32_t ready_count = 0;
+
+	for (uint32_t i = 0; i < DW_CAPTURE_RING_SIZE; i++)
+	{
+		if (m_slots[i].busy && m_slots[i].frame <= completed_frame)
+			ready[ready_count++] = &m_slots[i];
+	}
+
+	std::sort(ready, ready + ready_count, [](const Slot* a, const Slot* b) { return a->frame < b->frame; });
+
+	for (uint32_t i = 0; i < ready_count; i++)
+	{
+		Slot& slot = *ready[i];
+		slot.busy = false;
+
+		if (!slot.coherent)
+		{
+			VkMappedMemoryRange range = {};
+			range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory = slot.memory;
+			range.offset = 0;
+			range.size = VK_WHOLE_SIZE;
+			vkInvalidateMappedMemoryRanges(m_device, 1, &range);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_stats.captured++;
+
+			// Late frames of a stream that has already ended would reopen, and truncate, its file.
+			if (slot.video && (slot.stream <= m_ended_stream || m_jobs.size() >= DW_CAPTURE_MAX_QUEUED))
+			{
+				m_stats.dropped++;
+				continue;
+			}
+		}
+
+		// Host cached memory makes this copy cheap, and frees the slot right away instead of holding it
+		// until the disk write is done.
+		Job* job = new Job();
+		size_t size = (size_t)slot.width * slot.height * capture_format_size(slot.format);
+
+		job->pixels.assign((const uint8_t*)slot.mapped, (const uint8_t*)slot.mapped + size);
+		job->width = slot.width;
+		job->height = slot.height;
+		job->format = slot.format;
+		job->frame = slot.frame;
+		job->path = slot.path;
+		job->output = slot.output;
+		job->video = slot.video;
+		job->stream = slot.stream;
+		job->end_video = false;
+
+		push(job);
+	}
+
+	end_finished_streams();
+}
+
+void FrameCapture::stats(CaptureStats& stats)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	stats = m_stats;
+}
+
+void FrameCapture::push(Job* job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(job);
+	}
+
+	m_condition.notify_one();
+}
+
+void FrameCapture::writer()
+{
+	while (true)
+	{
+		Job* job = nullptr;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return !m_running || !m_jobs.empty(); });
+
+			// Drain the queue before exiting so nothing captured is lost.
+			if (m_jobs.empty())
+				break;
+
+			job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		write(*job);
+		delete job;
+	}
+
+	if (m_video_file)
+	{
+		fclose(m_video_file);
+		m_video_file = nullptr;
+	}
+}
+
+void FrameCapture::write(Job& job)
+{
+	if (job.end_video)
+	{
+		if (m_video_file && m_open_stream == job.stream)
+		{
+			fclose(m_video_file);
+			m_video_file = nullptr;
+		}
+
+		m_closed_stream = std::max(m_closed_stream, job.stream);
+		return;
+	}
+
+	if (job.video && job.stream <= m_closed_stream)
+		return;
+
+	RawFrameHeader header;
+	header.magic = DW_RAW_FRAME_MAGIC;
+	header.width = job.width;
+	header.height = job.height;
+	header.format = (uint32_t)job.format;
+	header.bytes_per_pixel = capture_format_size(job.format);
+	header.reserved = 0;
+	header.frame = job.frame;
+
+	bool ok = false;
+
+	if (job.video)
+	{
+		// Frames arrive in stream order, so a new stream means the previous one is done with.
+		if (m_video_file && m_open_stream != job.stream)
+		{
+			fclose(m_video_file);
+			m_video_file = nullptr;
+		}
+
+		if (!m_video_file)
+		{
+			m_video_file = fopen(job.path.c_str(), "wb");
+			m_open_stream = job.stream;
+		}
+
+		ok = m_video_file && write_raw_frame(m_video_file, header, job.pixels.data());
+	}
+	else if (job.output == CaptureFormat::PNG && (is_bgra8(job.format) || is_rgba8(job.format)))
+	{
+		size_t count = (size_t)job.width * job.height;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			uint8_t* p = &job.pixels[i * 4];
+
+			if (is_bgra8(job.format))
+				std::swap(p[0], p[2]);
+
+			// Swap chain alpha is undefined with opaque composition.
+			p[3] = 255;
+		}
+
+		ok = write_png(job.path.c_str(), job.pixels.data(), job.width, job.height);
+	}
+	else
+	{
+		if (job.output == CaptureFormat::PNG)
+			std::cout << "Frame capture : PNG needs an 8-bit RGBA/BGRA format, writing raw instead" << std::endl;
+
+		ok = write_raw(job.path.c_str(), header, job.pixels.data());
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (ok)
+	{
+		m_stats.written++;
+		m_stats.bytes_written += job.pixels.size();
+	}
+	else
+		std::cout << "Frame capture : failed to write " << job.path << std::endl;
+}
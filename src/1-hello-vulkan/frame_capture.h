@@ -0,0 +1,151 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "memory_policy.h"
+
+// Readback buffers in flight. One more than the frames in flight, so a slot is normally free again
+// by the time it comes around.
+#define DW_CAPTURE_RING_SIZE 3
+// Frames waiting for the writer thread. Video frames beyond this are dropped rather than letting
+// a slow disk grow memory without bound; screenshots are always kept.
+#define DW_CAPTURE_MAX_QUEUED 8
+// If set, every presented frame is appended to the raw stream at this path, e.g. for headless regression runs.
+#define DW_CAPTURE_VIDEO_ENV "DW_CAPTURE_VIDEO"
+
+namespace CaptureFormat
+{
+	enum
+	{
+		PNG,
+		// A single RawFrameHeader + pixels, see image_writer.h.
+		RAW
+	};
+}
+
+struct CaptureStats
+{
+	uint64_t captured;
+	// No free readback slot, or the writer was too far behind.
+	uint64_t dropped;
+	uint64_t written;
+	uint64_t bytes_written;
+};
+
+// Asynchronous GPU readback. record() returns a command buffer that copies an image into a ring of
+// host cached buffers; it is submitted right after the frame's own work. Once the frame's fence has
+// signalled, collect() hands the pixels to a writer thread that produces PNG/raw screenshots or
+// appends to a raw video stream, so the render thread never waits on the GPU or the disk.
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	bool initialize(VkPhysicalDevice physical_device, VkDevice device, uint32_t queue_family);
+	// The device must be idle. Pending readbacks are written out before returning.
+	void shutdown();
+
+	// Captures the next recorded frame.
+	void screenshot(const std::string& path, uint32_t format = CaptureFormat::PNG);
+	// Appends every frame to a raw stream until stop_video().
+	void start_video(const std::string& path);
+	void stop_video();
+
+	inline bool wants_frame() const { return !m_screenshots.empty() || m_video; }
+	inline bool video_active() const { return m_video; }
+
+	// image must be in layout and is returned to it; src_stage and src_access are the stage and access of
+	// the last write to it, which the copy waits for. frame is the timeline point the copy's submission
+	// will signal. Returns VK_NULL_HANDLE if nothing is wanted this frame, the format is not supported,
+	// or no readback slot is free.
+	VkCommandBuffer record(VkImage image, VkFormat format, VkExtent2D extent, VkImageLayout layout, VkPipelineStageFlags src_stage, VkAccessFlags src_access, uint64_t frame);
+
+	// Call with the completed timeline point; collects every readback at or before it.
+	void collect(uint64_t completed_frame);
+
+	void stats(CaptureStats& stats);
+
+private:
+	struct Slot
+	{
+		VkBuffer		buffer;
+		VkDeviceMemory	memory;
+		VkDeviceSize	size;
+		bool			coherent;
+		void*			mapped;
+		VkCommandBuffer	cmd;
+		bool			busy;
+		uint64_t		frame;
+		uint32_t		width;
+		uint32_t		height;
+		VkFormat		format;
+		// Screenshot path, or the stream's path for video frames; taken when the copy is recorded.
+		std::string		path;
+		uint32_t		output;
+		bool			video;
+		// Video stream the frame belongs to.
+		uint32_t		stream;
+	};
+
+	struct Job
+	{
+		std::vector<uint8_t> pixels;
+		uint32_t			 width;
+		uint32_t			 height;
+		VkFormat			 format;
+		uint64_t			 frame;
+		std::string			 path;
+		uint32_t			 output;
+		bool				 video;
+		uint32_t			 stream;
+		// Closes the video stream; carries no pixels.
+		bool				 end_video;
+	};
+
+	bool ensure_size(Slot& slot, VkDeviceSize size);
+	void release(Slot& slot);
+	void push(Job* job);
+	void end_finished_streams();
+	void writer();
+	void write(Job& job);
+
+private:
+	VkDevice				m_device;
+	VkCommandPool			m_command_pool;
+	gfx::MemoryPolicy		m_memory_policy;
+	VkDeviceSize			m_non_coherent_atom_size;
+	Slot					m_slots[DW_CAPTURE_RING_SIZE];
+	uint32_t				m_next_slot;
+	std::deque<std::pair<std::string, uint32_t>> m_screenshots;
+	bool					m_video;
+	std::string				m_video_path;
+	// Streams are numbered from 1 as they start. A stopped stream is only ended once every frame
+	// recorded for it has been collected, so its last frames still reach the file.
+	uint32_t				m_video_stream;
+	std::deque<uint32_t>	m_stopped_streams;
+	uint32_t				m_ended_stream;
+
+	// Writer thread.
+	std::thread				m_thread;
+	std::mutex				m_mutex;
+	std::condition_variable	m_condition;
+	std::deque<Job*>		m_jobs;
+	bool					m_running;
+	FILE*					m_video_file;
+	// Writer thread only: the stream m_video_file belongs to, and the last stream closed.
+	uint32_t				m_open_stream;
+	uint32_t				m_closed_stream;
+	CaptureStats			m_stats;
+};
+
+// Bytes per pixel for formats that can be read back, 0 otherwise.
+extern uint32_t capture_format_size(VkFormat format);
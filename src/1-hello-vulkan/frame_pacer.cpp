@@ -0,0 +1,113 @@
+#include "frame_pacer.h"
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+// Weight of the newest frame in the work prediction.
+#define DW_FRAME_PACER_SMOOTHING 0.1
+// sleep_for() regularly overshoots by a fraction of a millisecond, so the last stretch is spun.
+#define DW_FRAME_PACER_SPIN_MS 1.0
+
+static double now_ms()
+{
+	using namespace std::chrono;
+	return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void sleep_until_ms(double deadline)
+{
+	double remaining = deadline - now_ms();
+
+	if (remaining > DW_FRAME_PACER_SPIN_MS)
+		std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(remaining - DW_FRAME_PACER_SPIN_MS));
+
+	while (now_ms() < deadline)
+		std::this_thread::yield();
+}
+
+FramePacer::FramePacer() : m_target_ms(0.0), m_margin_ms(1.0), m_just_in_time(false)
+{
+	reset();
+}
+
+void FramePacer::reset()
+{
+	m_predicted_ms = 0.0;
+	m_input_time = 0.0;
+	m_last_input_time = 0.0;
+	m_last_present_time = 0.0;
+	m_frame_count = 0;
+}
+
+double FramePacer::wait_for_input()
+{
+	if (m_target_ms > 0.0 && m_frame_count > 0)
+	{
+		// Without just in time this is a plain frame limiter that evens out intervals. With it, the next
+		// present is due one interval after the previous one, and input is sampled just early enough
+		// for the predicted work to finish by then.
+		double deadline = m_input_time + m_target_ms;
+
+		if (m_just_in_time)
+			deadline = m_last_present_time + m_target_ms - m_predicted_ms - m_margin_ms;
+
+		sleep_until_ms(deadline);
+	}
+
+	m_input_time = now_ms();
+
+	return m_input_time;
+}
+
+void FramePacer::presented(double input_time)
+{
+	double now = now_ms();
+	double latency = now - input_time;
+
+	m_predicted_ms = m_frame_count == 0 ? latency : m_predicted_ms + (latency - m_predicted_ms) * DW_FRAME_PACER_SMOOTHING;
+
+	uint32_t slot = m_frame_count % DW_FRAME_PACER_HISTORY;
+	m_latency_ms[slot] = (float)latency;
+	m_frame_ms[slot] = m_frame_count == 0 ? 0.0f : (float)(input_time - m_last_input_time);
+
+	m_last_input_time = input_time;
+	m_last_present_time = now;
+	m_frame_count++;
+}
+
+void FramePacer::stats(FramePacerStats& stats) const
+{
+	uint32_t count = std::min(m_frame_count, (uint32_t)DW_FRAME_PACER_HISTORY);
+
+	stats.frame_count = m_frame_count;
+	stats.mean_frame_ms = 0.0;
+	stats.mean_latency_ms = 0.0;
+	stats.p99_latency_ms = 0.0;
+	stats.max_latency_ms = 0.0;
+
+	if (count == 0)
+		return;
+
+	float sorted[DW_FRAME_PACER_HISTORY];
+	uint32_t frame_samples = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		sorted[i] = m_latency_ms[i];
+		stats.mean_latency_ms += m_latency_ms[i];
+
+		// The very first frame has no interval.
+		if (m_frame_ms[i] > 0.0f)
+		{
+			stats.mean_frame_ms += m_frame_ms[i];
+			frame_samples++;
+		}
+	}
+
+	std::sort(sorted, sorted + count);
+
+	stats.mean_latency_ms /= count;
+	stats.mean_frame_ms = frame_samples > 0 ? stats.mean_frame_ms / frame_samples : 0.0;
+	stats.p99_latency_ms = sorted[std::min(count - 1, (count * 99) / 100)];
+	stats.max_latency_ms = sorted[count - 1];
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+#define DW_FRAME_PACER_HISTORY 256
+
+struct FramePacerStats
+{
+	uint32_t frame_count;
+	double	 mean_frame_ms;
+	double	 mean_latency_ms;
+	double	 p99_latency_ms;
+	double	 max_latency_ms;
+};
+
+// Keeps frame intervals even and measures input-to-present latency.
+//
+// Each frame calls wait_for_input() right before input is sampled and keeps the time it returns.
+// presented() gets that time back right after vkQueuePresentKHR returns for the same frame, which
+// may be after later frames sampled their input. The time between the two is the latency recorded.
+// With a target interval set, wait_for_input() holds each frame to that interval. With just_in_time
+// also enabled, it sleeps so that input is sampled as late as possible: one target interval after
+// the previous present, minus the predicted input-to-present time and a safety margin. The
+// prediction is an exponential moving average of recent frames, so a single slow frame does not
+// cause a burst of early wake-ups.
+class FramePacer
+{
+public:
+	FramePacer();
+
+	// Desired interval between frames, usually the display refresh interval. 0 disables pacing.
+	inline void set_target_interval(double ms) { m_target_ms = ms; }
+	inline void set_just_in_time(bool enabled) { m_just_in_time = enabled; }
+	inline void set_margin(double ms) { m_margin_ms = ms; }
+
+	// Returns the time input is sampled at, in ms.
+	double wait_for_input();
+	void presented(double input_time);
+
+	void stats(FramePacerStats& stats) const;
+	void reset();
+
+	inline double predicted_work_ms() const { return m_predicted_ms; }
+
+private:
+	double	 m_target_ms;
+	double	 m_margin_ms;
+	bool	 m_just_in_time;
+	double	 m_predicted_ms;
+	// Of the last wait_for_input(), and of the last frame presented.
+	double	 m_input_time;
+	double	 m_last_input_time;
+	double	 m_last_present_time;
+	uint32_t m_frame_count;
+	float	 m_latency_ms[DW_FRAME_PACER_HISTORY];
+	float	 m_frame_ms[DW_FRAME_PACER_HISTORY];
+};
@@ -0,0 +1,453 @@
+#include "frustum_culling.h"
+#include "worker_pool.h"
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define DW_CULL_SSE
+#include <xmmintrin.h>
+
+// AVX is compiled for the single kernel only and picked at runtime, the rest of the build stays baseline.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define DW_CULL_AVX
+#define DW_TARGET_AVX
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined(__GNUC__)
+#define DW_CULL_AVX
+#define DW_TARGET_AVX __attribute__((target("avx")))
+#include <immintrin.h>
+#endif
+#endif
+
+// Planes split into components (and absolute normals for the AABB test), ready to broadcast.
+struct CullPlanes
+{
+	float x[6];
+	float y[6];
+	float z[6];
+	float w[6];
+	float abs_x[6];
+	float abs_y[6];
+	float abs_z[6];
+};
+
+typedef uint32_t (*CullFunction)(const CullPlanes& planes, const CullBounds& bounds, uint32_t begin, uint32_t end, uint32_t* visible);
+
+static const char* g_kernel_names[] =
+{
+	"auto",
+	"scalar",
+	"sse",
+	"avx"
+};
+
+void CullBounds::resize(size_t count)
+{
+	center_x.resize(count);
+	center_y.resize(count);
+	center_z.resize(count);
+	extent_x.resize(count);
+	extent_y.resize(count);
+	extent_z.resize(count);
+	radius.resize(count);
+}
+
+void extract_frustum(const glm::mat4& m, Frustum& frustum)
+{
+	// Rows of the matrix; glm stores columns.
+	glm::vec4 r0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 r1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 r2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 r3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	frustum.planes[0] = r3 + r0;
+	frustum.planes[1] = r3 - r0;
+	frustum.planes[2] = r3 + r1;
+	frustum.planes[3] = r3 - r1;
+	// Clip depth is 0..w, so the near plane is z >= 0 rather than z >= -w.
+	frustum.planes[4] = r2;
+	frustum.planes[5] = r3 - r2;
+
+	for (uint32_t i = 0; i < 6; i++)
+		frustum.planes[i] /= glm::length(glm::vec3(frustum.planes[i]));
+}
+
+static bool cpu_has_avx()
+{
+#if defined(DW_CULL_AVX) && defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 1);
+
+	// The OS also has to save the YMM registers.
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#elif defined(DW_CULL_AVX)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx") != 0;
+#else
+	return false;
+#endif
+}
+
+bool cull_kernel_supported(uint32_t kernel)
+{
+	switch (kernel)
+	{
+	case CullKernel::AUTO:
+	case CullKernel::SCALAR:
+		return true;
+#if defined(DW_CULL_SSE)
+	case CullKernel::SSE:
+		return true;
+#endif
+	case CullKernel::AVX:
+		return cpu_has_avx();
+	default:
+		return false;
+	}
+}
+
+const char* cull_kernel_name(uint32_t kernel)
+{
+	return kernel < CullKernel::COUNT ? g_kernel_names[kernel] : "unknown";
+}
+
+static uint32_t cull_spheres_scalar(const CullPlanes& planes, const CullBounds& bounds, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = begin; i < end; i++)
+	{
+		float cx = bounds.center_x[i];
+		float cy = bounds.center_y[i];
+		float cz = bounds.center_z[i];
+		float r = bounds.radius[i];
+		bool inside = true;
+
+		for (uint32_t p = 0; p < 6; p++)
+			inside &= planes.x[p] * cx + planes.y[p] * cy + planes.z[p] * cz + planes.w[p] >= -r;
+
+		// Branchless: always write, only advance for survivors.
+		visible[count] = i;
+		count += inside;
+	}
+
+	return count;
+}
+
+static uint32_t cull_aabbs_scalar(const CullPlanes& planes, const CullBounds& bounds, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	uint32_t count = 0;
+
+	for (uint32_t i = begin; i < end; i++)
+	{
+		float cx = bounds.center_x[i];
+		float cy = bounds.center_y[i];
+		float cz = bounds.center_z[i];
+		float ex = bounds.extent_x[i];
+		float ey = bounds.extent_y[i];
+		float ez = bounds.extent_z[i];
+		bool inside = true;
+
+		// The box is outside a plane only if its corner furthest along the normal is.
+		for (uint32_t p = 0; p < 6; p++)
+			inside &= planes.x[p] * cx + planes.y[p] * cy + planes.z[p] * cz + planes.w[p] >= -(planes.abs_x[p] * ex + planes.abs_y[p] * ey + planes.abs_z[p] * ez);
+
+		visible[count] = i;
+		count += inside;
+	}
+
+	return count;
+}
+
+#if defined(DW_CULL_SSE)
+static inline uint32_t emit_sse(int mask, uint32_t base, uint32_t* visible, uint32_t count)
+{
+	for (uint32_t lane = 0; lane < 4; lane++)
+	{
+		visible[count] = base + lane;
+		count += (mask >> lane) & 1;
+	}
+
+	return count;
+}
+
+static uint32_t cull_spheres_sse(const CullPlanes& planes, const CullBounds& bounds, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	__m128 px[6], py[6], pz[6], pw[6];
+
+	for (uint32_t p = 0; p < 6; p++)
+	{
+		px[p] = _mm_set1_ps(planes.x[p]);
+		py[p] = _mm_set1_ps(planes.y[p]);
+		pz[p] = _mm_set1_ps(planes.z[p]);
+		pw[p] = _mm_set1_ps(planes.w[p]);
+	}
+
+	uint32_t count = 0;
+	uint32_t i = begin;
+
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&bounds.center_x[i]);
+		__m128 cy = _mm_loadu_ps(&bounds.center_y[i]);
+		__m128 cz = _mm_loadu_ps(&bounds.center_z[i]);
+		__m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&bounds.radius[i]));
+		__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px[0], cx), _mm_mul_ps(py[0], cy)), _mm_add_ps(_mm_mul_ps(pz[0], cz), pw[0])), neg_r);
+
+		for (uint32_t p = 1; p < 6; p++)
+		{
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], cx), _mm_mul_ps(py[p], cy)), _mm_add_ps(_mm_mul_ps(pz[p], cz), pw[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, neg_r));
+		}
+
+		count = emit_sse(_mm_movemask_ps(inside), i, visible, count);
+	}
+
+	return count + cull_spheres_scalar(planes, bounds, i, end, visible + count);
+}
+
+static uint32_t cull_aabbs_sse(const CullPlanes& planes, const CullBounds& bounds, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	__m128 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+
+	for (uint32_t p = 0; p < 6; p++)
+	{
+		px[p] = _mm_set1_ps(planes.x[p]);
+		py[p] = _mm_set1_ps(planes.y[p]);
+		pz[p] = _mm_set1_ps(planes.z[p]);
+		pw[p] = _mm_set1_ps(planes.w[p]);
+		ax[p] = _mm_set1_ps(planes.abs_x[p]);
+		ay[p] = _mm_set1_ps(planes.abs_y[p]);
+		az[p] = _mm_set1_ps(planes.abs_z[p]);
+	}
+
+	uint32_t count = 0;
+	uint32_t i = begin;
+
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&bounds.center_x[i]);
+		__m128 cy = _mm_loadu_ps(&bounds.center_y[i]);
+		__m128 cz = _mm_loadu_ps(&bounds.center_z[i]);
+		__m128 ex = _mm_loadu_ps(&bounds.extent_x[i]);
+		__m128 ey = _mm_loadu_ps(&bounds.extent_y[i]);
+		__m128 ez = _mm_loadu_ps(&bounds.extent_z[i]);
+		__m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], cx), _mm_mul_ps(py[p], cy)), _mm_add_ps(_mm_mul_ps(pz[p], cz), pw[p]));
+			__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+		}
+
+		count = emit_sse(_mm_movemask_ps(inside), i, visible, count);
+	}
+
+	return count + cull_aabbs_scalar(planes, bounds, i, end, visible + count);
+}
+#endif
+
+#if defined(DW_CULL_AVX)
+DW_TARGET_AVX static uint32_t cull_spheres_avx(const CullPlanes& planes, const CullBounds& bounds, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	__m256 px[6], py[6], pz[6], pw[6];
+
+	for (uint32_t p = 0; p < 6; p++)
+	{
+		px[p] = _mm256_set1_ps(planes.x[p]);
+		py[p] = _mm256_set1_ps(planes.y[p]);
+		pz[p] = _mm256_set1_ps(planes.z[p]);
+		pw[p] = _mm256_set1_ps(planes.w[p]);
+	}
+
+	uint32_t count = 0;
+	uint32_t i = begin;
+
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 cx = _mm256_loadu_ps(&bounds.center_x[i]);
+		__m256 cy = _mm256_loadu_ps(&bounds.center_y[i]);
+		__m256 cz = _mm256_loadu_ps(&bounds.center_z[i]);
+		__m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&bounds.radius[i]));
+		__m256 inside = _mm256_cmp_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[0], cx), _mm256_mul_ps(py[0], cy)), _mm256_add_ps(_mm256_mul_ps(pz[0], cz), pw[0])), neg_r, _CMP_GE_OQ);
+
+		for (uint32_t p = 1; p < 6; p++)
+		{
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], cx), _mm256_mul_ps(py[p], cy)), _mm256_add_ps(_mm256_mul_ps(pz[p], cz), pw[p]));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, neg_r, _CMP_GE_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(inside);
+
+		for (uint32_t lane = 0; lane < 8; lane++)
+		{
+			visible[count] = i + lane;
+			count += (mask >> lane) & 1;
+		}
+	}
+
+	return count + cull_spheres_scalar(planes, bounds, i, end, visible + count);
+}
+
+DW_TARGET_AVX static uint32_t cull_aabbs_avx(const CullPlanes& planes, const CullBounds& bounds, uint32_t begin, uint32_t end, uint32_t* visible)
+{
+	__m256 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+
+	for (uint32_t p = 0; p < 6; p++)
+	{
+		px[p] = _mm256_set1_ps(planes.x[p]);
+		py[p] = _mm256_set1_ps(planes.y[p]);
+		pz[p] = _mm256_set1_ps(planes.z[p]);
+		pw[p] = _mm256_set1_ps(planes.w[p]);
+		ax[p] = _mm256_set1_ps(planes.abs_x[p]);
+		ay[p] = _mm256_set1_ps(planes.abs_y[p]);
+		az[p] = _mm256_set1_ps(planes.abs_z[p]);
+	}
+
+	uint32_t count = 0;
+	uint32_t i = begin;
+
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 cx = _mm256_loadu_ps(&bounds.center_x[i]);
+		__m256 cy = _mm256_loadu_ps(&bounds.center_y[i]);
+		__m256 cz = _mm256_loadu_ps(&bounds.center_z[i]);
+		__m256 ex = _mm256_loadu_ps(&bounds.extent_x[i]);
+		__m256 ey = _mm256_loadu_ps(&bounds.extent_y[i]);
+		__m256 ez = _mm256_loadu_ps(&bounds.extent_z[i]);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+		for (uint32_t p = 0; p < 6; p++)
+		{
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], cx), _mm256_mul_ps(py[p], cy)), _mm256_add_ps(_mm256_mul_ps(pz[p], cz), pw[p]));
+			__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)), _mm256_mul_ps(az[p], ez));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(inside);
+
+		for (uint32_t lane = 0; lane < 8; lane++)
+		{
+			visible[count] = i + lane;
+			count += (mask >> lane) & 1;
+		}
+	}
+
+	return count + cull_aabbs_scalar(planes, bounds, i, end, visible + count);
+}
+#endif
+
+FrustumCuller::FrustumCuller() : m_pool(nullptr), m_kernel(CullKernel::SCALAR)
+{
+
+}
+
+void FrustumCuller::initialize(WorkerPool* pool, uint32_t kernel)
+{
+	m_pool = pool;
+
+	if (kernel == CullKernel::AUTO || !cull_kernel_supported(kernel))
+	{
+		kernel = CullKernel::SCALAR;
+
+		if (cull_kernel_supported(CullKernel::AVX))
+			kernel = CullKernel::AVX;
+		else if (cull_kernel_supported(CullKernel::SSE))
+			kernel = CullKernel::SSE;
+	}
+
+	m_kernel = kernel;
+}
+
+uint32_t FrustumCuller::cull_spheres(const Frustum& frustum, const CullBounds& bounds, std::vector<uint32_t>& visible)
+{
+	return cull(frustum, bounds, true, visible);
+}
+
+uint32_t FrustumCuller::cull_aabbs(const Frustum& frustum, const CullBounds& bounds, std::vector<uint32_t>& visible)
+{
+	return cull(frustum, bounds, false, visible);
+}
+
+uint32_t FrustumCuller::cull(const Frustum& frustum, const CullBounds& bounds, bool spheres, std::vector<uint32_t>& visible)
+{
+	CullFunction fn = spheres ? cull_spheres_scalar : cull_aabbs_scalar;
+
+#if defined(DW_CULL_SSE)
+	if (m_kernel == CullKernel::SSE)
+		fn = spheres ? cull_spheres_sse : cull_aabbs_sse;
+#endif
+#if defined(DW_CULL_AVX)
+	if (m_kernel == CullKernel::AVX)
+		fn = spheres ? cull_spheres_avx : cull_aabbs_avx;
+#endif
+
+	CullPlanes planes;
+
+	for (uint32_t p = 0; p < 6; p++)
+	{
+		planes.x[p] = frustum.planes[p].x;
+		planes.y[p] = frustum.planes[p].y;
+		planes.z[p] = frustum.planes[p].z;
+		planes.w[p] = frustum.planes[p].w;
+		planes.abs_x[p] = fabsf(planes.x[p]);
+		planes.abs_y[p] = fabsf(planes.y[p]);
+		planes.abs_z[p] = fabsf(planes.z[p]);
+	}
+
+	uint32_t count = (uint32_t)bounds.size();
+	uint32_t chunks = (count + DW_CULL_CHUNK - 1) / DW_CULL_CHUNK;
+
+	// Only grows, so steady state frames don't reallocate.
+	if (visible.size() < count)
+		visible.resize(count);
+
+	m_chunk_counts.resize(chunks);
+
+	// Ranges handed out by the pool start on chunk boundaries but may span several chunks.
+	auto work = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t chunk_begin = begin; chunk_begin < end; chunk_begin += DW_CULL_CHUNK)
+		{
+			uint32_t chunk_end = std::min(chunk_begin + DW_CULL_CHUNK, end);
+			m_chunk_counts[chunk_begin / DW_CULL_CHUNK] = fn(planes, bounds, chunk_begin, chunk_end, visible.data() + chunk_begin);
+		}
+	};
+
+	if (m_pool)
+		m_pool->parallel_for(count, DW_CULL_CHUNK, work);
+	else
+		work(0, count);
+
+	uint32_t visible_count = chunks > 0 ? m_chunk_counts[0] : 0;
+
+	for (uint32_t chunk = 1; chunk < chunks; chunk++)
+	{
+		memmove(visible.data() + visible_count, visible.data() + chunk * DW_CULL_CHUNK, m_chunk_counts[chunk] * sizeof(uint32_t));
+		visible_count += m_chunk_counts[chunk];
+	}
+
+	return visible_count;
+}
+
+void push_visible_draws(DrawStream& stream, const std::vector<uint32_t>& visible, uint32_t count, const DrawPacket* packets, const CullBounds& bounds, const glm::vec3& eye, const glm::vec3& forward)
+{
+	stream.reserve(stream.size() + count);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t object = visible[i];
+		DrawPacket packet = packets[object];
+
+		float depth = (bounds.center_x[object] - eye.x) * forward.x + (bounds.center_y[object] - eye.y) * forward.y + (bounds.center_z[object] - eye.z) * forward.z;
+		packet.key |= draw_depth_bits(depth);
+
+		stream.push(packet);
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "draw_stream.h"
+
+// Objects per parallel work item when culling.
+#define DW_CULL_CHUNK 16384
+
+class WorkerPool;
+
+namespace CullKernel
+{
+	enum
+	{
+		// The widest kernel the CPU supports.
+		AUTO,
+		SCALAR,
+		SSE,
+		AVX,
+		COUNT
+	};
+}
+
+// World space bounds in struct-of-arrays form, so the SIMD kernels load 4 or 8 objects per register.
+// Each object has both an AABB (center/extents) and the sphere enclosing it (center/radius).
+struct CullBounds
+{
+	std::vector<float> center_x;
+	std::vector<float> center_y;
+	std::vector<float> center_z;
+	std::vector<float> extent_x;
+	std::vector<float> extent_y;
+	std::vector<float> extent_z;
+	std::vector<float> radius;
+
+	void resize(size_t count);
+	inline size_t size() const { return radius.size(); }
+};
+
+// Normalized planes facing inwards: a point p is inside if dot(plane.xyz, p) + plane.w >= 0 for all six.
+struct Frustum
+{
+	glm::vec4 planes[6];
+};
+
+// For zero to one clip depth (Vulkan) projections.
+extern void extract_frustum(const glm::mat4& view_projection, Frustum& frustum);
+
+extern bool cull_kernel_supported(uint32_t kernel);
+extern const char* cull_kernel_name(uint32_t kernel);
+
+// Culls bounds against a frustum, spreading the work over a WorkerPool when given one. Each chunk
+// writes its survivors in place and the chunks are compacted afterwards, so the visible list is in
+// ascending index order regardless of the thread count.
+class FrustumCuller
+{
+public:
+	FrustumCuller();
+
+	// Unsupported kernels fall back to the best supported one.
+	void initialize(WorkerPool* pool, uint32_t kernel = CullKernel::AUTO);
+
+	uint32_t cull_spheres(const Frustum& frustum, const CullBounds& bounds, std::vector<uint32_t>& visible);
+	uint32_t cull_aabbs(const Frustum& frustum, const CullBounds& bounds, std::vector<uint32_t>& visible);
+
+	inline uint32_t kernel() const { return m_kernel; }
+
+private:
+	uint32_t cull(const Frustum& frustum, const CullBounds& bounds, bool spheres, std::vector<uint32_t>& visible);
+
+private:
+	WorkerPool*			  m_pool;
+	uint32_t			  m_kernel;
+	std::vector<uint32_t> m_chunk_counts;
+};
+
+// Feeds the visible objects to the renderer. packets holds one packet per object with the depth bits
+// of its key left at zero; they are filled in from the distance along the view direction, so
+// opaque passes draw front to back.
+extern void push_visible_draws(DrawStream& stream, const std::vector<uint32_t>& visible, uint32_t count, const DrawPacket* packets, const CullBounds& bounds, const glm::vec3& eye, const glm::vec3& forward);
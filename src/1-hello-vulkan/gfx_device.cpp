@@ -1,5 +1,6 @@
 #include "gfx_device.h"
 #include <assert.h>
+#include <string.h>
 #include <iostream>
 
 #define VK_CHECK_RESULT(f)																				\
@@ -23,11 +24,123 @@ namespace gfx
 		{ VK_FORMAT_R16_UINT, VK_FORMAT_R16G16_UINT, VK_FORMAT_R16G16B16_UINT, VK_FORMAT_R16G16B16A16_UINT },
 		{ VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT },
 		{ VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT },
+		{ VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_R16G16B16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT },
 	};
 
-	bool Device::Init()
+	// Used when InputElementDesc::normalized is set. Only 8 and 16-bit integer types can be normalized.
+	const VkFormat g_NormalizedInputAttribFormatTable[][4] =
 	{
-		return 0;
+		{ VK_FORMAT_R8_SNORM, VK_FORMAT_R8G8_SNORM, VK_FORMAT_R8G8B8_SNORM, VK_FORMAT_R8G8B8A8_SNORM },
+		{ VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM },
+		{ VK_FORMAT_R16_SNORM, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R16G16B16_SNORM, VK_FORMAT_R16G16B16A16_SNORM },
+		{ VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED },
+		{ VK_FORMAT_R16_UNORM, VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16A16_UNORM },
+		{ VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED },
+		{ VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED },
+		{ VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED },
+	};
+
+	// Indexed by PackedType, [normalized].
+	const VkFormat g_PackedInputAttribFormatTable[][2] =
+	{
+		{ VK_FORMAT_UNDEFINED, VK_FORMAT_UNDEFINED },
+		{ VK_FORMAT_A2B10G10R10_SINT_PACK32, VK_FORMAT_A2B10G10R10_SNORM_PACK32 },
+		{ VK_FORMAT_A2B10G10R10_UINT_PACK32, VK_FORMAT_A2B10G10R10_UNORM_PACK32 },
+	};
+
+	const uint32_t g_DataTypeSizeTable[] =
+	{
+		1, 1, 2, 4, 2, 4, 4, 2
+	};
+
+	static VkFormat InputAttribFormat(const InputElementDesc& element, uint32_t& columnSize)
+	{
+		VkFormat format;
+
+		if (element.packedType != PackedType::NONE)
+		{
+			format = g_PackedInputAttribFormatTable[element.packedType][element.normalized ? 1 : 0];
+			columnSize = 4;
+		}
+		else
+		{
+			assert(element.numSubElements > 0);
+			assert(element.numSubElements <= 4);
+			assert(element.type < DataType::COUNT);
+
+			if (element.normalized)
+				format = g_NormalizedInputAttribFormatTable[element.type][element.numSubElements - 1];
+			else
+				format = g_InputAttribFormatTable[element.type][element.numSubElements - 1];
+
+			columnSize = element.numSubElements * g_DataTypeSizeTable[element.type];
+		}
+
+		assert(format != VK_FORMAT_UNDEFINED);
+
+		return format;
+	}
+
+	Device::Device() : m_VKPhysicalDevice(VK_NULL_HANDLE), m_VKDevice(VK_NULL_HANDLE), m_Queue(nullptr), m_SwapChainFramebuffers(nullptr),
+					   m_NonCoherentAtomSize(1), m_UploadPool(VK_NULL_HANDLE), m_UploadCmd(VK_NULL_HANDLE), m_LastUpload(0),
+					   m_Residency(nullptr)
+	{
+
+	}
+
+	bool Device::Init(VkPhysicalDevice physicalDevice, VkDevice device, QueueTimeline* queue, uint32_t queueFamily, ResidencyManager* residency)
+	{
+		m_VKPhysicalDevice = physicalDevice;
+		m_VKDevice = device;
+		m_Queue = queue;
+		m_Residency = residency;
+
+		m_Deletions.initialize(device);
+		m_MemoryPolicy.Init(physicalDevice);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		m_NonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		if (vkCreateCommandPool(m_VKDevice, &poolInfo, nullptr, &m_UploadPool) != VK_SUCCESS)
+			return false;
+
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = m_UploadPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(m_VKDevice, &allocInfo, &m_UploadCmd) != VK_SUCCESS)
+			return false;
+
+		std::cout << "Memory : " << (m_MemoryPolicy.IsUMA() ? "UMA, staging bypassed" : (m_MemoryPolicy.HasReBAR() ? "discrete with ReBAR" : "discrete")) << std::endl;
+
+		return true;
+	}
+
+	void Device::Shutdown()
+	{
+		if (m_StagingBuffer.valid())
+			DestroyBuffer(m_StagingBuffer);
+
+		m_StagingBuffer = BufferHandle();
+
+		if (m_Queue)
+			m_Queue->wait_idle();
+
+		m_Deletions.flush();
+
+		if (m_UploadPool != VK_NULL_HANDLE)
+			vkDestroyCommandPool(m_VKDevice, m_UploadPool, nullptr);
+
+		m_UploadPool = VK_NULL_HANDLE;
+		m_UploadCmd = VK_NULL_HANDLE;
 	}
 
 	//InputElement elements[] =
@@ -43,39 +156,72 @@ namespace gfx
 	//ilcd.num_elements = 2;
 	//ilcd.vertex_size = sizeof(float) * 6;
 
-	InputLayout* Device::CreateInputLayout(const InputLayoutCreateDesc& desc)
+	InputLayoutHandle Device::CreateInputLayout(const InputLayoutCreateDesc& desc)
 	{
-		InputLayout* il = new InputLayout();
-	
-		il->inputBindingDesc.binding = 0;
-		il->inputBindingDesc.stride = desc.vertexSize;
-		il->inputBindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		InputLayout* il = nullptr;
+		InputLayoutHandle handle = m_InputLayouts.create(&il);
+
+		if (desc.numBindings == 0)
+		{
+			il->numBindings = 1;
+			il->inputBindingDescs[0].binding = 0;
+			il->inputBindingDescs[0].stride = desc.vertexSize;
+			il->inputBindingDescs[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		}
+		else
+		{
+			assert(desc.numBindings <= DW_VK_MAX_INPUT_BINDINGS);
+
+			il->numBindings = desc.numBindings;
+
+			for (uint32_t i = 0; i < desc.numBindings; i++)
+			{
+				il->inputBindingDescs[i].binding = i;
+				il->inputBindingDescs[i].stride = desc.bindings[i].stride;
+				il->inputBindingDescs[i].inputRate = desc.bindings[i].inputRate == InputRate::PER_INSTANCE ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX;
+			}
+		}
+
+		uint32_t location = 0;
 
 		for (uint32_t i = 0; i < desc.numElements; i++)
 		{
-			il->inputAttribDescs[i].binding = 0;
-			il->inputAttribDescs[i].location = i;
-			
-			assert(desc.elements[i].numSubElements > 0);
-			assert(desc.elements[i].type >= 0);
-			assert(desc.elements[i].type < 7);
+			const InputElementDesc& element = desc.elements[i];
+
+			assert(element.binding < il->numBindings);
 
-			il->inputAttribDescs[i].format = g_InputAttribFormatTable[desc.elements[i].type][desc.elements[i].numSubElements - 1];
-			il->inputAttribDescs[i].offset = desc.elements[i].offset;
+			uint32_t numLocations = element.numLocations > 0 ? element.numLocations : 1;
+			uint32_t columnSize = 0;
+			VkFormat format = InputAttribFormat(element, columnSize);
+
+			// Matrices and arrays take one location per column, each column laid out right after the previous one.
+			for (uint32_t j = 0; j < numLocations; j++)
+			{
+				assert(location < DW_VK_MAX_INPUT_ATTRIB);
+
+				il->inputAttribDescs[location].binding = element.binding;
+				il->inputAttribDescs[location].location = location;
+				il->inputAttribDescs[location].format = format;
+				il->inputAttribDescs[location].offset = element.offset + j * columnSize;
+				location++;
+			}
 		}
 
+		il->numAttribs = location;
+
 		il->inputStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		il->inputStateInfo.vertexBindingDescriptionCount = 1;
-		il->inputStateInfo.pVertexBindingDescriptions = &il->inputBindingDesc;
-		il->inputStateInfo.vertexAttributeDescriptionCount = desc.numElements;
+		il->inputStateInfo.vertexBindingDescriptionCount = il->numBindings;
+		il->inputStateInfo.pVertexBindingDescriptions = &il->inputBindingDescs[0];
+		il->inputStateInfo.vertexAttributeDescriptionCount = il->numAttribs;
 		il->inputStateInfo.pVertexAttributeDescriptions = &il->inputAttribDescs[0];
 
-		return il;
+		return handle;
 	}
 
-	Shader* Device::CreateShader(const ShaderCreateDesc& desc)
+	ShaderHandle Device::CreateShader(const ShaderCreateDesc& desc)
 	{
-		Shader* shader = new Shader();
+		Shader* shader = nullptr;
+		ShaderHandle handle = m_Shaders.create(&shader);
 
 		//VkShaderModuleCreateInfo moduleCreateInfo{};
 		//moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -86,11 +232,379 @@ namespace gfx
 
 		//VK_CHECK_RESULT(vkCreateShaderModule(m_Device, &moduleCreateInfo, NULL, &shader->module));
 
-		return shader;
+		return handle;
+	}
+
+	void Device::DestroyInputLayout(InputLayoutHandle handle)
+	{
+		m_InputLayouts.destroy(handle);
+	}
+
+	void Device::DestroyShader(ShaderHandle handle)
+	{
+		Shader& shader = m_Shaders.lookup(handle);
+
+		if (shader.m_VKModule != VK_NULL_HANDLE)
+		{
+			CollectDeletions();
+			m_Deletions.destroy_shader_module(shader.m_VKModule);
+		}
+
+		m_Shaders.destroy(handle);
+	}
+
+	bool Device::AllocateBuffer(VkDeviceSize size, VkBufferUsageFlags usageFlags, uint32_t usage, uint32_t placement, bool makeRoom, Buffer& buffer)
+	{
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		// Always allow transfers, so staged uploads and readback copies work regardless of placement.
+		bufferInfo.usage = usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VkBuffer vkBuffer;
+
+		if (vkCreateBuffer(m_VKDevice, &bufferInfo, nullptr, &vkBuffer) != VK_SUCCESS)
+			return false;
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(m_VKDevice, vkBuffer, &requirements);
+
+		MemoryPlacement memoryPlacement;
+		bool found = placement == Placement::AUTO ? m_MemoryPolicy.Choose(usage, requirements.memoryTypeBits, memoryPlacement)
+												  : m_MemoryPolicy.ChoosePlacement(placement, requirements.memoryTypeBits, memoryPlacement);
+
+		// Demotes least recently used streamable buffers first. If not enough could be freed the
+		// allocation still goes ahead and the driver pages.
+		if (found && makeRoom && m_Residency)
+			m_Residency->make_room(m_Residency->heap_for_memory_type(memoryPlacement.memoryType), requirements.size);
+
+		VkMemoryAllocateInfo memoryInfo = {};
+		memoryInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memoryInfo.allocationSize = requirements.size;
+		memoryInfo.memoryTypeIndex = memoryPlacement.memoryType;
+
+		VkDeviceMemory memory;
+
+		if (!found || vkAllocateMemory(m_VKDevice, &memoryInfo, nullptr, &memory) != VK_SUCCESS)
+		{
+			vkDestroyBuffer(m_VKDevice, vkBuffer, nullptr);
+			return false;
+		}
+
+		VK_CHECK_RESULT(vkBindBufferMemory(m_VKDevice, vkBuffer, memory, 0));
+
+		buffer.buffer = vkBuffer;
+		buffer.memory = memory;
+		buffer.size = size;
+		buffer.placement = memoryPlacement.placement;
+		buffer.coherent = (memoryPlacement.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+		buffer.mapped = nullptr;
+		buffer.usageFlags = usageFlags;
+		buffer.allocationSize = requirements.size;
+		buffer.memoryType = memoryPlacement.memoryType;
+
+		// Staged buffers are never mapped, even if the memory type happens to be host visible.
+		if (memoryPlacement.placement != Placement::DEVICE_LOCAL_STAGED && (memoryPlacement.flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+			VK_CHECK_RESULT(vkMapMemory(m_VKDevice, memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped));
+
+		return true;
+	}
+
+	BufferHandle Device::CreateBuffer(const BufferCreateDesc& desc)
+	{
+		// Memory released by earlier destroys is given back before allocating more.
+		CollectDeletions();
+
+		Buffer allocated = {};
+
+		if (!AllocateBuffer(desc.size, desc.usageFlags, desc.usage, desc.placement, true, allocated))
+			return BufferHandle();
+
+		Buffer* buffer = nullptr;
+		BufferHandle handle = m_Buffers.create(&buffer);
+
+		*buffer = allocated;
+
+		if (m_Residency)
+		{
+			uint32_t category = desc.usage == BufferUsage::STAGING ? MemoryCategory::STAGING : (desc.texels ? MemoryCategory::TEXTURE : MemoryCategory::BUFFER);
+			uint32_t heap = m_Residency->heap_for_memory_type(buffer->memoryType);
+
+			buffer->residency = m_Residency->register_resource(category, heap, buffer->allocationSize, desc.streamable, &Device::DemoteBufferCallback, this);
+
+			if (m_ResidentBuffers.size() <= buffer->residency.index())
+				m_ResidentBuffers.resize(buffer->residency.index() + 1);
+
+			m_ResidentBuffers[buffer->residency.index()] = handle;
+		}
+
+		if (desc.data && !UpdateBuffer(handle, desc.data, desc.size))
+		{
+			DestroyBuffer(handle);
+			return BufferHandle();
+		}
+
+		return handle;
+	}
+
+	void Device::DestroyBuffer(BufferHandle handle)
+	{
+		Buffer& buffer = m_Buffers.lookup(handle);
+
+		// Only the CPU mapping goes away now, the GPU may still be reading the buffer.
+		if (buffer.mapped)
+			vkUnmapMemory(m_VKDevice, buffer.memory);
+
+		CollectDeletions();
+		m_Deletions.destroy_buffer(buffer.buffer);
+		m_Deletions.free_memory(buffer.memory);
+
+		if (buffer.residency.valid())
+			m_Residency->unregister_resource(buffer.residency);
+
+		m_Buffers.destroy(handle);
+	}
+
+	void Device::TouchBuffer(BufferHandle handle)
+	{
+		Buffer& buffer = m_Buffers.lookup(handle);
+
+		if (buffer.residency.valid())
+			m_Residency->touch(buffer.residency);
+	}
+
+	bool Device::DemoteBufferCallback(Demotion& demotion)
+	{
+		return ((Device*)demotion.user_data)->DemoteBuffer(demotion);
+	}
+
+	// Moves the buffer to host memory, keeping its handle and contents. The old memory is released once
+	// the GPU is done with it.
+	bool Device::DemoteBuffer(Demotion& demotion)
+	{
+		Buffer& buffer = m_Buffers.lookup(m_ResidentBuffers[demotion.handle.index()]);
+
+		// Already as far down as it goes, or no queue to copy it on.
+		if (buffer.placement == Placement::HOST_MAPPED || !m_Queue)
+			return false;
+
+		Buffer demoted = {};
+
+		if (!AllocateBuffer(buffer.size, buffer.usageFlags, BufferUsage::STATIC, Placement::HOST_MAPPED, false, demoted))
+			return false;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(m_UploadCmd, &beginInfo);
+
+		VkBufferCopy region = { 0, 0, buffer.size };
+		vkCmdCopyBuffer(m_UploadCmd, buffer.buffer, demoted.buffer, 1, &region);
+
+		// The copy has to be visible to host reads through the mapping, not just to later GPU work.
+		VkBufferMemoryBarrier toHost = {};
+		toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		toHost.buffer = demoted.buffer;
+		toHost.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(m_UploadCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &toHost, 0, nullptr);
+
+		vkEndCommandBuffer(m_UploadCmd);
+
+		uint64_t point = m_Queue->submit(&m_UploadCmd, 1);
+
+		if (point == 0)
+		{
+			vkUnmapMemory(m_VKDevice, demoted.memory);
+			vkDestroyBuffer(m_VKDevice, demoted.buffer, nullptr);
+			vkFreeMemory(m_VKDevice, demoted.memory, nullptr);
+			return false;
+		}
+
+		// The upload command buffer is reused by the next upload or demotion.
+		m_LastUpload = point;
+		m_Queue->wait(m_LastUpload);
+
+		if (buffer.mapped)
+			vkUnmapMemory(m_VKDevice, buffer.memory);
+
+		CollectDeletions();
+		m_Deletions.destroy_buffer(buffer.buffer);
+		m_Deletions.free_memory(buffer.memory);
+
+		demoted.residency = buffer.residency;
+		buffer = demoted;
+
+		demotion.new_heap = m_Residency->heap_for_memory_type(buffer.memoryType);
+		demotion.new_size = buffer.allocationSize;
+
+		return true;
+	}
+
+	void Device::CollectDeletions()
+	{
+		// Without a queue nothing can be in flight.
+		if (!m_Queue)
+		{
+			m_Deletions.flush();
+			return;
+		}
+
+		m_Deletions.collect(m_Queue->completed());
+		m_Deletions.set_frame(m_Queue->next_point());
+	}
+
+	bool Device::UploadStaged(Buffer& buffer, const void* data, VkDeviceSize size, VkDeviceSize offset)
+	{
+		if (!m_StagingBuffer.valid() || m_Buffers.lookup(m_StagingBuffer).size < size)
+		{
+			if (m_StagingBuffer.valid())
+				DestroyBuffer(m_StagingBuffer);
+
+			BufferCreateDesc stagingDesc = {};
+			stagingDesc.size = size;
+			stagingDesc.usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			stagingDesc.usage = BufferUsage::STAGING;
+
+			m_StagingBuffer = CreateBuffer(stagingDesc);
+
+			// Out of host memory, or no host visible type: the next upload tries again.
+			if (!m_StagingBuffer.valid())
+				return false;
+
+			if (!m_Buffers.lookup(m_StagingBuffer).mapped)
+			{
+				DestroyBuffer(m_StagingBuffer);
+				m_StagingBuffer = BufferHandle();
+				return false;
+			}
+		}
+
+		Buffer& staging = m_Buffers.lookup(m_StagingBuffer);
+		memcpy(staging.mapped, data, (size_t)size);
+
+		if (!staging.coherent)
+		{
+			VkMappedMemoryRange range = {};
+			range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory = staging.memory;
+			range.offset = 0;
+			range.size = VK_WHOLE_SIZE;
+			vkFlushMappedMemoryRanges(m_VKDevice, 1, &range);
+		}
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(m_UploadCmd, &beginInfo);
+
+		VkBufferCopy region = { 0, offset, size };
+		vkCmdCopyBuffer(m_UploadCmd, staging.buffer, buffer.buffer, 1, &region);
+
+		vkEndCommandBuffer(m_UploadCmd);
+
+		uint64_t point = m_Queue->submit(&m_UploadCmd, 1);
+
+		// Submission failed (e.g. device lost): the destination never received the data.
+		if (point == 0)
+		{
+			std::cout << "Staged upload : submit failed" << std::endl;
+			return false;
+		}
+
+		// The staging buffer and command buffer are reused by the next upload.
+		m_LastUpload = point;
+		m_Queue->wait(m_LastUpload);
+
+		return true;
+	}
+
+	bool Device::UpdateBuffer(BufferHandle handle, const void* data, VkDeviceSize size, VkDeviceSize offset)
+	{
+		Buffer& buffer = m_Buffers.lookup(handle);
+
+		assert(offset + size <= buffer.size);
+
+		if (!buffer.mapped)
+			return UploadStaged(buffer, data, size, offset);
+
+		memcpy((uint8_t*)buffer.mapped + offset, data, (size_t)size);
+
+		if (!buffer.coherent)
+		{
+			VkMappedMemoryRange range = {};
+			range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory = buffer.memory;
+			range.offset = offset - offset % m_NonCoherentAtomSize;
+			range.size = VK_WHOLE_SIZE;
+			vkFlushMappedMemoryRanges(m_VKDevice, 1, &range);
+		}
+
+		return true;
+	}
+
+	void* Device::MapForRead(BufferHandle handle)
+	{
+		Buffer& buffer = m_Buffers.lookup(handle);
+
+		if (buffer.mapped && !buffer.coherent)
+		{
+			VkMappedMemoryRange range = {};
+			range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory = buffer.memory;
+			range.offset = 0;
+			range.size = VK_WHOLE_SIZE;
+			vkInvalidateMappedMemoryRanges(m_VKDevice, 1, &range);
+		}
+
+		return buffer.mapped;
 	}
 
 	Framebuffer* Device::DefaultFramebuffer()
 	{
 		return nullptr;
 	}
+
+	void CommandBuffer::BindVertexArray(VertexArray* vertexArray)
+	{
+		VkBuffer buffers[DW_VK_MAX_INPUT_BINDINGS];
+
+		for (uint32_t i = 0; i < vertexArray->numVertexBuffers; i++)
+			buffers[i] = vertexArray->vertexBuffers[i]->buffer;
+
+		vkCmdBindVertexBuffers(m_VKCommandBuffer, 0, vertexArray->numVertexBuffers, buffers, vertexArray->vertexBufferOffsets);
+
+		if (vertexArray->indexBuffer)
+		{
+			VkIndexType indexType = vertexArray->indexBuffer->dataType == DataType::UINT16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+			vkCmdBindIndexBuffer(m_VKCommandBuffer, vertexArray->indexBuffer->buffer, 0, indexType);
+		}
+	}
+
+	void CommandBuffer::Draw(uint32_t vertexCount, uint32_t firstVertex)
+	{
+		vkCmdDraw(m_VKCommandBuffer, vertexCount, 1, firstVertex, 0);
+	}
+
+	void CommandBuffer::DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex)
+	{
+		vkCmdDrawIndexed(m_VKCommandBuffer, indexCount, 1, firstIndex, baseVertex, 0);
+	}
+
+	void CommandBuffer::DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+	{
+		vkCmdDraw(m_VKCommandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+	}
+
+	void CommandBuffer::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+	{
+		vkCmdDrawIndexed(m_VKCommandBuffer, indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+	}
 }
\ No newline at end of file
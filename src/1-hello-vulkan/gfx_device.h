@@ -1,15 +1,61 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
-
-#define DW_VK_MAX_INPUT_ATTRIB 8
+#include "handle_pool.h"
+#include "memory_policy.h"
+#include "timeline.h"
+#include "deletion_queue.h"
+#include "residency_manager.h"
+
+#define DW_VK_MAX_INPUT_ATTRIB 16
+#define DW_VK_MAX_INPUT_BINDINGS 8
 #define DW_VK_MAX_RENDER_TARGETS 16
 
 namespace gfx
 {
+	// Order matches the rows of g_InputAttribFormatTable.
+	namespace DataType
+	{
+		enum
+		{
+			INT8,
+			UINT8,
+			INT16,
+			INT32,
+			UINT16,
+			UINT32,
+			FLOAT,
+			HALF_FLOAT,
+			COUNT
+		};
+	}
+
+	// Formats that pack all components into a single 32-bit word. When set on an
+	// InputElementDesc it overrides type and numSubElements.
+	namespace PackedType
+	{
+		enum
+		{
+			NONE,
+			INT_2_10_10_10,
+			UINT_2_10_10_10
+		};
+	}
+
+	namespace InputRate
+	{
+		enum
+		{
+			PER_VERTEX,
+			PER_INSTANCE
+		};
+	}
+
+	// A point on a queue timeline; complete once the timeline has reached it.
 	struct Fence
 	{
-		VkFence fence;
+		QueueTimeline* timeline;
+		uint64_t	   point;
 	};
 
 	struct Texture
@@ -42,9 +88,38 @@ namespace gfx
 
 	struct BufferCreateDesc
 	{
+		VkDeviceSize	   size;
+		VkBufferUsageFlags usageFlags;
+		// BufferUsage, drives the memory placement.
+		uint32_t		   usage;
+		// Placement::AUTO (0) unless a specific placement is wanted.
+		uint32_t		   placement;
+		// Optional initial contents, size bytes. CreateBuffer fails if they cannot be uploaded.
+		const void*		   data;
+		// Moved to host memory when its heap goes over budget (see Device::Init's residency manager).
+		bool			   streamable;
+		// Texel data kept in a buffer (e.g. streamed texture mips), tracked as texture memory.
+		bool			   texels;
+	};
 
+	struct Buffer
+	{
+		VkBuffer		   buffer;
+		VkDeviceMemory	   memory;
+		VkDeviceSize	   size;
+		uint32_t		   placement;
+		bool			   coherent;
+		// Persistently mapped for every placement except DEVICE_LOCAL_STAGED.
+		void*			   mapped;
+		VkBufferUsageFlags usageFlags;
+		VkDeviceSize	   allocationSize;
+		uint32_t		   memoryType;
+		// Invalid if the device has no residency manager.
+		ResidencyHandle	   residency;
 	};
 
+	typedef Handle<Buffer> BufferHandle;
+
 	struct VertexBuffer
 	{
 		VkBuffer	   buffer;
@@ -71,6 +146,18 @@ namespace gfx
 		bool		normalized;
 		uint32_t	offset;
 		const char* semanticName;
+		uint32_t	binding;
+		// Number of consecutive locations the element occupies, e.g. 4 for a mat4
+		// made of 4 vec4 columns. 0 is treated as 1.
+		uint32_t	numLocations;
+		// PackedType of the element; layouts listing only the fields above get plain types.
+		uint32_t	packedType = PackedType::NONE;
+	};
+
+	struct InputBindingDesc
+	{
+		uint32_t stride;
+		uint32_t inputRate;
 	};
 
 	struct InputLayoutCreateDesc
@@ -78,20 +165,31 @@ namespace gfx
 		InputElementDesc* elements;
 		uint32_t		  vertexSize;
 		uint32_t		  numElements;
+		// Optional. If numBindings is 0 a single per-vertex binding of vertexSize is used.
+		InputBindingDesc* bindings;
+		uint32_t		  numBindings;
 	};
 
 	struct InputLayout
 	{
-		VkVertexInputBindingDescription		 inputBindingDesc;
+		uint32_t							 numBindings;
+		uint32_t							 numAttribs;
+		VkVertexInputBindingDescription		 inputBindingDescs[DW_VK_MAX_INPUT_BINDINGS];
 		VkVertexInputAttributeDescription	 inputAttribDescs[DW_VK_MAX_INPUT_ATTRIB];
 		VkPipelineVertexInputStateCreateInfo inputStateInfo;
 	};
 
+	typedef Handle<InputLayout> InputLayoutHandle;
+
+	// One vertex buffer per binding of the layout. Bindings with a PER_INSTANCE
+	// input rate are advanced once per instance.
 	struct VertexArray
 	{
-		VertexBuffer* vertexBuffer;
-		IndexBuffer*  indexBuffer;
-		InputLayout*  layout;
+		VertexBuffer* vertexBuffers[DW_VK_MAX_INPUT_BINDINGS];
+		VkDeviceSize  vertexBufferOffsets[DW_VK_MAX_INPUT_BINDINGS];
+		uint32_t	  numVertexBuffers;
+		IndexBuffer*	  indexBuffer;
+		InputLayoutHandle layout;
 	};
 
 	struct ShaderCreateDesc
@@ -135,6 +233,8 @@ namespace gfx
 		char		   m_EntryPoint[16];
 	};
 
+	typedef Handle<Shader> ShaderHandle;
+
 	struct PipelineState
 	{
 		VkPipeline m_Pipeline;
@@ -163,6 +263,17 @@ namespace gfx
 
 	class CommandBuffer
 	{
+	public:
+		CommandBuffer(VkCommandBuffer cmd = VK_NULL_HANDLE) : m_VKCommandBuffer(cmd) {}
+
+		void BindVertexArray(VertexArray* vertexArray);
+		void Draw(uint32_t vertexCount, uint32_t firstVertex);
+		void DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex);
+		void DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+		void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance);
+
+		inline VkCommandBuffer Handle() { return m_VKCommandBuffer; }
+
 	private:
 		VkCommandBuffer m_VKCommandBuffer;
 	};
@@ -170,15 +281,54 @@ namespace gfx
 	class Device
 	{
 	private:
+		VkPhysicalDevice m_VKPhysicalDevice;
 		VkDevice m_VKDevice;
+		QueueTimeline* m_Queue;
 		Framebuffer* m_SwapChainFramebuffers;
 
+		HandlePool<InputLayout> m_InputLayouts;
+		HandlePool<Shader>		m_Shaders;
+		HandlePool<Buffer>		m_Buffers;
+
+		MemoryPolicy	m_MemoryPolicy;
+		VkDeviceSize	m_NonCoherentAtomSize;
+
+		// Synchronous uploads into DEVICE_LOCAL_STAGED buffers go through this staging buffer, which
+		// grows to the largest upload seen.
+		VkCommandPool	m_UploadPool;
+		VkCommandBuffer	m_UploadCmd;
+		// Timeline point of the last staged upload.
+		uint64_t		m_LastUpload;
+		BufferHandle	m_StagingBuffer;
+
+		// Destroyed buffers and shaders wait here until the queue is past every submission that may use them.
+		DeletionQueue	m_Deletions;
+
+		// Optional. Buffers are registered with it and make room for themselves before allocating.
+		ResidencyManager*	m_Residency;
+		// Buffer registered under each residency handle index, for demotions.
+		std::vector<BufferHandle>	m_ResidentBuffers;
+
+		void CollectDeletions();
+		bool AllocateBuffer(VkDeviceSize size, VkBufferUsageFlags usageFlags, uint32_t usage, uint32_t placement, bool makeRoom, Buffer& buffer);
+		bool DemoteBuffer(Demotion& demotion);
+		static bool DemoteBufferCallback(Demotion& demotion);
+		bool UploadStaged(Buffer& buffer, const void* data, VkDeviceSize size, VkDeviceSize offset);
+
 	public:
-		bool Init();
+		Device();
+
+		// Staged uploads are submitted to queue; queueFamily is its family and must support transfers.
+		// With a residency manager, every buffer is tracked by it and streamable ones can be demoted.
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, QueueTimeline* queue, uint32_t queueFamily, ResidencyManager* residency = nullptr);
+		void Shutdown();
+
+		inline const MemoryPolicy& Memory() const { return m_MemoryPolicy; }
 
 		// Creation
-		InputLayout* CreateInputLayout(const InputLayoutCreateDesc& desc);
-		Shader* CreateShader(const ShaderCreateDesc& desc);
+		InputLayoutHandle CreateInputLayout(const InputLayoutCreateDesc& desc);
+		ShaderHandle CreateShader(const ShaderCreateDesc& desc);
+		BufferHandle CreateBuffer(const BufferCreateDesc& desc);
 		PipelineState* CreatePipelineState(const PipelineStateCreateDesc& desc);
 		DescriptorHeap* CreateDescriptorHeap(const DescriptorHeapCreateDesc& desc);
 		DescriptorSet* CreateDescriptorSet(const DescriptorSetCreateDesc& desc);
@@ -186,5 +336,26 @@ namespace gfx
 		Framebuffer* CreateFramebuffer(const FramebufferCreateDesc& desc);
 
 		Framebuffer* DefaultFramebuffer();
+
+		// Destruction. Buffers and shaders are released once the queue completes the next submission, so
+		// work recorded with them before the call is still safe to submit.
+		void DestroyInputLayout(InputLayoutHandle handle);
+		void DestroyShader(ShaderHandle handle);
+		void DestroyBuffer(BufferHandle handle);
+
+		// Writes into mapped buffers directly and stages (synchronously) into device local ones. False if
+		// the staging buffer could not be created, in which case the buffer is left unchanged.
+		bool UpdateBuffer(BufferHandle handle, const void* data, VkDeviceSize size, VkDeviceSize offset = 0);
+		// Returns the mapped pointer, invalidated for CPU reads if the memory is not coherent.
+		// nullptr for DEVICE_LOCAL_STAGED buffers.
+		void* MapForRead(BufferHandle handle);
+		// Marks the buffer as used this frame, so it is the last to be demoted.
+		void TouchBuffer(BufferHandle handle);
+
+		// Lookup. Pointers stay valid until the handle is destroyed. A streamable buffer's VkBuffer and
+		// memory change when it is demoted, so look it up again after the residency manager evicts.
+		inline InputLayout* GetInputLayout(InputLayoutHandle handle) { return &m_InputLayouts.lookup(handle); }
+		inline Shader* GetShader(ShaderHandle handle) { return &m_Shaders.lookup(handle); }
+		inline Buffer* GetBuffer(BufferHandle handle) { return &m_Buffers.lookup(handle); }
 	};
 }
@@ -0,0 +1,119 @@
+#include "gpu_timer.h"
+#include <algorithm>
+
+GpuTimer::GpuTimer() : m_device(VK_NULL_HANDLE), m_pool(VK_NULL_HANDLE), m_period_ns(1.0), m_valid_mask(~0ull), m_slot(0), m_frame_ms(0.0)
+{
+
+}
+
+bool GpuTimer::initialize(VkPhysicalDevice physical_device, VkDevice device, uint32_t queue_family, uint32_t slots)
+{
+	m_device = device;
+
+	uint32_t family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count, nullptr);
+	std::vector<VkQueueFamilyProperties> families(family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count, families.data());
+
+	if (queue_family >= family_count || families[queue_family].timestampValidBits == 0)
+		return false;
+
+	uint32_t valid_bits = families[queue_family].timestampValidBits;
+	m_valid_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+	m_period_ns = properties.limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo pool_info = {};
+	pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	pool_info.queryCount = slots * DW_GPU_TIMER_MAX_SCOPES * 2;
+
+	if (vkCreateQueryPool(device, &pool_info, nullptr, &m_pool) != VK_SUCCESS)
+	{
+		m_pool = VK_NULL_HANDLE;
+		return false;
+	}
+
+	m_slots.assign(slots, Slot());
+	m_timestamps.resize(DW_GPU_TIMER_MAX_SCOPES * 2);
+	m_results.reserve(DW_GPU_TIMER_MAX_SCOPES);
+
+	return true;
+}
+
+void GpuTimer::shutdown()
+{
+	if (m_pool != VK_NULL_HANDLE)
+		vkDestroyQueryPool(m_device, m_pool, nullptr);
+
+	m_pool = VK_NULL_HANDLE;
+	m_slots.clear();
+}
+
+void GpuTimer::collect(uint32_t slot)
+{
+	if (m_pool == VK_NULL_HANDLE || m_slots[slot].scope_count == 0)
+		return;
+
+	Slot& s = m_slots[slot];
+	uint32_t count = s.scope_count * 2;
+
+	// No WAIT flag: the frame is known to be complete, anything else is a bug worth seeing as NOT_READY.
+	if (vkGetQueryPoolResults(m_device, m_pool, slot * DW_GPU_TIMER_MAX_SCOPES * 2, count, sizeof(uint64_t) * count, m_timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+		return;
+
+	m_results.clear();
+
+	uint64_t first = ~0ull;
+	uint64_t last = 0;
+
+	for (uint32_t i = 0; i < s.scope_count; i++)
+	{
+		uint64_t begin = m_timestamps[i * 2] & m_valid_mask;
+		uint64_t end = m_timestamps[i * 2 + 1] & m_valid_mask;
+
+		GpuScopeTiming timing = { s.names[i], (double)((end - begin) & m_valid_mask) * m_period_ns * 1e-6 };
+		m_results.push_back(timing);
+
+		first = std::min(first, begin);
+		last = std::max(last, end);
+	}
+
+	m_frame_ms = (double)((last - first) & m_valid_mask) * m_period_ns * 1e-6;
+	s.scope_count = 0;
+}
+
+void GpuTimer::begin_frame(VkCommandBuffer cmd, uint32_t slot)
+{
+	m_slot = slot;
+
+	if (m_pool == VK_NULL_HANDLE)
+		return;
+
+	m_slots[slot].scope_count = 0;
+	vkCmdResetQueryPool(cmd, m_pool, slot * DW_GPU_TIMER_MAX_SCOPES * 2, DW_GPU_TIMER_MAX_SCOPES * 2);
+}
+
+uint32_t GpuTimer::begin_scope(VkCommandBuffer cmd, const char* name)
+{
+	if (m_pool == VK_NULL_HANDLE || m_slots[m_slot].scope_count == DW_GPU_TIMER_MAX_SCOPES)
+		return DW_GPU_TIMER_MAX_SCOPES;
+
+	Slot& s = m_slots[m_slot];
+	uint32_t scope = s.scope_count++;
+
+	s.names[scope] = name;
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_pool, (m_slot * DW_GPU_TIMER_MAX_SCOPES + scope) * 2);
+
+	return scope;
+}
+
+void GpuTimer::end_scope(VkCommandBuffer cmd, uint32_t scope)
+{
+	if (scope >= DW_GPU_TIMER_MAX_SCOPES)
+		return;
+
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_pool, (m_slot * DW_GPU_TIMER_MAX_SCOPES + scope) * 2 + 1);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+
+// Scopes per frame. Each takes two timestamps.
+#define DW_GPU_TIMER_MAX_SCOPES 32
+
+struct GpuScopeTiming
+{
+	const char* name;
+	double		ms;
+};
+
+// Timestamp queries around named scopes of a frame's command buffer, one query range per frame
+// slot. Results are read once the slot's previous frame has completed, which begin_frame() of the
+// backend already waits for, so reading never stalls. Timings therefore lag DW_MAX_FRAMES_IN_FLIGHT
+// frames behind.
+class GpuTimer
+{
+public:
+	GpuTimer();
+
+	// Returns false if the queue family has no timestamps; the timer then records nothing and
+	// reports no results.
+	bool initialize(VkPhysicalDevice physical_device, VkDevice device, uint32_t queue_family, uint32_t slots);
+	void shutdown();
+
+	// Reads the results of the frame that last used slot. It must have completed.
+	void collect(uint32_t slot);
+
+	// Resets the slot's queries. Record before any scope and outside of render passes.
+	void begin_frame(VkCommandBuffer cmd, uint32_t slot);
+	// name must outlive the results (string literals). Returns the scope for end_scope().
+	uint32_t begin_scope(VkCommandBuffer cmd, const char* name);
+	void end_scope(VkCommandBuffer cmd, uint32_t scope);
+
+	// Scopes of the last collected frame, in the order they were begun.
+	inline const std::vector<GpuScopeTiming>& results() const { return m_results; }
+	// From the first timestamp to the last of the last collected frame. 0 if nothing was collected.
+	inline double frame_ms() const { return m_frame_ms; }
+	inline bool supported() const { return m_pool != VK_NULL_HANDLE; }
+
+private:
+	struct Slot
+	{
+		const char* names[DW_GPU_TIMER_MAX_SCOPES];
+		uint32_t	scope_count;
+	};
+
+	VkDevice					m_device;
+	VkQueryPool					m_pool;
+	double						m_period_ns;
+	uint64_t					m_valid_mask;
+	uint32_t					m_slot;
+	std::vector<Slot>			m_slots;
+	std::vector<uint64_t>		m_timestamps;
+	std::vector<GpuScopeTiming> m_results;
+	double						m_frame_ms;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <memory>
+#include <assert.h>
+
+// 32-bit handle: low bits index a pool slot, high bits carry the slot's generation at creation time.
+#define DW_HANDLE_INDEX_BITS 20
+#define DW_HANDLE_GENERATION_BITS (32 - DW_HANDLE_INDEX_BITS)
+#define DW_HANDLE_INDEX_MASK ((1u << DW_HANDLE_INDEX_BITS) - 1)
+#define DW_HANDLE_GENERATION_MASK ((1u << DW_HANDLE_GENERATION_BITS) - 1)
+#define DW_HANDLE_MAX_COUNT (1u << DW_HANDLE_INDEX_BITS)
+#define DW_INVALID_HANDLE 0
+// Payload is allocated in chunks of this many slots so it never moves once created.
+#define DW_HANDLE_POOL_CHUNK_BITS 8
+#define DW_HANDLE_POOL_CHUNK_SIZE (1u << DW_HANDLE_POOL_CHUNK_BITS)
+#define DW_HANDLE_POOL_NO_FREE_SLOT 0xFFFFFFFF
+
+// Typed so a handle for one resource type cannot be passed where another is expected.
+template <typename T>
+struct Handle
+{
+	uint32_t id;
+
+	Handle() : id(DW_INVALID_HANDLE) {}
+	explicit Handle(uint32_t value) : id(value) {}
+
+	inline uint32_t index() const { return id & DW_HANDLE_INDEX_MASK; }
+	inline uint32_t generation() const { return id >> DW_HANDLE_INDEX_BITS; }
+	inline bool valid() const { return id != DW_INVALID_HANDLE; }
+
+	inline bool operator==(const Handle& other) const { return id == other.id; }
+	inline bool operator!=(const Handle& other) const { return id != other.id; }
+};
+
+// Pool of T addressed by generational handles. Slot metadata is kept struct-of-arrays: generations
+// (touched by every lookup) and the free list live in their own dense arrays, apart from the payload,
+// so validation never pulls cold resource data into cache. Payload is stored in contiguous chunks that
+// are never reallocated, so pointers to it stay valid (resources such as InputLayout point into
+// themselves). Create and destroy are O(1) through an intrusive free list; destroying bumps the slot's
+// generation so older handles to it go stale. Lookups assert on stale handles in debug builds and skip
+// the check in release; destroy() always checks.
+template <typename T>
+class HandlePool
+{
+public:
+	explicit HandlePool(uint32_t initial_capacity = 64) : m_free_head(DW_HANDLE_POOL_NO_FREE_SLOT), m_live_count(0)
+	{
+		m_generations.reserve(initial_capacity);
+		m_next_free.reserve(initial_capacity);
+	}
+
+	Handle<T> create(T** data = nullptr)
+	{
+		uint32_t index;
+
+		if (m_free_head != DW_HANDLE_POOL_NO_FREE_SLOT)
+		{
+			index = m_free_head;
+			m_free_head = m_next_free[index];
+			m_next_free[index] = DW_HANDLE_POOL_NO_FREE_SLOT;
+			slot(index) = T();
+		}
+		else
+		{
+			assert(m_generations.size() < DW_HANDLE_MAX_COUNT);
+
+			index = (uint32_t)m_generations.size();
+
+			if ((index & (DW_HANDLE_POOL_CHUNK_SIZE - 1)) == 0)
+				m_chunks.emplace_back(new T[DW_HANDLE_POOL_CHUNK_SIZE]());
+
+			// Generation 0 is never handed out so that a zero id is always invalid.
+			m_generations.push_back(1);
+			m_next_free.push_back(DW_HANDLE_POOL_NO_FREE_SLOT);
+		}
+
+		m_live_count++;
+
+		if (data)
+			*data = &slot(index);
+
+		return Handle<T>((m_generations[index] << DW_HANDLE_INDEX_BITS) | index);
+	}
+
+	// Stale handles are ignored (and assert in debug builds): freeing the slot again would put it on
+	// the free list twice.
+	void destroy(Handle<T> handle)
+	{
+		bool valid = is_valid(handle);
+		assert(valid);
+
+		if (!valid)
+			return;
+
+		uint32_t index = handle.index();
+		uint32_t generation = (m_generations[index] + 1) & DW_HANDLE_GENERATION_MASK;
+
+		m_generations[index] = generation == 0 ? 1 : generation;
+		m_next_free[index] = m_free_head;
+		m_free_head = index;
+		m_live_count--;
+	}
+
+	inline bool is_valid(Handle<T> handle) const
+	{
+		uint32_t index = handle.index();
+		return handle.valid() && index < m_generations.size() && m_generations[index] == handle.generation();
+	}
+
+	inline T& lookup(Handle<T> handle)
+	{
+		assert(is_valid(handle));
+		return slot(handle.index());
+	}
+
+	inline const T& lookup(Handle<T> handle) const
+	{
+		assert(is_valid(handle));
+		return slot(handle.index());
+	}
+
+	// Returns nullptr instead of asserting, for callers that expect stale handles.
+	inline T* try_lookup(Handle<T> handle)
+	{
+		return is_valid(handle) ? &slot(handle.index()) : nullptr;
+	}
+
+	inline uint32_t size() const { return m_live_count; }
+	inline uint32_t capacity() const { return (uint32_t)m_chunks.size() * DW_HANDLE_POOL_CHUNK_SIZE; }
+
+private:
+	inline T& slot(uint32_t index) { return m_chunks[index >> DW_HANDLE_POOL_CHUNK_BITS][index & (DW_HANDLE_POOL_CHUNK_SIZE - 1)]; }
+	inline const T& slot(uint32_t index) const { return m_chunks[index >> DW_HANDLE_POOL_CHUNK_BITS][index & (DW_HANDLE_POOL_CHUNK_SIZE - 1)]; }
+
+	std::vector<std::unique_ptr<T[]>> m_chunks;
+	std::vector<uint32_t> m_generations;
+	std::vector<uint32_t> m_next_free;
+	uint32_t			  m_free_head;
+	uint32_t			  m_live_count;
+};
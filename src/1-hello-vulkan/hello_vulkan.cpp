@@ -8,7 +8,7 @@
 //		return true;
 //	}
 //
-//	virtual void render() override
+//	virtual void render(const FrameInfo& frame) override
 //	{
 //
 //	}
@@ -0,0 +1,205 @@
+#include "image_writer.h"
+#include <string.h>
+
+// Largest payload of a stored deflate block.
+#define DW_PNG_STORED_BLOCK_SIZE 65535
+
+static uint32_t g_crc_table[256];
+static bool g_crc_table_ready = false;
+
+static void build_crc_table()
+{
+	for (uint32_t n = 0; n < 256; n++)
+	{
+		uint32_t c = n;
+
+		for (int k = 0; k < 8; k++)
+			c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+
+		g_crc_table[n] = c;
+	}
+
+	g_crc_table_ready = true;
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t* data, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		crc = g_crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+static void put_u32_be(uint8_t* out, uint32_t value)
+{
+	out[0] = (uint8_t)(value >> 24);
+	out[1] = (uint8_t)(value >> 16);
+	out[2] = (uint8_t)(value >> 8);
+	out[3] = (uint8_t)value;
+}
+
+// Streams one PNG chunk; the CRC covers type and data.
+class ChunkWriter
+{
+public:
+	ChunkWriter(FILE* file, const char* type, uint32_t length) : m_file(file), m_crc(0xFFFFFFFFu)
+	{
+		uint8_t header[8];
+		put_u32_be(header, length);
+		memcpy(header + 4, type, 4);
+
+		fwrite(header, 1, 8, m_file);
+		m_crc = crc_update(m_crc, header + 4, 4);
+	}
+
+	void write(const uint8_t* data, size_t size)
+	{
+		fwrite(data, 1, size, m_file);
+		m_crc = crc_update(m_crc, data, size);
+	}
+
+	void finish()
+	{
+		uint8_t crc[4];
+		put_u32_be(crc, m_crc ^ 0xFFFFFFFFu);
+		fwrite(crc, 1, 4, m_file);
+	}
+
+private:
+	FILE*	 m_file;
+	uint32_t m_crc;
+};
+
+bool write_png(const char* path, const uint8_t* rgba, uint32_t width, uint32_t height)
+{
+	if (!g_crc_table_ready)
+		build_crc_table();
+
+	FILE* file = fopen(path, "wb");
+
+	if (!file)
+		return false;
+
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	fwrite(signature, 1, 8, file);
+
+	uint8_t ihdr[13];
+	put_u32_be(ihdr, width);
+	put_u32_be(ihdr + 4, height);
+	ihdr[8] = 8;  // bit depth
+	ihdr[9] = 6;  // RGBA
+	ihdr[10] = 0; // deflate
+	ihdr[11] = 0; // adaptive filtering
+	ihdr[12] = 0; // no interlace
+
+	ChunkWriter ihdr_chunk(file, "IHDR", 13);
+	ihdr_chunk.write(ihdr, 13);
+	ihdr_chunk.finish();
+
+	// Each row is prefixed with filter type 0 (none).
+	size_t row_size = (size_t)width * 4 + 1;
+	size_t raw_size = row_size * height;
+	size_t block_count = (raw_size + DW_PNG_STORED_BLOCK_SIZE - 1) / DW_PNG_STORED_BLOCK_SIZE;
+	size_t idat_size = 2 + block_count * 5 + raw_size + 4;
+
+	if (idat_size > 0x7FFFFFFFu)
+	{
+		fclose(file);
+		return false;
+	}
+
+	ChunkWriter idat(file, "IDAT", (uint32_t)idat_size);
+
+	static const uint8_t zlib_header[2] = { 0x78, 0x01 };
+	idat.write(zlib_header, 2);
+
+	uint32_t adler_a = 1;
+	uint32_t adler_b = 0;
+	size_t offset = 0;
+
+	while (offset < raw_size)
+	{
+		size_t block = raw_size - offset < DW_PNG_STORED_BLOCK_SIZE ? raw_size - offset : DW_PNG_STORED_BLOCK_SIZE;
+		bool last = offset + block == raw_size;
+
+		uint8_t block_header[5] = { (uint8_t)(last ? 1 : 0), (uint8_t)block, (uint8_t)(block >> 8), (uint8_t)~block, (uint8_t)(~block >> 8) };
+		idat.write(block_header, 5);
+
+		// Blocks do not line up with rows, so feed the row bytes (filter byte + pixels) through in pieces.
+		size_t end = offset + block;
+
+		while (offset < end)
+		{
+			size_t row = offset / row_size;
+			size_t column = offset % row_size;
+			size_t count = row_size - column < end - offset ? row_size - column : end - offset;
+
+			const uint8_t* src;
+			static const uint8_t filter = 0;
+
+			if (column == 0)
+			{
+				src = &filter;
+				count = 1;
+			}
+			else
+				src = rgba + row * (row_size - 1) + (column - 1);
+
+			idat.write(src, count);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				adler_a = (adler_a + src[i]) % 65521;
+				adler_b = (adler_b + adler_a) % 65521;
+			}
+
+			offset += count;
+		}
+	}
+
+	uint8_t adler[4];
+	put_u32_be(adler, (adler_b << 16) | adler_a);
+	idat.write(adler, 4);
+	idat.finish();
+
+	ChunkWriter iend(file, "IEND", 0);
+	iend.finish();
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+
+	return ok;
+}
+
+bool write_raw_frame(FILE* file, const RawFrameHeader& header, const uint8_t* pixels)
+{
+	size_t size = (size_t)header.width * header.height * header.bytes_per_pixel;
+
+	if (fwrite(&header, sizeof(header), 1, file) != 1)
+		return false;
+
+	return fwrite(pixels, 1, size, file) == size;
+}
+
+bool write_raw(const char* path, const RawFrameHeader& header, const uint8_t* pixels)
+{
+	FILE* file = fopen(path, "wb");
+
+	if (!file)
+		return false;
+
+	bool ok = write_raw_frame(file, header, pixels);
+	fclose(file);
+
+	return ok;
+}
+
+bool read_raw_frame(FILE* file, RawFrameHeader& header, std::vector<uint8_t>& pixels)
+{
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != DW_RAW_FRAME_MAGIC)
+		return false;
+
+	pixels.resize((size_t)header.width * header.height * header.bytes_per_pixel);
+
+	return fread(pixels.data(), 1, pixels.size(), file) == pixels.size();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#define DW_RAW_FRAME_MAGIC 0x46525744 // "DWRF"
+
+// Header written in front of every frame of a raw capture stream. Frames are self describing so a
+// stream survives resizes, and can be compared frame by frame without decoding anything.
+struct RawFrameHeader
+{
+	uint32_t magic;
+	uint32_t width;
+	uint32_t height;
+	// VkFormat of the pixels, tightly packed rows.
+	uint32_t format;
+	uint32_t bytes_per_pixel;
+	uint32_t reserved;
+	uint64_t frame;
+};
+
+// 8-bit RGBA, tightly packed. The zlib stream uses stored deflate blocks: no compression, but also
+// no dependency and no CPU spent on the capture thread beyond a CRC and an Adler-32.
+extern bool write_png(const char* path, const uint8_t* rgba, uint32_t width, uint32_t height);
+
+// Appends one frame (header + pixels) to an open raw stream.
+extern bool write_raw_frame(FILE* file, const RawFrameHeader& header, const uint8_t* pixels);
+extern bool write_raw(const char* path, const RawFrameHeader& header, const uint8_t* pixels);
+
+// Reads the next frame of a raw stream. Returns false at the end of the stream or on a bad header.
+extern bool read_raw_frame(FILE* file, RawFrameHeader& header, std::vector<uint8_t>& pixels);
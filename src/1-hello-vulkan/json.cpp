@@ -0,0 +1,329 @@
+#include "json.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace json
+{
+	static const Value g_null_value;
+
+	const Value& Value::operator[](const char* key) const
+	{
+		if (type != OBJECT)
+			return g_null_value;
+
+		auto it = object.find(key);
+		return it != object.end() ? it->second : g_null_value;
+	}
+
+	const Value& Value::operator[](size_t index) const
+	{
+		if (type != ARRAY || index >= array.size())
+			return g_null_value;
+
+		return array[index];
+	}
+
+	struct Parser
+	{
+		const char* cur;
+		const char* end;
+
+		void skip_whitespace()
+		{
+			while (cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r'))
+				cur++;
+		}
+
+		bool match(const char* literal)
+		{
+			size_t length = strlen(literal);
+
+			if ((size_t)(end - cur) < length || strncmp(cur, literal, length) != 0)
+				return false;
+
+			cur += length;
+			return true;
+		}
+
+		static void append_utf8(std::string& out, uint32_t cp)
+		{
+			if (cp < 0x80)
+				out += (char)cp;
+			else if (cp < 0x800)
+			{
+				out += (char)(0xC0 | (cp >> 6));
+				out += (char)(0x80 | (cp & 0x3F));
+			}
+			else if (cp < 0x10000)
+			{
+				out += (char)(0xE0 | (cp >> 12));
+				out += (char)(0x80 | ((cp >> 6) & 0x3F));
+				out += (char)(0x80 | (cp & 0x3F));
+			}
+			else
+			{
+				out += (char)(0xF0 | (cp >> 18));
+				out += (char)(0x80 | ((cp >> 12) & 0x3F));
+				out += (char)(0x80 | ((cp >> 6) & 0x3F));
+				out += (char)(0x80 | (cp & 0x3F));
+			}
+		}
+
+		bool parse_hex4(uint32_t& cp)
+		{
+			if (end - cur < 4)
+				return false;
+
+			cp = 0;
+
+			for (int i = 0; i < 4; i++)
+			{
+				char c = *cur++;
+				cp <<= 4;
+
+				if (c >= '0' && c <= '9')
+					cp |= c - '0';
+				else if (c >= 'a' && c <= 'f')
+					cp |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F')
+					cp |= c - 'A' + 10;
+				else
+					return false;
+			}
+
+			return true;
+		}
+
+		bool parse_string(std::string& out)
+		{
+			if (cur >= end || *cur != '"')
+				return false;
+
+			cur++;
+
+			while (cur < end && *cur != '"')
+			{
+				char c = *cur++;
+
+				if (c != '\\')
+				{
+					out += c;
+					continue;
+				}
+
+				if (cur >= end)
+					return false;
+
+				c = *cur++;
+
+				switch (c)
+				{
+				case '"': out += '"'; break;
+				case '\\': out += '\\'; break;
+				case '/': out += '/'; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'n': out += '\n'; break;
+				case 'r': out += '\r'; break;
+				case 't': out += '\t'; break;
+				case 'u':
+				{
+					uint32_t cp;
+					if (!parse_hex4(cp))
+						return false;
+
+					// Surrogate pair
+					if (cp >= 0xD800 && cp <= 0xDBFF && match("\\u"))
+					{
+						uint32_t low;
+						if (!parse_hex4(low))
+							return false;
+
+						cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+					}
+
+					append_utf8(out, cp);
+					break;
+				}
+				default:
+					return false;
+				}
+			}
+
+			if (cur >= end)
+				return false;
+
+			cur++;
+			return true;
+		}
+
+		bool parse_value(Value& value, int depth)
+		{
+			if (depth > 64)
+				return false;
+
+			skip_whitespace();
+
+			if (cur >= end)
+				return false;
+
+			switch (*cur)
+			{
+			case '{':
+			{
+				value.type = Value::OBJECT;
+				cur++;
+				skip_whitespace();
+
+				if (cur < end && *cur == '}')
+				{
+					cur++;
+					return true;
+				}
+
+				while (true)
+				{
+					skip_whitespace();
+
+					std::string key;
+					if (!parse_string(key))
+						return false;
+
+					skip_whitespace();
+
+					if (cur >= end || *cur != ':')
+						return false;
+
+					cur++;
+
+					if (!parse_value(value.object[key], depth + 1))
+						return false;
+
+					skip_whitespace();
+
+					if (cur < end && *cur == ',')
+						cur++;
+					else if (cur < end && *cur == '}')
+					{
+						cur++;
+						return true;
+					}
+					else
+						return false;
+				}
+			}
+			case '[':
+			{
+				value.type = Value::ARRAY;
+				cur++;
+				skip_whitespace();
+
+				if (cur < end && *cur == ']')
+				{
+					cur++;
+					return true;
+				}
+
+				while (true)
+				{
+					value.array.emplace_back();
+
+					if (!parse_value(value.array.back(), depth + 1))
+						return false;
+
+					skip_whitespace();
+
+					if (cur < end && *cur == ',')
+						cur++;
+					else if (cur < end && *cur == ']')
+					{
+						cur++;
+						return true;
+					}
+					else
+						return false;
+				}
+			}
+			case '"':
+				value.type = Value::STRING;
+				return parse_string(value.string);
+			case 't':
+				value.type = Value::BOOLEAN;
+				value.boolean = true;
+				return match("true");
+			case 'f':
+				value.type = Value::BOOLEAN;
+				value.boolean = false;
+				return match("false");
+			case 'n':
+				value.type = Value::NUL;
+				return match("null");
+			default:
+			{
+				// strtod needs a terminated string, numbers are short so copy them out.
+				char buffer[64];
+				size_t length = 0;
+
+				while (cur + length < end && length < sizeof(buffer) - 1 && strchr("+-0123456789.eE", cur[length]))
+					length++;
+
+				if (length == 0)
+					return false;
+
+				memcpy(buffer, cur, length);
+				buffer[length] = '\0';
+
+				char* number_end = nullptr;
+				value.type = Value::NUMBER;
+				value.number = strtod(buffer, &number_end);
+				cur += length;
+
+				return number_end == buffer + length;
+			}
+			}
+		}
+	};
+
+	bool parse(const char* text, size_t size, Value& value)
+	{
+		Parser parser = { text, text + size };
+
+		value = Value();
+
+		if (!parser.parse_value(value, 0))
+			return false;
+
+		parser.skip_whitespace();
+
+		return parser.cur == parser.end;
+	}
+
+	void write_string(std::string& out, const std::string& str)
+	{
+		out += '"';
+
+		for (char c : str)
+		{
+			switch (c)
+			{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20)
+				{
+					char escaped[8];
+					snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+					out += escaped;
+				}
+				else
+					out += c;
+			}
+		}
+
+		out += '"';
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace json
+{
+	// Minimal JSON DOM, enough for glTF headers and benchmark baselines. Not meant for large documents.
+	struct Value
+	{
+		enum Type
+		{
+			NUL,
+			BOOLEAN,
+			NUMBER,
+			STRING,
+			ARRAY,
+			OBJECT
+		};
+
+		Type						 type = NUL;
+		bool						 boolean = false;
+		double						 number = 0.0;
+		std::string					 string;
+		std::vector<Value>			 array;
+		std::map<std::string, Value> object;
+
+		// Returns a shared null value when the key or index does not exist, so lookups can be chained.
+		const Value& operator[](const char* key) const;
+		const Value& operator[](size_t index) const;
+
+		inline bool is_null() const { return type == NUL; }
+		inline size_t size() const { return type == ARRAY ? array.size() : (type == OBJECT ? object.size() : 0); }
+		inline double as_number(double fallback = 0.0) const { return type == NUMBER ? number : fallback; }
+		inline uint32_t as_uint(uint32_t fallback = 0) const { return type == NUMBER ? (uint32_t)number : fallback; }
+		inline const std::string& as_string() const { return string; }
+	};
+
+	extern bool parse(const char* text, size_t size, Value& value);
+
+	// Writes a string with JSON escaping, including the surrounding quotes.
+	extern void write_string(std::string& out, const std::string& str);
+}
@@ -0,0 +1,316 @@
+#include "light_clusters.h"
+#include "memory_policy.h"
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+
+// Clusters binned per workgroup of cluster_bin.comp, which also loads lights in batches of this many.
+#define DW_CLUSTER_GROUP_SIZE 128
+#define DW_INVALID_MEMORY_TYPE 0xFFFFFFFF
+
+LightClusters::LightClusters() : m_physical_device(VK_NULL_HANDLE), m_device(VK_NULL_HANDLE), m_max_lights(0), m_slot_count(0), m_set_layout(VK_NULL_HANDLE),
+								 m_pipeline_layout(VK_NULL_HANDLE), m_pipeline(VK_NULL_HANDLE), m_descriptor_pool(VK_NULL_HANDLE), m_counts({}), m_indices({})
+{
+	for (uint32_t i = 0; i < DW_CLUSTER_MAX_SLOTS; i++)
+		m_slots[i] = {};
+}
+
+bool LightClusters::initialize(VkPhysicalDevice physical_device, VkDevice device, const std::vector<char>& bin_spirv, uint32_t max_lights, uint32_t slots)
+{
+	m_physical_device = physical_device;
+	m_device = device;
+	m_max_lights = std::max(max_lights, 1u);
+	m_slot_count = std::min(slots, (uint32_t)DW_CLUSTER_MAX_SLOTS);
+
+	// 0: parameters, 1: lights, 2: lights per cluster, 3: light indices per cluster. Written by the
+	// binning pass, read by the fragment shaders.
+	VkDescriptorSetLayoutBinding bindings[4] = {};
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo set_layout_info = {};
+	set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	set_layout_info.bindingCount = 4;
+	set_layout_info.pBindings = bindings;
+
+	if (vkCreateDescriptorSetLayout(device, &set_layout_info, nullptr, &m_set_layout) != VK_SUCCESS)
+		return false;
+
+	VkPipelineLayoutCreateInfo layout_info = {};
+	layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layout_info.setLayoutCount = 1;
+	layout_info.pSetLayouts = &m_set_layout;
+
+	if (vkCreatePipelineLayout(device, &layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS)
+		return false;
+
+	VkShaderModuleCreateInfo module_info = {};
+	module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	module_info.codeSize = bin_spirv.size();
+	module_info.pCode = reinterpret_cast<const uint32_t*>(bin_spirv.data());
+
+	VkShaderModule module;
+	if (vkCreateShaderModule(device, &module_info, nullptr, &module) != VK_SUCCESS)
+		return false;
+
+	VkComputePipelineCreateInfo pipeline_info = {};
+	pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipeline_info.stage.module = module;
+	pipeline_info.stage.pName = "main";
+	pipeline_info.layout = m_pipeline_layout;
+	pipeline_info.basePipelineIndex = -1;
+
+	VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_pipeline);
+	vkDestroyShaderModule(device, module, nullptr);
+
+	if (result != VK_SUCCESS)
+	{
+		m_pipeline = VK_NULL_HANDLE;
+		return false;
+	}
+
+	if (!create_buffer(sizeof(uint32_t) * DW_CLUSTER_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false, m_counts) ||
+		!create_buffer(sizeof(uint32_t) * DW_CLUSTER_COUNT * DW_CLUSTER_MAX_LIGHTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false, m_indices))
+		return false;
+
+	for (uint32_t i = 0; i < m_slot_count; i++)
+	{
+		if (!create_buffer(sizeof(Params), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, true, m_slots[i].params) ||
+			!create_buffer(sizeof(Light) * m_max_lights, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true, m_slots[i].lights))
+			return false;
+	}
+
+	VkDescriptorPoolSize pool_sizes[2] =
+	{
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_slot_count },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_slot_count * 3 }
+	};
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets = m_slot_count;
+	pool_info.poolSizeCount = 2;
+	pool_info.pPoolSizes = pool_sizes;
+
+	if (vkCreateDescriptorPool(device, &pool_info, nullptr, &m_descriptor_pool) != VK_SUCCESS)
+		return false;
+
+	for (uint32_t i = 0; i < m_slot_count; i++)
+	{
+		Slot& slot = m_slots[i];
+
+		VkDescriptorSetAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		alloc_info.descriptorPool = m_descriptor_pool;
+		alloc_info.descriptorSetCount = 1;
+		alloc_info.pSetLayouts = &m_set_layout;
+
+		if (vkAllocateDescriptorSets(device, &alloc_info, &slot.set) != VK_SUCCESS)
+			return false;
+
+		VkDescriptorBufferInfo buffer_infos[4] =
+		{
+			{ slot.params.buffer, 0, VK_WHOLE_SIZE },
+			{ slot.lights.buffer, 0, VK_WHOLE_SIZE },
+			{ m_counts.buffer, 0, VK_WHOLE_SIZE },
+			{ m_indices.buffer, 0, VK_WHOLE_SIZE }
+		};
+
+		VkWriteDescriptorSet writes[4] = {};
+
+		for (uint32_t j = 0; j < 4; j++)
+		{
+			writes[j].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[j].dstSet = slot.set;
+			writes[j].dstBinding = j;
+			writes[j].descriptorCount = 1;
+			writes[j].descriptorType = bindings[j].descriptorType;
+			writes[j].pBufferInfo = &buffer_infos[j];
+		}
+
+		vkUpdateDescriptorSets(device, 4, writes, 0, nullptr);
+	}
+
+	return true;
+}
+
+void LightClusters::shutdown()
+{
+	for (uint32_t i = 0; i < m_slot_count; i++)
+	{
+		destroy_buffer(m_slots[i].params);
+		destroy_buffer(m_slots[i].lights);
+		m_slots[i] = {};
+	}
+
+	destroy_buffer(m_counts);
+	destroy_buffer(m_indices);
+
+	if (m_descriptor_pool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(m_device, m_descriptor_pool, nullptr);
+
+	if (m_pipeline != VK_NULL_HANDLE)
+		vkDestroyPipeline(m_device, m_pipeline, nullptr);
+
+	if (m_pipeline_layout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(m_device, m_pipeline_layout, nullptr);
+
+	if (m_set_layout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(m_device, m_set_layout, nullptr);
+
+	m_descriptor_pool = VK_NULL_HANDLE;
+	m_pipeline = VK_NULL_HANDLE;
+	m_pipeline_layout = VK_NULL_HANDLE;
+	m_set_layout = VK_NULL_HANDLE;
+}
+
+bool LightClusters::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, bool host_visible, Buffer& buffer)
+{
+	buffer = {};
+
+	VkBufferCreateInfo buffer_info = {};
+	buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_info.size = size;
+	buffer_info.usage = usage;
+	buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateBuffer(m_device, &buffer_info, nullptr, &buffer.buffer) != VK_SUCCESS)
+		return false;
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(m_device, buffer.buffer, &requirements);
+
+	gfx::MemoryPolicy policy;
+	policy.Init(m_physical_device);
+
+	// Rewritten every frame, so host visible ones go wherever the policy puts dynamic buffers.
+	gfx::MemoryPlacement placement = {};
+
+	if (host_visible)
+	{
+		if (!policy.Choose(gfx::BufferUsage::DYNAMIC, requirements.memoryTypeBits, placement))
+		{
+			destroy_buffer(buffer);
+			return false;
+		}
+	}
+	else
+	{
+		placement.memoryType = policy.FindType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		if (placement.memoryType == DW_INVALID_MEMORY_TYPE)
+		{
+			destroy_buffer(buffer);
+			return false;
+		}
+	}
+
+	VkMemoryAllocateInfo alloc_info = {};
+	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc_info.allocationSize = requirements.size;
+	alloc_info.memoryTypeIndex = placement.memoryType;
+
+	if (vkAllocateMemory(m_device, &alloc_info, nullptr, &buffer.memory) != VK_SUCCESS ||
+		vkBindBufferMemory(m_device, buffer.buffer, buffer.memory, 0) != VK_SUCCESS ||
+		(host_visible && vkMapMemory(m_device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped) != VK_SUCCESS))
+	{
+		destroy_buffer(buffer);
+		return false;
+	}
+
+	buffer.coherent = (placement.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+	return true;
+}
+
+void LightClusters::destroy_buffer(Buffer& buffer)
+{
+	if (buffer.buffer != VK_NULL_HANDLE)
+		vkDestroyBuffer(m_device, buffer.buffer, nullptr);
+
+	if (buffer.memory != VK_NULL_HANDLE)
+		vkFreeMemory(m_device, buffer.memory, nullptr);
+
+	buffer = {};
+}
+
+void LightClusters::flush(const Buffer& buffer)
+{
+	if (buffer.coherent)
+		return;
+
+	VkMappedMemoryRange range = {};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = buffer.memory;
+	range.offset = 0;
+	range.size = VK_WHOLE_SIZE;
+
+	vkFlushMappedMemoryRanges(m_device, 1, &range);
+}
+
+void LightClusters::update(uint32_t slot, const ClusterView& view, const Light* lights, uint32_t count)
+{
+	Slot& s = m_slots[slot];
+	count = std::min(count, m_max_lights);
+
+	float near_plane = std::max(view.near_plane, 1e-4f);
+	float far_plane = std::max(view.far_plane, near_plane * 1.001f);
+	float log_ratio = logf(far_plane / near_plane);
+
+	Params params = {};
+	memcpy(params.view, view.view, sizeof(params.view));
+	memcpy(params.camera_position, view.position, sizeof(view.position));
+
+	params.projection[0] = view.tan_half_fov_y * view.aspect;
+	params.projection[1] = view.tan_half_fov_y;
+	params.projection[2] = near_plane;
+	params.projection[3] = far_plane;
+
+	// Slice k starts at near * (far / near)^(k / Z): equal ratios, so froxels stay roughly cubic.
+	params.slicing[0] = DW_CLUSTER_Z / log_ratio;
+	params.slicing[1] = -DW_CLUSTER_Z * logf(near_plane) / log_ratio;
+	params.slicing[2] = (float)std::max(view.width, 1u) / DW_CLUSTER_X;
+	params.slicing[3] = (float)std::max(view.height, 1u) / DW_CLUSTER_Y;
+
+	params.grid[0] = DW_CLUSTER_X;
+	params.grid[1] = DW_CLUSTER_Y;
+	params.grid[2] = DW_CLUSTER_Z;
+	params.grid[3] = count;
+	params.limits[0] = DW_CLUSTER_MAX_LIGHTS;
+
+	memcpy(s.params.mapped, &params, sizeof(Params));
+
+	if (count > 0)
+		memcpy(s.lights.mapped, lights, sizeof(Light) * count);
+
+	flush(s.params);
+	flush(s.lights);
+}
+
+void LightClusters::record(VkCommandBuffer cmd, uint32_t slot)
+{
+	// The grid is shared between slots: wait for earlier frames on the queue to stop reading it, and
+	// order the writes after those of the previous binning.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &m_slots[slot].set, 0, nullptr);
+	vkCmdDispatch(cmd, (DW_CLUSTER_COUNT + DW_CLUSTER_GROUP_SIZE - 1) / DW_CLUSTER_GROUP_SIZE, 1, 1);
+
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
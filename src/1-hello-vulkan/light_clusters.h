@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+
+// Froxel grid: screen tiles (16x9 fits a 16:9 view) by depth slices. The shaders read the
+// dimensions from the cluster parameters, so these can change without touching them.
+#define DW_CLUSTER_X 16
+#define DW_CLUSTER_Y 9
+#define DW_CLUSTER_Z 24
+#define DW_CLUSTER_COUNT (DW_CLUSTER_X * DW_CLUSTER_Y * DW_CLUSTER_Z)
+// Light indices a cluster can hold. Lights binned past it are dropped from that cluster.
+#define DW_CLUSTER_MAX_LIGHTS 256
+#define DW_CLUSTER_MAX_SLOTS 4
+
+namespace LightType
+{
+	enum
+	{
+		POINT,
+		SPOT
+	};
+}
+
+// As laid out (std430) in the light buffer of cluster_bin.comp and clustered.frag.
+struct Light
+{
+	float	 position[3];
+	// Distance at which the light has faded out completely, also what it is binned by.
+	float	 range;
+	float	 color[3];
+	uint32_t type;
+	// Spot lights only: where the cone points (normalized) and the cosines of its inner and outer half
+	// angles.
+	float	 direction[3];
+	float	 cos_inner;
+	float	 cos_outer;
+	float	 padding[3];
+};
+
+// The camera the grid is built for. The projection must be a symmetric perspective one with the
+// y flip Vulkan needs, as from glm::perspective() with [1][1] negated.
+struct ClusterView
+{
+	// World to view, column-major. The camera looks down -z.
+	float	 view[16];
+	float	 position[3];
+	float	 tan_half_fov_y;
+	float	 aspect;
+	float	 near_plane;
+	float	 far_plane;
+	// Of the viewport shaded with the clusters, in pixels.
+	uint32_t width;
+	uint32_t height;
+};
+
+// Clustered forward lighting. A compute pass bins the frame's lights into a froxel grid, screen
+// tiles split into depth slices spaced exponentially from the near to the far plane, so each
+// cluster lists the lights whose volume touches it. Fragment shaders then find their cluster from
+// the pixel and view depth and loop over just those lights; see clustered.frag. Shading cost scales
+// with how many lights overlap a cluster rather than with how many there are or how objects are
+// split up, and there are no per-object light lists to maintain.
+//
+// Lights and the view are written by the CPU into host visible buffers per frame slot. The grid is
+// device local and shared by all slots: binning waits for the fragment shading of earlier frames on
+// the queue, so binning and shading must be recorded on the same queue.
+class LightClusters
+{
+public:
+	LightClusters();
+
+	// At most max_lights are binned per frame.
+	bool initialize(VkPhysicalDevice physical_device, VkDevice device, const std::vector<char>& bin_spirv, uint32_t max_lights, uint32_t slots);
+	// The device must be idle.
+	void shutdown();
+
+	// Copies the view and lights into the slot's buffers, whose previous frame must have completed.
+	// Lights past max_lights are ignored.
+	void update(uint32_t slot, const ClusterView& view, const Light* lights, uint32_t count);
+
+	// Bins the slot's lights. Record outside of render passes, before the draws that shade with them.
+	void record(VkCommandBuffer cmd, uint32_t slot);
+
+	// Layout of the set the shading pipelines bind (at set 0 in clustered.frag), and the slot's set.
+	inline VkDescriptorSetLayout set_layout() const { return m_set_layout; }
+	inline VkDescriptorSet descriptor_set(uint32_t slot) const { return m_slots[slot].set; }
+	inline uint32_t max_lights() const { return m_max_lights; }
+
+private:
+	// Mirrors ClusterParams of the shaders (std140).
+	struct Params
+	{
+		float	 view[16];
+		float	 camera_position[4];
+		// tan of the half field of view in x and y, near, far.
+		float	 projection[4];
+		// Slice scale and bias (slice = log(depth) * scale + bias), tile size in pixels.
+		float	 slicing[4];
+		// Grid dimensions, light count.
+		uint32_t grid[4];
+		// Light indices per cluster.
+		uint32_t limits[4];
+	};
+
+	struct Buffer
+	{
+		VkBuffer	   buffer;
+		VkDeviceMemory memory;
+		void*		   mapped;
+		bool		   coherent;
+	};
+
+	struct Slot
+	{
+		Buffer			params;
+		Buffer			lights;
+		VkDescriptorSet set;
+	};
+
+	bool create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, bool host_visible, Buffer& buffer);
+	void destroy_buffer(Buffer& buffer);
+	void flush(const Buffer& buffer);
+
+private:
+	VkPhysicalDevice	  m_physical_device;
+	VkDevice			  m_device;
+	uint32_t			  m_max_lights;
+	uint32_t			  m_slot_count;
+	VkDescriptorSetLayout m_set_layout;
+	VkPipelineLayout	  m_pipeline_layout;
+	VkPipeline			  m_pipeline;
+	VkDescriptorPool	  m_descriptor_pool;
+	// Lights per cluster, and DW_CLUSTER_MAX_LIGHTS light indices per cluster.
+	Buffer				  m_counts;
+	Buffer				  m_indices;
+	Slot				  m_slots[DW_CLUSTER_MAX_SLOTS];
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <assert.h>
+
+// Bounded multi-producer multi-consumer queue (Vyukov). Each cell carries a sequence number that
+// tells producers and consumers whether it is free or filled for their lap of the ring, so push
+// and pop only contend on a single atomic each and never take a lock.
+template <typename T>
+class LockFreeQueue
+{
+public:
+	explicit LockFreeQueue(size_t capacity) : m_cells(new Cell[capacity]), m_mask(capacity - 1), m_enqueue_pos(0), m_dequeue_pos(0)
+	{
+		// Capacity must be a power of two.
+		assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+
+		for (size_t i = 0; i < capacity; i++)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	LockFreeQueue(const LockFreeQueue&) = delete;
+	LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+	// Returns false if the queue is full.
+	bool push(const T& value)
+	{
+		size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true)
+		{
+			cell = &m_cells[pos & m_mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+			if (diff == 0)
+			{
+				if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		}
+
+		cell->data = value;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// Returns false if the queue is empty.
+	bool pop(T& value)
+	{
+		size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true)
+		{
+			cell = &m_cells[pos & m_mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+			if (diff == 0)
+			{
+				if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		}
+
+		value = cell->data;
+		cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+
+		return true;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T					data;
+	};
+
+	std::unique_ptr<Cell[]>	m_cells;
+	size_t					m_mask;
+	// Kept on separate cache lines so producers and consumers do not false share.
+	alignas(64) std::atomic<size_t> m_enqueue_pos;
+	alignas(64) std::atomic<size_t> m_dequeue_pos;
+};
@@ -0,0 +1,116 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+bool map_file(const char* path, MappedFile& file)
+{
+	HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (!mapping)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(handle);
+		return false;
+	}
+
+	file.data = (const uint8_t*)data;
+	file.size = (size_t)size.QuadPart;
+	file.file_handle = handle;
+	file.mapping_handle = mapping;
+
+	return true;
+}
+
+void unmap_file(MappedFile& file)
+{
+	if (file.data)
+		UnmapViewOfFile(file.data);
+
+	if (file.mapping_handle)
+		CloseHandle((HANDLE)file.mapping_handle);
+
+	if (file.file_handle)
+		CloseHandle((HANDLE)file.file_handle);
+
+	file = MappedFile();
+}
+
+#else
+
+bool map_file(const char* path, MappedFile& file)
+{
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (data == MAP_FAILED)
+	{
+		close(fd);
+		return false;
+	}
+
+	// The whole file is about to be streamed into a staging buffer.
+	madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+	madvise(data, (size_t)st.st_size, MADV_WILLNEED);
+
+	file.data = (const uint8_t*)data;
+	file.size = (size_t)st.st_size;
+	file.fd = fd;
+
+	return true;
+}
+
+void unmap_file(MappedFile& file)
+{
+	if (file.data)
+		munmap((void*)file.data, file.size);
+
+	if (file.fd >= 0)
+		close(file.fd);
+
+	file = MappedFile();
+}
+
+#endif
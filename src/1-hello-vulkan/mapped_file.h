@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Read-only memory mapping of a whole file. The pages are faulted in by the OS on first access,
+// so nothing is read or copied until the data is actually used.
+struct MappedFile
+{
+	const uint8_t* data { nullptr };
+	size_t		   size { 0 };
+#if defined(_WIN32)
+	void*		   file_handle { nullptr };
+	void*		   mapping_handle { nullptr };
+#else
+	int			   fd { -1 };
+#endif
+};
+
+extern bool map_file(const char* path, MappedFile& file);
+extern void unmap_file(MappedFile& file);
@@ -0,0 +1,158 @@
+#include "memory_policy.h"
+#include <string.h>
+
+#define DW_INVALID_MEMORY_TYPE 0xFFFFFFFF
+
+namespace gfx
+{
+	static const char* g_PlacementNames[] =
+	{
+		"auto",
+		"device local (staged)",
+		"device local (mapped)",
+		"host (mapped)",
+		"host (cached)"
+	};
+
+	const char* PlacementName(uint32_t placement)
+	{
+		return placement < Placement::COUNT ? g_PlacementNames[placement] : "unknown";
+	}
+
+	MemoryPolicy::MemoryPolicy() : m_UMA(false), m_ReBAR(false), m_DeviceLocalMapped(false), m_DeviceLocalTypeBits(0)
+	{
+		memset(&m_Properties, 0, sizeof(m_Properties));
+	}
+
+	void MemoryPolicy::Init(VkPhysicalDevice physicalDevice)
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_Properties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		bool allDeviceLocalMapped = true;
+		bool anyDeviceLocal = false;
+
+		m_ReBAR = false;
+		m_DeviceLocalMapped = false;
+		m_DeviceLocalTypeBits = 0;
+
+		for (uint32_t i = 0; i < m_Properties.memoryTypeCount; i++)
+		{
+			VkMemoryPropertyFlags flags = m_Properties.memoryTypes[i].propertyFlags;
+
+			if (!(flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+				continue;
+
+			anyDeviceLocal = true;
+			m_DeviceLocalTypeBits |= 1 << i;
+
+			if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			{
+				m_DeviceLocalMapped = true;
+
+				if (m_Properties.memoryHeaps[m_Properties.memoryTypes[i].heapIndex].size > DW_REBAR_MIN_HEAP_SIZE)
+					m_ReBAR = true;
+			}
+			else
+				allDeviceLocalMapped = false;
+		}
+
+		m_UMA = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ||
+				properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ||
+				(anyDeviceLocal && allDeviceLocalMapped);
+
+		// On UMA the whole heap is host visible; that is not a BAR.
+		if (m_UMA)
+			m_ReBAR = false;
+	}
+
+	uint32_t MemoryPolicy::FindType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const
+	{
+		uint32_t fallback = DW_INVALID_MEMORY_TYPE;
+
+		for (uint32_t i = 0; i < m_Properties.memoryTypeCount; i++)
+		{
+			VkMemoryPropertyFlags flags = m_Properties.memoryTypes[i].propertyFlags;
+
+			if (!(typeBits & (1 << i)) || (flags & required) != required)
+				continue;
+
+			if ((flags & preferred) == preferred)
+				return i;
+
+			if (fallback == DW_INVALID_MEMORY_TYPE)
+				fallback = i;
+		}
+
+		return fallback;
+	}
+
+	bool MemoryPolicy::ChoosePlacement(uint32_t placement, uint32_t typeBits, MemoryPlacement& result) const
+	{
+		uint32_t type = DW_INVALID_MEMORY_TYPE;
+
+		switch (placement)
+		{
+		case Placement::DEVICE_LOCAL_STAGED:
+			type = FindType(typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			break;
+		case Placement::DEVICE_LOCAL_MAPPED:
+			type = FindType(typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			break;
+		case Placement::HOST_MAPPED:
+			// Keep the (possibly small) BAR for buffers that benefit from it.
+			type = FindType(typeBits & ~m_DeviceLocalTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+			if (type == DW_INVALID_MEMORY_TYPE)
+				type = FindType(typeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			break;
+		case Placement::HOST_CACHED:
+			type = FindType(typeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+			if (type != DW_INVALID_MEMORY_TYPE && !(m_Properties.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT))
+				type = FindType(typeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+			if (type == DW_INVALID_MEMORY_TYPE)
+				type = FindType(typeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			break;
+		default:
+			return false;
+		}
+
+		if (type == DW_INVALID_MEMORY_TYPE)
+			return false;
+
+		result.placement = placement;
+		result.memoryType = type;
+		result.flags = m_Properties.memoryTypes[type].propertyFlags;
+
+		return true;
+	}
+
+	bool MemoryPolicy::Choose(uint32_t usage, uint32_t typeBits, MemoryPlacement& placement) const
+	{
+		switch (usage)
+		{
+		case BufferUsage::STATIC:
+			if (m_UMA && ChoosePlacement(Placement::DEVICE_LOCAL_MAPPED, typeBits, placement))
+				return true;
+			return ChoosePlacement(Placement::DEVICE_LOCAL_STAGED, typeBits, placement);
+
+		case BufferUsage::DYNAMIC:
+			if (m_DeviceLocalMapped && ChoosePlacement(Placement::DEVICE_LOCAL_MAPPED, typeBits, placement))
+				return true;
+			return ChoosePlacement(Placement::HOST_MAPPED, typeBits, placement);
+
+		case BufferUsage::READBACK:
+			return ChoosePlacement(Placement::HOST_CACHED, typeBits, placement);
+
+		case BufferUsage::STAGING:
+			return ChoosePlacement(Placement::HOST_MAPPED, typeBits, placement);
+
+		default:
+			return false;
+		}
+	}
+}
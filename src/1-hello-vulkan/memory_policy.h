@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+
+// Heaps larger than this that are both device local and host visible are treated as resizable BAR.
+// Without ReBAR the window is typically 256 MiB.
+#define DW_REBAR_MIN_HEAP_SIZE (256ull * 1024 * 1024)
+
+namespace gfx
+{
+	// How the CPU accesses a buffer over its lifetime.
+	namespace BufferUsage
+	{
+		enum
+		{
+			// Written once (or rarely), read by the GPU many times.
+			STATIC,
+			// Rewritten by the CPU every frame or so.
+			DYNAMIC,
+			// Written by the GPU, read back by the CPU.
+			READBACK,
+			// CPU-side source of transfers.
+			STAGING
+		};
+	}
+
+	namespace Placement
+	{
+		enum
+		{
+			// Let MemoryPolicy decide from the BufferUsage.
+			AUTO,
+			// Device local, filled through a staging buffer and a transfer.
+			DEVICE_LOCAL_STAGED,
+			// Device local and host visible (ReBAR or UMA), written directly.
+			DEVICE_LOCAL_MAPPED,
+			// System memory, host visible and coherent. The GPU reads it over the bus.
+			HOST_MAPPED,
+			// System memory, host cached. Fast CPU reads, for readback.
+			HOST_CACHED,
+			COUNT
+		};
+	}
+
+	struct MemoryPlacement
+	{
+		uint32_t			  placement;
+		uint32_t			  memoryType;
+		VkMemoryPropertyFlags flags;
+	};
+
+	// Picks memory types per buffer usage based on what the device actually exposes.
+	//
+	// - UMA devices (integrated GPUs, CPU implementations such as lavapipe, or any device where all
+	//   device local memory is host visible) never stage: a staging copy is a pure extra memcpy there.
+	// - Dynamic buffers go to device local + host visible memory when it exists (ReBAR or UMA), so they
+	//   are written in place and read by the GPU at full speed; otherwise to host visible system memory.
+	// - Static buffers go to device local memory and are filled through a staging buffer.
+	// - Readback buffers prefer host cached memory, since uncached reads are very slow.
+	class MemoryPolicy
+	{
+	public:
+		MemoryPolicy();
+
+		void Init(VkPhysicalDevice physicalDevice);
+
+		// Returns false if no memory type satisfies the usage within typeBits.
+		bool Choose(uint32_t usage, uint32_t typeBits, MemoryPlacement& placement) const;
+		// Like Choose() but for an explicit placement, e.g. to benchmark placements against each other.
+		bool ChoosePlacement(uint32_t placement, uint32_t typeBits, MemoryPlacement& result) const;
+
+		uint32_t FindType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0) const;
+
+		inline bool IsUMA() const { return m_UMA; }
+		inline bool HasReBAR() const { return m_ReBAR; }
+		inline bool HasDeviceLocalMapped() const { return m_DeviceLocalMapped; }
+		inline const VkPhysicalDeviceMemoryProperties& Properties() const { return m_Properties; }
+
+	private:
+		VkPhysicalDeviceMemoryProperties m_Properties;
+		bool							 m_UMA;
+		bool							 m_ReBAR;
+		bool							 m_DeviceLocalMapped;
+		uint32_t						 m_DeviceLocalTypeBits;
+	};
+
+	extern const char* PlacementName(uint32_t placement);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace mesh
+{
+	// Uncompressed vertex as produced by importers and generators, before any packing.
+	struct Vertex
+	{
+		float position[3];
+		float normal[3];
+		float uv[2];
+	};
+
+	struct Mesh
+	{
+		std::vector<Vertex>	  vertices;
+		std::vector<uint32_t> indices;
+	};
+}
@@ -0,0 +1,231 @@
+#include "mesh_cache.h"
+#include "mesh_packer.h"
+#include "mesh_optimizer.h"
+#include "gfx_device.h"
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <algorithm>
+#include <iostream>
+
+namespace mesh
+{
+	static inline uint64_t align_up(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Zero pads up to offset, then writes the section.
+	static bool write_section(FILE* file, uint64_t offset, const void* data, size_t size)
+	{
+		static const uint8_t padding[DW_MESH_CACHE_ALIGNMENT] = {};
+
+		long position = ftell(file);
+
+		if (position < 0 || (uint64_t)position > offset || offset - position > DW_MESH_CACHE_ALIGNMENT)
+			return false;
+
+		size_t pad = (size_t)(offset - position);
+
+		if (pad > 0 && fwrite(padding, 1, pad, file) != pad)
+			return false;
+
+		return size == 0 || fwrite(data, 1, size, file) == size;
+	}
+
+	static void compute_bounds(const Mesh& m, float* min, float* max)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			min[i] = m.vertices.empty() ? 0.0f : FLT_MAX;
+			max[i] = m.vertices.empty() ? 0.0f : -FLT_MAX;
+		}
+
+		for (const auto& vertex : m.vertices)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				min[i] = std::min(min[i], vertex.position[i]);
+				max[i] = std::max(max[i], vertex.position[i]);
+			}
+		}
+	}
+
+	bool write_mesh_cache(const char* path, const std::vector<Mesh>& meshes, uint32_t vertex_format)
+	{
+		CacheHeader header = {};
+		header.magic = DW_MESH_CACHE_MAGIC;
+		header.version = DW_MESH_CACHE_VERSION;
+		header.vertex_format = vertex_format;
+		header.vertex_stride = vertex_format == VertexFormat::PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+		header.mesh_count = (uint32_t)meshes.size();
+
+		std::vector<CacheMesh> table(meshes.size());
+		std::vector<uint8_t> vertex_data;
+		std::vector<uint8_t> index_data;
+
+		uint32_t base_vertex = 0;
+
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			const Mesh& m = meshes[i];
+			CacheMesh& entry = table[i];
+
+			entry.base_vertex = base_vertex;
+			entry.vertex_count = (uint32_t)m.vertices.size();
+			compute_bounds(m, entry.bounds_min, entry.bounds_max);
+
+			size_t vertex_offset = vertex_data.size();
+
+			if (vertex_format == VertexFormat::PACKED)
+			{
+				PackedMesh packed;
+				pack_mesh(m, packed);
+
+				memcpy(entry.position_scale, packed.position_scale, sizeof(entry.position_scale));
+				memcpy(entry.position_offset, packed.position_offset, sizeof(entry.position_offset));
+
+				vertex_data.resize(vertex_offset + packed.vertices.size() * sizeof(PackedVertex));
+				memcpy(&vertex_data[vertex_offset], packed.vertices.data(), packed.vertices.size() * sizeof(PackedVertex));
+			}
+			else
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					entry.position_scale[j] = 1.0f;
+					entry.position_offset[j] = 0.0f;
+				}
+
+				vertex_data.resize(vertex_offset + m.vertices.size() * sizeof(Vertex));
+				memcpy(&vertex_data[vertex_offset], m.vertices.data(), m.vertices.size() * sizeof(Vertex));
+			}
+
+			// Indices stay local to the mesh (drawn with base_vertex), which keeps most meshes 16-bit.
+			std::vector<uint8_t> encoded;
+			entry.index_type = encode_indices(m.indices, m.vertices.size(), encoded);
+			entry.index_count = (uint32_t)m.indices.size();
+			entry.index_offset = align_up(index_data.size(), 4);
+
+			index_data.resize(entry.index_offset + encoded.size());
+			memcpy(&index_data[entry.index_offset], encoded.data(), encoded.size());
+
+			base_vertex += entry.vertex_count;
+		}
+
+		header.mesh_table_offset = sizeof(CacheHeader);
+		header.vertex_data_offset = align_up(header.mesh_table_offset + table.size() * sizeof(CacheMesh), DW_MESH_CACHE_ALIGNMENT);
+		header.vertex_data_size = vertex_data.size();
+		header.index_data_offset = align_up(header.vertex_data_offset + header.vertex_data_size, DW_MESH_CACHE_ALIGNMENT);
+		header.index_data_size = index_data.size();
+
+		FILE* file = fopen(path, "wb");
+
+		if (!file)
+		{
+			std::cout << "Failed to open " << path << " for writing" << std::endl;
+			return false;
+		}
+
+		bool ok = write_section(file, 0, &header, sizeof(header)) &&
+			write_section(file, header.mesh_table_offset, table.data(), table.size() * sizeof(CacheMesh)) &&
+			write_section(file, header.vertex_data_offset, vertex_data.data(), vertex_data.size()) &&
+			write_section(file, header.index_data_offset, index_data.data(), index_data.size());
+
+		fclose(file);
+
+		if (!ok)
+			std::cout << "Failed to write mesh cache " << path << std::endl;
+
+		return ok;
+	}
+
+	// offset + size <= total without the sum wrapping around.
+	static inline bool in_range(uint64_t offset, uint64_t size, uint64_t total)
+	{
+		return offset <= total && size <= total - offset;
+	}
+
+	static bool validate_header(const CacheHeader& header, size_t size)
+	{
+		uint32_t stride = header.vertex_format == VertexFormat::PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+
+		return header.magic == DW_MESH_CACHE_MAGIC &&
+			header.version == DW_MESH_CACHE_VERSION &&
+			(header.vertex_format == VertexFormat::FLOAT || header.vertex_format == VertexFormat::PACKED) &&
+			header.vertex_stride == stride &&
+			header.mesh_table_offset % alignof(CacheMesh) == 0 &&
+			header.vertex_data_offset % DW_MESH_CACHE_ALIGNMENT == 0 &&
+			header.index_data_offset % DW_MESH_CACHE_ALIGNMENT == 0 &&
+			header.vertex_data_size % stride == 0 &&
+			in_range(header.mesh_table_offset, (uint64_t)header.mesh_count * sizeof(CacheMesh), size) &&
+			in_range(header.vertex_data_offset, header.vertex_data_size, size) &&
+			in_range(header.index_data_offset, header.index_data_size, size);
+	}
+
+	// Every mesh has to lie within its sections, so drawing or uploading one never reads past them.
+	// The index values themselves are not scanned.
+	static bool validate_mesh(const CacheHeader& header, const CacheMesh& entry)
+	{
+		uint64_t index_size;
+
+		if (entry.index_type == gfx::DataType::UINT16)
+			index_size = sizeof(uint16_t);
+		else if (entry.index_type == gfx::DataType::UINT32)
+			index_size = sizeof(uint32_t);
+		else
+			return false;
+
+		return in_range(entry.base_vertex, entry.vertex_count, header.vertex_data_size / header.vertex_stride) &&
+			entry.index_offset % index_size == 0 &&
+			in_range(entry.index_offset, (uint64_t)entry.index_count * index_size, header.index_data_size);
+	}
+
+	bool read_mesh_cache(const uint8_t* data, size_t size, MeshCache& cache)
+	{
+		const CacheHeader* header = (const CacheHeader*)data;
+		bool valid = size >= sizeof(CacheHeader) && validate_header(*header, size);
+
+		if (valid)
+		{
+			const CacheMesh* meshes = (const CacheMesh*)(data + header->mesh_table_offset);
+
+			for (uint32_t i = 0; valid && i < header->mesh_count; i++)
+				valid = validate_mesh(*header, meshes[i]);
+		}
+
+		if (!valid)
+			return false;
+
+		cache.header = header;
+		cache.meshes = (const CacheMesh*)(data + header->mesh_table_offset);
+		cache.vertex_data = data + header->vertex_data_offset;
+		cache.index_data = data + header->index_data_offset;
+
+		return true;
+	}
+
+	bool open_mesh_cache(const char* path, MeshCache& cache)
+	{
+		if (!map_file(path, cache.file))
+			return false;
+
+		if (!read_mesh_cache(cache.file.data, cache.file.size, cache))
+		{
+			std::cout << "Invalid or outdated mesh cache : " << path << std::endl;
+			close_mesh_cache(cache);
+			return false;
+		}
+
+		return true;
+	}
+
+	void close_mesh_cache(MeshCache& cache)
+	{
+		unmap_file(cache.file);
+
+		cache.header = nullptr;
+		cache.meshes = nullptr;
+		cache.vertex_data = nullptr;
+		cache.index_data = nullptr;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "mesh.h"
+#include "mapped_file.h"
+
+#define DW_MESH_CACHE_MAGIC 0x434D5744 // 'DWMC'
+#define DW_MESH_CACHE_VERSION 1
+#define DW_MESH_CACHE_ALIGNMENT 256
+
+// Binary mesh cache layout:
+//
+//   CacheHeader
+//   CacheMesh[mesh_count]			at mesh_table_offset
+//   vertex data					at vertex_data_offset, DW_MESH_CACHE_ALIGNMENT aligned
+//   index data						at index_data_offset, DW_MESH_CACHE_ALIGNMENT aligned
+//
+// Vertex and index sections are stored exactly as the GPU consumes them, so loading is a
+// single memcpy from the mapped file into a staging buffer per section.
+
+namespace mesh
+{
+	namespace VertexFormat
+	{
+		enum
+		{
+			FLOAT,	// mesh::Vertex
+			PACKED	// mesh::PackedVertex
+		};
+	}
+
+	struct CacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertex_format;
+		uint32_t vertex_stride;
+		uint32_t mesh_count;
+		uint32_t reserved;
+		uint64_t mesh_table_offset;
+		uint64_t vertex_data_offset;
+		uint64_t vertex_data_size;
+		uint64_t index_data_offset;
+		uint64_t index_data_size;
+	};
+
+	struct CacheMesh
+	{
+		uint32_t base_vertex;
+		uint32_t vertex_count;
+		uint64_t index_offset;		// Bytes, relative to the index section.
+		uint32_t index_count;
+		uint32_t index_type;		// gfx::DataType::UINT16 or UINT32
+		float	 position_scale[3];	// Dequantization for VertexFormat::PACKED, identity otherwise.
+		float	 position_offset[3];
+		float	 bounds_min[3];
+		float	 bounds_max[3];
+	};
+
+	struct MeshCache
+	{
+		MappedFile		   file;
+		const CacheHeader* header { nullptr };
+		const CacheMesh*   meshes { nullptr };
+		const uint8_t*	   vertex_data { nullptr };
+		const uint8_t*	   index_data { nullptr };
+	};
+
+	extern bool write_mesh_cache(const char* path, const std::vector<Mesh>& meshes, uint32_t vertex_format);
+
+	// Maps the file and validates the header and every mesh entry against the file. The section
+	// pointers point straight into the mapping.
+	extern bool open_mesh_cache(const char* path, MeshCache& cache);
+	// Same validation for a cache already in memory (e.g. read by the AssetStreamer). The section
+	// pointers point into data, which has to outlive the cache; there is nothing to close.
+	extern bool read_mesh_cache(const uint8_t* data, size_t size, MeshCache& cache);
+	extern void close_mesh_cache(MeshCache& cache);
+}
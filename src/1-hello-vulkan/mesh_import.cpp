@@ -0,0 +1,546 @@
+#include "mesh_import.h"
+#include "json.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+namespace mesh
+{
+	static bool read_file(const std::string& path, std::vector<char>& buffer)
+	{
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+		if (!file.is_open())
+			return false;
+
+		size_t size = (size_t)file.tellg();
+
+		// Terminated so strtof/strtol can never run past the end.
+		buffer.resize(size + 1);
+		file.seekg(0);
+		file.read(buffer.data(), size);
+		buffer[size] = '\0';
+
+		return true;
+	}
+
+	static std::string directory_of(const std::string& path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+	}
+
+	// --------------------------------------------------------------------------------------------
+	// OBJ
+	// --------------------------------------------------------------------------------------------
+
+	struct ObjIndex
+	{
+		int32_t position;
+		int32_t uv;
+		int32_t normal;
+	};
+
+	struct ObjIndexHash
+	{
+		size_t operator()(const ObjIndex& i) const
+		{
+			return ((size_t)i.position * 73856093) ^ ((size_t)i.uv * 19349663) ^ ((size_t)i.normal * 83492791);
+		}
+	};
+
+	struct ObjIndexEqual
+	{
+		bool operator()(const ObjIndex& a, const ObjIndex& b) const
+		{
+			return a.position == b.position && a.uv == b.uv && a.normal == b.normal;
+		}
+	};
+
+	static inline const char* skip_spaces(const char* p)
+	{
+		while (*p == ' ' || *p == '\t')
+			p++;
+		return p;
+	}
+
+	// OBJ indices are 1 based, negative values are relative to the end of the list.
+	static inline int32_t resolve_obj_index(long index, size_t count)
+	{
+		if (index > 0)
+			return (int32_t)(index - 1);
+		if (index < 0)
+			return (int32_t)(count + index);
+		return -1;
+	}
+
+	bool load_obj(const char* path, Mesh& mesh)
+	{
+		std::vector<char> text;
+
+		if (!read_file(path, text))
+		{
+			std::cout << "Failed to open " << path << std::endl;
+			return false;
+		}
+
+		std::vector<float> positions;
+		std::vector<float> normals;
+		std::vector<float> uvs;
+		std::unordered_map<ObjIndex, uint32_t, ObjIndexHash, ObjIndexEqual> vertex_map;
+		std::vector<uint32_t> face;
+
+		mesh.vertices.clear();
+		mesh.indices.clear();
+
+		const char* p = text.data();
+
+		while (*p)
+		{
+			p = skip_spaces(p);
+
+			if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+			{
+				p += 2;
+				for (int i = 0; i < 3; i++)
+					positions.push_back(strtof(p, (char**)&p));
+			}
+			else if (p[0] == 'v' && p[1] == 'n')
+			{
+				p += 2;
+				for (int i = 0; i < 3; i++)
+					normals.push_back(strtof(p, (char**)&p));
+			}
+			else if (p[0] == 'v' && p[1] == 't')
+			{
+				p += 2;
+				for (int i = 0; i < 2; i++)
+					uvs.push_back(strtof(p, (char**)&p));
+			}
+			else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+			{
+				p += 2;
+				face.clear();
+
+				while (true)
+				{
+					p = skip_spaces(p);
+
+					if (*p == '\0' || *p == '\n' || *p == '\r')
+						break;
+
+					char* end = nullptr;
+					ObjIndex index = { -1, -1, -1 };
+
+					index.position = resolve_obj_index(strtol(p, &end, 10), positions.size() / 3);
+
+					if (end == p)
+					{
+						std::cout << "Malformed face in " << path << std::endl;
+						return false;
+					}
+
+					p = end;
+
+					if (*p == '/')
+					{
+						p++;
+						if (*p != '/')
+						{
+							index.uv = resolve_obj_index(strtol(p, &end, 10), uvs.size() / 2);
+							p = end;
+						}
+
+						if (*p == '/')
+						{
+							p++;
+							index.normal = resolve_obj_index(strtol(p, &end, 10), normals.size() / 3);
+							p = end;
+						}
+					}
+
+					if (index.position < 0 || index.position >= (int32_t)(positions.size() / 3))
+					{
+						std::cout << "Invalid face index in " << path << std::endl;
+						return false;
+					}
+
+					auto result = vertex_map.insert(std::make_pair(index, (uint32_t)mesh.vertices.size()));
+
+					if (result.second)
+					{
+						Vertex v = {};
+						memcpy(v.position, &positions[index.position * 3], sizeof(float) * 3);
+
+						if (index.normal >= 0 && index.normal < (int32_t)(normals.size() / 3))
+							memcpy(v.normal, &normals[index.normal * 3], sizeof(float) * 3);
+
+						if (index.uv >= 0 && index.uv < (int32_t)(uvs.size() / 2))
+							memcpy(v.uv, &uvs[index.uv * 2], sizeof(float) * 2);
+
+						mesh.vertices.push_back(v);
+					}
+
+					face.push_back(result.first->second);
+				}
+
+				for (size_t i = 2; i < face.size(); i++)
+				{
+					mesh.indices.push_back(face[0]);
+					mesh.indices.push_back(face[i - 1]);
+					mesh.indices.push_back(face[i]);
+				}
+			}
+
+			// Skip the rest of the line (comments, groups, materials, ...)
+			while (*p && *p != '\n')
+				p++;
+
+			if (*p == '\n')
+				p++;
+		}
+
+		return true;
+	}
+
+	// --------------------------------------------------------------------------------------------
+	// glTF
+	// --------------------------------------------------------------------------------------------
+
+	const uint32_t kGlbMagic = 0x46546C67; // 'glTF'
+	const uint32_t kGlbChunkJson = 0x4E4F534A;
+	const uint32_t kGlbChunkBin = 0x004E4942;
+
+	namespace GltfComponentType
+	{
+		enum
+		{
+			UNSIGNED_BYTE = 5121,
+			UNSIGNED_SHORT = 5123,
+			UNSIGNED_INT = 5125,
+			FLOAT = 5126
+		};
+	}
+
+	static bool decode_base64(const char* src, size_t size, std::vector<uint8_t>& out)
+	{
+		static int8_t table[256];
+		static bool initialized = false;
+
+		if (!initialized)
+		{
+			const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			memset(table, -1, sizeof(table));
+
+			for (int i = 0; i < 64; i++)
+				table[(uint8_t)alphabet[i]] = (int8_t)i;
+
+			initialized = true;
+		}
+
+		uint32_t accumulator = 0;
+		int bits = 0;
+
+		for (size_t i = 0; i < size && src[i] != '='; i++)
+		{
+			int8_t value = table[(uint8_t)src[i]];
+
+			if (value < 0)
+				return false;
+
+			accumulator = (accumulator << 6) | (uint32_t)value;
+			bits += 6;
+
+			if (bits >= 8)
+			{
+				bits -= 8;
+				out.push_back((uint8_t)(accumulator >> bits));
+			}
+		}
+
+		return true;
+	}
+
+	struct GltfDocument
+	{
+		json::Value						  root;
+		std::vector<std::vector<uint8_t>> buffers;
+	};
+
+	// Returns a pointer to the first element of the accessor and its stride in bytes.
+	static const uint8_t* accessor_data(const GltfDocument& doc, const json::Value& accessor, uint32_t element_size, uint32_t& stride)
+	{
+		const json::Value& view = doc.root["bufferViews"][accessor["bufferView"].as_uint()];
+		uint32_t buffer_index = view["buffer"].as_uint();
+
+		if (accessor["bufferView"].is_null() || view.is_null() || buffer_index >= doc.buffers.size())
+			return nullptr;
+
+		const std::vector<uint8_t>& buffer = doc.buffers[buffer_index];
+		uint64_t offset = (uint64_t)view["byteOffset"].as_number() + (uint64_t)accessor["byteOffset"].as_number();
+		uint32_t count = accessor["count"].as_uint();
+
+		stride = view["byteStride"].as_uint(element_size);
+
+		if (count > 0 && offset + (uint64_t)(count - 1) * stride + element_size > buffer.size())
+			return nullptr;
+
+		return buffer.data() + offset;
+	}
+
+	static uint32_t component_size(uint32_t component_type)
+	{
+		switch (component_type)
+		{
+		case GltfComponentType::UNSIGNED_BYTE: return 1;
+		case GltfComponentType::UNSIGNED_SHORT: return 2;
+		default: return 4;
+		}
+	}
+
+	// Reads `components` floats per element into dst (with dst_stride floats between elements).
+	// Integer components are only accepted when normalized, as glTF allows for texture coordinates.
+	static bool read_float_accessor(const GltfDocument& doc, uint32_t index, uint32_t components, float* dst, size_t dst_stride, uint32_t count)
+	{
+		const json::Value& accessor = doc.root["accessors"][index];
+		uint32_t type = accessor["componentType"].as_uint();
+		uint32_t element_size = component_size(type) * components;
+		uint32_t stride = 0;
+
+		if (accessor["count"].as_uint() != count)
+			return false;
+
+		const uint8_t* src = accessor_data(doc, accessor, element_size, stride);
+
+		if (!src)
+			return false;
+
+		for (uint32_t i = 0; i < count; i++, src += stride, dst += dst_stride)
+		{
+			for (uint32_t c = 0; c < components; c++)
+			{
+				switch (type)
+				{
+				case GltfComponentType::FLOAT:
+					memcpy(&dst[c], src + c * 4, 4);
+					break;
+				case GltfComponentType::UNSIGNED_BYTE:
+					dst[c] = src[c] / 255.0f;
+					break;
+				case GltfComponentType::UNSIGNED_SHORT:
+				{
+					uint16_t value;
+					memcpy(&value, src + c * 2, 2);
+					dst[c] = value / 65535.0f;
+					break;
+				}
+				default:
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	static bool read_index_accessor(const GltfDocument& doc, uint32_t index, std::vector<uint32_t>& indices)
+	{
+		const json::Value& accessor = doc.root["accessors"][index];
+		uint32_t type = accessor["componentType"].as_uint();
+		uint32_t count = accessor["count"].as_uint();
+		uint32_t stride = 0;
+
+		const uint8_t* src = accessor_data(doc, accessor, component_size(type), stride);
+
+		if (!src)
+			return false;
+
+		indices.resize(count);
+
+		for (uint32_t i = 0; i < count; i++, src += stride)
+		{
+			switch (type)
+			{
+			case GltfComponentType::UNSIGNED_BYTE:
+				indices[i] = *src;
+				break;
+			case GltfComponentType::UNSIGNED_SHORT:
+			{
+				uint16_t value;
+				memcpy(&value, src, 2);
+				indices[i] = value;
+				break;
+			}
+			case GltfComponentType::UNSIGNED_INT:
+				memcpy(&indices[i], src, 4);
+				break;
+			default:
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static bool load_gltf_buffers(const std::string& path, const std::vector<char>& glb_bin, GltfDocument& doc)
+	{
+		const json::Value& buffers = doc.root["buffers"];
+		std::string directory = directory_of(path);
+
+		doc.buffers.resize(buffers.size());
+
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			const std::string& uri = buffers[i]["uri"].as_string();
+
+			if (uri.empty())
+			{
+				// GLB binary chunk
+				doc.buffers[i].assign(glb_bin.begin(), glb_bin.end());
+			}
+			else if (uri.compare(0, 5, "data:") == 0)
+			{
+				size_t comma = uri.find(',');
+
+				if (comma == std::string::npos || !decode_base64(uri.c_str() + comma + 1, uri.size() - comma - 1, doc.buffers[i]))
+					return false;
+			}
+			else
+			{
+				std::vector<char> data;
+
+				if (!read_file(directory + uri, data))
+				{
+					std::cout << "Failed to open " << directory + uri << std::endl;
+					return false;
+				}
+
+				doc.buffers[i].assign(data.begin(), data.end() - 1);
+			}
+		}
+
+		return true;
+	}
+
+	bool load_gltf(const char* path, std::vector<Mesh>& meshes)
+	{
+		std::vector<char> file;
+
+		if (!read_file(path, file))
+		{
+			std::cout << "Failed to open " << path << std::endl;
+			return false;
+		}
+
+		size_t file_size = file.size() - 1;
+		const char* json_text = file.data();
+		size_t json_size = file_size;
+		std::vector<char> glb_bin;
+
+		uint32_t magic = 0;
+		if (file_size >= 12)
+			memcpy(&magic, file.data(), 4);
+
+		if (magic == kGlbMagic)
+		{
+			// 12 byte header followed by chunks of { length, type, data }.
+			size_t offset = 12;
+			json_text = nullptr;
+
+			while (offset + 8 <= file_size)
+			{
+				uint32_t chunk_length, chunk_type;
+				memcpy(&chunk_length, file.data() + offset, 4);
+				memcpy(&chunk_type, file.data() + offset + 4, 4);
+
+				if (offset + 8 + chunk_length > file_size)
+					break;
+
+				if (chunk_type == kGlbChunkJson)
+				{
+					json_text = file.data() + offset + 8;
+					json_size = chunk_length;
+				}
+				else if (chunk_type == kGlbChunkBin)
+					glb_bin.assign(file.data() + offset + 8, file.data() + offset + 8 + chunk_length);
+
+				offset += 8 + ((chunk_length + 3) & ~3u);
+			}
+
+			if (!json_text)
+			{
+				std::cout << "Missing JSON chunk in " << path << std::endl;
+				return false;
+			}
+		}
+
+		GltfDocument doc;
+
+		if (!json::parse(json_text, json_size, doc.root))
+		{
+			std::cout << "Failed to parse " << path << std::endl;
+			return false;
+		}
+
+		if (!load_gltf_buffers(path, glb_bin, doc))
+			return false;
+
+		const json::Value& gltf_meshes = doc.root["meshes"];
+
+		for (size_t m = 0; m < gltf_meshes.size(); m++)
+		{
+			const json::Value& primitives = gltf_meshes[m]["primitives"];
+
+			for (size_t p = 0; p < primitives.size(); p++)
+			{
+				const json::Value& primitive = primitives[p];
+				const json::Value& attributes = primitive["attributes"];
+
+				// 4 = TRIANGLES, the default.
+				if (primitive["mode"].as_uint(4) != 4 || attributes["POSITION"].is_null())
+					continue;
+
+				uint32_t count = doc.root["accessors"][attributes["POSITION"].as_uint()]["count"].as_uint();
+
+				Mesh mesh;
+				mesh.vertices.resize(count);
+
+				const size_t stride = sizeof(Vertex) / sizeof(float);
+				float* base = reinterpret_cast<float*>(mesh.vertices.data());
+
+				bool ok = read_float_accessor(doc, attributes["POSITION"].as_uint(), 3, base + offsetof(Vertex, position) / sizeof(float), stride, count);
+
+				if (ok && !attributes["NORMAL"].is_null())
+					ok = read_float_accessor(doc, attributes["NORMAL"].as_uint(), 3, base + offsetof(Vertex, normal) / sizeof(float), stride, count);
+
+				if (ok && !attributes["TEXCOORD_0"].is_null())
+					ok = read_float_accessor(doc, attributes["TEXCOORD_0"].as_uint(), 2, base + offsetof(Vertex, uv) / sizeof(float), stride, count);
+
+				if (ok && !primitive["indices"].is_null())
+					ok = read_index_accessor(doc, primitive["indices"].as_uint(), mesh.indices);
+				else if (ok)
+				{
+					mesh.indices.resize(count);
+					for (uint32_t i = 0; i < count; i++)
+						mesh.indices[i] = i;
+				}
+
+				for (uint32_t index : mesh.indices)
+					ok = ok && index < count;
+
+				if (!ok)
+				{
+					std::cout << "Invalid accessor in mesh " << m << " of " << path << std::endl;
+					return false;
+				}
+
+				meshes.push_back(std::move(mesh));
+			}
+		}
+
+		return true;
+	}
+}
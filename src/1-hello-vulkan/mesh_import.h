@@ -0,0 +1,13 @@
+#pragma once
+
+#include "mesh.h"
+
+namespace mesh
+{
+	// Wavefront OBJ. Faces are fan triangulated and all groups are merged into one mesh.
+	extern bool load_obj(const char* path, Mesh& mesh);
+
+	// glTF 2.0, both .gltf (external or base64 embedded buffers) and .glb. Every triangle primitive
+	// becomes one mesh. Node transforms are not applied.
+	extern bool load_gltf(const char* path, std::vector<Mesh>& meshes);
+}
@@ -0,0 +1,599 @@
+#include "mesh_lod.h"
+#include "mesh_optimizer.h"
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+
+namespace mesh
+{
+	// Planes through border edges, perpendicular to the surface, hold outlines in place. Weighted well
+	// above the surface planes so a border only gives way where it is straight.
+	const float kBorderWeight = 10.0f;
+	// A level keeping more than this share of the previous level's indices is not worth its range.
+	const float kLodMinReduction = 0.9f;
+
+	namespace VertexKind
+	{
+		enum
+		{
+			// Inside the surface, collapses into any neighbour.
+			MANIFOLD,
+			// On a single open border, collapses along it only.
+			BORDER,
+			// On a seam, where borders meet or on a non-manifold edge: never moves.
+			LOCKED
+		};
+	}
+
+	// Sum of squared distances to planes, as the symmetric 4x4 matrix of Garland and Heckbert, and
+	// the total weight of the planes.
+	struct Quadric
+	{
+		float a2, b2, c2, d2;
+		float ab, ac, ad, bc, bd, cd;
+		float w;
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		float	 cost;
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const Vertex* v) const
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(v->position);
+			uint64_t hash = 14695981039346656037ull;
+
+			for (size_t i = 0; i < sizeof(v->position); i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+
+			return (size_t)hash;
+		}
+	};
+
+	struct PositionEqual
+	{
+		bool operator()(const Vertex* a, const Vertex* b) const
+		{
+			return memcmp(a->position, b->position, sizeof(a->position)) == 0;
+		}
+	};
+
+	static void quadric_add_plane(Quadric& q, float a, float b, float c, float d, float w)
+	{
+		q.a2 += a * a * w;
+		q.b2 += b * b * w;
+		q.c2 += c * c * w;
+		q.d2 += d * d * w;
+		q.ab += a * b * w;
+		q.ac += a * c * w;
+		q.ad += a * d * w;
+		q.bc += b * c * w;
+		q.bd += b * d * w;
+		q.cd += c * d * w;
+		q.w += w;
+	}
+
+	static void quadric_add(Quadric& q, const Quadric& r)
+	{
+		q.a2 += r.a2;
+		q.b2 += r.b2;
+		q.c2 += r.c2;
+		q.d2 += r.d2;
+		q.ab += r.ab;
+		q.ac += r.ac;
+		q.ad += r.ad;
+		q.bc += r.bc;
+		q.bd += r.bd;
+		q.cd += r.cd;
+		q.w += r.w;
+	}
+
+	// Weighted mean squared distance from p to the planes.
+	static float quadric_error(const Quadric& q, const float* p)
+	{
+		float x = p[0];
+		float y = p[1];
+		float z = p[2];
+
+		float e = q.a2 * x * x + q.b2 * y * y + q.c2 * z * z + q.d2
+				+ 2.0f * (q.ab * x * y + q.ac * x * z + q.bc * y * z)
+				+ 2.0f * (q.ad * x + q.bd * y + q.cd * z);
+
+		return fabsf(e) / (q.w > 0.0f ? q.w : 1.0f);
+	}
+
+	static void triangle_normal(const float* p0, const float* p1, const float* p2, float* n)
+	{
+		float e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		float e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+		n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+		n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+		n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+	}
+
+	static inline uint64_t edge_key(uint32_t a, uint32_t b)
+	{
+		return ((uint64_t)a << 32) | b;
+	}
+
+	size_t simplify(const Vertex* vertices, size_t vertex_count, const uint32_t* indices, size_t index_count, size_t target_index_count, float target_error, uint32_t* destination, float* result_error)
+	{
+		if (result_error)
+			*result_error = 0.0f;
+
+		// Work in a unit cube so the quadrics keep their precision away from the origin.
+		float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (size_t i = 0; i < index_count; i++)
+		{
+			const float* p = vertices[indices[i]].position;
+
+			for (int j = 0; j < 3; j++)
+			{
+				minimum[j] = std::min(minimum[j], p[j]);
+				maximum[j] = std::max(maximum[j], p[j]);
+			}
+		}
+
+		float extent = std::max(maximum[0] - minimum[0], std::max(maximum[1] - minimum[1], maximum[2] - minimum[2]));
+		float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+		// Referenced vertices that share a position are wedges of one point, differing in normal or UV.
+		// remap points each at the first of them, which stands for the point in everything below.
+		std::vector<uint32_t> remap(vertex_count);
+		std::vector<uint32_t> wedges(vertex_count, 0);
+		std::vector<float> positions(vertex_count * 3);
+		std::unordered_map<const Vertex*, uint32_t, PositionHash, PositionEqual> unique;
+		unique.reserve(vertex_count);
+
+		for (size_t i = 0; i < vertex_count; i++)
+			remap[i] = (uint32_t)i;
+
+		for (size_t i = 0; i < index_count; i++)
+		{
+			uint32_t v = indices[i];
+			auto it = unique.emplace(&vertices[v], v);
+
+			if (it.second || it.first->second != remap[v])
+			{
+				remap[v] = it.first->second;
+				wedges[remap[v]]++;
+			}
+		}
+
+		for (size_t i = 0; i < vertex_count; i++)
+		{
+			for (int j = 0; j < 3; j++)
+				positions[i * 3 + j] = (vertices[i].position[j] - minimum[j]) * scale;
+		}
+
+		// Triangles that are already degenerate only get in the way.
+		std::vector<uint32_t> result;
+		result.reserve(index_count);
+
+		for (size_t i = 0; i + 2 < index_count; i += 3)
+		{
+			uint32_t r0 = remap[indices[i + 0]];
+			uint32_t r1 = remap[indices[i + 1]];
+			uint32_t r2 = remap[indices[i + 2]];
+
+			if (r0 != r1 && r1 != r2 && r2 != r0)
+				result.insert(result.end(), indices + i, indices + i + 3);
+		}
+
+		// Directed edges between points. An edge whose reverse is missing is a border, one that shows
+		// up twice is non-manifold.
+		std::unordered_map<uint64_t, uint32_t> edges;
+		edges.reserve(result.size());
+
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (int e = 0; e < 3; e++)
+				edges[edge_key(remap[result[i + e]], remap[result[i + (e + 1) % 3]])]++;
+		}
+
+		std::vector<uint8_t> kind(vertex_count, VertexKind::MANIFOLD);
+		std::vector<uint32_t> border_next(vertex_count, ~0u);
+		std::vector<uint32_t> border_prev(vertex_count, ~0u);
+		std::vector<uint8_t> border_out(vertex_count, 0);
+		std::vector<uint8_t> border_in(vertex_count, 0);
+		std::vector<Quadric> quadrics(vertex_count, Quadric());
+
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			uint32_t r[3] = { remap[result[i + 0]], remap[result[i + 1]], remap[result[i + 2]] };
+
+			float n[3];
+			triangle_normal(&positions[r[0] * 3], &positions[r[1] * 3], &positions[r[2] * 3], n);
+
+			float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			bool has_plane = length > 0.0f;
+
+			if (has_plane)
+			{
+				n[0] /= length;
+				n[1] /= length;
+				n[2] /= length;
+
+				const float* p0 = &positions[r[0] * 3];
+				float d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+
+				for (int j = 0; j < 3; j++)
+					quadric_add_plane(quadrics[r[j]], n[0], n[1], n[2], d, length * 0.5f);
+			}
+
+			for (int e = 0; e < 3; e++)
+			{
+				uint32_t a = r[e];
+				uint32_t b = r[(e + 1) % 3];
+
+				if (edges[edge_key(a, b)] > 1)
+				{
+					kind[a] = VertexKind::LOCKED;
+					kind[b] = VertexKind::LOCKED;
+				}
+
+				if (edges.find(edge_key(b, a)) != edges.end())
+					continue;
+
+				border_out[a]++;
+				border_in[b]++;
+				border_next[a] = b;
+				border_prev[b] = a;
+
+				if (!has_plane)
+					continue;
+
+				const float* pa = &positions[a * 3];
+				const float* pb = &positions[b * 3];
+				float edge[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+				float edge_length2 = edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2];
+
+				float m[3] = { edge[1] * n[2] - edge[2] * n[1], edge[2] * n[0] - edge[0] * n[2], edge[0] * n[1] - edge[1] * n[0] };
+				float m_length = sqrtf(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+
+				if (m_length <= 0.0f)
+					continue;
+
+				m[0] /= m_length;
+				m[1] /= m_length;
+				m[2] /= m_length;
+
+				float d = -(m[0] * pa[0] + m[1] * pa[1] + m[2] * pa[2]);
+
+				quadric_add_plane(quadrics[a], m[0], m[1], m[2], d, edge_length2 * kBorderWeight);
+				quadric_add_plane(quadrics[b], m[0], m[1], m[2], d, edge_length2 * kBorderWeight);
+			}
+		}
+
+		for (size_t i = 0; i < vertex_count; i++)
+		{
+			if (remap[i] != i || kind[i] == VertexKind::LOCKED)
+				continue;
+
+			if (wedges[i] > 1)
+				kind[i] = VertexKind::LOCKED;
+			else if (border_out[i] == 1 && border_in[i] == 1)
+				kind[i] = VertexKind::BORDER;
+			else if (border_out[i] != 0 || border_in[i] != 0)
+				kind[i] = VertexKind::LOCKED;
+		}
+
+		float error_limit = std::max(target_error, 0.0f) * scale;
+		error_limit *= error_limit;
+		float max_error = 0.0f;
+
+		std::vector<uint32_t> collapse(vertex_count);
+		std::vector<uint8_t> locked(vertex_count);
+		std::vector<uint32_t> offsets(vertex_count + 1);
+		std::vector<uint32_t> adjacency;
+		std::vector<Collapse> candidates;
+
+		// A collapse that turns a triangle around from over it is not taken.
+		auto flips = [&](uint32_t from, uint32_t to)
+		{
+			const float* target = &positions[to * 3];
+
+			for (uint32_t i = offsets[from]; i < offsets[from + 1]; i++)
+			{
+				const uint32_t* triangle = &result[adjacency[i] * 3];
+				const float* p[3];
+				const float* q[3];
+				bool degenerate = false;
+
+				for (int j = 0; j < 3; j++)
+				{
+					uint32_t r = remap[triangle[j]];
+					degenerate |= r == to;
+					p[j] = &positions[r * 3];
+					q[j] = r == from ? target : p[j];
+				}
+
+				if (degenerate)
+					continue;
+
+				float n0[3];
+				float n1[3];
+				triangle_normal(p[0], p[1], p[2], n0);
+				triangle_normal(q[0], q[1], q[2], n1);
+
+				if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0f)
+					return true;
+			}
+
+			return false;
+		};
+
+		// Each pass collapses the cheapest edges whose neighbourhoods do not touch, then rewrites the
+		// indices, until the target is reached or nothing within the error limit is left.
+		while (result.size() > target_index_count)
+		{
+			std::fill(offsets.begin(), offsets.end(), 0);
+
+			for (uint32_t v : result)
+				offsets[v + 1]++;
+
+			for (size_t i = 0; i < vertex_count; i++)
+				offsets[i + 1] += offsets[i];
+
+			adjacency.resize(result.size());
+			std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+
+			for (size_t i = 0; i < result.size(); i++)
+				adjacency[cursor[result[i]]++] = (uint32_t)(i / 3);
+
+			candidates.clear();
+
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				for (int e = 0; e < 6; e++)
+				{
+					// Both directions of each edge, the triangle's own wedge of the target included.
+					uint32_t from = result[i + e % 3];
+					uint32_t to = result[i + (e % 3 + (e < 3 ? 1 : 2)) % 3];
+					uint32_t rf = remap[from];
+					uint32_t rt = remap[to];
+
+					if (kind[rf] == VertexKind::LOCKED)
+						continue;
+
+					if (kind[rf] == VertexKind::BORDER && border_next[rf] != rt && border_prev[rf] != rt)
+						continue;
+
+					Quadric q = quadrics[rf];
+					quadric_add(q, quadrics[rt]);
+
+					float cost = quadric_error(q, &positions[rt * 3]);
+
+					if (cost <= error_limit)
+						candidates.push_back({ from, to, cost });
+				}
+			}
+
+			std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+			for (size_t i = 0; i < vertex_count; i++)
+				collapse[i] = (uint32_t)i;
+
+			std::fill(locked.begin(), locked.end(), 0);
+
+			size_t budget = std::max<size_t>(1, (result.size() - target_index_count) / 3);
+			size_t removed = 0;
+			size_t collapses = 0;
+
+			for (const Collapse& c : candidates)
+			{
+				uint32_t rf = remap[c.from];
+				uint32_t rt = remap[c.to];
+
+				if (locked[rf] || locked[rt] || flips(rf, rt))
+					continue;
+
+				// Only unlocked points move, and those have a single wedge: c.from is the point.
+				collapse[c.from] = c.to;
+				quadric_add(quadrics[rt], quadrics[rf]);
+
+				// The triangles around the point change shape, keep them out of other collapses this pass.
+				for (uint32_t j = offsets[rf]; j < offsets[rf + 1]; j++)
+				{
+					const uint32_t* triangle = &result[adjacency[j] * 3];
+
+					for (int k = 0; k < 3; k++)
+						locked[remap[triangle[k]]] = 1;
+				}
+
+				locked[rt] = 1;
+
+				if (kind[rf] == VertexKind::BORDER)
+				{
+					if (border_next[rf] == rt)
+					{
+						border_prev[rt] = border_prev[rf];
+						border_next[border_prev[rf]] = rt;
+					}
+					else
+					{
+						border_next[rt] = border_next[rf];
+						border_prev[border_next[rf]] = rt;
+					}
+				}
+
+				max_error = std::max(max_error, c.cost);
+				removed += kind[rf] == VertexKind::BORDER ? 1 : 2;
+				collapses++;
+
+				if (removed >= budget)
+					break;
+			}
+
+			if (collapses == 0)
+				break;
+
+			size_t write = 0;
+
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				uint32_t v0 = collapse[result[i + 0]];
+				uint32_t v1 = collapse[result[i + 1]];
+				uint32_t v2 = collapse[result[i + 2]];
+
+				if (remap[v0] == remap[v1] || remap[v1] == remap[v2] || remap[v2] == remap[v0])
+					continue;
+
+				result[write + 0] = v0;
+				result[write + 1] = v1;
+				result[write + 2] = v2;
+				write += 3;
+			}
+
+			result.resize(write);
+		}
+
+		if (!result.empty())
+			memcpy(destination, result.data(), result.size() * sizeof(uint32_t));
+
+		if (result_error)
+			*result_error = sqrtf(max_error) / scale;
+
+		return result.size();
+	}
+
+	void generate_lods(const Mesh& mesh, LodMesh& lod_mesh, const LodSettings& settings)
+	{
+		lod_mesh.vertices = mesh.vertices;
+		lod_mesh.indices = mesh.indices;
+		lod_mesh.lods.clear();
+
+		if (lod_mesh.indices.empty())
+		{
+			lod_mesh.indices.resize(mesh.vertices.size());
+
+			for (size_t i = 0; i < lod_mesh.indices.size(); i++)
+				lod_mesh.indices[i] = (uint32_t)i;
+		}
+
+		float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (const Vertex& v : mesh.vertices)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				minimum[j] = std::min(minimum[j], v.position[j]);
+				maximum[j] = std::max(maximum[j], v.position[j]);
+			}
+		}
+
+		float radius2 = 0.0f;
+
+		for (int j = 0; j < 3; j++)
+			lod_mesh.center[j] = mesh.vertices.empty() ? 0.0f : (minimum[j] + maximum[j]) * 0.5f;
+
+		for (const Vertex& v : mesh.vertices)
+		{
+			float d[3] = { v.position[0] - lod_mesh.center[0], v.position[1] - lod_mesh.center[1], v.position[2] - lod_mesh.center[2] };
+			radius2 = std::max(radius2, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+		}
+
+		lod_mesh.radius = sqrtf(radius2);
+		lod_mesh.lods.push_back({ 0, (uint32_t)lod_mesh.indices.size(), 0.0f });
+
+		uint32_t max_lods = std::min<uint32_t>(settings.max_lods, DW_MESH_MAX_LODS);
+		float max_error = settings.max_error * lod_mesh.radius;
+		float error = 0.0f;
+
+		std::vector<uint32_t> current = lod_mesh.indices;
+		std::vector<uint32_t> next;
+
+		while (lod_mesh.lods.size() < max_lods)
+		{
+			size_t target = (size_t)(current.size() / 3 * settings.reduction) * 3;
+
+			if (target < 3)
+				break;
+
+			float step_error = 0.0f;
+			next.resize(current.size());
+
+			size_t count = simplify(lod_mesh.vertices.data(), lod_mesh.vertices.size(), current.data(), current.size(), target, max_error - error, next.data(), &step_error);
+
+			if (count == 0 || count > current.size() * kLodMinReduction)
+				break;
+
+			next.resize(count);
+			optimize_vertex_cache(next.data(), next.size(), lod_mesh.vertices.size());
+
+			// Each level is simplified from the previous one, so the errors add up.
+			error += step_error;
+
+			lod_mesh.lods.push_back({ (uint32_t)lod_mesh.indices.size(), (uint32_t)count, error });
+			lod_mesh.indices.insert(lod_mesh.indices.end(), next.begin(), next.end());
+			current.swap(next);
+		}
+	}
+
+	void generate_lod_meshes(const std::vector<Mesh>& meshes, std::vector<LodMesh>& lod_meshes, const LodSettings& settings, uint32_t thread_count)
+	{
+		lod_meshes.resize(meshes.size());
+
+		if (thread_count == 0)
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+		thread_count = std::min(thread_count, (uint32_t)meshes.size());
+
+		std::atomic<size_t> next(0);
+
+		auto worker = [&]()
+		{
+			for (size_t i = next++; i < meshes.size(); i = next++)
+				generate_lods(meshes[i], lod_meshes[i], settings);
+		};
+
+		std::vector<std::thread> threads;
+
+		for (uint32_t i = 1; i < thread_count; i++)
+			threads.emplace_back(worker);
+
+		worker();
+
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	uint32_t select_lod(const LodMesh& lod_mesh, float scale, float distance, float projection_scale, float max_pixels)
+	{
+		if (lod_mesh.lods.empty())
+			return 0;
+
+		// Distance to the nearest point of the bounds, where the error looks largest.
+		float nearest = distance - lod_mesh.radius * scale;
+
+		if (nearest <= 0.0f)
+			return 0;
+
+		// Largest model space error that still projects to max_pixels at that distance.
+		float allowed = max_pixels * nearest / (projection_scale * scale);
+
+		for (uint32_t i = (uint32_t)lod_mesh.lods.size() - 1; i > 0; i--)
+		{
+			if (lod_mesh.lods[i].error <= allowed)
+				return i;
+		}
+
+		return 0;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "mesh.h"
+
+#define DW_MESH_MAX_LODS 8
+
+namespace mesh
+{
+	struct MeshLod
+	{
+		// Range of the level in LodMesh::indices.
+		uint32_t first_index;
+		uint32_t index_count;
+		// How far, in model units, the level's surface may stray from the full detail one.
+		float	 error;
+	};
+
+	// Every level of a mesh over one vertex array: the levels only differ in their index ranges, so
+	// the vertices and the packed indices upload as one vertex and one index buffer. To draw level i,
+	// bind them as a gfx::VertexArray and issue
+	//
+	//   DrawIndexedInstanced(lods[i].index_count, instances, lods[i].first_index, 0, first_instance)
+	struct LodMesh
+	{
+		std::vector<Vertex>	  vertices;
+		std::vector<uint32_t> indices;
+		// Finest first, errors increasing.
+		std::vector<MeshLod>  lods;
+		// Bounding sphere, in model space.
+		float				  center[3];
+		float				  radius;
+	};
+
+	struct LodSettings
+	{
+		// Including the full detail level, at most DW_MESH_MAX_LODS.
+		uint32_t max_lods { DW_MESH_MAX_LODS };
+		// Triangles of each level relative to the previous one.
+		float	 reduction { 0.5f };
+		// Levels stop once their error would exceed this share of the bounding radius.
+		float	 max_error { 0.05f };
+	};
+
+	// Quadric error edge collapse (Garland and Heckbert 1997). Collapses edges, cheapest first, until at
+	// most target_index_count indices are left or the next collapse would move the surface further than
+	// target_error (model units). Border edges only collapse along the border, and vertices on UV or
+	// normal seams stay in place, so outlines and texture mapping survive. destination needs room for
+	// index_count indices and may alias indices. Returns the index count written; result_error, if not
+	// null, receives the error reached.
+	extern size_t simplify(const Vertex* vertices, size_t vertex_count, const uint32_t* indices, size_t index_count, size_t target_index_count, float target_error, uint32_t* destination, float* result_error = nullptr);
+
+	// Builds the chain by simplifying each level from the previous one and packs every level into one
+	// index buffer. Each level is reordered for the vertex cache; the full detail one is kept as is, so
+	// run optimize_mesh first. Stops early once simplification stalls.
+	extern void generate_lods(const Mesh& mesh, LodMesh& lod_mesh, const LodSettings& settings = LodSettings());
+
+	// Runs generate_lods over all meshes on a pool of worker threads, one mesh per task.
+	// A thread_count of 0 uses every hardware thread.
+	extern void generate_lod_meshes(const std::vector<Mesh>& meshes, std::vector<LodMesh>& lod_meshes, const LodSettings& settings = LodSettings(), uint32_t thread_count = 0);
+
+	// Picks the coarsest level whose error projects to at most max_pixels on screen, for an instance
+	// with uniform scale whose bounds center is distance away from the camera. projection_scale is the
+	// viewport height in pixels over 2 tan(fov_y / 2), the size in pixels of one unit at distance one.
+	extern uint32_t select_lod(const LodMesh& lod_mesh, float scale, float distance, float projection_scale, float max_pixels);
+}
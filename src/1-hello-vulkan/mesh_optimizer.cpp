@@ -0,0 +1,417 @@
+#include "mesh_optimizer.h"
+#include "gfx_device.h"
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+
+namespace mesh
+{
+	struct VertexHash
+	{
+		size_t operator()(const Vertex& v) const
+		{
+			// FNV-1a over the raw bytes, Vertex has no padding.
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&v);
+			uint64_t hash = 14695981039346656037ull;
+
+			for (size_t i = 0; i < sizeof(Vertex); i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+
+			return (size_t)hash;
+		}
+	};
+
+	struct VertexEqual
+	{
+		bool operator()(const Vertex& a, const Vertex& b) const
+		{
+			return memcmp(&a, &b, sizeof(Vertex)) == 0;
+		}
+	};
+
+	float compute_acmr(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size)
+	{
+		if (index_count < 3)
+			return 0.0f;
+
+		// FIFO cache: a vertex is resident while fewer than cache_size misses happened since it was inserted.
+		std::vector<uint32_t> timestamps(vertex_count, 0);
+		uint32_t time = cache_size + 1;
+		uint32_t misses = 0;
+
+		for (size_t i = 0; i < index_count; i++)
+		{
+			uint32_t v = indices[i];
+
+			if (time - timestamps[v] > cache_size)
+			{
+				timestamps[v] = time++;
+				misses++;
+			}
+		}
+
+		return (float)misses / (float)(index_count / 3);
+	}
+
+	uint32_t deduplicate_vertices(Mesh& mesh)
+	{
+		std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> unique;
+		unique.reserve(mesh.vertices.size());
+
+		std::vector<Vertex> vertices;
+		vertices.reserve(mesh.vertices.size());
+
+		std::vector<uint32_t> remap(mesh.vertices.size());
+
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			auto result = unique.insert(std::make_pair(mesh.vertices[i], (uint32_t)vertices.size()));
+
+			if (result.second)
+				vertices.push_back(mesh.vertices[i]);
+
+			remap[i] = result.first->second;
+		}
+
+		// Unindexed input: every vertex is referenced once in order.
+		if (mesh.indices.empty())
+		{
+			mesh.indices = remap;
+		}
+		else
+		{
+			for (auto& index : mesh.indices)
+				index = remap[index];
+		}
+
+		mesh.vertices.swap(vertices);
+
+		return (uint32_t)mesh.vertices.size();
+	}
+
+	void optimize_vertex_cache(uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size, std::vector<uint32_t>* clusters)
+	{
+		size_t triangle_count = index_count / 3;
+
+		if (clusters)
+			clusters->clear();
+
+		if (triangle_count == 0)
+			return;
+
+		// Vertex -> triangle adjacency in CSR form. live holds the number of not yet emitted triangles per vertex.
+		std::vector<uint32_t> live(vertex_count, 0);
+		std::vector<uint32_t> offsets(vertex_count + 1, 0);
+		std::vector<uint32_t> adjacency(triangle_count * 3);
+
+		for (size_t i = 0; i < triangle_count * 3; i++)
+			live[indices[i]]++;
+
+		for (size_t i = 0; i < vertex_count; i++)
+			offsets[i + 1] = offsets[i] + live[i];
+
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+		for (size_t i = 0; i < triangle_count * 3; i++)
+			adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+
+		std::vector<uint32_t> timestamps(vertex_count, 0);
+		std::vector<uint32_t> dead_end;
+		std::vector<uint32_t> candidates;
+		std::vector<uint8_t>  emitted(triangle_count, 0);
+		std::vector<uint32_t> output;
+
+		dead_end.reserve(triangle_count * 3);
+		output.reserve(triangle_count * 3);
+
+		uint32_t time = cache_size + 1;
+		size_t cursor = 0;
+		int64_t fanning = indices[0];
+
+		if (clusters)
+			clusters->push_back(0);
+
+		while (fanning >= 0)
+		{
+			candidates.clear();
+
+			// Emit every remaining triangle around the fanning vertex.
+			for (uint32_t i = offsets[fanning]; i < offsets[fanning + 1]; i++)
+			{
+				uint32_t t = adjacency[i];
+
+				if (emitted[t])
+					continue;
+
+				for (int j = 0; j < 3; j++)
+				{
+					uint32_t v = indices[t * 3 + j];
+
+					output.push_back(v);
+					dead_end.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+
+					if (time - timestamps[v] > cache_size)
+						timestamps[v] = time++;
+				}
+
+				emitted[t] = 1;
+			}
+
+			// Pick the candidate that is still in cache and will stay there the longest after fanning.
+			int64_t next = -1;
+			int64_t best_priority = -1;
+
+			for (uint32_t v : candidates)
+			{
+				if (live[v] == 0)
+					continue;
+
+				int64_t priority = 0;
+
+				if (time - timestamps[v] + 2 * live[v] <= cache_size)
+					priority = time - timestamps[v];
+
+				if (priority > best_priority)
+				{
+					best_priority = priority;
+					next = v;
+				}
+			}
+
+			if (next == -1)
+			{
+				bool flushed = true;
+
+				// Dead end: backtrack through recently emitted vertices first, they are likely still cached.
+				while (!dead_end.empty())
+				{
+					uint32_t d = dead_end.back();
+					dead_end.pop_back();
+
+					if (live[d] > 0)
+					{
+						next = d;
+						flushed = time - timestamps[d] > cache_size;
+						break;
+					}
+				}
+
+				while (next == -1 && cursor < vertex_count)
+				{
+					if (live[cursor] > 0)
+						next = (int64_t)cursor;
+					else
+						cursor++;
+				}
+
+				if (clusters && next != -1 && flushed)
+					clusters->push_back((uint32_t)(output.size() / 3));
+			}
+
+			fanning = next;
+		}
+
+		memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+	}
+
+	void optimize_overdraw(Mesh& mesh, const std::vector<uint32_t>& clusters)
+	{
+		size_t triangle_count = mesh.indices.size() / 3;
+
+		if (clusters.size() < 2)
+			return;
+
+		struct Cluster
+		{
+			uint32_t begin;
+			uint32_t end;
+			float	 sort_key;
+		};
+
+		std::vector<Cluster> sorted(clusters.size());
+		std::vector<float> centroids(clusters.size() * 3, 0.0f);
+		std::vector<float> normals(clusters.size() * 3, 0.0f);
+		float mesh_centroid[3] = { 0.0f, 0.0f, 0.0f };
+		float mesh_area = 0.0f;
+
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			sorted[c].begin = clusters[c];
+			sorted[c].end = c + 1 < clusters.size() ? clusters[c + 1] : (uint32_t)triangle_count;
+
+			float* centroid = &centroids[c * 3];
+			float* normal = &normals[c * 3];
+			float cluster_area = 0.0f;
+
+			for (uint32_t t = sorted[c].begin; t < sorted[c].end; t++)
+			{
+				const float* p0 = mesh.vertices[mesh.indices[t * 3 + 0]].position;
+				const float* p1 = mesh.vertices[mesh.indices[t * 3 + 1]].position;
+				const float* p2 = mesh.vertices[mesh.indices[t * 3 + 2]].position;
+
+				float e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				float e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				float n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+				float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+				for (int i = 0; i < 3; i++)
+				{
+					// Area weighted, so sliver triangles do not drag the centroid around.
+					float c_i = (p0[i] + p1[i] + p2[i]) / 3.0f;
+					centroid[i] += c_i * area;
+					mesh_centroid[i] += c_i * area;
+					normal[i] += n[i];
+				}
+
+				cluster_area += area;
+			}
+
+			mesh_area += cluster_area;
+
+			if (cluster_area > 0.0f)
+			{
+				for (int i = 0; i < 3; i++)
+					centroid[i] /= cluster_area;
+			}
+		}
+
+		if (mesh_area > 0.0f)
+		{
+			for (int i = 0; i < 3; i++)
+				mesh_centroid[i] /= mesh_area;
+		}
+
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			const float* centroid = &centroids[c * 3];
+			const float* normal = &normals[c * 3];
+			float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+			float key = 0.0f;
+
+			if (length > 0.0f)
+			{
+				for (int i = 0; i < 3; i++)
+					key += (centroid[i] - mesh_centroid[i]) * normal[i] / length;
+			}
+
+			sorted[c].sort_key = key;
+		}
+
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sort_key > b.sort_key; });
+
+		std::vector<uint32_t> indices;
+		indices.reserve(mesh.indices.size());
+
+		for (const auto& cluster : sorted)
+			indices.insert(indices.end(), mesh.indices.begin() + cluster.begin * 3, mesh.indices.begin() + cluster.end * 3);
+
+		mesh.indices.swap(indices);
+	}
+
+	void optimize_vertex_fetch(Mesh& mesh)
+	{
+		const uint32_t kUnused = 0xFFFFFFFF;
+
+		std::vector<uint32_t> remap(mesh.vertices.size(), kUnused);
+		std::vector<Vertex> vertices;
+		vertices.reserve(mesh.vertices.size());
+
+		for (auto& index : mesh.indices)
+		{
+			if (remap[index] == kUnused)
+			{
+				remap[index] = (uint32_t)vertices.size();
+				vertices.push_back(mesh.vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		mesh.vertices.swap(vertices);
+	}
+
+	void optimize_mesh(Mesh& mesh, OptimizeStats* stats)
+	{
+		if (stats)
+		{
+			stats->vertices_before = (uint32_t)mesh.vertices.size();
+
+			if (mesh.indices.empty())
+				stats->acmr_before = 3.0f;
+			else
+				stats->acmr_before = compute_acmr(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+		}
+
+		deduplicate_vertices(mesh);
+
+		std::vector<uint32_t> clusters;
+		optimize_vertex_cache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), DW_MESH_VERTEX_CACHE_SIZE, &clusters);
+		optimize_overdraw(mesh, clusters);
+		optimize_vertex_fetch(mesh);
+
+		if (stats)
+		{
+			stats->vertices_after = (uint32_t)mesh.vertices.size();
+			stats->acmr_after = compute_acmr(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+		}
+	}
+
+	void optimize_meshes(std::vector<Mesh>& meshes, std::vector<OptimizeStats>* stats, uint32_t thread_count)
+	{
+		if (stats)
+			stats->resize(meshes.size());
+
+		if (thread_count == 0)
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+		thread_count = std::min(thread_count, (uint32_t)meshes.size());
+
+		std::atomic<size_t> next(0);
+
+		auto worker = [&]()
+		{
+			for (size_t i = next++; i < meshes.size(); i = next++)
+				optimize_mesh(meshes[i], stats ? &(*stats)[i] : nullptr);
+		};
+
+		std::vector<std::thread> threads;
+
+		for (uint32_t i = 1; i < thread_count; i++)
+			threads.emplace_back(worker);
+
+		worker();
+
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	uint32_t encode_indices(const std::vector<uint32_t>& indices, size_t vertex_count, std::vector<uint8_t>& data)
+	{
+		if (vertex_count <= 0xFFFF)
+		{
+			data.resize(indices.size() * sizeof(uint16_t));
+			uint16_t* dst = reinterpret_cast<uint16_t*>(data.data());
+
+			for (size_t i = 0; i < indices.size(); i++)
+				dst[i] = (uint16_t)indices[i];
+
+			return gfx::DataType::UINT16;
+		}
+		else
+		{
+			data.resize(indices.size() * sizeof(uint32_t));
+			memcpy(data.data(), indices.data(), data.size());
+
+			return gfx::DataType::UINT32;
+		}
+	}
+}
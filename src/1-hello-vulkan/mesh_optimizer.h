@@ -0,0 +1,44 @@
+#pragma once
+
+#include "mesh.h"
+
+#define DW_MESH_VERTEX_CACHE_SIZE 16
+
+namespace mesh
+{
+	struct OptimizeStats
+	{
+		uint32_t vertices_before;
+		uint32_t vertices_after;
+		float	 acmr_before;
+		float	 acmr_after;
+	};
+
+	// Average cache miss ratio: transformed vertices per triangle for a FIFO post-transform cache.
+	// 3.0 is the worst case, ~0.5-0.7 is typical for well ordered regular meshes.
+	extern float compute_acmr(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size = DW_MESH_VERTEX_CACHE_SIZE);
+
+	// Merges bitwise identical vertices and rewrites the index buffer. Returns the new vertex count.
+	extern uint32_t deduplicate_vertices(Mesh& mesh);
+
+	// Tipsify (Sander et al. 2007) reordering for post-transform cache locality. If clusters is not null
+	// it receives the first triangle of each cluster, split at the points where the cache is flushed anyway.
+	extern void optimize_vertex_cache(uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size = DW_MESH_VERTEX_CACHE_SIZE, std::vector<uint32_t>* clusters = nullptr);
+
+	// Sorts the clusters from optimize_vertex_cache so outward facing ones are drawn first, which reduces
+	// overdraw from most view directions without touching the order inside a cluster.
+	extern void optimize_overdraw(Mesh& mesh, const std::vector<uint32_t>& clusters);
+
+	// Renumbers vertices in order of first reference so vertex fetch walks memory linearly.
+	extern void optimize_vertex_fetch(Mesh& mesh);
+
+	// Full pipeline: deduplicate, vertex cache, overdraw, vertex fetch.
+	extern void optimize_mesh(Mesh& mesh, OptimizeStats* stats = nullptr);
+
+	// Runs optimize_mesh over all meshes on a pool of worker threads, one mesh per task.
+	// A thread_count of 0 uses every hardware thread.
+	extern void optimize_meshes(std::vector<Mesh>& meshes, std::vector<OptimizeStats>* stats = nullptr, uint32_t thread_count = 0);
+
+	// Writes indices as 16-bit when every index fits, otherwise 32-bit. Returns the gfx::DataType to put in IndexBuffer::dataType.
+	extern uint32_t encode_indices(const std::vector<uint32_t>& indices, size_t vertex_count, std::vector<uint8_t>& data);
+}
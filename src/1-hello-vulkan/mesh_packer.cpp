@@ -0,0 +1,251 @@
+#include "mesh_packer.h"
+#include <stddef.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DW_MESH_PACKER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__F16C__)
+#define DW_MESH_PACKER_F16C
+#include <immintrin.h>
+#endif
+
+namespace mesh
+{
+	const gfx::InputElementDesc g_packed_vertex_elements[3] =
+	{
+		{ 4, gfx::DataType::INT16, true, offsetof(PackedVertex, position), "POSITION", 0, 1, gfx::PackedType::NONE },
+		{ 4, gfx::DataType::INT32, true, offsetof(PackedVertex, normal), "NORMAL", 0, 1, gfx::PackedType::INT_2_10_10_10 },
+		{ 2, gfx::DataType::HALF_FLOAT, false, offsetof(PackedVertex, uv), "TEXCOORD", 0, 1, gfx::PackedType::NONE }
+	};
+
+	uint16_t float_to_half(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		uint32_t sign = (bits >> 16) & 0x8000;
+		int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+		uint32_t mantissa = bits & 0x7FFFFF;
+
+		// NaN / Inf
+		if (((bits >> 23) & 0xFF) == 0xFF)
+			return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+		// Overflow clamps to Inf.
+		if (exponent >= 31)
+			return (uint16_t)(sign | 0x7C00);
+
+		// Denormal or zero.
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+				return (uint16_t)sign;
+
+			mantissa |= 0x800000;
+			uint32_t shift = 14 - exponent;
+			uint32_t half = mantissa >> shift;
+			uint32_t rest = mantissa & ((1 << shift) - 1);
+			uint32_t halfway = 1 << (shift - 1);
+
+			if (rest > halfway || (rest == halfway && (half & 1)))
+				half++;
+
+			return (uint16_t)(sign | half);
+		}
+
+		uint32_t half = sign | (exponent << 10) | (mantissa >> 13);
+		uint32_t rest = mantissa & 0x1FFF;
+
+		// Round to nearest even, a carry into the exponent is the correct result.
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+			half++;
+
+		return (uint16_t)half;
+	}
+
+	float half_to_float(uint16_t value)
+	{
+		uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+		uint32_t exponent = (value >> 10) & 0x1F;
+		uint32_t mantissa = value & 0x3FF;
+		uint32_t bits;
+
+		if (exponent == 0)
+		{
+			if (mantissa == 0)
+				bits = sign;
+			else
+			{
+				// Renormalize denormals.
+				exponent = 127 - 15 + 1;
+				while (!(mantissa & 0x400))
+				{
+					mantissa <<= 1;
+					exponent--;
+				}
+				mantissa &= 0x3FF;
+				bits = sign | (exponent << 23) | (mantissa << 13);
+			}
+		}
+		else if (exponent == 31)
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		else
+			bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+		float result;
+		memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	static inline uint32_t pack_snorm_10_10_10_2(float x, float y, float z)
+	{
+		int32_t ix = (int32_t)roundf(std::max(-1.0f, std::min(1.0f, x)) * 511.0f);
+		int32_t iy = (int32_t)roundf(std::max(-1.0f, std::min(1.0f, y)) * 511.0f);
+		int32_t iz = (int32_t)roundf(std::max(-1.0f, std::min(1.0f, z)) * 511.0f);
+
+		return ((uint32_t)ix & 0x3FF) | (((uint32_t)iy & 0x3FF) << 10) | (((uint32_t)iz & 0x3FF) << 20);
+	}
+
+	static inline int16_t pack_snorm16(float value)
+	{
+		return (int16_t)roundf(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f);
+	}
+
+#if defined(DW_MESH_PACKER_SSE2)
+	// Rounds half away from zero like roundf() in the scalar path, where cvtps would round half to even.
+	// x - trunc(x) is exact for the clamped ranges here (well below 2^23), so the comparison is too.
+	static inline __m128i round_epi32(__m128 x)
+	{
+		__m128i truncated = _mm_cvttps_epi32(x);
+		__m128 fraction = _mm_sub_ps(x, _mm_cvtepi32_ps(truncated));
+
+		// All bits set (-1) where the fraction reaches a half, away from zero.
+		__m128i up = _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f)));
+		__m128i down = _mm_castps_si128(_mm_cmple_ps(fraction, _mm_set1_ps(-0.5f)));
+
+		return _mm_add_epi32(_mm_sub_epi32(truncated, up), down);
+	}
+#endif
+
+	static void pack_vertex_scalar(const Vertex& src, const float* inv_scale, const float* offset, PackedVertex& dst)
+	{
+		for (int i = 0; i < 3; i++)
+			dst.position[i] = pack_snorm16((src.position[i] - offset[i]) * inv_scale[i]);
+
+		dst.position[3] = 0;
+		dst.normal = pack_snorm_10_10_10_2(src.normal[0], src.normal[1], src.normal[2]);
+		dst.uv[0] = float_to_half(src.uv[0]);
+		dst.uv[1] = float_to_half(src.uv[1]);
+	}
+
+	void pack_vertices(const Vertex* src, uint32_t count, const float* position_scale, const float* position_offset, PackedVertex* dst)
+	{
+		float inv_scale[3];
+
+		for (int i = 0; i < 3; i++)
+			inv_scale[i] = position_scale[i] > 0.0f ? 1.0f / position_scale[i] : 0.0f;
+
+		uint32_t i = 0;
+
+#if defined(DW_MESH_PACKER_SSE2)
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 minus_one = _mm_set1_ps(-1.0f);
+		const __m128 snorm16_max = _mm_set1_ps(32767.0f);
+		const __m128 snorm10_max = _mm_set1_ps(511.0f);
+		const __m128 v_inv_scale = _mm_set_ps(0.0f, inv_scale[2], inv_scale[1], inv_scale[0]);
+		const __m128 v_offset = _mm_set_ps(0.0f, position_offset[2], position_offset[1], position_offset[0]);
+		const __m128i mask_10 = _mm_set1_epi32(0x3FF);
+
+		// Two vertices per iteration: positions of both end up in one 128-bit register after packing.
+		for (; i + 2 <= count; i += 2)
+		{
+			const Vertex& a = src[i];
+			const Vertex& b = src[i + 1];
+
+			__m128 pa = _mm_set_ps(0.0f, a.position[2], a.position[1], a.position[0]);
+			__m128 pb = _mm_set_ps(0.0f, b.position[2], b.position[1], b.position[0]);
+
+			pa = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(pa, v_offset), v_inv_scale), minus_one), one), snorm16_max);
+			pb = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(pb, v_offset), v_inv_scale), minus_one), one), snorm16_max);
+
+			__m128i positions = _mm_packs_epi32(round_epi32(pa), round_epi32(pb));
+
+			_mm_storel_epi64((__m128i*)dst[i].position, positions);
+			_mm_storel_epi64((__m128i*)dst[i + 1].position, _mm_unpackhi_epi64(positions, positions));
+
+			// Normals are quantized in SIMD, the final 10:10:10:2 bit packing is done per vertex.
+			__m128 na = _mm_set_ps(0.0f, a.normal[2], a.normal[1], a.normal[0]);
+			__m128 nb = _mm_set_ps(0.0f, b.normal[2], b.normal[1], b.normal[0]);
+
+			__m128i ina = _mm_and_si128(round_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(na, minus_one), one), snorm10_max)), mask_10);
+			__m128i inb = _mm_and_si128(round_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(nb, minus_one), one), snorm10_max)), mask_10);
+
+			alignas(16) uint32_t na_bits[4];
+			alignas(16) uint32_t nb_bits[4];
+			_mm_store_si128((__m128i*)na_bits, ina);
+			_mm_store_si128((__m128i*)nb_bits, inb);
+
+			dst[i].normal = na_bits[0] | (na_bits[1] << 10) | (na_bits[2] << 20);
+			dst[i + 1].normal = nb_bits[0] | (nb_bits[1] << 10) | (nb_bits[2] << 20);
+
+#if defined(DW_MESH_PACKER_F16C)
+			__m128i uvs = _mm_cvtps_ph(_mm_set_ps(b.uv[1], b.uv[0], a.uv[1], a.uv[0]), _MM_FROUND_TO_NEAREST_INT);
+			alignas(16) uint16_t uv_bits[8];
+			_mm_store_si128((__m128i*)uv_bits, uvs);
+
+			dst[i].uv[0] = uv_bits[0];
+			dst[i].uv[1] = uv_bits[1];
+			dst[i + 1].uv[0] = uv_bits[2];
+			dst[i + 1].uv[1] = uv_bits[3];
+#else
+			dst[i].uv[0] = float_to_half(a.uv[0]);
+			dst[i].uv[1] = float_to_half(a.uv[1]);
+			dst[i + 1].uv[0] = float_to_half(b.uv[0]);
+			dst[i + 1].uv[1] = float_to_half(b.uv[1]);
+#endif
+		}
+#endif
+
+		for (; i < count; i++)
+			pack_vertex_scalar(src[i], inv_scale, position_offset, dst[i]);
+	}
+
+	void pack_mesh(const Mesh& src, PackedMesh& dst)
+	{
+		float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (const auto& vertex : src.vertices)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				min[i] = std::min(min[i], vertex.position[i]);
+				max[i] = std::max(max[i], vertex.position[i]);
+			}
+		}
+
+		if (src.vertices.empty())
+		{
+			for (int i = 0; i < 3; i++)
+				min[i] = max[i] = 0.0f;
+		}
+
+		// Map the bounds onto [-1, 1] so the full SNORM16 range is used on every axis.
+		for (int i = 0; i < 3; i++)
+		{
+			dst.position_offset[i] = (min[i] + max[i]) * 0.5f;
+			dst.position_scale[i] = (max[i] - min[i]) * 0.5f;
+		}
+
+		dst.vertices.resize(src.vertices.size());
+		dst.indices = src.indices;
+
+		pack_vertices(src.vertices.data(), (uint32_t)src.vertices.size(), dst.position_scale, dst.position_offset, dst.vertices.data());
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "mesh.h"
+#include "gfx_device.h"
+
+namespace mesh
+{
+	// Packed vertex layout, 16 bytes instead of the 32 bytes of mesh::Vertex:
+	//   position : 4 x SNORM16, relative to the mesh bounds (w is unused)
+	//   normal   : A2B10G10R10 SNORM
+	//   uv       : 2 x SFLOAT16
+	struct PackedVertex
+	{
+		int16_t  position[4];
+		uint32_t normal;
+		uint16_t uv[2];
+	};
+
+	struct PackedMesh
+	{
+		std::vector<PackedVertex> vertices;
+		std::vector<uint32_t>	  indices;
+		// Vertex shader reconstructs the position as position * position_scale + position_offset.
+		float					  position_scale[3];
+		float					  position_offset[3];
+	};
+
+	// Input elements describing PackedVertex for Device::CreateInputLayout.
+	extern const gfx::InputElementDesc g_packed_vertex_elements[3];
+
+	extern uint16_t float_to_half(float value);
+	extern float half_to_float(uint16_t value);
+
+	extern void pack_mesh(const Mesh& src, PackedMesh& dst);
+	extern void pack_vertices(const Vertex* src, uint32_t count, const float* position_scale, const float* position_offset, PackedVertex* dst);
+}
@@ -0,0 +1,45 @@
+#include "mesh_upload.h"
+#include <iostream>
+
+namespace mesh
+{
+	bool upload_mesh_cache(gfx::Device& device, const MeshCache& cache, gfx::BufferHandle& vertex_buffer, gfx::BufferHandle& index_buffer, bool streamable)
+	{
+		vertex_buffer = gfx::BufferHandle();
+		index_buffer = gfx::BufferHandle();
+
+		// Vulkan has no empty buffers.
+		if (cache.header->vertex_data_size == 0 || cache.header->index_data_size == 0)
+			return false;
+
+		gfx::BufferCreateDesc desc = {};
+		desc.size = cache.header->vertex_data_size;
+		desc.usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		desc.usage = gfx::BufferUsage::STATIC;
+		desc.data = cache.vertex_data;
+		desc.streamable = streamable;
+
+		vertex_buffer = device.CreateBuffer(desc);
+
+		desc.size = cache.header->index_data_size;
+		desc.usageFlags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		desc.data = cache.index_data;
+
+		index_buffer = device.CreateBuffer(desc);
+
+		if (vertex_buffer.valid() && index_buffer.valid())
+			return true;
+
+		if (vertex_buffer.valid())
+			device.DestroyBuffer(vertex_buffer);
+
+		if (index_buffer.valid())
+			device.DestroyBuffer(index_buffer);
+
+		vertex_buffer = gfx::BufferHandle();
+		index_buffer = gfx::BufferHandle();
+
+		std::cout << "Failed to upload mesh cache" << std::endl;
+		return false;
+	}
+}
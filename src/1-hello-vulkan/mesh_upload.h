@@ -0,0 +1,14 @@
+#pragma once
+
+#include "mesh_cache.h"
+#include "gfx_device.h"
+
+namespace mesh
+{
+	// Creates a static vertex and an index buffer holding the cache's two sections. Each section is
+	// copied straight from the mapping into the device's staging buffer, or into the buffer itself when
+	// it is host visible, with no intermediate copy. A mesh is then drawn with its index range
+	// (index_offset over the index size) and base_vertex. Both handles are invalid on failure.
+	// Streamable buffers may be demoted by the device's residency manager.
+	extern bool upload_mesh_cache(gfx::Device& device, const MeshCache& cache, gfx::BufferHandle& vertex_buffer, gfx::BufferHandle& index_buffer, bool streamable = false);
+}
@@ -0,0 +1,485 @@
+#include "post_process.h"
+#include "memory_policy.h"
+#include <algorithm>
+
+#define DW_POST_GROUP_SIZE 8
+#define DW_INVALID_MEMORY_TYPE 0xFFFFFFFF
+// Weight of each smaller mip as it is added on the way back up the bloom chain.
+#define DW_BLOOM_UPSAMPLE_WEIGHT 1.0f
+
+PostProcess::PostProcess() : m_physical_device(VK_NULL_HANDLE), m_device(VK_NULL_HANDLE), m_slots(0), m_family_count(0), m_memory_type(0), m_sampler(VK_NULL_HANDLE),
+							 m_set_layout(VK_NULL_HANDLE), m_pipeline_layout(VK_NULL_HANDLE), m_descriptor_pool(VK_NULL_HANDLE), m_bloom_mips(0),
+							 m_bloom({}), m_ldr({}), m_linear_output(false), m_swap_red_blue(false)
+{
+	for (uint32_t i = 0; i < PostShader::COUNT; i++)
+		m_pipelines[i] = VK_NULL_HANDLE;
+
+	for (uint32_t i = 0; i < DW_POST_MAX_SLOTS; i++)
+	{
+		m_scene[i] = {};
+		m_output[i] = {};
+	}
+
+	for (uint32_t i = 0; i < DW_BLOOM_MIPS; i++)
+		m_bloom_views[i] = VK_NULL_HANDLE;
+
+	m_settings.exposure = 1.0f;
+	m_settings.bloom_threshold = 1.0f;
+	m_settings.bloom_knee = 0.5f;
+	m_settings.bloom_intensity = 0.05f;
+	m_settings.fxaa = true;
+}
+
+bool PostProcess::initialize(VkPhysicalDevice physical_device, VkDevice device, const std::vector<char>* spirv, uint32_t slots, uint32_t graphics_family, uint32_t compute_family)
+{
+	m_physical_device = physical_device;
+	m_device = device;
+	m_slots = std::min(slots, (uint32_t)DW_POST_MAX_SLOTS);
+
+	m_families[0] = graphics_family;
+	m_families[1] = compute_family;
+	m_family_count = graphics_family == compute_family ? 1 : 2;
+
+	VkSamplerCreateInfo sampler_info = {};
+	sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_info.magFilter = VK_FILTER_LINEAR;
+	sampler_info.minFilter = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+	if (vkCreateSampler(device, &sampler_info, nullptr, &m_sampler) != VK_SUCCESS)
+		return false;
+
+	// Every pass has the same interface: up to two sampled inputs and a storage image output.
+	VkDescriptorSetLayoutBinding bindings[3] = {};
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = i < 2 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo set_layout_info = {};
+	set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	set_layout_info.bindingCount = 3;
+	set_layout_info.pBindings = bindings;
+
+	if (vkCreateDescriptorSetLayout(device, &set_layout_info, nullptr, &m_set_layout) != VK_SUCCESS)
+		return false;
+
+	VkPushConstantRange push_range = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Constants) };
+
+	VkPipelineLayoutCreateInfo layout_info = {};
+	layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layout_info.setLayoutCount = 1;
+	layout_info.pSetLayouts = &m_set_layout;
+	layout_info.pushConstantRangeCount = 1;
+	layout_info.pPushConstantRanges = &push_range;
+
+	if (vkCreatePipelineLayout(device, &layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS)
+		return false;
+
+	for (uint32_t i = 0; i < PostShader::COUNT; i++)
+	{
+		VkShaderModuleCreateInfo module_info = {};
+		module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		module_info.codeSize = spirv[i].size();
+		module_info.pCode = reinterpret_cast<const uint32_t*>(spirv[i].data());
+
+		VkShaderModule module;
+		if (vkCreateShaderModule(device, &module_info, nullptr, &module) != VK_SUCCESS)
+			return false;
+
+		VkComputePipelineCreateInfo pipeline_info = {};
+		pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipeline_info.stage.module = module;
+		pipeline_info.stage.pName = "main";
+		pipeline_info.layout = m_pipeline_layout;
+		pipeline_info.basePipelineIndex = -1;
+
+		VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_pipelines[i]);
+		vkDestroyShaderModule(device, module, nullptr);
+
+		if (result != VK_SUCCESS)
+		{
+			m_pipelines[i] = VK_NULL_HANDLE;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void PostProcess::shutdown(DeletionQueue& deletion_queue)
+{
+	retire_images(deletion_queue);
+
+	for (uint32_t i = 0; i < PostShader::COUNT; i++)
+	{
+		if (m_pipelines[i] != VK_NULL_HANDLE)
+			vkDestroyPipeline(m_device, m_pipelines[i], nullptr);
+
+		m_pipelines[i] = VK_NULL_HANDLE;
+	}
+
+	if (m_pipeline_layout != VK_NULL_HANDLE)
+		vkDestroyPipelineLayout(m_device, m_pipeline_layout, nullptr);
+
+	if (m_set_layout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(m_device, m_set_layout, nullptr);
+
+	if (m_sampler != VK_NULL_HANDLE)
+		vkDestroySampler(m_device, m_sampler, nullptr);
+
+	m_pipeline_layout = VK_NULL_HANDLE;
+	m_set_layout = VK_NULL_HANDLE;
+	m_sampler = VK_NULL_HANDLE;
+}
+
+bool PostProcess::create_image(VkFormat format, VkExtent2D extent, uint32_t mips, VkImageUsageFlags usage, bool shared, PostImage& image)
+{
+	image = {};
+
+	VkImageCreateInfo image_info = {};
+	image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image_info.imageType = VK_IMAGE_TYPE_2D;
+	image_info.format = format;
+	image_info.extent = { extent.width, extent.height, 1 };
+	image_info.mipLevels = mips;
+	image_info.arrayLayers = 1;
+	image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+	image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	image_info.usage = usage;
+	image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	// Concurrent sharing instead of queue family ownership transfers for images that cross queues.
+	if (shared && m_family_count > 1)
+	{
+		image_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		image_info.queueFamilyIndexCount = m_family_count;
+		image_info.pQueueFamilyIndices = m_families;
+	}
+	else
+		image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateImage(m_device, &image_info, nullptr, &image.image) != VK_SUCCESS)
+		return false;
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(m_device, image.image, &requirements);
+
+	gfx::MemoryPolicy policy;
+	policy.Init(m_physical_device);
+
+	uint32_t memory_type = policy.FindType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	if (memory_type == DW_INVALID_MEMORY_TYPE)
+	{
+		vkDestroyImage(m_device, image.image, nullptr);
+		image = {};
+		return false;
+	}
+
+	VkMemoryAllocateInfo alloc_info = {};
+	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc_info.allocationSize = requirements.size;
+	alloc_info.memoryTypeIndex = memory_type;
+
+	if (vkAllocateMemory(m_device, &alloc_info, nullptr, &image.memory) != VK_SUCCESS)
+	{
+		vkDestroyImage(m_device, image.image, nullptr);
+		image = {};
+		return false;
+	}
+
+	m_memory_type = memory_type;
+	image.size = requirements.size;
+
+	if (vkBindImageMemory(m_device, image.image, image.memory, 0) != VK_SUCCESS)
+		return false;
+
+	image.view = create_view(image.image, format, 0);
+
+	return image.view != VK_NULL_HANDLE;
+}
+
+void PostProcess::retire_image(PostImage& image, DeletionQueue& deletion_queue)
+{
+	if (image.view != VK_NULL_HANDLE)
+		deletion_queue.destroy_image_view(image.view);
+
+	if (image.image != VK_NULL_HANDLE)
+		deletion_queue.destroy_image(image.image);
+
+	if (image.memory != VK_NULL_HANDLE)
+		deletion_queue.free_memory(image.memory);
+
+	image = {};
+}
+
+VkImageView PostProcess::create_view(VkImage image, VkFormat format, uint32_t mip)
+{
+	VkImageViewCreateInfo view_info = {};
+	view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	view_info.image = image;
+	view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	view_info.format = format;
+	view_info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, 0, 1 };
+
+	VkImageView view;
+	if (vkCreateImageView(m_device, &view_info, nullptr, &view) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	return view;
+}
+
+void PostProcess::retire_images(DeletionQueue& deletion_queue)
+{
+	for (uint32_t i = 0; i < m_slots; i++)
+	{
+		retire_image(m_scene[i], deletion_queue);
+		retire_image(m_output[i], deletion_queue);
+	}
+
+	retire_image(m_bloom, deletion_queue);
+	retire_image(m_ldr, deletion_queue);
+
+	// View 0 belonged to the bloom image itself.
+	for (uint32_t i = 1; i < m_bloom_mips; i++)
+		deletion_queue.destroy_image_view(m_bloom_views[i]);
+
+	if (m_descriptor_pool != VK_NULL_HANDLE)
+		deletion_queue.destroy_descriptor_pool(m_descriptor_pool);
+
+	m_descriptor_pool = VK_NULL_HANDLE;
+	m_bloom_mips = 0;
+	m_sets.clear();
+}
+
+bool PostProcess::resize(VkExtent2D extent, DeletionQueue& deletion_queue)
+{
+	retire_images(deletion_queue);
+
+	for (uint32_t i = 0; i < m_slots; i++)
+	{
+		if (!create_image(DW_POST_SCENE_FORMAT, extent, 1, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, true, m_scene[i]) ||
+			!create_image(DW_POST_OUTPUT_FORMAT, extent, 1, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true, m_output[i]))
+			return false;
+	}
+
+	VkExtent2D bloom_extent = { std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u) };
+
+	m_bloom_mips = 1;
+
+	while (m_bloom_mips < DW_BLOOM_MIPS && std::max(bloom_extent.width, bloom_extent.height) >> m_bloom_mips > 0)
+		m_bloom_mips++;
+
+	if (!create_image(DW_POST_SCENE_FORMAT, bloom_extent, m_bloom_mips, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, false, m_bloom) ||
+		!create_image(DW_POST_OUTPUT_FORMAT, extent, 1, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, false, m_ldr))
+		return false;
+
+	m_bloom_views[0] = m_bloom.view;
+
+	for (uint32_t i = 1; i < m_bloom_mips; i++)
+	{
+		m_bloom_views[i] = create_view(m_bloom.image, DW_POST_SCENE_FORMAT, i);
+
+		if (m_bloom_views[i] == VK_NULL_HANDLE)
+			return false;
+	}
+
+	return create_descriptor_sets();
+}
+
+bool PostProcess::create_descriptor_sets()
+{
+	uint32_t per_slot = m_bloom_mips * 2 + 1;
+	uint32_t set_count = per_slot * m_slots;
+
+	VkDescriptorPoolSize pool_sizes[] =
+	{
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, set_count * 2 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, set_count }
+	};
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets = set_count;
+	pool_info.poolSizeCount = 2;
+	pool_info.pPoolSizes = pool_sizes;
+
+	if (vkCreateDescriptorPool(m_device, &pool_info, nullptr, &m_descriptor_pool) != VK_SUCCESS)
+	{
+		m_descriptor_pool = VK_NULL_HANDLE;
+		return false;
+	}
+
+	m_sets.resize(set_count);
+	std::vector<VkDescriptorSetLayout> layouts(set_count, m_set_layout);
+
+	VkDescriptorSetAllocateInfo alloc_info = {};
+	alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	alloc_info.descriptorPool = m_descriptor_pool;
+	alloc_info.descriptorSetCount = set_count;
+	alloc_info.pSetLayouts = layouts.data();
+
+	if (vkAllocateDescriptorSets(m_device, &alloc_info, m_sets.data()) != VK_SUCCESS)
+		return false;
+
+	// The images only change on resize, so the sets are written once here rather than per frame.
+	for (uint32_t slot = 0; slot < m_slots; slot++)
+	{
+		VkDescriptorSet* sets = &m_sets[slot * per_slot];
+
+		write_set(sets[0], m_scene[slot].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_NULL_HANDLE, m_bloom_views[0]);
+
+		for (uint32_t i = 1; i < m_bloom_mips; i++)
+			write_set(sets[i], m_bloom_views[i - 1], VK_IMAGE_LAYOUT_GENERAL, VK_NULL_HANDLE, m_bloom_views[i]);
+
+		// Upsample into mip i from mip i + 1.
+		for (uint32_t i = 0; i + 1 < m_bloom_mips; i++)
+			write_set(sets[m_bloom_mips + i], m_bloom_views[i + 1], VK_IMAGE_LAYOUT_GENERAL, VK_NULL_HANDLE, m_bloom_views[i]);
+
+		write_set(sets[m_bloom_mips * 2 - 1], m_scene[slot].view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, m_bloom_views[0], m_ldr.view);
+		write_set(sets[m_bloom_mips * 2], m_ldr.view, VK_IMAGE_LAYOUT_GENERAL, VK_NULL_HANDLE, m_output[slot].view);
+	}
+
+	return true;
+}
+
+void PostProcess::write_set(VkDescriptorSet set, VkImageView input, VkImageLayout input_layout, VkImageView secondary, VkImageView output)
+{
+	VkDescriptorImageInfo images[3] =
+	{
+		{ m_sampler, input, input_layout },
+		{ m_sampler, secondary, VK_IMAGE_LAYOUT_GENERAL },
+		{ VK_NULL_HANDLE, output, VK_IMAGE_LAYOUT_GENERAL }
+	};
+
+	VkWriteDescriptorSet writes[3] = {};
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		// Only the tonemap pass reads a second input; bindings a shader doesn't use may stay empty.
+		if (images[i].imageView == VK_NULL_HANDLE)
+			continue;
+
+		VkWriteDescriptorSet& write = writes[count++];
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = set;
+		write.dstBinding = i;
+		write.descriptorCount = 1;
+		write.descriptorType = i < 2 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		write.pImageInfo = &images[i];
+	}
+
+	vkUpdateDescriptorSets(m_device, count, writes, 0, nullptr);
+}
+
+void PostProcess::dispatch(VkCommandBuffer cmd, uint32_t shader, VkDescriptorSet set, VkExtent2D src, VkExtent2D dst, const float* params)
+{
+	Constants constants = { { (int32_t)src.width, (int32_t)src.height }, { (int32_t)dst.width, (int32_t)dst.height }, { params[0], params[1], params[2], params[3] } };
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[shader]);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &set, 0, nullptr);
+	vkCmdPushConstants(cmd, m_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Constants), &constants);
+	vkCmdDispatch(cmd, (dst.width + DW_POST_GROUP_SIZE - 1) / DW_POST_GROUP_SIZE, (dst.height + DW_POST_GROUP_SIZE - 1) / DW_POST_GROUP_SIZE, 1);
+
+	// Every pass reads what the one before it wrote.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void PostProcess::record(VkCommandBuffer cmd, uint32_t slot, VkExtent2D render_extent, GpuTimer& timer)
+{
+	uint32_t per_slot = m_bloom_mips * 2 + 1;
+	const VkDescriptorSet* sets = &m_sets[slot * per_slot];
+
+	// Part of each bloom mip in use, following the render extent down the chain.
+	VkExtent2D regions[DW_BLOOM_MIPS];
+	regions[0] = { std::max(render_extent.width / 2, 1u), std::max(render_extent.height / 2, 1u) };
+
+	for (uint32_t i = 1; i < m_bloom_mips; i++)
+		regions[i] = { std::max(regions[i - 1].width / 2, 1u), std::max(regions[i - 1].height / 2, 1u) };
+
+	// Nothing of the previous contents is needed. The source stage covers the previous chain on this
+	// queue, which read and wrote the shared bloom and LDR images.
+	VkImageMemoryBarrier barriers[3] = {};
+	VkImage images[3] = { m_bloom.image, m_ldr.image, m_output[slot].image };
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barriers[i].srcAccessMask = 0;
+		barriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barriers[i].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barriers[i].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barriers[i].image = images[i];
+		barriers[i].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1 };
+	}
+
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 3, barriers);
+
+	uint32_t scope = timer.begin_scope(cmd, "bloom downsample");
+
+	for (uint32_t i = 0; i < m_bloom_mips; i++)
+	{
+		// Only the first mip applies the threshold.
+		float params[4] = { m_settings.bloom_threshold, m_settings.bloom_knee, i == 0 ? 1.0f : 0.0f, 0.0f };
+		dispatch(cmd, PostShader::DOWNSAMPLE, sets[i], i == 0 ? render_extent : regions[i - 1], regions[i], params);
+	}
+
+	timer.end_scope(cmd, scope);
+	scope = timer.begin_scope(cmd, "bloom upsample");
+
+	for (uint32_t i = m_bloom_mips - 1; i > 0; i--)
+	{
+		float params[4] = { DW_BLOOM_UPSAMPLE_WEIGHT, 0.0f, 0.0f, 0.0f };
+		dispatch(cmd, PostShader::UPSAMPLE, sets[m_bloom_mips + i - 1], regions[i], regions[i - 1], params);
+	}
+
+	timer.end_scope(cmd, scope);
+	scope = timer.begin_scope(cmd, "tonemap");
+
+	float tonemap_params[4] = { m_settings.exposure, m_settings.bloom_intensity, (float)regions[0].width, (float)regions[0].height };
+	dispatch(cmd, PostShader::TONEMAP, sets[m_bloom_mips * 2 - 1], render_extent, render_extent, tonemap_params);
+
+	timer.end_scope(cmd, scope);
+	scope = timer.begin_scope(cmd, "fxaa");
+
+	float fxaa_params[4] = { m_settings.fxaa ? 1.0f : 0.0f, m_linear_output ? 1.0f : 0.0f, m_swap_red_blue ? 1.0f : 0.0f, 0.0f };
+	dispatch(cmd, PostShader::FXAA, sets[m_bloom_mips * 2], render_extent, render_extent, fxaa_params);
+
+	timer.end_scope(cmd, scope);
+
+	// For the blit or copy to the swap chain when it is on the same queue.
+	VkMemoryBarrier to_transfer = {};
+	to_transfer.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	to_transfer.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	to_transfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &to_transfer, 0, nullptr, 0, nullptr);
+}
+
+VkDeviceSize PostProcess::allocated() const
+{
+	VkDeviceSize size = m_bloom.size + m_ldr.size;
+
+	for (uint32_t i = 0; i < m_slots; i++)
+		size += m_scene[i].size + m_output[i].size;
+
+	return size;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+#include "deletion_queue.h"
+#include "gpu_timer.h"
+
+// What the scene is rendered (resolved) into and what the chain outputs.
+#define DW_POST_SCENE_FORMAT VK_FORMAT_R16G16B16A16_SFLOAT
+#define DW_POST_OUTPUT_FORMAT VK_FORMAT_R8G8B8A8_UNORM
+// Levels of the bloom chain, the first at half the scene's size. Fewer for tiny windows.
+#define DW_BLOOM_MIPS 5
+#define DW_POST_MAX_SLOTS 4
+
+namespace PostShader
+{
+	enum
+	{
+		DOWNSAMPLE,
+		UPSAMPLE,
+		TONEMAP,
+		FXAA,
+		COUNT
+	};
+}
+
+struct PostProcessSettings
+{
+	float exposure;
+	// Scene brightness where bloom starts, and the share of it over which it fades in.
+	float bloom_threshold;
+	float bloom_knee;
+	float bloom_intensity;
+	bool  fxaa;
+};
+
+struct PostImage
+{
+	VkImage		   image;
+	VkDeviceMemory memory;
+	VkImageView	   view;
+	VkDeviceSize   size;
+};
+
+// Compute post-processing from the HDR scene to the image presented:
+//
+//   scene -> bloom downsample (one pass per mip) -> bloom upsample (back up the chain, adding)
+//         -> tonemap (exposure, bloom, ACES, sRGB encoding) -> FXAA -> output
+//
+// The blur kernels tile their source texels through shared memory. Everything runs on storage
+// images in the GENERAL layout except the scene, which the render pass resolves into and leaves in
+// SHADER_READ_ONLY_OPTIMAL.
+//
+// Scene and output images exist once per frame slot, so the chain of one frame can run on an async
+// compute queue while the graphics queue renders the next frame into the other slot's scene and
+// blits the previous output. Both are shared concurrently between the graphics and compute queue
+// families when those differ. The bloom chain and the tonemapped image are only touched by the
+// chain itself, so one of each is enough: a frame's chain only starts once the previous one on the
+// same queue has finished with them.
+class PostProcess
+{
+public:
+	PostProcess();
+
+	// spirv is indexed by PostShader. Images are created by resize().
+	bool initialize(VkPhysicalDevice physical_device, VkDevice device, const std::vector<char>* spirv, uint32_t slots, uint32_t graphics_family, uint32_t compute_family);
+	// Retires the images like resize(); everything else is destroyed right away, so the device must be idle.
+	void shutdown(DeletionQueue& deletion_queue);
+
+	// (Re)creates all images at extent, the full swap chain size. Old ones are retired through the
+	// deletion queue, whose frame must already cover everything that may still use them.
+	bool resize(VkExtent2D extent, DeletionQueue& deletion_queue);
+
+	// How the output is written for the way it gets to the swap chain: linear values when blitted into
+	// an sRGB format (the blit encodes again), red and blue swapped when copied raw into a BGRA one.
+	inline void set_output_encoding(bool linear, bool swap_red_blue) { m_linear_output = linear; m_swap_red_blue = swap_red_blue; }
+
+	// Records the whole chain for the slot's scene, of which render_extent is used. Each pass is a
+	// scope of timer, which must have begun a frame on cmd. The output ends up in GENERAL, visible
+	// to transfers on the same queue; other queues need a semaphore.
+	void record(VkCommandBuffer cmd, uint32_t slot, VkExtent2D render_extent, GpuTimer& timer);
+
+	inline VkImageView scene_view(uint32_t slot) const { return m_scene[slot].view; }
+	inline VkImage output_image(uint32_t slot) const { return m_output[slot].image; }
+
+	inline PostProcessSettings& settings() { return m_settings; }
+	// All images, for residency tracking. They share one device local memory type.
+	VkDeviceSize allocated() const;
+	inline uint32_t memory_type() const { return m_memory_type; }
+
+private:
+	struct Constants
+	{
+		int32_t src_size[2];
+		int32_t dst_size[2];
+		float	params[4];
+	};
+
+	bool create_image(VkFormat format, VkExtent2D extent, uint32_t mips, VkImageUsageFlags usage, bool shared, PostImage& image);
+	void retire_image(PostImage& image, DeletionQueue& deletion_queue);
+	void retire_images(DeletionQueue& deletion_queue);
+	VkImageView create_view(VkImage image, VkFormat format, uint32_t mip);
+	bool create_descriptor_sets();
+	void write_set(VkDescriptorSet set, VkImageView input, VkImageLayout input_layout, VkImageView secondary, VkImageView output);
+	void dispatch(VkCommandBuffer cmd, uint32_t shader, VkDescriptorSet set, VkExtent2D src, VkExtent2D dst, const float* params);
+
+private:
+	VkPhysicalDevice	  m_physical_device;
+	VkDevice			  m_device;
+	uint32_t			  m_slots;
+	uint32_t			  m_families[2];
+	uint32_t			  m_family_count;
+	uint32_t			  m_memory_type;
+	VkSampler			  m_sampler;
+	VkDescriptorSetLayout m_set_layout;
+	VkPipelineLayout	  m_pipeline_layout;
+	VkPipeline			  m_pipelines[PostShader::COUNT];
+	// Recreated with the images, since sets still used by frames in flight can't be rewritten.
+	VkDescriptorPool	  m_descriptor_pool;
+	uint32_t			  m_bloom_mips;
+	PostImage			  m_scene[DW_POST_MAX_SLOTS];
+	PostImage			  m_output[DW_POST_MAX_SLOTS];
+	PostImage			  m_bloom;
+	PostImage			  m_ldr;
+	VkImageView			  m_bloom_views[DW_BLOOM_MIPS];
+	// Per slot: downsample per mip, upsample per mip but the last, tonemap, FXAA.
+	std::vector<VkDescriptorSet> m_sets;
+	PostProcessSettings	  m_settings;
+	bool				  m_linear_output;
+	bool				  m_swap_red_blue;
+};
@@ -0,0 +1,371 @@
+#include "render_targets.h"
+#include "memory_policy.h"
+
+#define DW_INVALID_MEMORY_TYPE 0xFFFFFFFF
+
+static bool is_depth_format(VkFormat format)
+{
+	return format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D16_UNORM;
+}
+
+VkSampleCountFlagBits max_sample_count(VkPhysicalDevice device)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device, &properties);
+
+	VkSampleCountFlags counts = properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
+
+	for (uint32_t samples = VK_SAMPLE_COUNT_64_BIT; samples > VK_SAMPLE_COUNT_1_BIT; samples >>= 1)
+	{
+		if (counts & samples)
+			return (VkSampleCountFlagBits)samples;
+	}
+
+	return VK_SAMPLE_COUNT_1_BIT;
+}
+
+VkSampleCountFlagBits choose_sample_count(VkPhysicalDevice device, uint32_t requested)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device, &properties);
+
+	VkSampleCountFlags counts = properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
+
+	for (uint32_t samples = VK_SAMPLE_COUNT_64_BIT; samples > VK_SAMPLE_COUNT_1_BIT; samples >>= 1)
+	{
+		if (samples <= requested && (counts & samples))
+			return (VkSampleCountFlagBits)samples;
+	}
+
+	return VK_SAMPLE_COUNT_1_BIT;
+}
+
+VkFormat choose_depth_format(VkPhysicalDevice device)
+{
+	const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
+
+	for (VkFormat format : candidates)
+	{
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(device, format, &properties);
+
+		if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+			return format;
+	}
+
+	return VK_FORMAT_UNDEFINED;
+}
+
+VkFormat choose_shadow_format(VkPhysicalDevice device)
+{
+	const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM };
+	const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+	for (VkFormat format : candidates)
+	{
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(device, format, &properties);
+
+		if ((properties.optimalTilingFeatures & required) == required)
+			return format;
+	}
+
+	return VK_FORMAT_UNDEFINED;
+}
+
+static bool create_target(VkPhysicalDevice physical_device, VkDevice device, VkFormat format, VkExtent2D extent, VkSampleCountFlagBits samples, VkImageUsageFlags usage, bool transient, RenderTarget& target)
+{
+	bool depth = is_depth_format(format);
+
+	target = {};
+	target.format = format;
+	target.samples = samples;
+
+	VkImageCreateInfo image_info = {};
+	image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image_info.imageType = VK_IMAGE_TYPE_2D;
+	image_info.format = format;
+	image_info.extent = { extent.width, extent.height, 1 };
+	image_info.mipLevels = 1;
+	image_info.arrayLayers = 1;
+	image_info.samples = samples;
+	image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	image_info.usage = usage | (depth ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+
+	if (transient)
+		image_info.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+	image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if (vkCreateImage(device, &image_info, nullptr, &target.image) != VK_SUCCESS)
+		return false;
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(device, target.image, &requirements);
+
+	gfx::MemoryPolicy policy;
+	policy.Init(physical_device);
+
+	// Lazily allocated types are device local by definition, no need to ask for both. Only transient
+	// images may be bound to them.
+	target.memory_type = transient ? policy.FindType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) : DW_INVALID_MEMORY_TYPE;
+	target.lazy = target.memory_type != DW_INVALID_MEMORY_TYPE;
+
+	if (!target.lazy)
+		target.memory_type = policy.FindType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	if (target.memory_type == DW_INVALID_MEMORY_TYPE)
+	{
+		destroy_render_target(device, target);
+		return false;
+	}
+
+	VkMemoryAllocateInfo alloc_info = {};
+	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc_info.allocationSize = requirements.size;
+	alloc_info.memoryTypeIndex = target.memory_type;
+
+	if (vkAllocateMemory(device, &alloc_info, nullptr, &target.memory) != VK_SUCCESS ||
+		vkBindImageMemory(device, target.image, target.memory, 0) != VK_SUCCESS)
+	{
+		destroy_render_target(device, target);
+		return false;
+	}
+
+	target.size = requirements.size;
+
+	VkImageViewCreateInfo view_info = {};
+	view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	view_info.image = target.image;
+	view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	view_info.format = format;
+	view_info.subresourceRange.aspectMask = depth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+	view_info.subresourceRange.levelCount = 1;
+	view_info.subresourceRange.layerCount = 1;
+
+	if (vkCreateImageView(device, &view_info, nullptr, &target.view) != VK_SUCCESS)
+	{
+		destroy_render_target(device, target);
+		return false;
+	}
+
+	return true;
+}
+
+bool create_transient_target(VkPhysicalDevice physical_device, VkDevice device, VkFormat format, VkExtent2D extent, VkSampleCountFlagBits samples, RenderTarget& target)
+{
+	return create_target(physical_device, device, format, extent, samples, 0, true, target);
+}
+
+bool create_render_target(VkPhysicalDevice physical_device, VkDevice device, VkFormat format, VkExtent2D extent, VkImageUsageFlags usage, RenderTarget& target)
+{
+	return create_target(physical_device, device, format, extent, VK_SAMPLE_COUNT_1_BIT, usage, false, target);
+}
+
+void destroy_render_target(VkDevice device, RenderTarget& target)
+{
+	if (target.view != VK_NULL_HANDLE)
+		vkDestroyImageView(device, target.view, nullptr);
+
+	if (target.image != VK_NULL_HANDLE)
+		vkDestroyImage(device, target.image, nullptr);
+
+	if (target.memory != VK_NULL_HANDLE)
+		vkFreeMemory(device, target.memory, nullptr);
+
+	target.view = VK_NULL_HANDLE;
+	target.image = VK_NULL_HANDLE;
+	target.memory = VK_NULL_HANDLE;
+}
+
+VkDeviceSize render_target_committed(VkDevice device, const RenderTarget& target)
+{
+	if (!target.lazy || target.memory == VK_NULL_HANDLE)
+		return target.size;
+
+	VkDeviceSize committed = 0;
+	vkGetDeviceMemoryCommitment(device, target.memory, &committed);
+
+	return committed;
+}
+
+VkRenderPass create_msaa_render_pass(VkDevice device, VkFormat output_format, VkFormat depth_format, VkSampleCountFlagBits samples, VkImageLayout final_layout)
+{
+	bool resolve = samples != VK_SAMPLE_COUNT_1_BIT;
+
+	VkAttachmentDescription attachments[3] = {};
+
+	// Multisampled color is only needed until the resolve, so it is never stored.
+	attachments[0].format = output_format;
+	attachments[0].samples = samples;
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[0].storeOp = resolve ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+	attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[0].finalLayout = resolve ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : final_layout;
+
+	attachments[1].format = depth_format;
+	attachments[1].samples = samples;
+	attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	// Fully overwritten by the resolve, the previous contents are never loaded.
+	attachments[2].format = output_format;
+	attachments[2].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[2].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[2].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachments[2].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[2].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[2].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[2].finalLayout = final_layout;
+
+	VkAttachmentReference color_ref = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	VkAttachmentReference depth_ref = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+	VkAttachmentReference resolve_ref = { 2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &color_ref;
+	subpass.pResolveAttachments = resolve ? &resolve_ref : nullptr;
+	subpass.pDepthStencilAttachment = &depth_ref;
+
+	// The transient targets are shared by every frame in flight, so each frame's writes have to wait
+	// for the previous frame's, not just for the swap chain image.
+	VkSubpassDependency dependencies[2] = {};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	// The output is read afterwards by transfers (upscale, readback) or shaders (post-processing).
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+	VkRenderPassCreateInfo render_pass_info = {};
+	render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	render_pass_info.attachmentCount = resolve ? 3 : 2;
+	render_pass_info.pAttachments = attachments;
+	render_pass_info.subpassCount = 1;
+	render_pass_info.pSubpasses = &subpass;
+	render_pass_info.dependencyCount = 2;
+	render_pass_info.pDependencies = dependencies;
+
+	VkRenderPass render_pass;
+
+	if (vkCreateRenderPass(device, &render_pass_info, nullptr, &render_pass) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	return render_pass;
+}
+
+VkFramebuffer create_msaa_framebuffer(VkDevice device, VkRenderPass render_pass, VkExtent2D extent, VkSampleCountFlagBits samples, VkImageView color, VkImageView depth, VkImageView output)
+{
+	VkImageView attachments[3] = { color, depth, output };
+	uint32_t count = 3;
+
+	if (samples == VK_SAMPLE_COUNT_1_BIT)
+	{
+		attachments[0] = output;
+		count = 2;
+	}
+
+	VkFramebufferCreateInfo framebuffer_info = {};
+	framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebuffer_info.renderPass = render_pass;
+	framebuffer_info.attachmentCount = count;
+	framebuffer_info.pAttachments = attachments;
+	framebuffer_info.width = extent.width;
+	framebuffer_info.height = extent.height;
+	framebuffer_info.layers = 1;
+
+	VkFramebuffer framebuffer;
+
+	if (vkCreateFramebuffer(device, &framebuffer_info, nullptr, &framebuffer) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	return framebuffer;
+}
+
+VkRenderPass create_depth_render_pass(VkDevice device, VkFormat depth_format, bool load, VkImageLayout initial_layout, VkImageLayout final_layout)
+{
+	VkAttachmentDescription attachment = {};
+	attachment.format = depth_format;
+	attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	attachment.loadOp = load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachment.initialLayout = load ? initial_layout : VK_IMAGE_LAYOUT_UNDEFINED;
+	attachment.finalLayout = final_layout;
+
+	VkAttachmentReference depth_ref = { 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.pDepthStencilAttachment = &depth_ref;
+
+	// What was there before may have been written by a copy (the loaded contents) and read by
+	// shaders or copies of an earlier frame, which the writes have to wait for.
+	VkSubpassDependency dependencies[2] = {};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+	VkRenderPassCreateInfo render_pass_info = {};
+	render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	render_pass_info.attachmentCount = 1;
+	render_pass_info.pAttachments = &attachment;
+	render_pass_info.subpassCount = 1;
+	render_pass_info.pSubpasses = &subpass;
+	render_pass_info.dependencyCount = 2;
+	render_pass_info.pDependencies = dependencies;
+
+	VkRenderPass render_pass;
+
+	if (vkCreateRenderPass(device, &render_pass_info, nullptr, &render_pass) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	return render_pass;
+}
+
+VkFramebuffer create_depth_framebuffer(VkDevice device, VkRenderPass render_pass, VkExtent2D extent, VkImageView depth)
+{
+	VkFramebufferCreateInfo framebuffer_info = {};
+	framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebuffer_info.renderPass = render_pass;
+	framebuffer_info.attachmentCount = 1;
+	framebuffer_info.pAttachments = &depth;
+	framebuffer_info.width = extent.width;
+	framebuffer_info.height = extent.height;
+	framebuffer_info.layers = 1;
+
+	VkFramebuffer framebuffer;
+
+	if (vkCreateFramebuffer(device, &framebuffer_info, nullptr, &framebuffer) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	return framebuffer;
+}
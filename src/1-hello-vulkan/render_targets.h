@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+
+// Samples per pixel unless the application asks for something else. Clamped to what the device supports.
+#define DW_DEFAULT_SAMPLE_COUNT 4
+
+// An image that is only ever used as an attachment within a render pass.
+struct RenderTarget
+{
+	VkImage					image;
+	VkDeviceMemory			memory;
+	VkImageView				view;
+	VkFormat				format;
+	VkSampleCountFlagBits	samples;
+	uint32_t				memory_type;
+	// What was allocated. For lazily allocated memory the driver may commit less (or nothing, on
+	// tilers), see render_target_committed().
+	VkDeviceSize			size;
+	bool					lazy;
+};
+
+// Highest sample count supported for both color and depth framebuffer attachments.
+extern VkSampleCountFlagBits max_sample_count(VkPhysicalDevice device);
+// The largest supported count that is at most requested; 0 or 1 means no multisampling.
+extern VkSampleCountFlagBits choose_sample_count(VkPhysicalDevice device, uint32_t requested);
+// First of D32, D32S8, D24S8 usable as an optimal tiling depth attachment, VK_FORMAT_UNDEFINED if none.
+extern VkFormat choose_depth_format(VkPhysicalDevice device);
+// First of D32, D16 usable as an optimal tiling depth attachment that shaders can also sample, for
+// shadow maps. VK_FORMAT_UNDEFINED if none.
+extern VkFormat choose_shadow_format(VkPhysicalDevice device);
+
+// Creates a color or depth attachment (by format) that does not outlive the render pass: transient
+// usage, backed by lazily allocated memory when the device has such a type. Tile-based GPUs then
+// keep the multisampled data in tile memory and never write it out; elsewhere it is regular
+// device local memory. Returns false and leaves nothing behind on failure.
+extern bool create_transient_target(VkPhysicalDevice physical_device, VkDevice device, VkFormat format, VkExtent2D extent, VkSampleCountFlagBits samples, RenderTarget& target);
+// Single sampled attachment in device local memory whose contents outlive the render pass, e.g. to
+// be blitted or sampled afterwards. usage is added to the attachment usage.
+extern bool create_render_target(VkPhysicalDevice physical_device, VkDevice device, VkFormat format, VkExtent2D extent, VkImageUsageFlags usage, RenderTarget& target);
+extern void destroy_render_target(VkDevice device, RenderTarget& target);
+// Bytes the driver actually committed for the target.
+extern VkDeviceSize render_target_committed(VkDevice device, const RenderTarget& target);
+
+// Single subpass render pass drawing color and depth at samples per pixel into output_format.
+//
+// Attachments are, in order: color, depth and, for samples > 1, the single sampled output the
+// color is resolved into at the end of the subpass. The resolve happens as part of the render pass
+// rather than as a separate blit, so the multisampled color never has to be stored. With one
+// sample, color is the output itself. Either way color clears from clear value 0 and depth from 1,
+// and the output ends up in final_layout.
+extern VkRenderPass create_msaa_render_pass(VkDevice device, VkFormat output_format, VkFormat depth_format, VkSampleCountFlagBits samples, VkImageLayout final_layout);
+// color is ignored for samples == 1.
+extern VkFramebuffer create_msaa_framebuffer(VkDevice device, VkRenderPass render_pass, VkExtent2D extent, VkSampleCountFlagBits samples, VkImageView color, VkImageView depth, VkImageView output);
+
+// Depth-only single subpass render pass, for shadow maps and other passes without color. Depth
+// either clears to 1 or, with load, keeps what the attachment holds in initial_layout (which must
+// then not be UNDEFINED), e.g. a copy of a cached layer to draw more on top of. It is stored and
+// left in final_layout. Pipelines for it have no color attachments, and usually no fragment shader.
+extern VkRenderPass create_depth_render_pass(VkDevice device, VkFormat depth_format, bool load, VkImageLayout initial_layout, VkImageLayout final_layout);
+extern VkFramebuffer create_depth_framebuffer(VkDevice device, VkRenderPass render_pass, VkExtent2D extent, VkImageView depth);
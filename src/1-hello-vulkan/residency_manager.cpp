@@ -0,0 +1,311 @@
+#include "residency_manager.h"
+#include <string.h>
+#include <iostream>
+#include <algorithm>
+
+static const char* g_CategoryNames[] =
+{
+	"textures",
+	"buffers",
+	"attachments",
+	"staging"
+};
+
+ResidencyManager::ResidencyManager() : m_device(VK_NULL_HANDLE), m_memory_budget(false), m_get_memory_properties2(nullptr), m_frame(0),
+									   m_streamable_count(0), m_evictions(0), m_failed_evictions(0), m_bytes_demoted(0)
+{
+	memset(&m_memory, 0, sizeof(m_memory));
+	memset(m_category_usage, 0, sizeof(m_category_usage));
+}
+
+void ResidencyManager::initialize(VkInstance instance, VkPhysicalDevice device, bool memory_budget)
+{
+	m_device = device;
+	vkGetPhysicalDeviceMemoryProperties(device, &m_memory);
+
+	m_heaps.resize(m_memory.memoryHeapCount);
+	m_tracked_at_query.assign(m_memory.memoryHeapCount, 0);
+	m_budget_caps.assign(m_memory.memoryHeapCount, 0);
+
+	for (uint32_t i = 0; i < m_memory.memoryHeapCount; i++)
+	{
+		m_heaps[i].size = m_memory.memoryHeaps[i].size;
+		m_heaps[i].budget = m_memory.memoryHeaps[i].size;
+		m_heaps[i].driver_usage = 0;
+		m_heaps[i].tracked_usage = 0;
+		m_heaps[i].device_local = (m_memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+	}
+
+	m_memory_budget = false;
+
+#if defined(VK_EXT_memory_budget) && defined(VK_KHR_get_physical_device_properties2)
+	if (memory_budget)
+	{
+		// Core in 1.1, otherwise through the KHR extension.
+		m_get_memory_properties2 = (void*)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2");
+
+		if (!m_get_memory_properties2)
+			m_get_memory_properties2 = (void*)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+
+		m_memory_budget = m_get_memory_properties2 != nullptr;
+	}
+#endif
+
+	query_budget();
+
+	std::cout << "Residency : " << (m_memory_budget ? "VK_EXT_memory_budget" : "heap sizes") << " budgets" << std::endl;
+}
+
+void ResidencyManager::query_budget()
+{
+#if defined(VK_EXT_memory_budget) && defined(VK_KHR_get_physical_device_properties2)
+	if (m_memory_budget)
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2KHR properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+		properties.pNext = &budget;
+
+		((PFN_vkGetPhysicalDeviceMemoryProperties2KHR)m_get_memory_properties2)(m_device, &properties);
+
+		for (uint32_t i = 0; i < m_memory.memoryHeapCount; i++)
+		{
+			m_heaps[i].budget = m_budget_caps[i] > 0 ? std::min(budget.heapBudget[i], m_budget_caps[i]) : budget.heapBudget[i];
+			m_heaps[i].driver_usage = budget.heapUsage[i];
+			m_tracked_at_query[i] = m_heaps[i].tracked_usage;
+		}
+
+		return;
+	}
+#endif
+
+	for (uint32_t i = 0; i < m_memory.memoryHeapCount; i++)
+		m_heaps[i].driver_usage = m_heaps[i].tracked_usage;
+}
+
+void ResidencyManager::cap_budget(uint32_t heap, VkDeviceSize budget)
+{
+	m_budget_caps[heap] = budget;
+	m_heaps[heap].budget = m_memory.memoryHeaps[heap].size;
+
+	query_budget();
+
+	if (budget > 0)
+		m_heaps[heap].budget = std::min(m_heaps[heap].budget, budget);
+}
+
+VkDeviceSize ResidencyManager::usage(uint32_t heap) const
+{
+	const HeapStats& h = m_heaps[heap];
+
+	if (!m_memory_budget)
+		return h.tracked_usage;
+
+	// Driver usage also covers allocations made outside the manager (swap chain, driver internals).
+	// Between queries, carry it forward by what the manager has allocated or freed since.
+	int64_t delta = (int64_t)h.tracked_usage - (int64_t)m_tracked_at_query[heap];
+	int64_t estimated = std::max<int64_t>((int64_t)h.driver_usage + delta, 0);
+
+	return std::max((VkDeviceSize)estimated, h.tracked_usage);
+}
+
+void ResidencyManager::unlink(ResidencyHandle handle, ResidentResource& resource)
+{
+	if (resource.prev.valid())
+		m_resources.lookup(resource.prev).next = resource.next;
+	else
+		m_lru_head = resource.next;
+
+	if (resource.next.valid())
+		m_resources.lookup(resource.next).prev = resource.prev;
+	else
+		m_lru_tail = resource.prev;
+
+	resource.prev = ResidencyHandle();
+	resource.next = ResidencyHandle();
+}
+
+void ResidencyManager::link_front(ResidencyHandle handle, ResidentResource& resource)
+{
+	resource.prev = ResidencyHandle();
+	resource.next = m_lru_head;
+
+	if (m_lru_head.valid())
+		m_resources.lookup(m_lru_head).prev = handle;
+	else
+		m_lru_tail = handle;
+
+	m_lru_head = handle;
+}
+
+ResidencyHandle ResidencyManager::register_resource(uint32_t category, uint32_t heap, VkDeviceSize size, bool streamable, DemoteCallback demote, void* user_data)
+{
+	ResidentResource* resource = nullptr;
+	ResidencyHandle handle = m_resources.create(&resource);
+
+	resource->category = category;
+	resource->heap = heap;
+	resource->size = size;
+	resource->last_used_frame = m_frame;
+	resource->streamable = streamable && demote != nullptr;
+	resource->demote_failed = false;
+	resource->demote = demote;
+	resource->user_data = user_data;
+
+	link_front(handle, *resource);
+
+	m_heaps[heap].tracked_usage += size;
+	m_category_usage[category] += size;
+
+	if (resource->streamable)
+		m_streamable_count++;
+
+	return handle;
+}
+
+void ResidencyManager::unregister_resource(ResidencyHandle handle)
+{
+	ResidentResource& resource = m_resources.lookup(handle);
+
+	unlink(handle, resource);
+
+	m_heaps[resource.heap].tracked_usage -= resource.size;
+	m_category_usage[resource.category] -= resource.size;
+
+	if (resource.streamable)
+		m_streamable_count--;
+
+	m_resources.destroy(handle);
+}
+
+void ResidencyManager::resize_resource(ResidencyHandle handle, uint32_t heap, VkDeviceSize size)
+{
+	ResidentResource& resource = m_resources.lookup(handle);
+
+	m_heaps[resource.heap].tracked_usage -= resource.size;
+	m_category_usage[resource.category] -= resource.size;
+
+	resource.heap = heap;
+	resource.size = size;
+	resource.demote_failed = false;
+
+	m_heaps[heap].tracked_usage += size;
+	m_category_usage[resource.category] += size;
+}
+
+void ResidencyManager::touch(ResidencyHandle handle)
+{
+	ResidentResource& resource = m_resources.lookup(handle);
+
+	resource.last_used_frame = m_frame;
+
+	if (m_lru_head != handle)
+	{
+		unlink(handle, resource);
+		link_front(handle, resource);
+	}
+}
+
+bool ResidencyManager::evict(uint32_t heap, VkDeviceSize target)
+{
+	ResidencyHandle handle = m_lru_tail;
+
+	while (handle.valid() && usage(heap) > target)
+	{
+		ResidentResource& resource = m_resources.lookup(handle);
+		ResidencyHandle prev = resource.prev;
+
+		// The list is ordered by last use, so everything further up is more recent still.
+		if (resource.last_used_frame + DW_RESIDENCY_MIN_IDLE_FRAMES > m_frame)
+			break;
+
+		if (resource.streamable && !resource.demote_failed && resource.heap == heap)
+		{
+			Demotion demotion = { handle, resource.category, resource.heap, resource.size, resource.user_data, resource.heap, resource.size };
+
+			if (resource.demote(demotion) && (demotion.new_heap != heap || demotion.new_size < resource.size))
+			{
+				m_bytes_demoted += resource.size - (demotion.new_heap == heap ? demotion.new_size : 0);
+				m_evictions++;
+
+				resize_resource(handle, demotion.new_heap, demotion.new_size);
+			}
+			else
+			{
+				resource.demote_failed = true;
+				m_failed_evictions++;
+			}
+		}
+
+		handle = prev;
+	}
+
+	return usage(heap) <= target;
+}
+
+void ResidencyManager::update(uint64_t frame)
+{
+	m_frame = frame;
+
+	if (frame % DW_RESIDENCY_BUDGET_QUERY_INTERVAL == 0)
+		query_budget();
+
+	for (uint32_t i = 0; i < m_heaps.size(); i++)
+	{
+		if (usage(i) > (VkDeviceSize)(m_heaps[i].budget * DW_RESIDENCY_HIGH_WATERMARK))
+			evict(i, (VkDeviceSize)(m_heaps[i].budget * DW_RESIDENCY_LOW_WATERMARK));
+	}
+}
+
+bool ResidencyManager::make_room(uint32_t heap, VkDeviceSize size)
+{
+	VkDeviceSize limit = (VkDeviceSize)(m_heaps[heap].budget * DW_RESIDENCY_HIGH_WATERMARK);
+
+	if (size > limit)
+		return false;
+
+	if (usage(heap) + size <= limit)
+		return true;
+
+	return evict(heap, limit - size);
+}
+
+void ResidencyManager::stats(ResidencyStats& stats) const
+{
+	stats.memory_budget_ext = m_memory_budget;
+	stats.heaps = m_heaps;
+
+	for (uint32_t i = 0; i < m_heaps.size(); i++)
+	{
+		if (!m_memory_budget)
+			stats.heaps[i].driver_usage = m_heaps[i].tracked_usage;
+	}
+
+	memcpy(stats.category_usage, m_category_usage, sizeof(m_category_usage));
+	stats.resource_count = m_resources.size();
+	stats.streamable_count = m_streamable_count;
+	stats.evictions = m_evictions;
+	stats.failed_evictions = m_failed_evictions;
+	stats.bytes_demoted = m_bytes_demoted;
+}
+
+void ResidencyManager::print_stats() const
+{
+	ResidencyStats s;
+	stats(s);
+
+	for (size_t i = 0; i < s.heaps.size(); i++)
+	{
+		std::cout << "Heap " << i << (s.heaps[i].device_local ? " (device local)" : "") << " : "
+				  << (s.heaps[i].driver_usage >> 20) << " / " << (s.heaps[i].budget >> 20) << " MiB used, "
+				  << (s.heaps[i].tracked_usage >> 20) << " MiB tracked" << std::endl;
+	}
+
+	for (uint32_t i = 0; i < MemoryCategory::COUNT; i++)
+		std::cout << "  " << g_CategoryNames[i] << " : " << (s.category_usage[i] >> 20) << " MiB" << std::endl;
+
+	std::cout << "Resources : " << s.resource_count << " (" << s.streamable_count << " streamable), evictions : " << s.evictions
+			  << ", failed : " << s.failed_evictions << ", demoted : " << (s.bytes_demoted >> 20) << " MiB" << std::endl;
+}
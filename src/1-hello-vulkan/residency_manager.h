@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+
+#include "handle_pool.h"
+
+// Start evicting when a heap goes over this fraction of its budget, and stop once under the low mark.
+#define DW_RESIDENCY_HIGH_WATERMARK 0.9
+#define DW_RESIDENCY_LOW_WATERMARK 0.8
+// Resources used within this many frames are never evicted, they may still be referenced by frames in flight.
+#define DW_RESIDENCY_MIN_IDLE_FRAMES 3
+// The driver budget is only re-queried this often; it changes slowly and the query is not free.
+#define DW_RESIDENCY_BUDGET_QUERY_INTERVAL 30
+
+namespace MemoryCategory
+{
+	enum
+	{
+		TEXTURE,
+		BUFFER,
+		ATTACHMENT,
+		STAGING,
+		COUNT
+	};
+}
+
+struct ResidentResource;
+typedef Handle<ResidentResource> ResidencyHandle;
+
+struct HeapStats
+{
+	VkDeviceSize size;
+	// From VK_EXT_memory_budget when available, otherwise the heap size.
+	VkDeviceSize budget;
+	// Driver reported usage of the whole process (VK_EXT_memory_budget only, otherwise equals tracked).
+	VkDeviceSize driver_usage;
+	// Bytes registered with the residency manager.
+	VkDeviceSize tracked_usage;
+	bool		 device_local;
+};
+
+struct ResidencyStats
+{
+	bool					memory_budget_ext;
+	std::vector<HeapStats>	heaps;
+	VkDeviceSize			category_usage[MemoryCategory::COUNT];
+	uint32_t				resource_count;
+	uint32_t				streamable_count;
+	uint64_t				evictions;
+	uint64_t				failed_evictions;
+	VkDeviceSize			bytes_demoted;
+};
+
+// Passed to the owner of a streamable resource when it has to shrink. The owner drops mips or moves
+// the resource to host memory, then fills in the new size and heap. Returning false leaves the
+// resource untouched (e.g. it is already at its smallest).
+struct Demotion
+{
+	ResidencyHandle handle;
+	uint32_t		category;
+	uint32_t		heap;
+	VkDeviceSize	size;
+	void*			user_data;
+	uint32_t		new_heap;
+	VkDeviceSize	new_size;
+};
+
+typedef bool (*DemoteCallback)(Demotion& demotion);
+
+struct ResidentResource
+{
+	uint32_t	   category;
+	uint32_t	   heap;
+	VkDeviceSize   size;
+	uint64_t	   last_used_frame;
+	bool		   streamable;
+	// The last demotion failed. Not retried (or counted again) until the owner resizes it.
+	bool		   demote_failed;
+	DemoteCallback demote;
+	void*		   user_data;
+	// Intrusive LRU list, most recently used at the head.
+	ResidencyHandle prev;
+	ResidencyHandle next;
+};
+
+// Tracks device memory usage per heap and per category against the heap budgets and keeps heaps
+// under budget by demoting least recently used streamable resources, rather than letting
+// allocations fail.
+class ResidencyManager
+{
+public:
+	ResidencyManager();
+
+	// memory_budget must only be true if VK_EXT_memory_budget was enabled on the device (and the
+	// instance has VK_KHR_get_physical_device_properties2 or is 1.1+).
+	void initialize(VkInstance instance, VkPhysicalDevice device, bool memory_budget);
+
+	ResidencyHandle register_resource(uint32_t category, uint32_t heap, VkDeviceSize size, bool streamable = false, DemoteCallback demote = nullptr, void* user_data = nullptr);
+	void unregister_resource(ResidencyHandle handle);
+	// Updates size or heap after the owner changed the resource outside of a demotion.
+	void resize_resource(ResidencyHandle handle, uint32_t heap, VkDeviceSize size);
+
+	// Marks the resource as used this frame and moves it to the front of the LRU list.
+	void touch(ResidencyHandle handle);
+
+	// Call once per frame. Refreshes the budget periodically and evicts from heaps over the high mark.
+	void update(uint64_t frame);
+
+	// Evicts until size more bytes fit into heap under budget. Returns false if not enough could be
+	// freed; the caller may still allocate and rely on the driver to page.
+	bool make_room(uint32_t heap, VkDeviceSize size);
+
+	// Caps the heap's budget below what the driver reports, e.g. to exercise eviction. 0 removes the cap.
+	void cap_budget(uint32_t heap, VkDeviceSize budget);
+
+	void stats(ResidencyStats& stats) const;
+	void print_stats() const;
+
+	inline uint32_t heap_for_memory_type(uint32_t type) const { return m_memory.memoryTypes[type].heapIndex; }
+
+private:
+	void query_budget();
+	void unlink(ResidencyHandle handle, ResidentResource& resource);
+	void link_front(ResidencyHandle handle, ResidentResource& resource);
+	VkDeviceSize usage(uint32_t heap) const;
+	bool evict(uint32_t heap, VkDeviceSize target);
+
+private:
+	VkPhysicalDevice				 m_device;
+	VkPhysicalDeviceMemoryProperties m_memory;
+	bool							 m_memory_budget;
+	void*							 m_get_memory_properties2;
+	uint64_t						 m_frame;
+	HandlePool<ResidentResource>	 m_resources;
+	ResidencyHandle					 m_lru_head;
+	ResidencyHandle					 m_lru_tail;
+	std::vector<HeapStats>			 m_heaps;
+	// Tracked usage at the time of the last budget query, so driver usage can be extrapolated between queries.
+	std::vector<VkDeviceSize>		 m_tracked_at_query;
+	std::vector<VkDeviceSize>		 m_budget_caps;
+	VkDeviceSize					 m_category_usage[MemoryCategory::COUNT];
+	uint32_t						 m_streamable_count;
+	uint64_t						 m_evictions;
+	uint64_t						 m_failed_evictions;
+	VkDeviceSize					 m_bytes_demoted;
+};
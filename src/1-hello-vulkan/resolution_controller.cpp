@@ -0,0 +1,92 @@
+#include "resolution_controller.h"
+#include <math.h>
+#include <algorithm>
+
+// Weight of the newest frame in the smoothed GPU time. Rising times get the full weight, so a
+// spike is answered right away rather than after several slow frames.
+#define DW_RESOLUTION_SMOOTHING 0.2
+
+ResolutionController::ResolutionController() : m_target_ms(0.0)
+{
+	reset();
+}
+
+void ResolutionController::set_target(double gpu_ms)
+{
+	m_target_ms = gpu_ms;
+	reset();
+}
+
+void ResolutionController::reset()
+{
+	m_scale = DW_RESOLUTION_MAX_SCALE;
+	m_smoothed_ms = 0.0;
+	m_cheap_frames = 0;
+	m_cooldown = 0;
+	m_changes = 0;
+}
+
+double ResolutionController::update(double gpu_ms)
+{
+	if (m_target_ms <= 0.0 || gpu_ms <= 0.0)
+		return m_scale;
+
+	if (m_cooldown > 0)
+	{
+		// Still frames rendered at the previous scale.
+		m_cooldown--;
+		m_smoothed_ms = gpu_ms;
+		return m_scale;
+	}
+
+	if (gpu_ms > m_smoothed_ms || m_smoothed_ms == 0.0)
+		m_smoothed_ms = gpu_ms;
+	else
+		m_smoothed_ms += (gpu_ms - m_smoothed_ms) * DW_RESOLUTION_SMOOTHING;
+
+	double scale = m_scale;
+
+	if (m_smoothed_ms > m_target_ms * DW_RESOLUTION_HIGH_WATERMARK)
+	{
+		// Aim for the middle of the band rather than the high mark, or the next spike crosses it again.
+		double goal = m_target_ms * (DW_RESOLUTION_HIGH_WATERMARK + DW_RESOLUTION_LOW_WATERMARK) * 0.5;
+		scale = m_scale * sqrt(goal / m_smoothed_ms);
+		m_cheap_frames = 0;
+	}
+	else if (m_smoothed_ms < m_target_ms * DW_RESOLUTION_LOW_WATERMARK)
+	{
+		if (++m_cheap_frames >= DW_RESOLUTION_INCREASE_FRAMES)
+		{
+			double goal = m_scale * sqrt(m_target_ms * DW_RESOLUTION_LOW_WATERMARK / m_smoothed_ms);
+			scale = std::min(goal, m_scale + DW_RESOLUTION_INCREASE_STEP);
+			m_cheap_frames = 0;
+		}
+	}
+	else
+		m_cheap_frames = 0;
+
+	scale = std::max((double)DW_RESOLUTION_MIN_SCALE, std::min((double)DW_RESOLUTION_MAX_SCALE, scale));
+
+	if (scale != m_scale)
+	{
+		m_scale = scale;
+		m_cooldown = DW_RESOLUTION_COOLDOWN_FRAMES;
+		m_changes++;
+	}
+
+	return m_scale;
+}
+
+static uint32_t scale_dimension(uint32_t size, double scale)
+{
+	uint32_t scaled = (uint32_t)(size * scale + 0.5);
+	scaled = (scaled + DW_RESOLUTION_ALIGNMENT / 2) / DW_RESOLUTION_ALIGNMENT * DW_RESOLUTION_ALIGNMENT;
+
+	return std::max(1u, std::min(size, scaled));
+}
+
+void ResolutionController::scaled_extent(uint32_t width, uint32_t height, uint32_t& scaled_width, uint32_t& scaled_height) const
+{
+	scaled_width = scale_dimension(width, m_scale);
+	scaled_height = scale_dimension(height, m_scale);
+}
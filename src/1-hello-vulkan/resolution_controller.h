@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+// Scale limits, per axis. Below half resolution the upscale blurs more than a frame time spike hurts.
+#define DW_RESOLUTION_MIN_SCALE 0.5
+#define DW_RESOLUTION_MAX_SCALE 1.0
+// Scale down once the smoothed GPU time goes over this fraction of the budget, and only consider
+// scaling up below the lower one. The gap between them is the hysteresis that keeps the scale from
+// oscillating around the budget.
+#define DW_RESOLUTION_HIGH_WATERMARK 0.95
+#define DW_RESOLUTION_LOW_WATERMARK 0.8
+// Consecutive frames under the low mark before scaling up. Scaling down is immediate.
+#define DW_RESOLUTION_INCREASE_FRAMES 30
+// Largest step up, per axis. Down steps are as large as the measurement asks for.
+#define DW_RESOLUTION_INCREASE_STEP 0.05
+// Frames ignored after a change, until measurements at the new scale come back from the GPU.
+#define DW_RESOLUTION_COOLDOWN_FRAMES 4
+// Render extents are rounded to multiples of this, so tiny scale changes do not move the viewport.
+#define DW_RESOLUTION_ALIGNMENT 8
+
+// Picks the render resolution from measured GPU frame times. GPU time is assumed to be roughly
+// proportional to the pixel count, i.e. to the square of the scale, so a frame that is too slow is
+// corrected in one step. Getting faster is only trusted after a run of cheap frames, and then the
+// scale creeps up in small steps.
+class ResolutionController
+{
+public:
+	ResolutionController();
+
+	// GPU time budget per frame. 0 disables the controller and pins the scale to the maximum.
+	void set_target(double gpu_ms);
+	void reset();
+
+	// Feed the GPU time of each completed frame. Returns the scale to render the next frame at.
+	double update(double gpu_ms);
+
+	// width x height scaled, aligned and clamped to [1, width] x [1, height].
+	void scaled_extent(uint32_t width, uint32_t height, uint32_t& scaled_width, uint32_t& scaled_height) const;
+
+	inline double scale() const { return m_scale; }
+	inline double target() const { return m_target_ms; }
+	inline double smoothed_ms() const { return m_smoothed_ms; }
+	inline uint64_t changes() const { return m_changes; }
+
+private:
+	double	 m_target_ms;
+	double	 m_scale;
+	double	 m_smoothed_ms;
+	uint32_t m_cheap_frames;
+	uint32_t m_cooldown;
+	uint64_t m_changes;
+};
@@ -0,0 +1,507 @@
+#include "shadow_cascades.h"
+#include "render_targets.h"
+#include "memory_policy.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <math.h>
+#include <algorithm>
+
+#define DW_INVALID_MEMORY_TYPE 0xFFFFFFFF
+
+ShadowCascades::ShadowCascades() : m_physical_device(VK_NULL_HANDLE), m_device(VK_NULL_HANDLE), m_resolution(0), m_format(VK_FORMAT_UNDEFINED), m_array_view(VK_NULL_HANDLE),
+								   m_sampler(VK_NULL_HANDLE), m_light_direction(0.0f), m_light_view(1.0f), m_invalidated(true), m_stats({})
+{
+	for (uint32_t i = 0; i < ShadowLayer::COUNT; i++)
+	{
+		m_images[i] = VK_NULL_HANDLE;
+		m_memory[i] = VK_NULL_HANDLE;
+		m_render_passes[i] = VK_NULL_HANDLE;
+	}
+
+	for (uint32_t i = 0; i < DW_SHADOW_CASCADES; i++)
+	{
+		Cascade& cascade = m_cascades[i];
+		cascade.shadow = { glm::mat4(1.0f), 0.0f };
+		cascade.center = glm::vec3(0.0f);
+		cascade.radius = 0.0f;
+		cascade.depth_near = 0.0f;
+		cascade.depth_far = 0.0f;
+		cascade.valid = false;
+		cascade.initialized = false;
+
+		for (uint32_t j = 0; j < ShadowLayer::COUNT; j++)
+		{
+			cascade.dirty[j] = false;
+			cascade.views[j] = VK_NULL_HANDLE;
+			cascade.framebuffers[j] = VK_NULL_HANDLE;
+		}
+	}
+
+	m_settings.distance = 150.0f;
+	m_settings.split_lambda = 0.75f;
+	m_settings.margin = 0.25f;
+	m_settings.caster_distance = 100.0f;
+	m_settings.depth_bias_constant = 1.25f;
+	m_settings.depth_bias_slope = 1.75f;
+}
+
+bool ShadowCascades::initialize(VkPhysicalDevice physical_device, VkDevice device, uint32_t resolution)
+{
+	m_physical_device = physical_device;
+	m_device = device;
+	m_resolution = resolution;
+	m_format = choose_shadow_format(physical_device);
+	m_invalidated = true;
+
+	if (m_format == VK_FORMAT_UNDEFINED)
+		return false;
+
+	// The static layer is only ever copied from; the sampled one is copied into, drawn over and sampled.
+	if (!create_layer(VK_IMAGE_USAGE_TRANSFER_SRC_BIT, ShadowLayer::STATIC) ||
+		!create_layer(VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, ShadowLayer::DYNAMIC))
+		return false;
+
+	m_render_passes[ShadowLayer::STATIC] = create_depth_render_pass(device, m_format, false, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	m_render_passes[ShadowLayer::DYNAMIC] = create_depth_render_pass(device, m_format, true, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	if (m_render_passes[ShadowLayer::STATIC] == VK_NULL_HANDLE || m_render_passes[ShadowLayer::DYNAMIC] == VK_NULL_HANDLE)
+		return false;
+
+	VkExtent2D extent = { resolution, resolution };
+
+	for (uint32_t i = 0; i < DW_SHADOW_CASCADES; i++)
+	{
+		for (uint32_t layer = 0; layer < ShadowLayer::COUNT; layer++)
+		{
+			VkImageViewCreateInfo view_info = {};
+			view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			view_info.image = m_images[layer];
+			view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view_info.format = m_format;
+			view_info.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, i, 1 };
+
+			if (vkCreateImageView(device, &view_info, nullptr, &m_cascades[i].views[layer]) != VK_SUCCESS)
+				return false;
+
+			m_cascades[i].framebuffers[layer] = create_depth_framebuffer(device, m_render_passes[layer], extent, m_cascades[i].views[layer]);
+
+			if (m_cascades[i].framebuffers[layer] == VK_NULL_HANDLE)
+				return false;
+		}
+	}
+
+	VkImageViewCreateInfo array_info = {};
+	array_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	array_info.image = m_images[ShadowLayer::DYNAMIC];
+	array_info.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+	array_info.format = m_format;
+	array_info.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, DW_SHADOW_CASCADES };
+
+	if (vkCreateImageView(device, &array_info, nullptr, &m_array_view) != VK_SUCCESS)
+		return false;
+
+	// Outside of a cascade counts as lit.
+	VkSamplerCreateInfo sampler_info = {};
+	sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	sampler_info.magFilter = VK_FILTER_LINEAR;
+	sampler_info.minFilter = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	sampler_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	sampler_info.compareEnable = VK_TRUE;
+	sampler_info.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	if (vkCreateSampler(device, &sampler_info, nullptr, &m_sampler) != VK_SUCCESS)
+		return false;
+
+	return true;
+}
+
+void ShadowCascades::shutdown()
+{
+	for (uint32_t i = 0; i < DW_SHADOW_CASCADES; i++)
+	{
+		Cascade& cascade = m_cascades[i];
+
+		for (uint32_t layer = 0; layer < ShadowLayer::COUNT; layer++)
+		{
+			if (cascade.framebuffers[layer] != VK_NULL_HANDLE)
+				vkDestroyFramebuffer(m_device, cascade.framebuffers[layer], nullptr);
+
+			if (cascade.views[layer] != VK_NULL_HANDLE)
+				vkDestroyImageView(m_device, cascade.views[layer], nullptr);
+
+			cascade.framebuffers[layer] = VK_NULL_HANDLE;
+			cascade.views[layer] = VK_NULL_HANDLE;
+			cascade.casters[layer].clear();
+		}
+
+		cascade.valid = false;
+		cascade.initialized = false;
+	}
+
+	if (m_sampler != VK_NULL_HANDLE)
+		vkDestroySampler(m_device, m_sampler, nullptr);
+
+	if (m_array_view != VK_NULL_HANDLE)
+		vkDestroyImageView(m_device, m_array_view, nullptr);
+
+	for (uint32_t layer = 0; layer < ShadowLayer::COUNT; layer++)
+	{
+		if (m_render_passes[layer] != VK_NULL_HANDLE)
+			vkDestroyRenderPass(m_device, m_render_passes[layer], nullptr);
+
+		if (m_images[layer] != VK_NULL_HANDLE)
+			vkDestroyImage(m_device, m_images[layer], nullptr);
+
+		if (m_memory[layer] != VK_NULL_HANDLE)
+			vkFreeMemory(m_device, m_memory[layer], nullptr);
+
+		m_render_passes[layer] = VK_NULL_HANDLE;
+		m_images[layer] = VK_NULL_HANDLE;
+		m_memory[layer] = VK_NULL_HANDLE;
+	}
+
+	m_sampler = VK_NULL_HANDLE;
+	m_array_view = VK_NULL_HANDLE;
+	m_previous.clear();
+}
+
+bool ShadowCascades::create_layer(VkImageUsageFlags usage, uint32_t layer)
+{
+	VkImageCreateInfo image_info = {};
+	image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image_info.imageType = VK_IMAGE_TYPE_2D;
+	image_info.format = m_format;
+	image_info.extent = { m_resolution, m_resolution, 1 };
+	image_info.mipLevels = 1;
+	image_info.arrayLayers = DW_SHADOW_CASCADES;
+	image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+	image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	image_info.usage = usage | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if (vkCreateImage(m_device, &image_info, nullptr, &m_images[layer]) != VK_SUCCESS)
+		return false;
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(m_device, m_images[layer], &requirements);
+
+	gfx::MemoryPolicy policy;
+	policy.Init(m_physical_device);
+
+	VkMemoryAllocateInfo alloc_info = {};
+	alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc_info.allocationSize = requirements.size;
+	alloc_info.memoryTypeIndex = policy.FindType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	if (alloc_info.memoryTypeIndex == DW_INVALID_MEMORY_TYPE || vkAllocateMemory(m_device, &alloc_info, nullptr, &m_memory[layer]) != VK_SUCCESS)
+		return false;
+
+	return vkBindImageMemory(m_device, m_images[layer], m_memory[layer], 0) == VK_SUCCESS;
+}
+
+VkPipeline ShadowCascades::create_caster_pipeline(VkShaderModule vert_module, const VkPipelineVertexInputStateCreateInfo* input_state, VkPipelineLayout layout) const
+{
+	// Depth is all that is written, so no fragment shader runs at all.
+	VkPipelineShaderStageCreateInfo vert_stage = {};
+	vert_stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vert_stage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	vert_stage.module = vert_module;
+	vert_stage.pName = "main";
+
+	VkPipelineInputAssemblyStateCreateInfo input_assembly = {};
+	input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	VkPipelineViewportStateCreateInfo viewport_state = {};
+	viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state.viewportCount = 1;
+	viewport_state.scissorCount = 1;
+
+	// Casters are often single sided, so nothing is culled; the bias takes care of acne instead.
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.lineWidth = 1.0f;
+	rasterizer.cullMode = VK_CULL_MODE_NONE;
+	rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	rasterizer.depthBiasEnable = VK_TRUE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisampling.minSampleShading = 1.0f;
+
+	// Less or equal, so dynamic casters drawn over the copied static layer can touch it exactly.
+	VkPipelineDepthStencilStateCreateInfo depth_stencil = {};
+	depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depth_stencil.depthTestEnable = VK_TRUE;
+	depth_stencil.depthWriteEnable = VK_TRUE;
+	depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	VkPipelineColorBlendStateCreateInfo color_blending = {};
+	color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+
+	VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_DEPTH_BIAS };
+
+	VkPipelineDynamicStateCreateInfo dynamic_state = {};
+	dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamic_state.dynamicStateCount = 3;
+	dynamic_state.pDynamicStates = dynamic_states;
+
+	// Both layers' render passes are compatible (same single depth attachment), either will do.
+	VkGraphicsPipelineCreateInfo pipeline_info = {};
+	pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipeline_info.stageCount = 1;
+	pipeline_info.pStages = &vert_stage;
+	pipeline_info.pVertexInputState = input_state;
+	pipeline_info.pInputAssemblyState = &input_assembly;
+	pipeline_info.pViewportState = &viewport_state;
+	pipeline_info.pRasterizationState = &rasterizer;
+	pipeline_info.pMultisampleState = &multisampling;
+	pipeline_info.pDepthStencilState = &depth_stencil;
+	pipeline_info.pColorBlendState = &color_blending;
+	pipeline_info.pDynamicState = &dynamic_state;
+	pipeline_info.layout = layout;
+	pipeline_info.renderPass = m_render_passes[ShadowLayer::STATIC];
+	pipeline_info.subpass = 0;
+	pipeline_info.basePipelineIndex = -1;
+
+	VkPipeline pipeline;
+
+	if (vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	return pipeline;
+}
+
+bool ShadowCascades::overlaps(const Cascade& cascade, const ShadowCaster& caster) const
+{
+	glm::vec3 p = glm::vec3(m_light_view * glm::vec4(caster.center, 1.0f));
+	float reach = cascade.radius + caster.radius;
+	float depth = -p.z;
+
+	return fabsf(p.x - cascade.center.x) <= reach && fabsf(p.y - cascade.center.y) <= reach &&
+		   depth >= cascade.depth_near - caster.radius && depth <= cascade.depth_far + caster.radius;
+}
+
+static bool same_caster(const ShadowCaster& a, const ShadowCaster& b)
+{
+	return a.center == b.center && a.radius == b.radius && a.dynamic == b.dynamic;
+}
+
+void ShadowCascades::update(const ShadowCamera& camera, const glm::vec3& light_direction, const ShadowCaster* casters, uint32_t count)
+{
+	glm::vec3 direction = glm::normalize(light_direction);
+	bool redraw_all = m_invalidated || count != m_previous.size();
+
+	if (direction != m_light_direction)
+	{
+		glm::vec3 up = fabsf(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+		m_light_direction = direction;
+		m_light_view = glm::lookAt(glm::vec3(0.0f), direction, up);
+		redraw_all = true;
+	}
+
+	glm::mat4 camera_to_world = glm::inverse(camera.view);
+	float near_plane = camera.near_plane;
+	float far_plane = std::max(std::min(camera.far_plane, m_settings.distance), near_plane * 1.001f);
+	float split_near = near_plane;
+
+	for (uint32_t i = 0; i < DW_SHADOW_CASCADES; i++)
+	{
+		Cascade& cascade = m_cascades[i];
+
+		float t = (float)(i + 1) / DW_SHADOW_CASCADES;
+		float split_log = near_plane * powf(far_plane / near_plane, t);
+		float split_uniform = near_plane + (far_plane - near_plane) * t;
+		float split_far = m_settings.split_lambda * split_log + (1.0f - m_settings.split_lambda) * split_uniform;
+
+		// Bounding sphere of the slice, centered on the view axis. It does not depend on where the
+		// camera looks, so rotating in place never resizes the cascade. Rounded up so float noise
+		// does not either.
+		float half_depth = (split_far - split_near) * 0.5f;
+		float tan_x = camera.tan_half_fov_y * camera.aspect;
+		float far_corner = glm::length(glm::vec3(split_far * tan_x, split_far * camera.tan_half_fov_y, half_depth));
+		float near_corner = glm::length(glm::vec3(split_near * tan_x, split_near * camera.tan_half_fov_y, half_depth));
+		float radius = ceilf(std::max(far_corner, near_corner) * 16.0f) / 16.0f;
+
+		glm::vec4 center_view(0.0f, 0.0f, -(split_near + half_depth), 1.0f);
+		glm::vec3 center = glm::vec3(m_light_view * (camera_to_world * center_view));
+
+		float covered = radius * (1.0f + m_settings.margin);
+		glm::vec3 offset = glm::abs(center - cascade.center);
+		float slack = covered - radius;
+
+		if (redraw_all || !cascade.valid || covered != cascade.radius || offset.x > slack || offset.y > slack || offset.z > slack)
+		{
+			// Snapped to whole texels, so moving the cascade does not make the shadow edges swim.
+			float texel = covered * 2.0f / m_resolution;
+
+			cascade.center = glm::vec3(floorf(center.x / texel + 0.5f) * texel, floorf(center.y / texel + 0.5f) * texel, center.z);
+			cascade.radius = covered;
+			cascade.depth_near = -cascade.center.z - covered - m_settings.caster_distance;
+			cascade.depth_far = -cascade.center.z + covered;
+			cascade.valid = true;
+			cascade.dirty[ShadowLayer::STATIC] = true;
+			cascade.dirty[ShadowLayer::DYNAMIC] = true;
+
+			// Right handed orthographic projection with zero to one depth.
+			float l = cascade.center.x - covered;
+			float r = cascade.center.x + covered;
+			float b = cascade.center.y - covered;
+			float top = cascade.center.y + covered;
+			float n = cascade.depth_near;
+			float f = cascade.depth_far;
+
+			glm::mat4 projection(1.0f);
+			projection[0][0] = 2.0f / (r - l);
+			projection[1][1] = 2.0f / (top - b);
+			projection[2][2] = -1.0f / (f - n);
+			projection[3][0] = -(r + l) / (r - l);
+			projection[3][1] = -(top + b) / (top - b);
+			projection[3][2] = -n / (f - n);
+
+			cascade.shadow.view_projection = projection * m_light_view;
+		}
+
+		cascade.shadow.split = split_far;
+		split_near = split_far;
+	}
+
+	// A caster that changed dirties the cascades it was in and the ones it is in now.
+	if (!redraw_all)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const ShadowCaster& previous = m_previous[i];
+			const ShadowCaster& current = casters[i];
+
+			if (same_caster(previous, current))
+				continue;
+
+			bool only_dynamic = previous.dynamic && current.dynamic;
+
+			for (uint32_t c = 0; c < DW_SHADOW_CASCADES; c++)
+			{
+				Cascade& cascade = m_cascades[c];
+
+				if (!overlaps(cascade, previous) && !overlaps(cascade, current))
+					continue;
+
+				cascade.dirty[ShadowLayer::DYNAMIC] = true;
+
+				if (!only_dynamic)
+					cascade.dirty[ShadowLayer::STATIC] = true;
+			}
+		}
+	}
+
+	m_previous.assign(casters, casters + count);
+	m_invalidated = false;
+
+	for (uint32_t c = 0; c < DW_SHADOW_CASCADES; c++)
+	{
+		Cascade& cascade = m_cascades[c];
+
+		for (uint32_t layer = 0; layer < ShadowLayer::COUNT; layer++)
+		{
+			cascade.casters[layer].clear();
+
+			if (!cascade.dirty[layer])
+				continue;
+
+			bool dynamic = layer == ShadowLayer::DYNAMIC;
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (casters[i].dynamic == dynamic && overlaps(cascade, casters[i]))
+					cascade.casters[layer].push_back(i);
+			}
+		}
+	}
+}
+
+void ShadowCascades::record(VkCommandBuffer cmd, const ShadowDrawFn& draw)
+{
+	m_stats = {};
+
+	VkViewport viewport = { 0.0f, 0.0f, (float)m_resolution, (float)m_resolution, 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, { m_resolution, m_resolution } };
+
+	for (uint32_t c = 0; c < DW_SHADOW_CASCADES; c++)
+	{
+		Cascade& cascade = m_cascades[c];
+
+		// The static layer is never redrawn without compositing again.
+		if (!cascade.dirty[ShadowLayer::DYNAMIC])
+			continue;
+
+		for (uint32_t layer = 0; layer < ShadowLayer::COUNT; layer++)
+		{
+			if (!cascade.dirty[layer])
+				continue;
+
+			if (layer == ShadowLayer::DYNAMIC)
+			{
+				// Start from the static casters. Earlier frames may still be sampling the layer.
+				VkImageMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.oldLayout = cascade.initialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = m_images[ShadowLayer::DYNAMIC];
+				barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, c, 1 };
+
+				vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+				VkImageCopy copy = {};
+				copy.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, c, 1 };
+				copy.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, c, 1 };
+				copy.extent = { m_resolution, m_resolution, 1 };
+
+				vkCmdCopyImage(cmd, m_images[ShadowLayer::STATIC], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_images[ShadowLayer::DYNAMIC], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+			}
+
+			VkClearValue clear_value = {};
+			clear_value.depthStencil = { 1.0f, 0 };
+
+			VkRenderPassBeginInfo render_pass_info = {};
+			render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			render_pass_info.renderPass = m_render_passes[layer];
+			render_pass_info.framebuffer = cascade.framebuffers[layer];
+			render_pass_info.renderArea.extent = scissor.extent;
+			render_pass_info.clearValueCount = 1;
+			render_pass_info.pClearValues = &clear_value;
+
+			vkCmdBeginRenderPass(cmd, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdSetViewport(cmd, 0, 1, &viewport);
+			vkCmdSetScissor(cmd, 0, 1, &scissor);
+			vkCmdSetDepthBias(cmd, m_settings.depth_bias_constant, 0.0f, m_settings.depth_bias_slope);
+
+			const std::vector<uint32_t>& casters = cascade.casters[layer];
+
+			if (!casters.empty())
+				draw(cmd, cascade.shadow.view_projection, casters.data(), (uint32_t)casters.size());
+
+			vkCmdEndRenderPass(cmd);
+
+			if (layer == ShadowLayer::STATIC)
+				m_stats.static_redraws++;
+			else
+				m_stats.dynamic_redraws++;
+
+			m_stats.casters_drawn += (uint32_t)casters.size();
+			cascade.dirty[layer] = false;
+		}
+
+		cascade.initialized = true;
+	}
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+#include <functional>
+#include <glm/glm.hpp>
+
+#define DW_SHADOW_CASCADES 4
+#define DW_SHADOW_DEFAULT_RESOLUTION 2048
+
+namespace ShadowLayer
+{
+	enum
+	{
+		// Static casters only, cached across frames.
+		STATIC,
+		// A copy of the static layer with the dynamic casters drawn over it: what shaders sample.
+		DYNAMIC,
+		COUNT
+	};
+}
+
+// World space bounding sphere of a shadow caster. ShadowCascades::update() takes the casters as an
+// array that must keep each caster at the same index from frame to frame: it finds the ones that
+// moved by comparing against the previous frame's array.
+struct ShadowCaster
+{
+	glm::vec3 center;
+	float	  radius;
+	// Static casters are drawn into the cached layer, which is only redrawn when one of them changes
+	// or the cascade moves. Dynamic ones are drawn over a copy of it whenever one of them moves.
+	bool	  dynamic;
+};
+
+// The camera the cascades are fit to, with a symmetric perspective projection.
+struct ShadowCamera
+{
+	// World to view. The camera looks down -z.
+	glm::mat4 view;
+	float	  tan_half_fov_y;
+	float	  aspect;
+	float	  near_plane;
+	float	  far_plane;
+};
+
+struct ShadowSettings
+{
+	// View depth where the last cascade ends, at most the camera's far plane.
+	float distance;
+	// Blend of logarithmic (1) and uniform (0) split depths.
+	float split_lambda;
+	// Extra coverage around each cascade's slice of the camera frustum, as a share of the slice's
+	// radius. A cascade stays where it is, and keeps its cached contents, until the slice leaves that
+	// margin; larger margins mean fewer redraws but fewer texels per world unit.
+	float margin;
+	// How far beyond a cascade toward the light casters are still drawn into it.
+	float caster_distance;
+	float depth_bias_constant;
+	float depth_bias_slope;
+};
+
+struct ShadowCascade
+{
+	// World to shadow map clip space with zero to one depth. Not flipped: uv = clip.xy * 0.5 + 0.5.
+	glm::mat4 view_projection;
+	// View depth where the cascade ends.
+	float	  split;
+};
+
+struct ShadowStats
+{
+	// Cascades whose static layer and whose composited layer were redrawn.
+	uint32_t static_redraws;
+	uint32_t dynamic_redraws;
+	// Casters drawn over all cascades and layers.
+	uint32_t casters_drawn;
+};
+
+// Draws casters, indices into the array given to update(), with view_projection and a pipeline from
+// ShadowCascades::create_caster_pipeline(). The render pass, viewport, scissor and depth bias are set.
+typedef std::function<void(VkCommandBuffer cmd, const glm::mat4& view_projection, const uint32_t* casters, uint32_t count)> ShadowDrawFn;
+
+// Cascaded shadow maps for a directional light that are only redrawn where something changed.
+//
+// Each cascade covers its slice of the camera frustum plus a margin and is snapped to whole texels
+// in light space. It only moves once the slice would leave the covered area, so most frames reuse
+// the cascade unchanged and its contents stay valid. Static casters go into a cached layer that is
+// redrawn only when the cascade moves or a static caster inside it changes. The sampled layer is a
+// copy of the cached one with the dynamic casters drawn on top, redone only when a dynamic caster
+// inside moved. A camera standing still in a static scene costs no shadow draws at all.
+//
+// Both layers are 2D array images with a layer per cascade, shared by all frames in flight: updates
+// wait for the fragment shaders of earlier frames on the same queue.
+class ShadowCascades
+{
+public:
+	ShadowCascades();
+
+	bool initialize(VkPhysicalDevice physical_device, VkDevice device, uint32_t resolution = DW_SHADOW_DEFAULT_RESOLUTION);
+	// The device must be idle.
+	void shutdown();
+
+	// Depth-only pipeline for drawing casters into either layer: vertex stage only, no color
+	// attachments, dynamic viewport, scissor and depth bias. VK_NULL_HANDLE on failure.
+	VkPipeline create_caster_pipeline(VkShaderModule vert_module, const VkPipelineVertexInputStateCreateInfo* input_state, VkPipelineLayout layout) const;
+
+	// Fits the cascades to the camera and finds what has to be redrawn. light_direction points away
+	// from the light; any change to it redraws everything.
+	void update(const ShadowCamera& camera, const glm::vec3& light_direction, const ShadowCaster* casters, uint32_t count);
+	// Redraws what the updates since the last call found out of date. Record outside of render
+	// passes, before anything samples the cascades.
+	void record(VkCommandBuffer cmd, const ShadowDrawFn& draw);
+	// Redraws everything on the next update, e.g. when casters changed shape but not bounds.
+	inline void invalidate() { m_invalidated = true; }
+
+	inline const ShadowCascade& cascade(uint32_t index) const { return m_cascades[index].shadow; }
+	// Every cascade as a layer of a 2D array, in SHADER_READ_ONLY_OPTIMAL once recorded.
+	inline VkImageView shadow_view() const { return m_array_view; }
+	// Depth comparison (less or equal) with linear filtering, for sampler2DArrayShadow.
+	inline VkSampler sampler() const { return m_sampler; }
+	inline uint32_t resolution() const { return m_resolution; }
+
+	inline ShadowSettings& settings() { return m_settings; }
+	// Of the last record().
+	inline const ShadowStats& stats() const { return m_stats; }
+
+private:
+	struct Cascade
+	{
+		ShadowCascade		  shadow;
+		// Light space center (texel snapped) and half size of the covered square, and the range of
+		// distances along the light casters are drawn for.
+		glm::vec3			  center;
+		float				  radius;
+		float				  depth_near;
+		float				  depth_far;
+		bool				  valid;
+		bool				  dirty[ShadowLayer::COUNT];
+		// The sampled layer has contents, so its layout is known.
+		bool				  initialized;
+		std::vector<uint32_t> casters[ShadowLayer::COUNT];
+		VkImageView			  views[ShadowLayer::COUNT];
+		VkFramebuffer		  framebuffers[ShadowLayer::COUNT];
+	};
+
+	bool create_layer(VkImageUsageFlags usage, uint32_t layer);
+	bool overlaps(const Cascade& cascade, const ShadowCaster& caster) const;
+
+private:
+	VkPhysicalDevice		 m_physical_device;
+	VkDevice				 m_device;
+	uint32_t				 m_resolution;
+	VkFormat				 m_format;
+	VkImage					 m_images[ShadowLayer::COUNT];
+	VkDeviceMemory			 m_memory[ShadowLayer::COUNT];
+	VkRenderPass			 m_render_passes[ShadowLayer::COUNT];
+	VkImageView				 m_array_view;
+	VkSampler				 m_sampler;
+	Cascade					 m_cascades[DW_SHADOW_CASCADES];
+	glm::vec3				 m_light_direction;
+	glm::mat4				 m_light_view;
+	std::vector<ShadowCaster> m_previous;
+	bool					 m_invalidated;
+	ShadowSettings			 m_settings;
+	ShadowStats				 m_stats;
+};
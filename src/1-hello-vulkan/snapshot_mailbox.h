@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// Slots needed by SnapshotMailbox: the one being written, the one being read and the latest complete one.
+#define DW_SNAPSHOT_SLOTS 3
+// Set on the ready slot until the consumer takes it.
+#define DW_SNAPSHOT_FRESH 0x80000000u
+
+// Hands the latest snapshot from one producer to one consumer without either side waiting. The
+// producer fills write_slot() and publishes it; the consumer acquires the most recently published
+// slot and reads it until its next acquire. Slots are indices into storage owned by the caller, so
+// the snapshot type can be anything. Intermediate snapshots are dropped if the consumer is slower.
+class SnapshotMailbox
+{
+public:
+	SnapshotMailbox() : m_write(0), m_read(1), m_ready(2) {}
+
+	inline uint32_t write_slot() const { return m_write; }
+	inline uint32_t read_slot() const { return m_read; }
+
+	// Producer side. The written slot becomes the latest; writing continues in the previous latest.
+	inline void publish()
+	{
+		m_write = m_ready.exchange(m_write | DW_SNAPSHOT_FRESH, std::memory_order_acq_rel) & ~DW_SNAPSHOT_FRESH;
+	}
+
+	// Consumer side. Returns false if nothing was published since the last acquire, in which case
+	// read_slot() still holds the previous snapshot.
+	inline bool acquire()
+	{
+		if (!(m_ready.load(std::memory_order_acquire) & DW_SNAPSHOT_FRESH))
+			return false;
+
+		m_read = m_ready.exchange(m_read, std::memory_order_acq_rel) & ~DW_SNAPSHOT_FRESH;
+		return true;
+	}
+
+private:
+	uint32_t			  m_write;
+	uint32_t			  m_read;
+	// Latest complete slot, with DW_SNAPSHOT_FRESH set until the consumer takes it.
+	std::atomic<uint32_t> m_ready;
+};
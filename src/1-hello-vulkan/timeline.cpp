@@ -0,0 +1,278 @@
+#include "timeline.h"
+#include <string.h>
+#include <assert.h>
+#include <vector>
+
+bool timeline_semaphore_supported(VkInstance instance, VkPhysicalDevice device)
+{
+#if defined(VK_KHR_timeline_semaphore) && defined(VK_KHR_get_physical_device_properties2)
+	uint32_t count = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
+
+	std::vector<VkExtensionProperties> extensions(count);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &count, extensions.data());
+
+	bool found = false;
+
+	for (const auto& extension : extensions)
+	{
+		if (strcmp(extension.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0)
+			found = true;
+	}
+
+	if (!found)
+		return false;
+
+	// Core in 1.1, otherwise through the KHR extension.
+	PFN_vkGetPhysicalDeviceFeatures2KHR get_features2 = (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2");
+
+	if (!get_features2)
+		get_features2 = (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR");
+
+	if (!get_features2)
+		return false;
+
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline = {};
+	timeline.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+
+	VkPhysicalDeviceFeatures2KHR features = {};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+	features.pNext = &timeline;
+
+	get_features2(device, &features);
+
+	return timeline.timelineSemaphore == VK_TRUE;
+#else
+	return false;
+#endif
+}
+
+QueueTimeline::QueueTimeline() : m_device(VK_NULL_HANDLE), m_queue(VK_NULL_HANDLE), m_semaphore(VK_NULL_HANDLE), m_get_counter_value(nullptr),
+								 m_wait_semaphores(nullptr), m_last_submitted(0), m_completed(0), m_blocking_waits(0)
+{
+
+}
+
+bool QueueTimeline::initialize(VkDevice device, VkQueue queue, bool timeline_semaphore)
+{
+	m_device = device;
+	m_queue = queue;
+
+#if defined(VK_KHR_timeline_semaphore)
+	if (timeline_semaphore)
+	{
+		m_get_counter_value = (void*)vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+		m_wait_semaphores = (void*)vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR");
+
+		VkSemaphoreTypeCreateInfoKHR type_info = {};
+		type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+		type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		type_info.initialValue = 0;
+
+		VkSemaphoreCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		info.pNext = &type_info;
+
+		if (m_get_counter_value && m_wait_semaphores && vkCreateSemaphore(device, &info, nullptr, &m_semaphore) == VK_SUCCESS)
+			return true;
+
+		m_semaphore = VK_NULL_HANDLE;
+	}
+#endif
+
+	return true;
+}
+
+void QueueTimeline::shutdown()
+{
+	if (m_device == VK_NULL_HANDLE)
+		return;
+
+	wait_idle();
+
+	if (m_semaphore != VK_NULL_HANDLE)
+		vkDestroySemaphore(m_device, m_semaphore, nullptr);
+
+	for (const auto& pending : m_pending)
+		vkDestroyFence(m_device, pending.fence, nullptr);
+
+	for (VkFence fence : m_free_fences)
+		vkDestroyFence(m_device, fence, nullptr);
+
+	m_semaphore = VK_NULL_HANDLE;
+	m_pending.clear();
+	m_free_fences.clear();
+	m_device = VK_NULL_HANDLE;
+}
+
+VkFence QueueTimeline::acquire_fence()
+{
+	recycle_signalled();
+
+	if (!m_free_fences.empty())
+	{
+		VkFence fence = m_free_fences.back();
+		m_free_fences.pop_back();
+		return fence;
+	}
+
+	VkFenceCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	VkFence fence = VK_NULL_HANDLE;
+
+	if (vkCreateFence(m_device, &info, nullptr, &fence) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+
+	return fence;
+}
+
+void QueueTimeline::recycle_signalled()
+{
+	while (!m_pending.empty() && vkGetFenceStatus(m_device, m_pending.front().fence) == VK_SUCCESS)
+	{
+		const PendingFence& pending = m_pending.front();
+
+		if (pending.point > m_completed)
+			m_completed = pending.point;
+
+		vkResetFences(m_device, 1, &pending.fence);
+		m_free_fences.push_back(pending.fence);
+		m_pending.pop_front();
+	}
+}
+
+uint64_t QueueTimeline::submit(const VkCommandBuffer* cmds, uint32_t cmd_count, const VkSemaphore* wait, const VkPipelineStageFlags* stages, uint32_t wait_count,
+							   const VkSemaphore* signal, uint32_t signal_count)
+{
+	assert(signal_count < DW_TIMELINE_MAX_SEMAPHORES && wait_count <= DW_TIMELINE_MAX_SEMAPHORES);
+
+	uint64_t point = m_last_submitted + 1;
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.waitSemaphoreCount = wait_count;
+	submit_info.pWaitSemaphores = wait;
+	submit_info.pWaitDstStageMask = stages;
+	submit_info.commandBufferCount = cmd_count;
+	submit_info.pCommandBuffers = cmds;
+	submit_info.signalSemaphoreCount = signal_count;
+	submit_info.pSignalSemaphores = signal;
+
+	VkFence fence = VK_NULL_HANDLE;
+
+#if defined(VK_KHR_timeline_semaphore)
+	VkSemaphore signal_semaphores[DW_TIMELINE_MAX_SEMAPHORES];
+	// Values for binary semaphores are ignored but the arrays have to match the semaphore counts.
+	uint64_t signal_values[DW_TIMELINE_MAX_SEMAPHORES] = {};
+	uint64_t wait_values[DW_TIMELINE_MAX_SEMAPHORES] = {};
+
+	VkTimelineSemaphoreSubmitInfoKHR timeline_info = {};
+
+	if (m_semaphore != VK_NULL_HANDLE)
+	{
+		for (uint32_t i = 0; i < signal_count; i++)
+			signal_semaphores[i] = signal[i];
+
+		signal_semaphores[signal_count] = m_semaphore;
+		signal_values[signal_count] = point;
+
+		timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+		timeline_info.waitSemaphoreValueCount = wait_count;
+		timeline_info.pWaitSemaphoreValues = wait_count > 0 ? wait_values : nullptr;
+		timeline_info.signalSemaphoreValueCount = signal_count + 1;
+		timeline_info.pSignalSemaphoreValues = signal_values;
+
+		submit_info.pNext = &timeline_info;
+		submit_info.signalSemaphoreCount = signal_count + 1;
+		submit_info.pSignalSemaphores = signal_semaphores;
+	}
+	else
+#endif
+	{
+		fence = acquire_fence();
+
+		// Without a fence the point could never be told apart from a completed one.
+		if (fence == VK_NULL_HANDLE)
+			return 0;
+	}
+
+	if (vkQueueSubmit(m_queue, 1, &submit_info, fence) != VK_SUCCESS)
+	{
+		if (fence != VK_NULL_HANDLE)
+			m_free_fences.push_back(fence);
+
+		return 0;
+	}
+
+	if (fence != VK_NULL_HANDLE)
+		m_pending.push_back({ fence, point });
+
+	m_last_submitted = point;
+
+	return point;
+}
+
+uint64_t QueueTimeline::completed()
+{
+#if defined(VK_KHR_timeline_semaphore)
+	if (m_semaphore != VK_NULL_HANDLE)
+	{
+		uint64_t value = 0;
+
+		if (((PFN_vkGetSemaphoreCounterValueKHR)m_get_counter_value)(m_device, m_semaphore, &value) == VK_SUCCESS && value > m_completed)
+			m_completed = value;
+
+		return m_completed;
+	}
+#endif
+
+	recycle_signalled();
+
+	return m_completed;
+}
+
+bool QueueTimeline::wait(uint64_t point, uint64_t timeout_ns)
+{
+	assert(point <= m_last_submitted);
+
+	if (point <= m_completed || point <= completed())
+		return true;
+
+	m_blocking_waits++;
+
+#if defined(VK_KHR_timeline_semaphore)
+	if (m_semaphore != VK_NULL_HANDLE)
+	{
+		VkSemaphoreWaitInfoKHR wait_info = {};
+		wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+		wait_info.semaphoreCount = 1;
+		wait_info.pSemaphores = &m_semaphore;
+		wait_info.pValues = &point;
+
+		if (((PFN_vkWaitSemaphoresKHR)m_wait_semaphores)(m_device, &wait_info, timeout_ns) != VK_SUCCESS)
+			return false;
+
+		m_completed = point > m_completed ? point : m_completed;
+		return true;
+	}
+#endif
+
+	// Every submit has its own fence, so the one for point is pending. Earlier fences are recycled
+	// as soon as they report signalled.
+	for (const auto& pending : m_pending)
+	{
+		if (pending.point < point)
+			continue;
+
+		if (vkWaitForFences(m_device, 1, &pending.fence, VK_TRUE, timeout_ns) != VK_SUCCESS)
+			return false;
+
+		break;
+	}
+
+	m_completed = point > m_completed ? point : m_completed;
+	recycle_signalled();
+
+	return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <vector>
+#include <deque>
+
+// Binary semaphores a single submit() can wait on or signal in addition to the timeline.
+#define DW_TIMELINE_MAX_SEMAPHORES 8
+
+// True if VK_KHR_timeline_semaphore is available and its feature supported. Needs an instance with
+// VK_KHR_get_physical_device_properties2 (or 1.1+) to query the feature.
+extern bool timeline_semaphore_supported(VkInstance instance, VkPhysicalDevice device);
+
+// A monotonically increasing counter for one queue. Every submit() returns the point it will signal
+// once its work, and everything submitted to the queue before it, has finished. The CPU can poll or
+// wait for any point, which replaces one fence per frame/upload/readback with a single value per queue.
+//
+// Backed by a timeline semaphore when VK_KHR_timeline_semaphore is enabled on the device, otherwise
+// by a pool of fences (one per submit, recycled once signalled). The fallback relies on a fence also
+// covering all earlier submissions to the queue.
+class QueueTimeline
+{
+public:
+	QueueTimeline();
+
+	// timeline_semaphore must only be true if the extension and feature were enabled on the device.
+	bool initialize(VkDevice device, VkQueue queue, bool timeline_semaphore);
+	// Waits for all submitted work, then destroys the semaphore or fences.
+	void shutdown();
+
+	// wait/signal are binary semaphores (e.g. swap chain acquire/present), stages one per wait.
+	// Returns the point that signals when this batch has completed, or 0 (always complete) if the
+	// submission failed.
+	uint64_t submit(const VkCommandBuffer* cmds, uint32_t cmd_count,
+					const VkSemaphore* wait = nullptr, const VkPipelineStageFlags* stages = nullptr, uint32_t wait_count = 0,
+					const VkSemaphore* signal = nullptr, uint32_t signal_count = 0);
+
+	// Highest point known to have completed. Never blocks.
+	uint64_t completed();
+	inline bool is_complete(uint64_t point) { return point <= m_completed || point <= completed(); }
+	// Returns false on timeout.
+	bool wait(uint64_t point, uint64_t timeout_ns = UINT64_MAX);
+	inline void wait_idle() { wait(m_last_submitted); }
+
+	inline uint64_t last_submitted() const { return m_last_submitted; }
+	// The point the next submit() will return, e.g. to tag work recorded before submitting it.
+	inline uint64_t next_point() const { return m_last_submitted + 1; }
+
+	inline VkQueue queue() const { return m_queue; }
+	inline bool uses_timeline_semaphore() const { return m_semaphore != VK_NULL_HANDLE; }
+	// For GPU side waits on other queues. VK_NULL_HANDLE with the fence fallback.
+	inline VkSemaphore semaphore() const { return m_semaphore; }
+
+	// CPU waits that actually blocked, and fences in the fallback pool.
+	inline uint64_t blocking_waits() const { return m_blocking_waits; }
+	inline size_t fence_count() const { return m_free_fences.size() + m_pending.size(); }
+
+private:
+	struct PendingFence
+	{
+		VkFence	 fence;
+		uint64_t point;
+	};
+
+	VkFence acquire_fence();
+	void recycle_signalled();
+
+private:
+	VkDevice				 m_device;
+	VkQueue					 m_queue;
+	VkSemaphore				 m_semaphore;
+	void*					 m_get_counter_value;
+	void*					 m_wait_semaphores;
+	uint64_t				 m_last_submitted;
+	uint64_t				 m_completed;
+	uint64_t				 m_blocking_waits;
+	// Fence fallback. Pending fences are in submission order.
+	std::deque<PendingFence> m_pending;
+	std::vector<VkFence>	 m_free_fences;
+};
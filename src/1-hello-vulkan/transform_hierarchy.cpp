@@ -0,0 +1,159 @@
+#include "transform_hierarchy.h"
+#include "worker_pool.h"
+#include <math.h>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define DW_TRANSFORM_SSE
+#include <xmmintrin.h>
+#endif
+
+static_assert(sizeof(glm::mat4) == sizeof(float) * 16, "glm::mat4 must be 16 tightly packed floats");
+
+// out = a * b for column major 4x4 matrices. Each output column is a linear combination of a's columns.
+static inline void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+#if defined(DW_TRANSFORM_SSE)
+	const float* pa = &a[0][0];
+	const float* pb = &b[0][0];
+	float* po = &out[0][0];
+
+	__m128 a0 = _mm_loadu_ps(pa);
+	__m128 a1 = _mm_loadu_ps(pa + 4);
+	__m128 a2 = _mm_loadu_ps(pa + 8);
+	__m128 a3 = _mm_loadu_ps(pa + 12);
+
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		__m128 column = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(pb[c * 4 + 0])), _mm_mul_ps(a1, _mm_set1_ps(pb[c * 4 + 1]))),
+								   _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(pb[c * 4 + 2])), _mm_mul_ps(a3, _mm_set1_ps(pb[c * 4 + 3]))));
+		_mm_storeu_ps(po + c * 4, column);
+	}
+#else
+	out = a * b;
+#endif
+}
+
+TransformHierarchy::TransformHierarchy() : m_levels_dirty(false)
+{
+
+}
+
+void TransformHierarchy::reserve(uint32_t count)
+{
+	m_local.reserve(count);
+	m_world.reserve(count);
+	m_parent.reserve(count);
+	m_depth.reserve(count);
+	m_bounds_center.reserve(count);
+	m_bounds_extents.reserve(count);
+	m_order.reserve(count);
+}
+
+void TransformHierarchy::clear()
+{
+	m_local.clear();
+	m_world.clear();
+	m_parent.clear();
+	m_depth.clear();
+	m_bounds_center.clear();
+	m_bounds_extents.clear();
+	m_bounds.resize(0);
+	m_order.clear();
+	m_level_start.clear();
+	m_levels_dirty = false;
+}
+
+uint32_t TransformHierarchy::create(uint32_t parent, const glm::mat4& local, const glm::vec3& bounds_center, const glm::vec3& bounds_extents)
+{
+	uint32_t node = (uint32_t)m_parent.size();
+
+	m_local.push_back(local);
+	m_world.push_back(local);
+	m_parent.push_back(parent);
+	m_depth.push_back(parent == DW_TRANSFORM_NO_PARENT ? 0 : m_depth[parent] + 1);
+	m_bounds_center.push_back(bounds_center);
+	m_bounds_extents.push_back(bounds_extents);
+	m_levels_dirty = true;
+
+	return node;
+}
+
+void TransformHierarchy::set_local(uint32_t node, const glm::mat4& local)
+{
+	m_local[node] = local;
+}
+
+// Counting sort of the nodes by depth; creation order is kept within a level.
+void TransformHierarchy::build_levels()
+{
+	uint32_t max_depth = 0;
+
+	for (uint32_t depth : m_depth)
+		max_depth = std::max(max_depth, depth);
+
+	m_level_start.assign(max_depth + 2, 0);
+
+	for (uint32_t depth : m_depth)
+		m_level_start[depth + 1]++;
+
+	for (uint32_t level = 1; level < m_level_start.size(); level++)
+		m_level_start[level] += m_level_start[level - 1];
+
+	std::vector<uint32_t> cursor(m_level_start.begin(), m_level_start.end() - 1);
+	m_order.resize(m_depth.size());
+
+	for (uint32_t node = 0; node < m_depth.size(); node++)
+		m_order[cursor[m_depth[node]]++] = node;
+
+	m_bounds.resize(m_depth.size());
+	m_levels_dirty = false;
+}
+
+void TransformHierarchy::update_range(uint32_t begin, uint32_t end)
+{
+	for (uint32_t i = begin; i < end; i++)
+	{
+		uint32_t node = m_order[i];
+		uint32_t parent = m_parent[node];
+
+		if (parent == DW_TRANSFORM_NO_PARENT)
+			m_world[node] = m_local[node];
+		else
+			multiply(m_world[parent], m_local[node], m_world[node]);
+
+		// Arvo: the world AABB of a transformed box has extents |M| * e.
+		const glm::mat4& m = m_world[node];
+		const glm::vec3& c = m_bounds_center[node];
+		const glm::vec3& e = m_bounds_extents[node];
+
+		float ex = fabsf(m[0][0]) * e.x + fabsf(m[1][0]) * e.y + fabsf(m[2][0]) * e.z;
+		float ey = fabsf(m[0][1]) * e.x + fabsf(m[1][1]) * e.y + fabsf(m[2][1]) * e.z;
+		float ez = fabsf(m[0][2]) * e.x + fabsf(m[1][2]) * e.y + fabsf(m[2][2]) * e.z;
+
+		m_bounds.center_x[node] = m[0][0] * c.x + m[1][0] * c.y + m[2][0] * c.z + m[3][0];
+		m_bounds.center_y[node] = m[0][1] * c.x + m[1][1] * c.y + m[2][1] * c.z + m[3][1];
+		m_bounds.center_z[node] = m[0][2] * c.x + m[1][2] * c.y + m[2][2] * c.z + m[3][2];
+		m_bounds.extent_x[node] = ex;
+		m_bounds.extent_y[node] = ey;
+		m_bounds.extent_z[node] = ez;
+		m_bounds.radius[node] = sqrtf(ex * ex + ey * ey + ez * ez);
+	}
+}
+
+void TransformHierarchy::update(WorkerPool* pool)
+{
+	if (m_levels_dirty)
+		build_levels();
+
+	for (uint32_t level = 0; level < level_count(); level++)
+	{
+		uint32_t begin = m_level_start[level];
+		uint32_t count = m_level_start[level + 1] - begin;
+
+		if (pool)
+			pool->parallel_for(count, DW_TRANSFORM_CHUNK, [&](uint32_t first, uint32_t last) { update_range(begin + first, begin + last); });
+		else
+			update_range(begin, begin + count);
+	}
+}
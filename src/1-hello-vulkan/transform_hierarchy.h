@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "frustum_culling.h"
+
+#define DW_TRANSFORM_NO_PARENT 0xFFFFFFFF
+// Nodes per parallel work item when updating a level.
+#define DW_TRANSFORM_CHUNK 2048
+
+class WorkerPool;
+
+// Scene transforms in struct-of-arrays form: local and world matrices, parents and local bounds each
+// live in their own array, indexed by node. update() walks the hierarchy one depth level at a time;
+// every parent is final before its level's children start, so the nodes within a level are
+// independent and are updated in parallel. World bounds are written straight into CullBounds.
+class TransformHierarchy
+{
+public:
+	TransformHierarchy();
+
+	void reserve(uint32_t count);
+	void clear();
+
+	// Parents must be created before their children. Bounds are a local space AABB.
+	uint32_t create(uint32_t parent, const glm::mat4& local, const glm::vec3& bounds_center, const glm::vec3& bounds_extents);
+	void set_local(uint32_t node, const glm::mat4& local);
+
+	void update(WorkerPool* pool = nullptr);
+
+	inline uint32_t size() const { return (uint32_t)m_parent.size(); }
+	inline uint32_t level_count() const { return m_level_start.empty() ? 0 : (uint32_t)m_level_start.size() - 1; }
+	inline const glm::mat4& local(uint32_t node) const { return m_local[node]; }
+	inline const glm::mat4& world(uint32_t node) const { return m_world[node]; }
+	inline const CullBounds& bounds() const { return m_bounds; }
+
+private:
+	void build_levels();
+	void update_range(uint32_t begin, uint32_t end);
+
+private:
+	std::vector<glm::mat4> m_local;
+	std::vector<glm::mat4> m_world;
+	std::vector<uint32_t>  m_parent;
+	std::vector<uint32_t>  m_depth;
+	std::vector<glm::vec3> m_bounds_center;
+	std::vector<glm::vec3> m_bounds_extents;
+	CullBounds			   m_bounds;
+	// Nodes ordered by depth, and where each level starts in that order (plus one past the end).
+	std::vector<uint32_t>  m_order;
+	std::vector<uint32_t>  m_level_start;
+	bool				   m_levels_dirty;
+};
@@ -2,13 +2,39 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <vector>
 #include <set>
 #include <algorithm>
-#include <fstream>
+#include <atomic>
 
 #include "vulkan_backend.h"
 #include "const.h"
+#include "asset_streamer.h"
+#include "deletion_queue.h"
+#include "device_selector.h"
+#include "frame_pacer.h"
+#include "frame_capture.h"
+#include "residency_manager.h"
+#include "timeline.h"
+#include "draw_stream.h"
+#include "draw_recorder.h"
+#include "frame_arena.h"
+#include "allocation_counter.h"
+#include "render_targets.h"
+#include "gpu_timer.h"
+#include "resolution_controller.h"
+#include "post_process.h"
+
+// Frames the CPU may record ahead of the GPU. Also how long retired objects wait before being freed.
+#define DW_MAX_FRAMES_IN_FLIGHT 2
+// Slot of the built-in triangle pipeline in the draw bindings, drawn when the application submits nothing.
+#define DW_BUILTIN_PIPELINE 0
+// Frames allowed to allocate while containers and arenas grow to their steady state size.
+#define DW_ALLOCATION_WARMUP_FRAMES 16
+// Share of the display refresh interval the GPU may take before the resolution drops.
+#define DW_GPU_BUDGET_FRACTION 0.9
 
 namespace vulkan_backend
 {
@@ -17,6 +43,7 @@ namespace vulkan_backend
 	VkDevice				 g_device;
 	VkQueue					 g_graphics_queue;
 	VkQueue					 g_present_queue;
+	VkQueue					 g_compute_queue = VK_NULL_HANDLE;
 	VkSurfaceKHR			 g_surface;
 	VkSwapchainKHR			 g_swap_chain;
 	VkFormat			     g_swap_chain_image_format;
@@ -25,17 +52,96 @@ namespace vulkan_backend
 	VkRenderPass			 g_render_pass;
 	VkPipeline				 g_graphics_pipeline;
 	VkCommandPool			 g_command_pool;
-	VkSemaphore				 g_image_availabel_sema;
-	VkSemaphore				 g_render_finished_sema;
+	VkSemaphore				 g_image_availabel_sema[DW_MAX_FRAMES_IN_FLIGHT];
+	VkSemaphore				 g_render_finished_sema[DW_MAX_FRAMES_IN_FLIGHT];
+	// Graphics queue timeline point of the last frame submitted from each slot.
+	uint64_t				 g_frame_points[DW_MAX_FRAMES_IN_FLIGHT] = {};
+	QueueTimeline			 g_graphics_timeline;
+	bool					 g_has_timeline_semaphore = false;
+	uint64_t				 g_frame_index = 0;
+	uint32_t				 g_frame_slot = 0;
+	uint32_t				 g_frames_in_flight = DW_MAX_FRAMES_IN_FLIGHT;
+	uint32_t				 g_present_policy = PresentPolicy::THROUGHPUT;
+	FramePacer				 g_frame_pacer;
+	// When each slot's frame sampled its input, for the latency reported once it is presented.
+	double					 g_input_times[DW_MAX_FRAMES_IN_FLIGHT] = {};
+	ResidencyManager		 g_residency;
+	FrameCapture			 g_frame_capture;
+	// Swap chain images can be copied from (TRANSFER_SRC usage is optional for swap chains).
+	bool					 g_swap_chain_capturable = false;
+	bool					 g_has_properties2 = false;
+	bool					 g_has_memory_budget = false;
+	DeletionQueue			 g_deletion_queue;
+	// Device and queue idle waits this session. Should only ever be the one at shutdown.
+	uint32_t				 g_idle_wait_count = 0;
+	DrawStream				 g_draw_stream;
+	DrawBindings			 g_draw_bindings;
+	RadixSorter				 g_draw_sorter;
+	DrawStreamStats			 g_draw_stats = {};
+	uint64_t				 g_binds_eliminated = 0;
+	// Heap allocations made by the main thread over the last full frame, and since startup at the last frame start.
+	uint64_t				 g_frame_allocations = 0;
+	uint64_t				 g_allocations_at_frame_start = 0;
+	// Frames after the warmup that allocated at all. Should stay 0.
+	uint64_t				 g_allocating_frames = 0;
+	// Multisampled color (only with more than one sample) and depth, shared by all frames in flight.
+	uint32_t				 g_requested_samples = DW_DEFAULT_SAMPLE_COUNT;
+	VkSampleCountFlagBits	 g_sample_count = VK_SAMPLE_COUNT_1_BIT;
+	VkFormat				 g_depth_format = VK_FORMAT_UNDEFINED;
+	RenderTarget			 g_color_target = {};
+	RenderTarget			 g_depth_target = {};
+	ResidencyHandle			 g_color_residency;
+	ResidencyHandle			 g_depth_residency;
+	// Dynamic resolution: the scene is rendered into the top left g_render_extent of the slot's scene
+	// image, which has the swap chain's size, post-processed at that size and blitted up to the swap
+	// chain image. Changing the scale only changes the viewport and dispatch sizes. Without blit support
+	// the output is copied to the swap chain at full size.
+	bool					 g_upscale_supported = false;
+	VkExtent2D				 g_render_extent = {};
+	// What each slot's frame was rendered at, for a present recorded a frame later.
+	VkExtent2D				 g_slot_render_extent[DW_MAX_FRAMES_IN_FLIGHT] = {};
+	ResolutionController	 g_resolution;
+	GpuTimer				 g_gpu_timer;
+	// The scene resolves into the slot's HDR image; the compute chain turns it into the slot's output.
+	PostProcess				 g_post_process;
+	ResidencyHandle			 g_post_residency;
+	VkFramebuffer			 g_scene_framebuffers[DW_MAX_FRAMES_IN_FLIGHT] = {};
+	// Async compute: with a compute-only queue family and more than one frame in flight, a frame's
+	// post-processing runs on the compute queue while the graphics queue renders the next frame's scene.
+	// Its blit and present are only submitted after that scene, which costs one frame of latency.
+	bool					 g_has_compute_queue = false;
+	bool					 g_async_compute = false;
+	VkCommandPool			 g_compute_command_pool = VK_NULL_HANDLE;
+	VkSemaphore				 g_scene_done_sema[DW_MAX_FRAMES_IN_FLIGHT];
+	VkSemaphore				 g_post_done_sema[DW_MAX_FRAMES_IN_FLIGHT];
+	GpuTimer				 g_compute_timer;
+	// Slot whose post-processing was submitted to the compute queue but not presented yet, -1 if none.
+	int32_t					 g_pending_present = -1;
+	// Bumped by every swap chain recreation.
+	uint64_t				 g_swap_chain_generation = 0;
 
 	VkDebugReportCallbackEXT g_debug_callback;
 
+	// One per frame slot, re-recorded from the draw stream every frame.
 	std::vector<VkCommandBuffer> g_command_buffers;
+	// Per frame slot as well, only used with async compute.
+	std::vector<VkCommandBuffer> g_compute_command_buffers;
+	std::vector<VkCommandBuffer> g_present_command_buffers;
 	std::vector<VkImage> g_swap_chain_images;
-	std::vector<VkImageView> g_swap_chain_image_views;
-	std::vector<VkFramebuffer> g_swap_chain_framebuffers;
 
 	GLFWwindow*				 g_window;
+	// Only touched through GLFW on the main thread. The render thread works from the framebuffer size
+	// handed over by set_framebuffer_size() (width in the high half) and the refresh interval read at
+	// initialize().
+	std::atomic<uint64_t>	 g_framebuffer_size(0);
+	double					 g_refresh_interval_ms = 1000.0 / 60.0;
+	bool					 g_just_in_time_pacing = true;
+
+	AssetStreamer			 g_asset_streamer;
+	// Kept around so pipelines can be rebuilt on swap chain recreation without touching the disk.
+	std::vector<char>		 g_vert_spirv;
+	std::vector<char>		 g_frag_spirv;
+	std::vector<char>		 g_post_spirv[PostShader::COUNT];
 	
 	const std::vector<const char*> g_validation_layers = 
 	{
@@ -57,6 +163,8 @@ namespace vulkan_backend
 	{
 		int graphics_family = -1;
 		int present_family = -1;
+		// A family with compute but no graphics, -1 if there is none.
+		int compute_family = -1;
 
 		bool is_complete()
 		{
@@ -67,27 +175,26 @@ namespace vulkan_backend
 	struct SwapChainSupportDetails
 	{
 		VkSurfaceCapabilitiesKHR		capabilities;
-		std::vector<VkSurfaceFormatKHR> format;
-		std::vector<VkPresentModeKHR>   present_modes;
+		FrameVector<VkSurfaceFormatKHR> format;
+		FrameVector<VkPresentModeKHR>   present_modes;
 	};
 
 	// private methods
 
-	static std::vector<char> read_file(const std::string& filename)
+	static void wait_for_file(AssetId id, std::vector<char>& buffer)
 	{
-		std::ifstream file(filename, std::ios::ate | std::ios::binary);
-		
-		if (!file.is_open())
-			throw std::runtime_error("Failed to open file!");
+		LoadedAsset asset;
 
-		size_t size = (size_t)file.tellg();
-		std::vector<char> buffer(size);
+		if (!g_asset_streamer.wait(id, asset) || !asset.success)
+			throw std::runtime_error("Failed to open file!");
 
-		file.seekg(0);
-		file.read(buffer.data(), size);
-		file.close();
+		buffer.assign(asset.data.begin(), asset.data.end());
+	}
 
-		return buffer;
+	static void device_wait_idle()
+	{
+		g_idle_wait_count++;
+		vkDeviceWaitIdle(g_device);
 	}
 
 	static VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(VkDebugReportFlagsEXT flags,
@@ -137,9 +244,40 @@ namespace vulkan_backend
 		if (g_enable_validation_layers)
 			extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
 
+		// Optional, needed to query VK_EXT_memory_budget on 1.0 instances.
+		uint32_t count = 0;
+		vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+		std::vector<VkExtensionProperties> available(count);
+		vkEnumerateInstanceExtensionProperties(nullptr, &count, available.data());
+
+		for (const auto& extension : available)
+		{
+			if (strcmp(extension.extensionName, "VK_KHR_get_physical_device_properties2") == 0)
+			{
+				extensions.push_back("VK_KHR_get_physical_device_properties2");
+				g_has_properties2 = true;
+			}
+		}
+
 		return extensions;
 	}
 
+	static bool device_extension_supported(VkPhysicalDevice device, const char* name)
+	{
+		uint32_t count = 0;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &count, nullptr);
+		std::vector<VkExtensionProperties> available(count);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &count, available.data());
+
+		for (const auto& extension : available)
+		{
+			if (strcmp(extension.extensionName, name) == 0)
+				return true;
+		}
+
+		return false;
+	}
+
 	void extension_info()
 	{
 		uint32_t count = 0;
@@ -188,32 +326,75 @@ namespace vulkan_backend
 			return capabilities.currentExtent;
 		else
 		{
-			int width, height;
-			glfwGetWindowSize(g_window, &width, &height);
+			uint64_t size = g_framebuffer_size.load();
 
-			VkExtent2D actual_extent = { width, height };
+			VkExtent2D actual_extent = { (uint32_t)(size >> 32), (uint32_t)size };
 			actual_extent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actual_extent.width));
+			actual_extent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actual_extent.height));
 			return actual_extent;
 		}
 	}
 
-	// Selects the best Swapping method (IMMEDIATE, FIFO, FIFO RELAXED, MAILBOX)
-	VkPresentModeKHR choose_swap_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes)
+	static bool has_present_mode(const FrameVector<VkPresentModeKHR>& available_present_modes, VkPresentModeKHR mode)
 	{
-		VkPresentModeKHR best_mode = VK_PRESENT_MODE_FIFO_KHR;
+		return std::find(available_present_modes.begin(), available_present_modes.end(), mode) != available_present_modes.end();
+	}
 
-		for (const auto& available_present_mode : available_present_modes)
-		{
-			if (available_present_mode == VK_PRESENT_MODE_MAILBOX_KHR)
-				best_mode = available_present_mode;
-			else if (available_present_mode == VK_PRESENT_MODE_IMMEDIATE_KHR)
-				best_mode = available_present_mode;
-		}
+	// VSYNC always uses FIFO. LOW_LATENCY and THROUGHPUT both prefer MAILBOX (newest frame wins, no
+	// tearing), then IMMEDIATE; they differ in image count and frames in flight instead.
+	VkPresentModeKHR choose_swap_present_mode(const FrameVector<VkPresentModeKHR>& available_present_modes)
+	{
+		if (g_present_policy == PresentPolicy::VSYNC)
+			return VK_PRESENT_MODE_FIFO_KHR;
 
-		return best_mode;
+		if (has_present_mode(available_present_modes, VK_PRESENT_MODE_MAILBOX_KHR))
+			return VK_PRESENT_MODE_MAILBOX_KHR;
+
+		if (has_present_mode(available_present_modes, VK_PRESENT_MODE_IMMEDIATE_KHR))
+			return VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+		return VK_PRESENT_MODE_FIFO_KHR;
+	}
+
+	// Fewer images means fewer frames queued ahead of the display, i.e. lower latency.
+	uint32_t choose_swap_image_count(const VkSurfaceCapabilitiesKHR& capabilities)
+	{
+		uint32_t image_count = capabilities.minImageCount;
+
+		if (g_present_policy == PresentPolicy::THROUGHPUT)
+			image_count++;
+
+		image_count = std::max(image_count, 2u);
+
+		if (capabilities.maxImageCount > 0 && image_count > capabilities.maxImageCount)
+			image_count = capabilities.maxImageCount;
+
+		return image_count;
+	}
+
+	static double display_refresh_interval_ms()
+	{
+		GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+		const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+
+		return 1000.0 / (mode && mode->refreshRate > 0 ? mode->refreshRate : 60);
 	}
 
-	VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& available_formats)
+	static void apply_present_policy()
+	{
+		// Low latency keeps a single frame in flight and samples input just in time for the next
+		// refresh. The others let the CPU run ahead and leave pacing to the present mode.
+		bool low_latency = g_present_policy == PresentPolicy::LOW_LATENCY;
+
+		g_frames_in_flight = low_latency ? 1 : DW_MAX_FRAMES_IN_FLIGHT;
+		// Overlapping post-processing with the next frame needs that next frame in flight.
+		g_async_compute = g_has_compute_queue && g_frames_in_flight > 1;
+		g_frame_pacer.set_just_in_time(low_latency && g_just_in_time_pacing);
+		g_frame_pacer.set_target_interval(low_latency ? g_refresh_interval_ms : 0.0);
+		g_frame_pacer.reset();
+	}
+
+	VkSurfaceFormatKHR choose_swap_surface_format(const FrameVector<VkSurfaceFormatKHR>& available_formats)
 	{
 		if (available_formats.size() == 1 && available_formats[0].format == VK_FORMAT_UNDEFINED)
 		{
@@ -264,7 +445,7 @@ namespace vulkan_backend
 		uint32_t family_count = 0;
 		vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count, nullptr);
 
-		std::vector<VkQueueFamilyProperties> families(family_count);
+		FrameVector<VkQueueFamilyProperties> families(family_count);
 		vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count, families.data());
 
 		for (int i = 0; i < family_count; i++)
@@ -282,75 +463,27 @@ namespace vulkan_backend
 				break;
 		}
 
-		return indices;
-	}
-
-	bool check_device_extension_support(VkPhysicalDevice device)
-	{
-		uint32_t extension_count;
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
-
-		std::vector<VkExtensionProperties> available_extensions(extension_count);
-
-		vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
-
-		std::set<std::string> required_extensions(g_device_extensions.begin(), g_device_extensions.end());
-
-		for (const auto& extension : available_extensions)
-		{
-			required_extensions.erase(extension.extensionName);
-		}
-
-		return required_extensions.empty();
-	}
-
-	bool is_device_suitable(VkPhysicalDevice device)
-	{
-		VkPhysicalDeviceProperties properties;
-		vkGetPhysicalDeviceProperties(device, &properties);
-
-		
-		if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+		for (int i = 0; i < family_count; i++)
 		{
-			std::cout << "Selected Device : " << properties.deviceName << std::endl;
-
-			QueueFamilyIndices indices = find_queue_families(device);
-
-			bool extensions_supported = check_device_extension_support(device);
-			bool swap_chain_adeqeute = false;
-
-			if (extensions_supported)
+			if (families[i].queueCount > 0 && (families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
 			{
-				SwapChainSupportDetails swap_chain_support = query_swap_chain_support(device);
-				swap_chain_adeqeute = !swap_chain_support.format.empty() && !swap_chain_support.present_modes.empty();
+				indices.compute_family = i;
+				break;
 			}
-
-			return indices.is_complete() && extensions_supported && swap_chain_adeqeute;
 		}
-		else
-			return false;
+
+		return indices;
 	}
 
 	void pick_physical_device()
 	{
-		uint32_t device_count = 0;
-		vkEnumeratePhysicalDevices(g_instance, &device_count, nullptr);
-
-		if (device_count == 0)
-			throw std::runtime_error("Failed to find GPUs with Vulkan support!");
+		DeviceRequirements requirements = {};
+		requirements.surface = g_surface;
+		requirements.extensions = g_device_extensions.data();
+		requirements.extension_count = (uint32_t)g_device_extensions.size();
 
-		std::vector<VkPhysicalDevice> devices(device_count);
-
-		vkEnumeratePhysicalDevices(g_instance, &device_count, devices.data());
-
-		for (const auto& device : devices)
-		{
-			if (is_device_suitable(device))
-			{
-				g_physical_device = device;
-				break;
-			}
-		}
+		// Integrated, virtual and CPU devices are all accepted, the selector only ranks them.
+		g_physical_device = select_physical_device(g_instance, requirements);
 
 		if (g_physical_device == VK_NULL_HANDLE)
 			throw std::runtime_error("Failed to find a suitable GPU!");
@@ -363,6 +496,9 @@ namespace vulkan_backend
 		std::vector<VkDeviceQueueCreateInfo> queue_infos;
 		std::set<int> unique_queue_families = { indices.graphics_family, indices.present_family };
 
+		if (indices.compute_family >= 0)
+			unique_queue_families.insert(indices.compute_family);
+
 		float priority = 1.0f;
 		for (int queue_family : unique_queue_families)
 		{
@@ -381,8 +517,30 @@ namespace vulkan_backend
 		device_info.pQueueCreateInfos = queue_infos.data();
 		device_info.queueCreateInfoCount = static_cast<uint32_t>(queue_infos.size());
 		device_info.pEnabledFeatures = &features;
-		device_info.enabledExtensionCount = static_cast<uint32_t>(g_device_extensions.size());
-		device_info.ppEnabledExtensionNames = g_device_extensions.data();
+
+		std::vector<const char*> extensions = g_device_extensions;
+
+		g_has_memory_budget = g_has_properties2 && device_extension_supported(g_physical_device, "VK_EXT_memory_budget");
+
+		if (g_has_memory_budget)
+			extensions.push_back("VK_EXT_memory_budget");
+
+		g_has_timeline_semaphore = g_has_properties2 && timeline_semaphore_supported(g_instance, g_physical_device);
+
+#if defined(VK_KHR_timeline_semaphore)
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline_features = {};
+		timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+		timeline_features.timelineSemaphore = VK_TRUE;
+
+		if (g_has_timeline_semaphore)
+		{
+			extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+			device_info.pNext = &timeline_features;
+		}
+#endif
+
+		device_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+		device_info.ppEnabledExtensionNames = extensions.data();
 
 		if (g_enable_validation_layers)
 		{
@@ -397,6 +555,33 @@ namespace vulkan_backend
 
 		vkGetDeviceQueue(g_device, indices.graphics_family, 0, &g_graphics_queue);
 		vkGetDeviceQueue(g_device, indices.present_family, 0, &g_present_queue);
+
+		g_has_compute_queue = indices.compute_family >= 0;
+
+		if (g_has_compute_queue)
+		{
+			vkGetDeviceQueue(g_device, indices.compute_family, 0, &g_compute_queue);
+			g_compute_timer.initialize(g_physical_device, g_device, indices.compute_family, DW_MAX_FRAMES_IN_FLIGHT);
+		}
+
+		g_graphics_timeline.initialize(g_device, g_graphics_queue, g_has_timeline_semaphore);
+
+		if (!g_gpu_timer.initialize(g_physical_device, g_device, indices.graphics_family, DW_MAX_FRAMES_IN_FLIGHT))
+			std::cout << "GPU timestamps not supported, dynamic resolution disabled" << std::endl;
+
+		std::cout << "Async compute queue : " << (g_has_compute_queue ? "yes" : "no") << std::endl;
+		std::cout << "Synchronization : " << (g_graphics_timeline.uses_timeline_semaphore() ? "timeline semaphore" : "fence pool") << std::endl;
+
+		g_deletion_queue.initialize(g_device);
+		g_residency.initialize(g_instance, g_physical_device, g_has_memory_budget);
+
+		if (!g_frame_capture.initialize(g_physical_device, g_device, indices.graphics_family))
+			throw std::runtime_error("Failed to initialize frame capture!");
+
+		const char* video_path = getenv(DW_CAPTURE_VIDEO_ENV);
+
+		if (video_path && video_path[0] != '\0')
+			g_frame_capture.start_video(video_path);
 	}
 
 	void create_swap_chain()
@@ -406,10 +591,7 @@ namespace vulkan_backend
 		VkPresentModeKHR present_mode = choose_swap_present_mode(swap_chain_support.present_modes);
 		VkExtent2D extent = choose_swap_extent(swap_chain_support.capabilities);
 
-		uint32_t image_count = swap_chain_support.capabilities.minImageCount + 1;
-
-		if (swap_chain_support.capabilities.maxImageCount > 0 && image_count > swap_chain_support.capabilities.maxImageCount)
-			image_count = swap_chain_support.capabilities.maxImageCount;
+		uint32_t image_count = choose_swap_image_count(swap_chain_support.capabilities);
 
 		VkSwapchainCreateInfoKHR create_info = {};
 
@@ -421,7 +603,37 @@ namespace vulkan_backend
 		create_info.imageColorSpace = surface_format.colorSpace;
 		create_info.imageExtent = extent;
 		create_info.imageArrayLayers = 1;
-		create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+		// Nothing renders into the swap chain images any more, the post-processing output is blitted or
+		// copied into them.
+		if (!(swap_chain_support.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+			throw std::runtime_error("Failed to find a swap chain usable as a transfer destination!");
+
+		create_info.imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+		g_swap_chain_capturable = (swap_chain_support.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+
+		if (g_swap_chain_capturable)
+			create_info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+		// Upscaling blits from the post-processing output into the swap chain image with linear filtering.
+		VkFormatProperties format_properties;
+		vkGetPhysicalDeviceFormatProperties(g_physical_device, surface_format.format, &format_properties);
+
+		VkFormat format = surface_format.format;
+		bool srgb = format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_R8G8B8A8_SRGB;
+		bool bgra = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+
+		g_upscale_supported = (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT) != 0;
+
+		// The output holds sRGB encoded values. A blit converts them, so into an sRGB format they have to
+		// be linear; a copy moves the bytes as they are, so they need the swap chain's channel order.
+		if (g_upscale_supported)
+			g_post_process.set_output_encoding(srgb, false);
+		else if (bgra || format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB)
+			g_post_process.set_output_encoding(false, bgra);
+		else
+			throw std::runtime_error("Failed to find a way to write the swap chain format!");
 
 		g_swap_chain_image_format = surface_format.format;
 		g_swap_chain_extent = extent;
@@ -446,11 +658,17 @@ namespace vulkan_backend
 		create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		create_info.presentMode = present_mode;
 		create_info.clipped = VK_TRUE;
-		create_info.oldSwapchain = VK_NULL_HANDLE;
+		// Handing over the old swap chain lets frames still in flight present from it; it is retired
+		// rather than destroyed until those frames have completed.
+		VkSwapchainKHR old_swap_chain = g_swap_chain;
+		create_info.oldSwapchain = old_swap_chain;
 
 		if (vkCreateSwapchainKHR(g_device, &create_info, nullptr, &g_swap_chain) != VK_SUCCESS)
 			throw std::runtime_error("Failed to create swap chain!");
 
+		if (old_swap_chain != VK_NULL_HANDLE)
+			g_deletion_queue.destroy_swapchain(old_swap_chain);
+
 		uint32_t swap_image_count = 0;
 		vkGetSwapchainImagesKHR(g_device, g_swap_chain, &swap_image_count, nullptr);
 		g_swap_chain_images.resize(swap_image_count);
@@ -521,33 +739,6 @@ namespace vulkan_backend
 			throw std::runtime_error("Failed to create window surface!");
 	}
 
-	void create_image_views()
-	{
-		g_swap_chain_image_views.resize(g_swap_chain_images.size());
-
-		for (size_t i = 0; i < g_swap_chain_images.size(); i++)
-		{
-			VkImageViewCreateInfo create_info = {};
-			create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			create_info.image = g_swap_chain_images[i];
-			create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-			create_info.format = g_swap_chain_image_format;
-			create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-			create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-			create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-			create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-
-			create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			create_info.subresourceRange.baseMipLevel = 0;
-			create_info.subresourceRange.levelCount = 1;
-			create_info.subresourceRange.baseArrayLayer = 0;
-			create_info.subresourceRange.layerCount = 1;
-
-			if (vkCreateImageView(g_device, &create_info, nullptr, &g_swap_chain_image_views[i]) != VK_SUCCESS)
-				throw std::runtime_error("Failed to create image view!");
-		}
-	}
-
 	VkShaderModule create_shader_module(const std::vector<char>& code)
 	{
 		VkShaderModuleCreateInfo create_info = {};
@@ -562,57 +753,61 @@ namespace vulkan_backend
 		return shader_module;
 	}
 
+	static void create_tracked_target(VkFormat format, RenderTarget& target, ResidencyHandle& residency)
+	{
+		if (!create_transient_target(g_physical_device, g_device, format, g_swap_chain_extent, g_sample_count, target))
+			throw std::runtime_error("Failed to create render target!");
+
+		residency = g_residency.register_resource(MemoryCategory::ATTACHMENT, g_residency.heap_for_memory_type(target.memory_type), target.size);
+	}
+
+	// Recreated with the swap chain, since they follow its extent.
+	void create_render_targets()
+	{
+		g_sample_count = choose_sample_count(g_physical_device, g_requested_samples);
+
+		if (g_sample_count != VK_SAMPLE_COUNT_1_BIT)
+			create_tracked_target(DW_POST_SCENE_FORMAT, g_color_target, g_color_residency);
+
+		create_tracked_target(g_depth_format, g_depth_target, g_depth_residency);
+
+		// At full size, so that no resolution scale ever needs a reallocation. The old images were
+		// retired along with the rest of the swap chain's objects.
+		if (!g_post_process.resize(g_swap_chain_extent, g_deletion_queue))
+			throw std::runtime_error("Failed to create post-processing images!");
+
+		g_post_residency = g_residency.register_resource(MemoryCategory::ATTACHMENT, g_residency.heap_for_memory_type(g_post_process.memory_type()), g_post_process.allocated());
+
+		VkDeviceSize size = g_color_target.size + g_depth_target.size + g_post_process.allocated();
+		std::cout << "Render targets : " << g_sample_count << "x, " << size / (1024 * 1024) << " MiB" << (g_depth_target.lazy ? " (lazily allocated)" : "") << std::endl;
+	}
+
+	static void retire_render_target(RenderTarget& target, ResidencyHandle residency)
+	{
+		if (target.image == VK_NULL_HANDLE)
+			return;
+
+		g_deletion_queue.destroy_image_view(target.view);
+		g_deletion_queue.destroy_image(target.image);
+		g_deletion_queue.free_memory(target.memory);
+		g_residency.unregister_resource(residency);
+
+		target = {};
+	}
+
 	void create_render_pass()
 	{
-		VkAttachmentDescription color_attachment = {};
-		color_attachment.format = g_swap_chain_image_format;
-		color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-		VkAttachmentReference color_att_ref = {};
-		color_att_ref.attachment = 0;
-		color_att_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkSubpassDescription subpass = {};
-		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpass.colorAttachmentCount = 1;
-		subpass.pColorAttachments = &color_att_ref;
-
-		VkRenderPassCreateInfo render_pass_info = {};
-		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		render_pass_info.attachmentCount = 1;
-		render_pass_info.pAttachments = &color_attachment;
-		render_pass_info.subpassCount = 1;
-		render_pass_info.pSubpasses = &subpass;
-
-		VkSubpassDependency dependency = {};
-
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-		render_pass_info.dependencyCount = 1;
-		render_pass_info.pDependencies = &dependency;
-
-		if (vkCreateRenderPass(g_device, &render_pass_info, nullptr, &g_render_pass) != VK_SUCCESS)
+		// Resolves into the slot's HDR scene image, left ready for the post-processing chain to sample.
+		g_render_pass = create_msaa_render_pass(g_device, DW_POST_SCENE_FORMAT, g_depth_format, g_sample_count, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		if (g_render_pass == VK_NULL_HANDLE)
 			throw std::runtime_error("Failed to create render pass!");
 	}
 
 	void create_graphics_pipeline()
 	{
-		auto vert_bin = read_file("shaders/vert.spv");
-		auto frag_bin = read_file("shaders/frag.spv");
-
-		VkShaderModule vert_module = create_shader_module(vert_bin);
-		VkShaderModule frag_module = create_shader_module(frag_bin);
+		VkShaderModule vert_module = create_shader_module(g_vert_spirv);
+		VkShaderModule frag_module = create_shader_module(g_frag_spirv);
 
 		VkPipelineShaderStageCreateInfo vert_shader_stage_info = {};
 		vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -681,12 +876,19 @@ namespace vulkan_backend
 
 		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 		multisampling.sampleShadingEnable = VK_FALSE;
-		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		multisampling.rasterizationSamples = g_sample_count;
 		multisampling.minSampleShading = 1.0f;
 		multisampling.pSampleMask = nullptr;
 		multisampling.alphaToCoverageEnable = VK_FALSE;
 		multisampling.alphaToOneEnable = VK_FALSE;
 
+		VkPipelineDepthStencilStateCreateInfo depth_stencil = {};
+
+		depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depth_stencil.depthTestEnable = VK_TRUE;
+		depth_stencil.depthWriteEnable = VK_TRUE;
+		depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
 		VkPipelineColorBlendAttachmentState color_blend_attachment = {};
 
 		color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
@@ -710,10 +912,11 @@ namespace vulkan_backend
 		color_blending.blendConstants[2] = 0.0f;
 		color_blending.blendConstants[3] = 0.0f;
 
+		// The viewport follows the resolution scale without recreating pipelines.
 		VkDynamicState dynamic_states[]
 		{
 			VK_DYNAMIC_STATE_VIEWPORT,
-			VK_DYNAMIC_STATE_LINE_WIDTH
+			VK_DYNAMIC_STATE_SCISSOR
 		};
 
 		VkPipelineDynamicStateCreateInfo dynamic_state = {};
@@ -742,9 +945,9 @@ namespace vulkan_backend
 		pipeline_info.pViewportState = &viewport_state;
 		pipeline_info.pRasterizationState = &rasterizer;
 		pipeline_info.pMultisampleState = &multisampling;
-		pipeline_info.pDepthStencilState = nullptr;
+		pipeline_info.pDepthStencilState = &depth_stencil;
 		pipeline_info.pColorBlendState = &color_blending;
-		pipeline_info.pDynamicState = nullptr;
+		pipeline_info.pDynamicState = &dynamic_state;
 		pipeline_info.layout = g_pipeline_layout;
 		pipeline_info.renderPass = g_render_pass;
 		pipeline_info.subpass = 0;
@@ -754,31 +957,27 @@ namespace vulkan_backend
 		if (vkCreateGraphicsPipelines(g_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &g_graphics_pipeline) != VK_SUCCESS)
 			throw std::runtime_error("Failed to create graphics pipeline!");
 
+		if (g_draw_bindings.pipelines.empty())
+		{
+			g_draw_bindings.pipelines.resize(1);
+			g_draw_bindings.pipeline_layouts.resize(1);
+		}
+
+		g_draw_bindings.pipelines[DW_BUILTIN_PIPELINE] = g_graphics_pipeline;
+		g_draw_bindings.pipeline_layouts[DW_BUILTIN_PIPELINE] = g_pipeline_layout;
+
 		vkDestroyShaderModule(g_device, frag_module, nullptr);
 		vkDestroyShaderModule(g_device, vert_module, nullptr);
 	}
 
+	// One per frame slot, each resolving into the slot's scene image.
 	void create_framebuffers()
 	{
-		g_swap_chain_framebuffers.resize(g_swap_chain_image_views.size());
-
-		for (size_t i = 0; i < g_swap_chain_image_views.size(); i++)
+		for (uint32_t i = 0; i < DW_MAX_FRAMES_IN_FLIGHT; i++)
 		{
-			VkImageView attachments[] = {
-				g_swap_chain_image_views[i]
-			};
-
-			VkFramebufferCreateInfo framebuffer_info = {};
+			g_scene_framebuffers[i] = create_msaa_framebuffer(g_device, g_render_pass, g_swap_chain_extent, g_sample_count, g_color_target.view, g_depth_target.view, g_post_process.scene_view(i));
 
-			framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			framebuffer_info.renderPass = g_render_pass;
-			framebuffer_info.attachmentCount = 1;
-			framebuffer_info.pAttachments = attachments;
-			framebuffer_info.width = g_swap_chain_extent.width;
-			framebuffer_info.height = g_swap_chain_extent.height;
-			framebuffer_info.layers = 1;
-
-			if (vkCreateFramebuffer(g_device, &framebuffer_info, nullptr, &g_swap_chain_framebuffers[i]) != VK_SUCCESS)
+			if (g_scene_framebuffers[i] == VK_NULL_HANDLE)
 				throw std::runtime_error("Failed to create framebuffer!");
 		}
 	}
@@ -790,70 +989,235 @@ namespace vulkan_backend
 		VkCommandPoolCreateInfo pool_info = {};
 		pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 		pool_info.queueFamilyIndex = indices.graphics_family;
-		pool_info.flags = 0;
+		pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
 		if (vkCreateCommandPool(g_device, &pool_info, nullptr, &g_command_pool) != VK_SUCCESS)
 			throw std::runtime_error("Failed to create command pool");
+
+		if (g_has_compute_queue)
+		{
+			pool_info.queueFamilyIndex = indices.compute_family;
+
+			if (vkCreateCommandPool(g_device, &pool_info, nullptr, &g_compute_command_pool) != VK_SUCCESS)
+				throw std::runtime_error("Failed to create command pool");
+		}
 	}
 
-	void create_command_buffers()
+	static void allocate_command_buffers(VkCommandPool pool, std::vector<VkCommandBuffer>& buffers)
 	{
-		g_command_buffers.resize(g_swap_chain_framebuffers.size());
+		buffers.resize(DW_MAX_FRAMES_IN_FLIGHT);
 
 		VkCommandBufferAllocateInfo alloc_info = {};
 		alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		alloc_info.commandPool = g_command_pool;
+		alloc_info.commandPool = pool;
 		alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		alloc_info.commandBufferCount = (uint32_t)g_command_buffers.size();
+		alloc_info.commandBufferCount = (uint32_t)buffers.size();
 
-		if (vkAllocateCommandBuffers(g_device, &alloc_info, g_command_buffers.data()) != VK_SUCCESS)
+		if (vkAllocateCommandBuffers(g_device, &alloc_info, buffers.data()) != VK_SUCCESS)
 			throw std::runtime_error("Failed to allocate command buffers");
+	}
+
+	void create_command_buffers()
+	{
+		allocate_command_buffers(g_command_pool, g_command_buffers);
 
-		for (size_t i = 0; i < g_command_buffers.size(); i++)
+		if (g_has_compute_queue)
 		{
-			VkCommandBufferBeginInfo begin_info = {};
-			begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-			begin_info.pInheritanceInfo = nullptr;
+			allocate_command_buffers(g_command_pool, g_present_command_buffers);
+			allocate_command_buffers(g_compute_command_pool, g_compute_command_buffers);
+		}
+	}
+
+	// Blits the rendered part of the slot's post-processing output over the whole swap chain image, or
+	// copies it when blits are not supported (and the render extent is the full extent).
+	static void record_present(VkCommandBuffer cmd, uint32_t slot, uint32_t image_index)
+	{
+		VkImage swap_chain_image = g_swap_chain_images[image_index];
+		VkExtent2D extent = g_slot_render_extent[slot];
+
+		// Chained to the acquire semaphore, which is waited on at the transfer stage.
+		VkImageMemoryBarrier to_transfer = {};
+		to_transfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		to_transfer.srcAccessMask = 0;
+		to_transfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		to_transfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		to_transfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		to_transfer.image = swap_chain_image;
+		to_transfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &to_transfer);
+
+		// The chain leaves its output in GENERAL, made visible to transfers by a barrier on the same
+		// queue or by the semaphore from the compute queue.
+		if (g_upscale_supported)
+		{
+			VkImageBlit blit = {};
+			blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			blit.srcOffsets[1] = { (int32_t)extent.width, (int32_t)extent.height, 1 };
+			blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			blit.dstOffsets[1] = { (int32_t)g_swap_chain_extent.width, (int32_t)g_swap_chain_extent.height, 1 };
+
+			vkCmdBlitImage(cmd, g_post_process.output_image(slot), VK_IMAGE_LAYOUT_GENERAL, swap_chain_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+		}
+		else
+		{
+			VkImageCopy copy = {};
+			copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			copy.extent = { g_swap_chain_extent.width, g_swap_chain_extent.height, 1 };
+
+			vkCmdCopyImage(cmd, g_post_process.output_image(slot), VK_IMAGE_LAYOUT_GENERAL, swap_chain_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+		}
+
+		VkImageMemoryBarrier to_present = to_transfer;
+		to_present.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		to_present.dstAccessMask = 0;
+		to_present.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		to_present.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+		// Ends at the transfer stage rather than bottom of pipe so the capture readback's barrier, which
+		// starts there, chains after the layout transition.
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &to_present);
+	}
 
-			vkBeginCommandBuffer(g_command_buffers[i], &begin_info);
+	static void begin_command_buffer(VkCommandBuffer cmd)
+	{
+		vkResetCommandBuffer(cmd, 0);
 
-			VkRenderPassBeginInfo render_pass_info = {};
-			render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			render_pass_info.renderPass = g_render_pass;
-			render_pass_info.framebuffer = g_swap_chain_framebuffers[i];
-			render_pass_info.renderArea.offset = { 0, 0 };
-			render_pass_info.renderArea.extent = g_swap_chain_extent;
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-			VkClearValue clear_color = { 0.0f, 0.0f, 0.0f, 1.0f };
-			render_pass_info.clearValueCount = 1;
-			render_pass_info.pClearValues = &clear_color;
+		vkBeginCommandBuffer(cmd, &begin_info);
+	}
 
-			vkCmdBeginRenderPass(g_command_buffers[i], &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
-			vkCmdBindPipeline(g_command_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, g_graphics_pipeline);
-			vkCmdDraw(g_command_buffers[i], 3, 1, 0, 0);
-			vkCmdEndRenderPass(g_command_buffers[i]);
+	static void end_command_buffer(VkCommandBuffer cmd)
+	{
+		if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
+			throw std::runtime_error("Failed to record command buffer");
+	}
 
-			if (vkEndCommandBuffer(g_command_buffers[i]) != VK_SUCCESS)
-				throw std::runtime_error("Failed to record command buffer");
+	// Sorts the frame's draw stream and translates it into the slot's command buffer. Without async
+	// compute the post-processing chain and the present blit follow in the same command buffer.
+	static void record_command_buffer(VkCommandBuffer cmd, uint32_t image_index)
+	{
+		// Keep the window from going blank when the application has nothing to draw.
+		if (g_draw_stream.empty())
+		{
+			DrawPacket triangle = {};
+			triangle.key = make_draw_key(0, DW_BUILTIN_PIPELINE, 0, 0.0f);
+			triangle.pipeline = DW_BUILTIN_PIPELINE;
+			triangle.material = DW_DRAW_NO_RESOURCE;
+			triangle.vertex_buffer = DW_DRAW_NO_RESOURCE;
+			triangle.index_buffer = DW_DRAW_NO_RESOURCE;
+			triangle.count = 3;
+			triangle.instance_count = 1;
+
+			g_draw_stream.push(triangle);
 		}
+
+		g_draw_stream.sort(g_draw_sorter);
+
+		begin_command_buffer(cmd);
+
+		g_gpu_timer.begin_frame(cmd, g_frame_slot);
+
+		VkRenderPassBeginInfo render_pass_info = {};
+		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		render_pass_info.renderPass = g_render_pass;
+		render_pass_info.framebuffer = g_scene_framebuffers[g_frame_slot];
+		render_pass_info.renderArea.offset = { 0, 0 };
+		render_pass_info.renderArea.extent = g_render_extent;
+
+		VkClearValue clear_values[2] = {};
+		clear_values[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+		clear_values[1].depthStencil = { 1.0f, 0 };
+
+		render_pass_info.clearValueCount = 2;
+		render_pass_info.pClearValues = clear_values;
+
+		g_draw_stats = {};
+
+		VkViewport viewport = { 0.0f, 0.0f, (float)g_render_extent.width, (float)g_render_extent.height, 0.0f, 1.0f };
+		VkRect2D scissor = { { 0, 0 }, g_render_extent };
+
+		uint32_t scene_scope = g_gpu_timer.begin_scope(cmd, "scene");
+
+		vkCmdBeginRenderPass(cmd, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdSetViewport(cmd, 0, 1, &viewport);
+		vkCmdSetScissor(cmd, 0, 1, &scissor);
+		record_draw_stream(cmd, g_draw_stream, 0, g_draw_stream.size(), g_draw_bindings, g_draw_stats);
+		vkCmdEndRenderPass(cmd);
+
+		g_gpu_timer.end_scope(cmd, scene_scope);
+
+		if (!g_async_compute)
+		{
+			g_post_process.record(cmd, g_frame_slot, g_render_extent, g_gpu_timer);
+
+			uint32_t present_scope = g_gpu_timer.begin_scope(cmd, "present");
+			record_present(cmd, g_frame_slot, image_index);
+			g_gpu_timer.end_scope(cmd, present_scope);
+		}
+
+		end_command_buffer(cmd);
+
+		g_binds_eliminated += g_draw_stats.binds_eliminated;
 	}
 
-	void create_semaphores()
+	// The slot's post-processing chain for the compute queue, timed with the compute queue's timer.
+	static void record_compute_command_buffer(VkCommandBuffer cmd)
+	{
+		begin_command_buffer(cmd);
+
+		g_compute_timer.begin_frame(cmd, g_frame_slot);
+		g_post_process.record(cmd, g_frame_slot, g_render_extent, g_compute_timer);
+
+		end_command_buffer(cmd);
+	}
+
+	void create_sync_objects()
 	{
 		VkSemaphoreCreateInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		if (vkCreateSemaphore(g_device, &info, nullptr, &g_image_availabel_sema) != VK_SUCCESS ||
-			vkCreateSemaphore(g_device, &info, nullptr, &g_render_finished_sema) != VK_SUCCESS)
+		for (uint32_t i = 0; i < DW_MAX_FRAMES_IN_FLIGHT; i++)
 		{
-			throw std::runtime_error("Failed to create semaphores");
+			if (vkCreateSemaphore(g_device, &info, nullptr, &g_image_availabel_sema[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(g_device, &info, nullptr, &g_render_finished_sema[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(g_device, &info, nullptr, &g_scene_done_sema[i]) != VK_SUCCESS ||
+				vkCreateSemaphore(g_device, &info, nullptr, &g_post_done_sema[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create semaphores");
+			}
 		}
 	}
 
 	bool initialize(GLFWwindow* window)
 	{
 		g_window = window;
+		g_refresh_interval_ms = display_refresh_interval_ms();
+
+		int width, height;
+		glfwGetFramebufferSize(window, &width, &height);
+		set_framebuffer_size(width, height);
+
+		// Feeds the heap allocations per frame check in begin_frame().
+		set_allocation_counting(true);
+
+		// Kick off shader IO first so it overlaps instance and device creation.
+		g_asset_streamer.initialize();
+
+		AssetId vert_id = g_asset_streamer.request("shaders/vert.spv", AssetType::SHADER, 1.0f);
+		AssetId frag_id = g_asset_streamer.request("shaders/frag.spv", AssetType::SHADER, 1.0f);
+
+		const char* post_paths[PostShader::COUNT] = { "shaders/post_downsample.spv", "shaders/post_upsample.spv", "shaders/post_tonemap.spv", "shaders/post_fxaa.spv" };
+		AssetId post_ids[PostShader::COUNT];
+
+		for (uint32_t i = 0; i < PostShader::COUNT; i++)
+			post_ids[i] = g_asset_streamer.request(post_paths[i], AssetType::SHADER, 1.0f);
 
 		if (!create_instance())
 			return false;
@@ -863,58 +1227,128 @@ namespace vulkan_backend
 		create_surface(window);
 		pick_physical_device();
 		create_logical_device();
+
+		wait_for_file(vert_id, g_vert_spirv);
+		wait_for_file(frag_id, g_frag_spirv);
+
+		for (uint32_t i = 0; i < PostShader::COUNT; i++)
+			wait_for_file(post_ids[i], g_post_spirv[i]);
+
+		QueueFamilyIndices indices = find_queue_families(g_physical_device);
+		uint32_t compute_family = g_has_compute_queue ? indices.compute_family : indices.graphics_family;
+
+		if (!g_post_process.initialize(g_physical_device, g_device, g_post_spirv, DW_MAX_FRAMES_IN_FLIGHT, indices.graphics_family, compute_family))
+			throw std::runtime_error("Failed to create post-processing pipelines!");
+
+		g_depth_format = choose_depth_format(g_physical_device);
+
+		if (g_depth_format == VK_FORMAT_UNDEFINED)
+			throw std::runtime_error("Failed to find a depth format!");
+
 		create_swap_chain();
-		create_image_views();
+		create_render_targets();
 		create_render_pass();
 		create_graphics_pipeline();
 		create_framebuffers();
 		create_command_pool();
 		create_command_buffers();
-		create_semaphores();
+		create_sync_objects();
+
+		g_draw_sorter.initialize();
+
+		apply_present_policy();
+
+		g_resolution.set_target(g_refresh_interval_ms * DW_GPU_BUDGET_FRACTION);
 
 		return true;
 	}
 
-	void draw()
+	void begin_frame()
 	{
-		vkQueueWaitIdle(g_present_queue);
+		g_frame_slot = g_frame_index % g_frames_in_flight;
 
-		uint32_t image_index;
-		VkResult result = vkAcquireNextImageKHR(g_device, g_swap_chain, std::numeric_limits<uint64_t>::max(), g_image_availabel_sema, VK_NULL_HANDLE, &image_index);
+		// Transient CPU data of the frame from DW_FRAME_ARENA_SLOTS frames ago is dead by now.
+		frame_arena_next_frame();
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR)
-		{
-			recreate_swap_chain();
-			return;
-		}
-		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		uint64_t allocations = thread_allocation_count();
+		g_frame_allocations = allocations - g_allocations_at_frame_start;
+		g_allocations_at_frame_start = allocations;
+
+		if (g_frame_index > DW_ALLOCATION_WARMUP_FRAMES && g_frame_allocations > 0)
+			g_allocating_frames++;
+
+		// Only wait for the frame that last used this slot instead of draining the queue. Point 0 (no
+		// frame yet) is always complete.
+		g_graphics_timeline.wait(g_frame_points[g_frame_slot]);
+
+		// Anything retired at or before the completed point is no longer in use by the GPU.
+		uint64_t completed = g_graphics_timeline.completed();
+		g_deletion_queue.collect(completed);
+		g_frame_capture.collect(completed);
+
+		// The slot's previous frame is done, so its timestamps are in. Its scale is what the GPU time
+		// was measured at; the controller ignores the frames in flight after a change.
+		g_gpu_timer.collect(g_frame_slot);
+		g_compute_timer.collect(g_frame_slot);
+
+		if (g_upscale_supported)
 		{
-			throw std::runtime_error("Failed to acquire swap chain image");
+			// With async compute the two queues overlap, so the busier one sets the pace.
+			double gpu_ms = g_gpu_timer.frame_ms();
+
+			if (g_async_compute)
+				gpu_ms = std::max(gpu_ms, g_compute_timer.frame_ms());
+
+			g_resolution.update(gpu_ms);
+			g_resolution.scaled_extent(g_swap_chain_extent.width, g_swap_chain_extent.height, g_render_extent.width, g_render_extent.height);
 		}
+		else
+			g_render_extent = g_swap_chain_extent;
 
-		VkSubmitInfo submit_info = {};
+		g_slot_render_extent[g_frame_slot] = g_render_extent;
 
-		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		// The application fills the stream between here and draw().
+		g_draw_stream.clear();
 
-		VkSemaphore wait_sema[] = { g_image_availabel_sema };
-		VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submit_info.waitSemaphoreCount = 1;
-		submit_info.pWaitSemaphores = wait_sema;
-		submit_info.pWaitDstStageMask = wait_stages;
-		submit_info.commandBufferCount = 1;
-		submit_info.pCommandBuffers = &g_command_buffers[image_index];
+		// Objects retired from here on may still be used by everything submitted so far. A frame still
+		// on the compute queue is only covered by its present, which follows this frame's scene.
+		g_deletion_queue.set_frame(g_graphics_timeline.last_submitted() + (g_pending_present >= 0 ? 2 : 0));
+		g_residency.update(g_frame_index);
 
-		VkSemaphore signal_sema[] = { g_render_finished_sema };
-		submit_info.signalSemaphoreCount = 1;
-		submit_info.pSignalSemaphores = signal_sema;
+		// Waiting after the fence, right before the caller samples input, keeps the sampled input as
+		// fresh as possible when the frame is presented.
+		g_input_times[g_frame_slot] = g_frame_pacer.wait_for_input();
+	}
 
-		if (vkQueueSubmit(g_graphics_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+	// Unsignals a binary semaphore whose waiting work was dropped, with an empty graphics submission
+	// that also becomes the slot's point.
+	static void consume_semaphore(uint32_t slot, VkSemaphore semaphore)
+	{
+		VkPipelineStageFlags stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		uint64_t point = g_graphics_timeline.submit(nullptr, 0, &semaphore, &stage, 1);
+
+		if (point == 0)
 			throw std::runtime_error("Failed to submit command buffer");
 
+		g_frame_points[slot] = point;
+	}
+
+	// A post-processed frame that will not be presented, e.g. because the swap chain is replaced.
+	static void drop_pending_present()
+	{
+		if (g_pending_present < 0)
+			return;
+
+		consume_semaphore(g_pending_present, g_post_done_sema[g_pending_present]);
+		g_pending_present = -1;
+	}
+
+	static void present_image(uint32_t slot, uint32_t image_index)
+	{
 		VkPresentInfoKHR present_info = {};
 		present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 		present_info.waitSemaphoreCount = 1;
-		present_info.pWaitSemaphores = signal_sema;
+		present_info.pWaitSemaphores = &g_render_finished_sema[slot];
 
 		VkSwapchainKHR swapchains[] = { g_swap_chain };
 		present_info.swapchainCount = 1;
@@ -922,67 +1356,381 @@ namespace vulkan_backend
 		present_info.pImageIndices = &image_index;
 		present_info.pResults = nullptr;
 
-		result = vkQueuePresentKHR(g_present_queue, &present_info);
+		VkResult result = vkQueuePresentKHR(g_present_queue, &present_info);
+
+		// With async compute this is the previous frame's slot, sampled before this frame's input.
+		g_frame_pacer.presented(g_input_times[slot]);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
-		{
 			recreate_swap_chain();
-			return;
-		}
 		else if (result != VK_SUCCESS)
-		{
 			throw std::runtime_error("Failed to present swap chain image");
+	}
+
+	// Submits the blit (or copy) of the slot's output into the swap chain image, plus the capture
+	// readback, and presents. With post_done, the slot's chain ran on the compute queue and only the
+	// blit is recorded; without, the whole frame is recorded here once the image index is known.
+	// Returns false, having submitted nothing, if the swap chain is out of date and has to be recreated.
+	static bool submit_present(uint32_t slot, VkSemaphore post_done)
+	{
+		uint32_t image_index;
+		VkResult result = vkAcquireNextImageKHR(g_device, g_swap_chain, std::numeric_limits<uint64_t>::max(), g_image_availabel_sema[slot], VK_NULL_HANDLE, &image_index);
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+			return false;
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+			throw std::runtime_error("Failed to acquire swap chain image");
+
+		VkCommandBuffer cmd;
+
+		if (post_done != VK_NULL_HANDLE)
+		{
+			cmd = g_present_command_buffers[slot];
+
+			begin_command_buffer(cmd);
+			record_present(cmd, slot, image_index);
+			end_command_buffer(cmd);
+		}
+		else
+		{
+			cmd = g_command_buffers[slot];
+			record_command_buffer(cmd, image_index);
 		}
+
+		// Both are first needed by the transfer into the swap chain image.
+		VkSemaphore wait_sema[] = { g_image_availabel_sema[slot], post_done };
+		VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT };
+		uint32_t wait_count = post_done != VK_NULL_HANDLE ? 2 : 1;
+
+		// The readback copy goes into the same submission, after the frame's commands, so it completes
+		// with the frame's timeline point.
+		VkCommandBuffer command_buffers[] = { cmd, VK_NULL_HANDLE };
+
+		if (g_swap_chain_capturable)
+			command_buffers[1] = g_frame_capture.record(g_swap_chain_images[image_index], g_swap_chain_image_format, g_swap_chain_extent, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+														VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, g_graphics_timeline.next_point());
+
+		uint64_t point = g_graphics_timeline.submit(command_buffers, command_buffers[1] != VK_NULL_HANDLE ? 2 : 1, wait_sema, wait_stages, wait_count, &g_render_finished_sema[slot], 1);
+
+		if (point == 0)
+			throw std::runtime_error("Failed to submit command buffer");
+
+		g_frame_points[slot] = point;
+
+		present_image(slot, image_index);
+
+		return true;
+	}
+
+	// Scene of this frame on the graphics queue, then the present of the previous frame, whose
+	// post-processing ran on the compute queue in the meantime, then this frame's post-processing.
+	static void draw_async()
+	{
+		uint32_t frame = g_frame_slot;
+
+		record_command_buffer(g_command_buffers[frame], 0);
+
+		uint64_t point = g_graphics_timeline.submit(&g_command_buffers[frame], 1, nullptr, nullptr, 0, &g_scene_done_sema[frame], 1);
+
+		if (point == 0)
+			throw std::runtime_error("Failed to submit command buffer");
+
+		// Until the present of this frame replaces it.
+		g_frame_points[frame] = point;
+
+		uint64_t generation = g_swap_chain_generation;
+
+		if (g_pending_present >= 0)
+		{
+			uint32_t slot = g_pending_present;
+
+			g_pending_present = -1;
+
+			// The dropped frame's chain has to be covered by a point before its images are retired.
+			if (!submit_present(slot, g_post_done_sema[slot]))
+			{
+				consume_semaphore(slot, g_post_done_sema[slot]);
+				recreate_swap_chain();
+			}
+		}
+
+		// A recreated swap chain came with new post-processing images; the scene went into the old ones.
+		if (generation != g_swap_chain_generation)
+		{
+			consume_semaphore(frame, g_scene_done_sema[frame]);
+			return;
+		}
+
+		record_compute_command_buffer(g_compute_command_buffers[frame]);
+
+		VkPipelineStageFlags stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		VkSubmitInfo submit_info = {};
+		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submit_info.waitSemaphoreCount = 1;
+		submit_info.pWaitSemaphores = &g_scene_done_sema[frame];
+		submit_info.pWaitDstStageMask = &stage;
+		submit_info.commandBufferCount = 1;
+		submit_info.pCommandBuffers = &g_compute_command_buffers[frame];
+		submit_info.signalSemaphoreCount = 1;
+		submit_info.pSignalSemaphores = &g_post_done_sema[frame];
+
+		// No fence or timeline: the present submission waits for this on the graphics queue, so the
+		// graphics timeline point of the frame covers it.
+		if (vkQueueSubmit(g_compute_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+			throw std::runtime_error("Failed to submit compute command buffer");
+
+		g_pending_present = frame;
 	}
 
+	void draw()
+	{
+		if (g_async_compute)
+			draw_async();
+		else if (!submit_present(g_frame_slot, VK_NULL_HANDLE))
+			recreate_swap_chain();
+
+		g_frame_index++;
+	}
+
+	// Retires everything that depends on the swap chain except the swap chain itself, which is handed
+	// over to its replacement in create_swap_chain().
 	void cleanup_swap_chain()
 	{
-		for (size_t i = 0; i < g_swap_chain_framebuffers.size(); i++)
-			vkDestroyFramebuffer(g_device, g_swap_chain_framebuffers[i], nullptr);
+		for (uint32_t i = 0; i < DW_MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			if (g_scene_framebuffers[i] != VK_NULL_HANDLE)
+				g_deletion_queue.destroy_framebuffer(g_scene_framebuffers[i]);
 
-		vkFreeCommandBuffers(g_device, g_command_pool, static_cast<uint32_t>(g_command_buffers.size()), g_command_buffers.data());
+			g_scene_framebuffers[i] = VK_NULL_HANDLE;
+		}
 
-		vkDestroyPipeline(g_device, g_graphics_pipeline, nullptr);
-		vkDestroyPipelineLayout(g_device, g_pipeline_layout, nullptr);
-		vkDestroyRenderPass(g_device, g_render_pass, nullptr);
+		g_deletion_queue.destroy_pipeline(g_graphics_pipeline);
+		g_deletion_queue.destroy_pipeline_layout(g_pipeline_layout);
+		g_deletion_queue.destroy_render_pass(g_render_pass);
 
-		for (size_t i = 0; i < g_swap_chain_image_views.size(); i++)
-			vkDestroyImageView(g_device, g_swap_chain_image_views[i], nullptr);
+		retire_render_target(g_color_target, g_color_residency);
+		retire_render_target(g_depth_target, g_depth_residency);
 
-		vkDestroySwapchainKHR(g_device, g_swap_chain, nullptr);
+		// The post-processing images themselves are retired when they are recreated or shut down.
+		g_residency.unregister_resource(g_post_residency);
 	}
 
 	void shutdown()
 	{
-		vkDeviceWaitIdle(g_device);
+		drop_pending_present();
+		device_wait_idle();
+
+		g_frame_capture.shutdown();
 
 		cleanup_swap_chain();
+		g_post_process.shutdown(g_deletion_queue);
+		g_deletion_queue.destroy_swapchain(g_swap_chain);
+		g_deletion_queue.flush();
+
+		g_draw_sorter.shutdown();
+
+		// Per pass timings of the last collected frame. With async compute the chain is on its own timer.
+		for (const GpuScopeTiming& timing : g_gpu_timer.results())
+			std::cout << "GPU " << timing.name << " : " << timing.ms << " ms" << std::endl;
+
+		if (g_async_compute)
+		{
+			for (const GpuScopeTiming& timing : g_compute_timer.results())
+				std::cout << "GPU " << timing.name << " (async compute) : " << timing.ms << " ms" << std::endl;
+		}
 
-		vkDestroySemaphore(g_device, g_render_finished_sema, nullptr);
-		vkDestroySemaphore(g_device, g_image_availabel_sema, nullptr);
+		g_gpu_timer.shutdown();
+		g_compute_timer.shutdown();
+
+		std::cout << "Blocking timeline waits : " << g_graphics_timeline.blocking_waits() << ", fences : " << g_graphics_timeline.fence_count() << std::endl;
+		g_graphics_timeline.shutdown();
+
+		for (uint32_t i = 0; i < DW_MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			vkDestroySemaphore(g_device, g_render_finished_sema[i], nullptr);
+			vkDestroySemaphore(g_device, g_image_availabel_sema[i], nullptr);
+			vkDestroySemaphore(g_device, g_scene_done_sema[i], nullptr);
+			vkDestroySemaphore(g_device, g_post_done_sema[i], nullptr);
+		}
 
 		vkDestroyCommandPool(g_device, g_command_pool, nullptr);
 
+		if (g_compute_command_pool != VK_NULL_HANDLE)
+			vkDestroyCommandPool(g_device, g_compute_command_pool, nullptr);
+
 		destroy_debug_report_callback_ext(g_instance, g_debug_callback, nullptr);
 		
 		vkDestroyDevice(g_device, nullptr);
 		vkDestroySurfaceKHR(g_instance, g_surface, nullptr);
 		vkDestroyInstance(g_instance, nullptr);
+
+		g_asset_streamer.shutdown();
+
+		std::cout << "Idle waits this session : " << g_idle_wait_count << " (" << g_frame_index << " frames)" << std::endl;
+
+		if (g_frame_index > DW_ALLOCATION_WARMUP_FRAMES)
+			std::cout << "Frames with heap allocations after warmup : " << g_allocating_frames << std::endl;
+
+		if (g_upscale_supported)
+			std::cout << "Dynamic resolution : scale " << g_resolution.scale() << ", " << g_resolution.changes() << " changes, GPU " << g_resolution.smoothed_ms() << " ms of " << g_resolution.target() << " ms" << std::endl;
+
+		if (g_frame_index > 0)
+			std::cout << "Draw stream : " << (double)g_binds_eliminated / g_frame_index << " redundant binds eliminated per frame" << std::endl;
+
+		g_residency.print_stats();
+
+		FramePacerStats stats;
+		g_frame_pacer.stats(stats);
+
+		std::cout << "Input to present : mean " << stats.mean_latency_ms << " ms, p99 " << stats.p99_latency_ms << " ms, max " << stats.max_latency_ms << " ms, frame time " << stats.mean_frame_ms << " ms" << std::endl;
+	}
+
+	void set_present_policy(uint32_t policy)
+	{
+		if (policy == g_present_policy)
+			return;
+
+		g_present_policy = policy;
+
+		if (g_device == VK_NULL_HANDLE)
+			return;
+
+		// Frames in flight may shrink, so every slot has to be free before the slot mapping changes.
+		// This waits on the graphics timeline for at most two frames, not for a device idle. A frame
+		// left on the compute queue is only covered once its present is dropped; async compute may be
+		// switched off below.
+		drop_pending_present();
+		g_graphics_timeline.wait_idle();
+
+		apply_present_policy();
+		recreate_swap_chain();
+	}
+
+	uint32_t present_policy()
+	{
+		return g_present_policy;
+	}
+
+	void set_just_in_time_pacing(bool enabled)
+	{
+		g_just_in_time_pacing = enabled;
+		g_frame_pacer.set_just_in_time(enabled && g_present_policy == PresentPolicy::LOW_LATENCY);
+	}
+
+	void set_framebuffer_size(uint32_t width, uint32_t height)
+	{
+		g_framebuffer_size = ((uint64_t)width << 32) | height;
+	}
+
+	void frame_stats(FramePacerStats& stats)
+	{
+		g_frame_pacer.stats(stats);
+	}
+
+	ResidencyManager& residency()
+	{
+		return g_residency;
+	}
+
+	FrameCapture& capture()
+	{
+		return g_frame_capture;
+	}
+
+	DrawStream& draw_stream()
+	{
+		return g_draw_stream;
+	}
+
+	DrawBindings& draw_bindings()
+	{
+		return g_draw_bindings;
+	}
+
+	void draw_stream_stats(DrawStreamStats& stats)
+	{
+		stats = g_draw_stats;
+	}
+
+	uint64_t frame_allocations()
+	{
+		return g_frame_allocations;
+	}
+
+	void set_sample_count(uint32_t samples)
+	{
+		if (samples == g_requested_samples)
+			return;
+
+		g_requested_samples = samples;
+
+		// Render pass, pipeline and targets all depend on the sample count, like on the swap chain.
+		if (g_device != VK_NULL_HANDLE)
+			recreate_swap_chain();
+	}
+
+	uint32_t sample_count()
+	{
+		return g_sample_count;
+	}
+
+	uint32_t max_samples()
+	{
+		return max_sample_count(g_physical_device);
+	}
+
+	void set_gpu_budget(double ms)
+	{
+		g_resolution.set_target(ms);
+	}
+
+	double resolution_scale()
+	{
+		return g_upscale_supported ? g_resolution.scale() : 1.0;
+	}
+
+	void render_extent(uint32_t& width, uint32_t& height)
+	{
+		width = g_render_extent.width;
+		height = g_render_extent.height;
+	}
+
+	const GpuTimer& gpu_timer()
+	{
+		return g_gpu_timer;
+	}
+
+	const GpuTimer& compute_gpu_timer()
+	{
+		return g_compute_timer;
+	}
+
+	PostProcessSettings& post_process_settings()
+	{
+		return g_post_process.settings();
+	}
+
+	bool async_compute()
+	{
+		return g_async_compute;
 	}
 
 	void recreate_swap_chain()
 	{
 		std::cout << "Recreating swap chain..." << std::endl;
 
-		vkDeviceWaitIdle(g_device);
+		drop_pending_present();
+		g_swap_chain_generation++;
 
+		// No idle wait: old objects are retired and freed once the frames using them have completed.
+		g_deletion_queue.set_frame(g_graphics_timeline.last_submitted());
 		cleanup_swap_chain();
 
 		create_swap_chain();
-		create_image_views();
+		create_render_targets();
 		create_render_pass();
 		create_graphics_pipeline();
 		create_framebuffers();
-		create_command_buffers();
 	}
 }
\ No newline at end of file
@@ -1,11 +1,91 @@
 #pragma once
 
+#include <stdint.h>
+#include "frame_pacer.h"
+#include "residency_manager.h"
+#include "frame_capture.h"
+#include "draw_stream.h"
+#include "draw_recorder.h"
+#include "gpu_timer.h"
+#include "post_process.h"
+
 struct GLFWwindow;
 
 namespace vulkan_backend
 {
+	namespace PresentPolicy
+	{
+		enum
+		{
+			// One frame in flight, fewest swap chain images, input sampled just in time for the next refresh.
+			LOW_LATENCY,
+			// MAILBOX/IMMEDIATE with an extra swap chain image and the CPU running ahead. The default.
+			THROUGHPUT,
+			// FIFO, tear free and display paced.
+			VSYNC
+		};
+	}
+
 	extern bool initialize(GLFWwindow* window);
+	// Waits for the frame slot to free up and for the pacer, then returns. Sample input right after.
+	extern void begin_frame();
 	extern void draw();
 	extern void shutdown();
 	extern void recreate_swap_chain();
+	// Framebuffer size in pixels, from the main thread's GLFW resize callback. Swap chains created
+	// afterwards use it where the surface leaves the extent to the application, so the thread that
+	// renders never calls into GLFW.
+	extern void set_framebuffer_size(uint32_t width, uint32_t height);
+
+	extern void set_present_policy(uint32_t policy);
+	extern uint32_t present_policy();
+	// Just in time pacing under LOW_LATENCY assumes input is sampled right after begin_frame(). When
+	// input is sampled on another thread, turn it off: the pacer then only limits the frame rate, and
+	// its latency is measured from begin_frame() rather than from the input. On by default.
+	extern void set_just_in_time_pacing(bool enabled);
+	extern void frame_stats(FramePacerStats& stats);
+
+	// Register device allocations here so they count against the heap budgets; see ResidencyManager.
+	extern ResidencyManager& residency();
+
+	// Screenshots and raw video capture of the presented frames.
+	extern FrameCapture& capture();
+
+	// Filled by Application::render() every frame, then sorted and recorded by draw(). Packet ids
+	// index draw_bindings(); pipeline 0 is the backend's built-in triangle. Pipelines must be created
+	// with sample_count() samples, a DW_POST_SCENE_FORMAT color and a depth attachment and dynamic
+	// viewport and scissor; the backend sets both to render_extent(). The scene is HDR, see PostProcess.
+	extern DrawStream& draw_stream();
+	extern DrawBindings& draw_bindings();
+	// Draws and binds of the last recorded frame, including how many redundant binds were skipped.
+	extern void draw_stream_stats(DrawStreamStats& stats);
+
+	// Heap allocations the main thread made during the last full frame (begin_frame() to begin_frame()).
+	// Frame-lifetime data should come from frame_arena() instead, so this stays 0 in steady state.
+	extern uint64_t frame_allocations();
+
+	// MSAA samples per pixel, rounded down to what the device supports (DW_DEFAULT_SAMPLE_COUNT by
+	// default). Changing it recreates the render pass and the built-in pipeline; pipelines in
+	// draw_bindings() have to be recreated by the application.
+	extern void set_sample_count(uint32_t samples);
+	extern uint32_t sample_count();
+	extern uint32_t max_samples();
+
+	// GPU time per frame the dynamic resolution controller aims for, by default a share of the display
+	// refresh interval. 0 renders at full resolution. See ResolutionController.
+	extern void set_gpu_budget(double ms);
+	extern double resolution_scale();
+	// Part of the swap chain extent the scene is rendered at this frame, valid after begin_frame().
+	extern void render_extent(uint32_t& width, uint32_t& height);
+	// Per scope GPU timings of a recent frame. With async compute the post-processing passes are in
+	// compute_gpu_timer() instead.
+	extern const GpuTimer& gpu_timer();
+	extern const GpuTimer& compute_gpu_timer();
+
+	// Read by every frame's post-processing chain, changes apply to the next one recorded.
+	extern PostProcessSettings& post_process_settings();
+	// True while post-processing runs on a separate compute queue, overlapping the next frame's scene
+	// at the cost of presenting one frame later. Needs a compute-only queue family and is off with
+	// PresentPolicy::LOW_LATENCY.
+	extern bool async_compute();
 }
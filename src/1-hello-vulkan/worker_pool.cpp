@@ -0,0 +1,121 @@
+#include "worker_pool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool() : m_quit(false), m_job(0), m_fn(nullptr), m_count(0), m_chunk_size(1), m_next_chunk(0), m_remaining(0)
+{
+
+}
+
+WorkerPool::~WorkerPool()
+{
+	shutdown();
+}
+
+void WorkerPool::initialize(uint32_t thread_count)
+{
+	if (thread_count == 0)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+	m_quit = false;
+
+	for (uint32_t i = 1; i < thread_count; i++)
+		m_threads.emplace_back(&WorkerPool::worker, this);
+}
+
+void WorkerPool::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+
+	m_wake.notify_all();
+
+	for (auto& thread : m_threads)
+		thread.join();
+
+	m_threads.clear();
+}
+
+void WorkerPool::run_chunks(uint32_t job, const std::function<void(uint32_t, uint32_t)>& fn, uint32_t count, uint32_t chunk_size)
+{
+	uint32_t chunks = (count + chunk_size - 1) / chunk_size;
+	uint64_t next = m_next_chunk.load(std::memory_order_acquire);
+
+	while ((uint32_t)(next >> 32) == job && (uint32_t)next < chunks)
+	{
+		if (!m_next_chunk.compare_exchange_weak(next, next + 1, std::memory_order_acq_rel))
+			continue;
+
+		uint32_t begin = (uint32_t)next * chunk_size;
+		uint32_t end = std::min(begin + chunk_size, count);
+
+		fn(begin, end);
+
+		m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+		next = m_next_chunk.load(std::memory_order_acquire);
+	}
+}
+
+void WorkerPool::worker()
+{
+	uint32_t seen = 0;
+
+	while (true)
+	{
+		const std::function<void(uint32_t, uint32_t)>* fn;
+		uint32_t count;
+		uint32_t chunk_size;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_quit || m_job != seen; });
+
+			if (m_quit)
+				return;
+
+			seen = m_job;
+			fn = m_fn;
+			count = m_count;
+			chunk_size = m_chunk_size;
+		}
+
+		run_chunks(seen, *fn, count, chunk_size);
+	}
+}
+
+void WorkerPool::parallel_for(uint32_t count, uint32_t chunk_size, const std::function<void(uint32_t, uint32_t)>& fn)
+{
+	if (count == 0)
+		return;
+
+	chunk_size = std::max(chunk_size, 1u);
+
+	// Not worth waking anyone.
+	if (m_threads.empty() || count <= chunk_size)
+	{
+		fn(0, count);
+		return;
+	}
+
+	uint32_t job;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		job = ++m_job;
+		m_fn = &fn;
+		m_count = count;
+		m_chunk_size = chunk_size;
+		m_remaining.store((count + chunk_size - 1) / chunk_size, std::memory_order_relaxed);
+		m_next_chunk.store((uint64_t)job << 32, std::memory_order_release);
+	}
+
+	m_wake.notify_all();
+
+	run_chunks(job, fn, count, chunk_size);
+
+	// Chunks claimed by workers may still be running.
+	while (m_remaining.load(std::memory_order_acquire) > 0)
+		std::this_thread::yield();
+}
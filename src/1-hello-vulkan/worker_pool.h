@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// Persistent threads for data parallel loops that run every frame, where spawning threads per call
+// would cost more than the work itself.
+class WorkerPool
+{
+public:
+	WorkerPool();
+	~WorkerPool();
+
+	// 0 picks one thread per core. The calling thread counts as one.
+	void initialize(uint32_t thread_count = 0);
+	void shutdown();
+
+	// Splits [0, count) into chunks of chunk_size and calls fn(begin, end) for each, on the workers
+	// and the calling thread. Returns once every chunk is done. Not reentrant.
+	void parallel_for(uint32_t count, uint32_t chunk_size, const std::function<void(uint32_t, uint32_t)>& fn);
+
+	inline uint32_t thread_count() const { return (uint32_t)m_threads.size() + 1; }
+
+private:
+	void worker();
+	void run_chunks(uint32_t job, const std::function<void(uint32_t, uint32_t)>& fn, uint32_t count, uint32_t chunk_size);
+
+private:
+	std::vector<std::thread>						 m_threads;
+	std::mutex										 m_mutex;
+	std::condition_variable							 m_wake;
+	bool											 m_quit;
+	uint32_t										 m_job;
+	// Current job, copied by the workers when they pick it up.
+	const std::function<void(uint32_t, uint32_t)>*	 m_fn;
+	uint32_t										 m_count;
+	uint32_t										 m_chunk_size;
+	// Job id in the high 32 bits, next chunk in the low 32. Tagging the counter keeps a worker that
+	// wakes up late from claiming chunks of a newer job with the old job's function.
+	std::atomic<uint64_t>							 m_next_chunk;
+	std::atomic<uint32_t>							 m_remaining;
+};
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+
+#include "mesh_import.h"
+#include "mesh_optimizer.h"
+#include "mesh_cache.h"
+
+static bool ends_with(const std::string& str, const char* suffix)
+{
+	size_t length = strlen(suffix);
+	return str.size() >= length && str.compare(str.size() - length, length, suffix) == 0;
+}
+
+static void print_usage()
+{
+	std::cout << "Usage : mesh-convert [--packed] [--no-optimize] <input.obj|input.gltf|input.glb>... <output.dwm>" << std::endl;
+	std::cout << "  --packed       Store 16 byte packed vertices instead of 32 byte float vertices." << std::endl;
+	std::cout << "  --no-optimize  Skip vertex cache, overdraw and vertex fetch optimization." << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t vertex_format = mesh::VertexFormat::FLOAT;
+	bool optimize = true;
+	std::vector<std::string> paths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--packed") == 0)
+			vertex_format = mesh::VertexFormat::PACKED;
+		else if (strcmp(argv[i], "--no-optimize") == 0)
+			optimize = false;
+		else
+			paths.push_back(argv[i]);
+	}
+
+	if (paths.size() < 2)
+	{
+		print_usage();
+		return 1;
+	}
+
+	std::string output = paths.back();
+	paths.pop_back();
+
+	std::vector<mesh::Mesh> meshes;
+
+	for (const auto& path : paths)
+	{
+		bool ok = false;
+
+		if (ends_with(path, ".obj"))
+		{
+			mesh::Mesh m;
+			ok = mesh::load_obj(path.c_str(), m);
+
+			if (ok)
+				meshes.push_back(std::move(m));
+		}
+		else if (ends_with(path, ".gltf") || ends_with(path, ".glb"))
+			ok = mesh::load_gltf(path.c_str(), meshes);
+		else
+			std::cout << "Unsupported input format : " << path << std::endl;
+
+		if (!ok)
+			return 1;
+	}
+
+	if (optimize)
+	{
+		std::vector<mesh::OptimizeStats> stats;
+		mesh::optimize_meshes(meshes, &stats);
+
+		for (size_t i = 0; i < stats.size(); i++)
+			std::cout << "Mesh " << i << " : ACMR " << stats[i].acmr_before << " -> " << stats[i].acmr_after << ", vertices " << stats[i].vertices_before << " -> " << stats[i].vertices_after << std::endl;
+	}
+
+	if (!mesh::write_mesh_cache(output.c_str(), meshes, vertex_format))
+		return 1;
+
+	std::cout << "Wrote " << meshes.size() << " meshes to " << output << std::endl;
+
+	return 0;
+}
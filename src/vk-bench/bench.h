@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+	struct Result
+	{
+		const char* name;
+		uint32_t	iterations;
+		double		mean_ms;
+		double		min_ms;
+		double		max_ms;
+		// Less sensitive to outliers than the mean; the number to track across commits.
+		double		median_ms;
+		// Units of work per call (draws, bytes, updates...), 0 if not meaningful. Used for per-item rates.
+		uint64_t	items;
+	};
+
+	// Overrides for every benchmark, set from the command line. 0 keeps each benchmark's own count.
+	struct Settings
+	{
+		uint32_t warmup = 0;
+		uint32_t iterations = 0;
+	};
+
+	// A reported result, kept for the CSV/JSON output.
+	struct Record
+	{
+		std::string group;
+		std::string name;
+		Result		result;
+	};
+
+	inline Settings& settings()
+	{
+		static Settings s;
+		return s;
+	}
+
+	inline std::vector<Record>& records()
+	{
+		static std::vector<Record> r;
+		return r;
+	}
+
+	inline std::string& current_group()
+	{
+		static std::string g;
+		return g;
+	}
+
+	// Results reported from here on are filed under group in the CSV/JSON output.
+	inline void set_group(const std::string& group)
+	{
+		current_group() = group;
+	}
+
+	// Relative to the first call: milliseconds since the epoch as a double only resolve to about 0.25 us.
+	inline double now_ms()
+	{
+		using namespace std::chrono;
+		static const steady_clock::time_point start = steady_clock::now();
+		return duration<double, std::milli>(steady_clock::now() - start).count();
+	}
+
+	// Runs fn() warmup times without measuring, then iterations times, and returns the per-call timings.
+	template <typename T>
+	Result run(const char* name, uint32_t warmup, uint32_t iterations, T fn, uint64_t items = 0)
+	{
+		if (settings().warmup > 0)
+			warmup = settings().warmup;
+
+		if (settings().iterations > 0)
+			iterations = settings().iterations;
+
+		for (uint32_t i = 0; i < warmup; i++)
+			fn();
+
+		Result result = { name, iterations, 0.0, 1e30, 0.0, 0.0, items };
+		std::vector<double> samples(iterations);
+
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			double start = now_ms();
+			fn();
+			double elapsed = now_ms() - start;
+
+			samples[i] = elapsed;
+			result.mean_ms += elapsed;
+			result.min_ms = std::min(result.min_ms, elapsed);
+			result.max_ms = std::max(result.max_ms, elapsed);
+		}
+
+		if (iterations > 0)
+		{
+			result.mean_ms /= iterations;
+
+			std::nth_element(samples.begin(), samples.begin() + iterations / 2, samples.end());
+			result.median_ms = samples[iterations / 2];
+		}
+
+		return result;
+	}
+
+	inline void report(const Result& result)
+	{
+		std::cout << result.name << " : mean " << result.mean_ms << " ms, median " << result.median_ms << " ms, min " << result.min_ms << " ms, max " << result.max_ms << " ms (" << result.iterations << " iterations)";
+
+		if (result.items > 0 && result.median_ms > 0.0)
+			std::cout << ", " << (result.median_ms * 1e6 / result.items) << " ns/item, " << (result.items / (result.median_ms / 1000.0)) << " items/s";
+
+		std::cout << std::endl;
+
+		Record record = { current_group(), result.name, result };
+		// The name may point into a temporary.
+		record.result.name = nullptr;
+		records().push_back(record);
+	}
+
+	// Write every reported result so far.
+	extern bool write_csv(const char* path);
+	extern bool write_json(const char* path);
+}
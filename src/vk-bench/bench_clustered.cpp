@@ -0,0 +1,263 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <vector>
+#include <string>
+#include <random>
+#include <stdexcept>
+#include <string.h>
+#include <math.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "bench_meshes.h"
+#include "render_targets.h"
+#include "light_clusters.h"
+
+namespace bench
+{
+	const uint32_t kClusterLightCounts[] = { 0, 1000, 10000 };
+	const uint32_t kClusterMaxLights = 10000;
+	// Floor tiles per side, and standing quads scattered over the floor for depth variety.
+	const uint32_t kClusterFloorTiles = 64;
+	const uint32_t kClusterWalls = 4000;
+	const float kClusterFloorExtent = 64.0f;
+
+	struct ClusterPushConstants
+	{
+		glm::mat4 view_projection;
+		glm::mat4 view;
+	};
+
+	// A quarter of them spot lights aimed roughly down.
+	static void make_cluster_lights(std::vector<Light>& lights, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> position(-kClusterFloorExtent, kClusterFloorExtent);
+		std::uniform_real_distribution<float> height(0.5f, 6.0f);
+		std::uniform_real_distribution<float> range(2.0f, 6.0f);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::uniform_real_distribution<float> tilt(-0.5f, 0.5f);
+
+		lights.resize(kClusterMaxLights);
+
+		for (Light& light : lights)
+		{
+			light = {};
+			light.position[0] = position(rng);
+			light.position[1] = height(rng);
+			light.position[2] = position(rng);
+			light.range = range(rng);
+			light.color[0] = unit(rng) * 4.0f;
+			light.color[1] = unit(rng) * 4.0f;
+			light.color[2] = unit(rng) * 4.0f;
+			light.type = unit(rng) < 0.25f ? LightType::SPOT : LightType::POINT;
+
+			glm::vec3 direction = glm::normalize(glm::vec3(tilt(rng), -1.0f, tilt(rng)));
+			light.direction[0] = direction.x;
+			light.direction[1] = direction.y;
+			light.direction[2] = direction.z;
+			light.cos_inner = cosf(0.5235988f);
+			light.cos_outer = cosf(0.6981317f);
+		}
+	}
+
+	void clustered(Context& ctx)
+	{
+		std::cout << std::endl << "--- Clustered : lights binned into a froxel grid by compute, shaded per cluster ---" << std::endl;
+
+		VkFormat depth_format = choose_depth_format(ctx.physical_device);
+
+		if (depth_format == VK_FORMAT_UNDEFINED)
+			throw std::runtime_error("Failed to find a depth format!");
+
+		LightClusters clusters;
+
+		if (!clusters.initialize(ctx.physical_device, ctx.device, read_file("shaders/cluster_bin.spv"), kClusterMaxLights, 1))
+			throw std::runtime_error("Failed to create light clusters!");
+
+		gfx::InputElementDesc elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 },
+			{ 4, gfx::DataType::FLOAT, false, 0, "TRANSFORM", 1, 4 }
+		};
+
+		gfx::InputBindingDesc bindings[] =
+		{
+			{ sizeof(float) * 3, gfx::InputRate::PER_VERTEX },
+			{ sizeof(float) * 16, gfx::InputRate::PER_INSTANCE }
+		};
+
+		gfx::InputLayoutCreateDesc desc = {};
+		desc.elements = elements;
+		desc.numElements = 2;
+		desc.bindings = bindings;
+		desc.numBindings = 2;
+
+		gfx::Device device;
+		gfx::InputLayoutHandle layout = device.CreateInputLayout(desc);
+
+		VkDescriptorSetLayout set_layout = clusters.set_layout();
+		VkPushConstantRange push_range = { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ClusterPushConstants) };
+
+		VkPipelineLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layout_info.setLayoutCount = 1;
+		layout_info.pSetLayouts = &set_layout;
+		layout_info.pushConstantRangeCount = 1;
+		layout_info.pPushConstantRanges = &push_range;
+
+		VkPipelineLayout pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		RenderTarget depth = {};
+
+		if (!create_transient_target(ctx.physical_device, ctx.device, depth_format, ctx.extent, VK_SAMPLE_COUNT_1_BIT, depth))
+			throw std::runtime_error("Failed to create depth target!");
+
+		VkRenderPass render_pass = create_msaa_render_pass(ctx.device, ctx.color_format, depth_format, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		VkFramebuffer framebuffer = create_msaa_framebuffer(ctx.device, render_pass, ctx.extent, VK_SAMPLE_COUNT_1_BIT, VK_NULL_HANDLE, depth.view, ctx.color_view);
+
+		if (render_pass == VK_NULL_HANDLE || framebuffer == VK_NULL_HANDLE)
+			throw std::runtime_error("Failed to create render pass!");
+
+		VkShaderModule vert_module = create_shader_module(ctx, read_file("shaders/lit_vert.spv"));
+		VkShaderModule frag_module = create_shader_module(ctx, read_file("shaders/clustered_frag.spv"));
+
+		PipelineTarget target = { render_pass, VK_SAMPLE_COUNT_1_BIT, true };
+		VkPipeline pipeline = create_pipeline(ctx, vert_module, frag_module, &device.GetInputLayout(layout)->inputStateInfo, pipeline_layout, VK_NULL_HANDLE, &target);
+
+		TransformDesc floor;
+		floor.count = kClusterFloorTiles * kClusterFloorTiles;
+		floor.plane = Plane::XZ;
+		floor.extent = kClusterFloorExtent;
+
+		TransformDesc walls;
+		walls.count = kClusterWalls;
+		walls.placement = Placement::SCATTER;
+		walls.plane = Plane::XZ;
+		walls.extent = kClusterFloorExtent;
+		walls.min_scale = 1.0f;
+		walls.max_scale = 3.0f;
+		walls.upright = true;
+
+		std::mt19937 rng(1337);
+		std::vector<float> transforms;
+		std::vector<Light> lights;
+		generate_transforms(floor, rng, transforms);
+		generate_transforms(walls, rng, transforms);
+		make_cluster_lights(lights, rng);
+
+		uint32_t instances = (uint32_t)(transforms.size() / 16);
+
+		gfx::VertexBuffer* quad_vb = create_vertex_buffer(ctx, kFloorQuadVertices, sizeof(kFloorQuadVertices));
+		gfx::IndexBuffer* quad_ib = create_index_buffer(ctx, kQuadIndices, sizeof(kQuadIndices), gfx::DataType::UINT16);
+		gfx::VertexBuffer* instance_vb = create_vertex_buffer(ctx, transforms.data(), transforms.size() * sizeof(float));
+
+		gfx::VertexArray va = {};
+		va.vertexBuffers[0] = quad_vb;
+		va.vertexBuffers[1] = instance_vb;
+		va.numVertexBuffers = 2;
+		va.indexBuffer = quad_ib;
+		va.layout = layout;
+
+		// Looking over the floor from above one edge.
+		glm::vec3 eye(0.0f, 25.0f, 70.0f);
+		glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		float fov = glm::radians(60.0f);
+		float aspect = (float)ctx.extent.width / (float)ctx.extent.height;
+		glm::mat4 projection = glm::perspective(fov, aspect, 0.5f, 200.0f);
+		projection[1][1] *= -1.0f;
+
+		ClusterPushConstants constants = { projection * view, view };
+
+		ClusterView cluster_view = {};
+		memcpy(cluster_view.view, glm::value_ptr(view), sizeof(cluster_view.view));
+		cluster_view.position[0] = eye.x;
+		cluster_view.position[1] = eye.y;
+		cluster_view.position[2] = eye.z;
+		cluster_view.tan_half_fov_y = tanf(fov * 0.5f);
+		cluster_view.aspect = aspect;
+		cluster_view.near_plane = 0.5f;
+		cluster_view.far_plane = 200.0f;
+		cluster_view.width = ctx.extent.width;
+		cluster_view.height = ctx.extent.height;
+
+		gfx::CommandBuffer cmd(ctx.command_buffer);
+		VkDescriptorSet set = clusters.descriptor_set(0);
+
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		auto bin = [&]()
+		{
+			vkBeginCommandBuffer(ctx.command_buffer, &begin_info);
+			clusters.record(ctx.command_buffer, 0);
+
+			if (vkEndCommandBuffer(ctx.command_buffer) != VK_SUCCESS)
+				throw std::runtime_error("Failed to record command buffer");
+
+			submit_and_wait(ctx);
+		};
+
+		// Shades with whatever the last bin() left in the grid.
+		auto shade = [&]()
+		{
+			vkBeginCommandBuffer(ctx.command_buffer, &begin_info);
+
+			VkClearValue clear_values[2] = {};
+			clear_values[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+			clear_values[1].depthStencil = { 1.0f, 0 };
+
+			VkRenderPassBeginInfo render_pass_info = {};
+			render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			render_pass_info.renderPass = render_pass;
+			render_pass_info.framebuffer = framebuffer;
+			render_pass_info.renderArea.extent = ctx.extent;
+			render_pass_info.clearValueCount = 2;
+			render_pass_info.pClearValues = clear_values;
+
+			vkCmdBeginRenderPass(ctx.command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBindPipeline(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			vkCmdBindDescriptorSets(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &set, 0, nullptr);
+			vkCmdPushConstants(ctx.command_buffer, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+			cmd.BindVertexArray(&va);
+			cmd.DrawIndexedInstanced(6, instances, 0, 0, 0);
+			end_render_pass(ctx);
+
+			submit_and_wait(ctx);
+		};
+
+		std::cout << "Grid : " << DW_CLUSTER_X << "x" << DW_CLUSTER_Y << "x" << DW_CLUSTER_Z << " clusters, " << instances << " quads" << std::endl;
+
+		for (uint32_t count : kClusterLightCounts)
+		{
+			clusters.update(0, cluster_view, lights.data(), count);
+
+			set_group("clustered/" + std::to_string(count) + " lights");
+
+			std::string bin_name = "bin " + std::to_string(count) + " lights";
+			report(run(bin_name.c_str(), 5, 50, bin, count));
+
+			std::string shade_name = "shade " + std::to_string(count) + " lights";
+			report(run(shade_name.c_str(), 5, 50, shade, count));
+		}
+
+		destroy_vertex_buffer(ctx, instance_vb);
+		destroy_index_buffer(ctx, quad_ib);
+		destroy_vertex_buffer(ctx, quad_vb);
+
+		vkDestroyPipeline(ctx.device, pipeline, nullptr);
+		vkDestroyShaderModule(ctx.device, frag_module, nullptr);
+		vkDestroyShaderModule(ctx.device, vert_module, nullptr);
+		vkDestroyFramebuffer(ctx.device, framebuffer, nullptr);
+		vkDestroyRenderPass(ctx.device, render_pass, nullptr);
+		destroy_render_target(ctx.device, depth);
+		vkDestroyPipelineLayout(ctx.device, pipeline_layout, nullptr);
+		device.DestroyInputLayout(layout);
+		clusters.shutdown();
+	}
+}
@@ -0,0 +1,492 @@
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <string.h>
+
+#include "bench_context.h"
+#include "device_selector.h"
+
+namespace bench
+{
+	const VkFormat kColorFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+	std::vector<char> read_file(const std::string& filename)
+	{
+		std::ifstream file(filename, std::ios::ate | std::ios::binary);
+
+		if (!file.is_open())
+			throw std::runtime_error("Failed to open file!");
+
+		size_t size = (size_t)file.tellg();
+		std::vector<char> buffer(size);
+
+		file.seekg(0);
+		file.read(buffer.data(), size);
+		file.close();
+
+		return buffer;
+	}
+
+	uint32_t find_memory_type(Context& ctx, uint32_t type_bits, VkMemoryPropertyFlags properties)
+	{
+		VkPhysicalDeviceMemoryProperties memory_properties;
+		vkGetPhysicalDeviceMemoryProperties(ctx.physical_device, &memory_properties);
+
+		for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
+		{
+			if ((type_bits & (1 << i)) && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
+				return i;
+		}
+
+		throw std::runtime_error("Failed to find suitable memory type!");
+	}
+
+	static void create_color_target(Context& ctx)
+	{
+		ctx.color_format = kColorFormat;
+
+		VkImageCreateInfo image_info = {};
+		image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image_info.imageType = VK_IMAGE_TYPE_2D;
+		image_info.format = kColorFormat;
+		image_info.extent = { ctx.extent.width, ctx.extent.height, 1 };
+		image_info.mipLevels = 1;
+		image_info.arrayLayers = 1;
+		image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+		image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(ctx.device, &image_info, nullptr, &ctx.color_image) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create color image!");
+
+		VkMemoryRequirements requirements;
+		vkGetImageMemoryRequirements(ctx.device, ctx.color_image, &requirements);
+
+		VkMemoryAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = requirements.size;
+		alloc_info.memoryTypeIndex = find_memory_type(ctx, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		if (vkAllocateMemory(ctx.device, &alloc_info, nullptr, &ctx.color_memory) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate color image memory!");
+
+		ctx.allocated_bytes += requirements.size;
+
+		vkBindImageMemory(ctx.device, ctx.color_image, ctx.color_memory, 0);
+
+		VkImageViewCreateInfo view_info = {};
+		view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		view_info.image = ctx.color_image;
+		view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		view_info.format = kColorFormat;
+		view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		view_info.subresourceRange.levelCount = 1;
+		view_info.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(ctx.device, &view_info, nullptr, &ctx.color_view) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create image view!");
+
+		VkAttachmentDescription color_attachment = {};
+		color_attachment.format = kColorFormat;
+		color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		color_attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+		VkAttachmentReference color_att_ref = {};
+		color_att_ref.attachment = 0;
+		color_att_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &color_att_ref;
+
+		VkRenderPassCreateInfo render_pass_info = {};
+		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		render_pass_info.attachmentCount = 1;
+		render_pass_info.pAttachments = &color_attachment;
+		render_pass_info.subpassCount = 1;
+		render_pass_info.pSubpasses = &subpass;
+
+		if (vkCreateRenderPass(ctx.device, &render_pass_info, nullptr, &ctx.render_pass) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create render pass!");
+
+		VkFramebufferCreateInfo framebuffer_info = {};
+		framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebuffer_info.renderPass = ctx.render_pass;
+		framebuffer_info.attachmentCount = 1;
+		framebuffer_info.pAttachments = &ctx.color_view;
+		framebuffer_info.width = ctx.extent.width;
+		framebuffer_info.height = ctx.extent.height;
+		framebuffer_info.layers = 1;
+
+		if (vkCreateFramebuffer(ctx.device, &framebuffer_info, nullptr, &ctx.framebuffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create framebuffer!");
+	}
+
+	bool create_context(Context& ctx, uint32_t width, uint32_t height)
+	{
+		VkApplicationInfo app_info = {};
+		app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		app_info.pApplicationName = "vk-bench";
+		app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+		app_info.pEngineName = "Experiment Engine";
+		app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+		app_info.apiVersion = VK_API_VERSION_1_0;
+
+		VkInstanceCreateInfo instance_info = {};
+		instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		instance_info.pApplicationInfo = &app_info;
+
+		if (vkCreateInstance(&instance_info, nullptr, &ctx.instance) != VK_SUCCESS)
+		{
+			std::cout << "Failed to create vkInstance!" << std::endl;
+			return false;
+		}
+
+		// Any device with a graphics queue will do, software rasterizers included. DW_VK_DEVICE picks a
+		// specific one, e.g. to compare lavapipe against the GPU.
+		DeviceRequirements requirements = {};
+		DeviceCapabilities caps;
+
+		ctx.physical_device = select_physical_device(ctx.instance, requirements, &caps, false);
+
+		if (ctx.physical_device == VK_NULL_HANDLE)
+		{
+			std::cout << "Failed to find a suitable GPU!" << std::endl;
+			return false;
+		}
+
+		ctx.queue_family = (uint32_t)caps.graphics_family;
+		std::cout << "Benchmark Device : " << caps.properties.deviceName << " (" << device_type_name(caps.properties.deviceType) << ")" << std::endl;
+
+		float priority = 1.0f;
+
+		VkDeviceQueueCreateInfo queue_info = {};
+		queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queue_info.queueFamilyIndex = ctx.queue_family;
+		queue_info.queueCount = 1;
+		queue_info.pQueuePriorities = &priority;
+
+		VkPhysicalDeviceFeatures features = {};
+
+		VkDeviceCreateInfo device_info = {};
+		device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		device_info.pQueueCreateInfos = &queue_info;
+		device_info.queueCreateInfoCount = 1;
+		device_info.pEnabledFeatures = &features;
+
+		if (vkCreateDevice(ctx.physical_device, &device_info, nullptr, &ctx.device) != VK_SUCCESS)
+		{
+			std::cout << "Failed to create logical device!" << std::endl;
+			return false;
+		}
+
+		vkGetDeviceQueue(ctx.device, ctx.queue_family, 0, &ctx.queue);
+
+		VkCommandPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		pool_info.queueFamilyIndex = ctx.queue_family;
+		pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		if (vkCreateCommandPool(ctx.device, &pool_info, nullptr, &ctx.command_pool) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create command pool");
+
+		VkCommandBufferAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		alloc_info.commandPool = ctx.command_pool;
+		alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		alloc_info.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(ctx.device, &alloc_info, &ctx.command_buffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate command buffers");
+
+		VkFenceCreateInfo fence_info = {};
+		fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if (vkCreateFence(ctx.device, &fence_info, nullptr, &ctx.fence) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create fence");
+
+		ctx.extent = { width, height };
+		create_color_target(ctx);
+		create_buffer(ctx, (VkDeviceSize)width * height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT, nullptr, ctx.readback_buffer, ctx.readback_memory);
+
+		return true;
+	}
+
+	void destroy_context(Context& ctx)
+	{
+		if (ctx.device != VK_NULL_HANDLE)
+		{
+			vkDeviceWaitIdle(ctx.device);
+
+			vkDestroyBuffer(ctx.device, ctx.readback_buffer, nullptr);
+			vkFreeMemory(ctx.device, ctx.readback_memory, nullptr);
+			vkDestroyFramebuffer(ctx.device, ctx.framebuffer, nullptr);
+			vkDestroyRenderPass(ctx.device, ctx.render_pass, nullptr);
+			vkDestroyImageView(ctx.device, ctx.color_view, nullptr);
+			vkDestroyImage(ctx.device, ctx.color_image, nullptr);
+			vkFreeMemory(ctx.device, ctx.color_memory, nullptr);
+			vkDestroyFence(ctx.device, ctx.fence, nullptr);
+			vkDestroyCommandPool(ctx.device, ctx.command_pool, nullptr);
+			vkDestroyDevice(ctx.device, nullptr);
+		}
+
+		if (ctx.instance != VK_NULL_HANDLE)
+			vkDestroyInstance(ctx.instance, nullptr);
+	}
+
+	void create_buffer(Context& ctx, VkDeviceSize size, VkBufferUsageFlags usage, const void* data, VkBuffer& buffer, VkDeviceMemory& memory)
+	{
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = size;
+		buffer_info.usage = usage;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateBuffer(ctx.device, &buffer_info, nullptr, &buffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create buffer!");
+
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(ctx.device, buffer, &requirements);
+
+		VkMemoryAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = requirements.size;
+		alloc_info.memoryTypeIndex = find_memory_type(ctx, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		if (vkAllocateMemory(ctx.device, &alloc_info, nullptr, &memory) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate buffer memory!");
+
+		ctx.allocated_bytes += requirements.size;
+
+		vkBindBufferMemory(ctx.device, buffer, memory, 0);
+
+		if (data)
+		{
+			void* ptr = nullptr;
+			vkMapMemory(ctx.device, memory, 0, size, 0, &ptr);
+			memcpy(ptr, data, size);
+			vkUnmapMemory(ctx.device, memory);
+		}
+	}
+
+	gfx::VertexBuffer* create_vertex_buffer(Context& ctx, const void* data, size_t size)
+	{
+		gfx::VertexBuffer* vb = new gfx::VertexBuffer();
+		create_buffer(ctx, size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, data, vb->buffer, vb->memory);
+		return vb;
+	}
+
+	gfx::IndexBuffer* create_index_buffer(Context& ctx, const void* data, size_t size, uint32_t data_type)
+	{
+		gfx::IndexBuffer* ib = new gfx::IndexBuffer();
+		create_buffer(ctx, size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, data, ib->buffer, ib->memory);
+		ib->dataType = data_type;
+		return ib;
+	}
+
+	void destroy_vertex_buffer(Context& ctx, gfx::VertexBuffer* vb)
+	{
+		vkDestroyBuffer(ctx.device, vb->buffer, nullptr);
+		vkFreeMemory(ctx.device, vb->memory, nullptr);
+		delete vb;
+	}
+
+	void destroy_index_buffer(Context& ctx, gfx::IndexBuffer* ib)
+	{
+		vkDestroyBuffer(ctx.device, ib->buffer, nullptr);
+		vkFreeMemory(ctx.device, ib->memory, nullptr);
+		delete ib;
+	}
+
+	VkShaderModule create_shader_module(Context& ctx, const std::vector<char>& code)
+	{
+		VkShaderModuleCreateInfo create_info = {};
+		create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		create_info.codeSize = code.size();
+		create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+		VkShaderModule shader_module;
+		if (vkCreateShaderModule(ctx.device, &create_info, nullptr, &shader_module) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create shader module!");
+
+		return shader_module;
+	}
+
+	VkPipeline create_pipeline(Context& ctx, const char* vert_path, const char* frag_path, const VkPipelineVertexInputStateCreateInfo* input_state, VkPipelineLayout layout)
+	{
+		VkShaderModule vert_module = create_shader_module(ctx, read_file(vert_path));
+		VkShaderModule frag_module = create_shader_module(ctx, read_file(frag_path));
+
+		VkPipeline pipeline = create_pipeline(ctx, vert_module, frag_module, input_state, layout);
+
+		vkDestroyShaderModule(ctx.device, frag_module, nullptr);
+		vkDestroyShaderModule(ctx.device, vert_module, nullptr);
+
+		return pipeline;
+	}
+
+	VkPipeline create_pipeline(Context& ctx, VkShaderModule vert_module, VkShaderModule frag_module, const VkPipelineVertexInputStateCreateInfo* input_state, VkPipelineLayout layout, VkPipelineCache cache, const PipelineTarget* target)
+	{
+		VkPipelineShaderStageCreateInfo shader_stages[2] = {};
+		shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shader_stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		shader_stages[0].module = vert_module;
+		shader_stages[0].pName = "main";
+		shader_stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shader_stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		shader_stages[1].module = frag_module;
+		shader_stages[1].pName = "main";
+
+		VkPipelineInputAssemblyStateCreateInfo input_assembly = {};
+		input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+		VkViewport viewport = { 0.0f, 0.0f, (float)ctx.extent.width, (float)ctx.extent.height, 0.0f, 1.0f };
+		VkRect2D scissor = { { 0, 0 }, ctx.extent };
+
+		VkPipelineViewportStateCreateInfo viewport_state = {};
+		viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewport_state.viewportCount = 1;
+		viewport_state.pViewports = &viewport;
+		viewport_state.scissorCount = 1;
+		viewport_state.pScissors = &scissor;
+
+		VkPipelineRasterizationStateCreateInfo rasterizer = {};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = VK_CULL_MODE_NONE;
+		rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+		VkPipelineMultisampleStateCreateInfo multisampling = {};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.rasterizationSamples = target ? target->samples : VK_SAMPLE_COUNT_1_BIT;
+		multisampling.minSampleShading = 1.0f;
+
+		VkPipelineDepthStencilStateCreateInfo depth_stencil = {};
+		depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depth_stencil.depthTestEnable = VK_TRUE;
+		depth_stencil.depthWriteEnable = VK_TRUE;
+		depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+		VkPipelineColorBlendAttachmentState color_blend_attachment = {};
+		color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+		VkPipelineColorBlendStateCreateInfo color_blending = {};
+		color_blending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		color_blending.attachmentCount = 1;
+		color_blending.pAttachments = &color_blend_attachment;
+
+		VkGraphicsPipelineCreateInfo pipeline_info = {};
+		pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipeline_info.stageCount = 2;
+		pipeline_info.pStages = shader_stages;
+		pipeline_info.pVertexInputState = input_state;
+		pipeline_info.pInputAssemblyState = &input_assembly;
+		pipeline_info.pViewportState = &viewport_state;
+		pipeline_info.pRasterizationState = &rasterizer;
+		pipeline_info.pMultisampleState = &multisampling;
+		pipeline_info.pDepthStencilState = target && target->depth ? &depth_stencil : nullptr;
+		pipeline_info.pColorBlendState = &color_blending;
+		pipeline_info.layout = layout;
+		pipeline_info.renderPass = target ? target->render_pass : ctx.render_pass;
+		pipeline_info.subpass = 0;
+		pipeline_info.basePipelineIndex = -1;
+
+		VkPipeline pipeline;
+		if (vkCreateGraphicsPipelines(ctx.device, cache, 1, &pipeline_info, nullptr, &pipeline) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create graphics pipeline!");
+
+		return pipeline;
+	}
+
+	void begin_render_pass(Context& ctx)
+	{
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(ctx.command_buffer, &begin_info);
+
+		VkClearValue clear_color = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+		VkRenderPassBeginInfo render_pass_info = {};
+		render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		render_pass_info.renderPass = ctx.render_pass;
+		render_pass_info.framebuffer = ctx.framebuffer;
+		render_pass_info.renderArea.extent = ctx.extent;
+		render_pass_info.clearValueCount = 1;
+		render_pass_info.pClearValues = &clear_color;
+
+		vkCmdBeginRenderPass(ctx.command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	void end_render_pass(Context& ctx)
+	{
+		vkCmdEndRenderPass(ctx.command_buffer);
+
+		if (vkEndCommandBuffer(ctx.command_buffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to record command buffer");
+	}
+
+	void submit_and_wait(Context& ctx)
+	{
+		VkSubmitInfo submit_info = {};
+		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submit_info.commandBufferCount = 1;
+		submit_info.pCommandBuffers = &ctx.command_buffer;
+
+		if (vkQueueSubmit(ctx.queue, 1, &submit_info, ctx.fence) != VK_SUCCESS)
+			throw std::runtime_error("Failed to submit command buffer");
+
+		vkWaitForFences(ctx.device, 1, &ctx.fence, VK_TRUE, UINT64_MAX);
+		vkResetFences(ctx.device, 1, &ctx.fence);
+	}
+
+	void read_color_target(Context& ctx, std::vector<uint8_t>& pixels)
+	{
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(ctx.command_buffer, &begin_info);
+
+		VkBufferImageCopy region = {};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { ctx.extent.width, ctx.extent.height, 1 };
+
+		vkCmdCopyImageToBuffer(ctx.command_buffer, ctx.color_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, ctx.readback_buffer, 1, &region);
+
+		VkBufferMemoryBarrier to_host = {};
+		to_host.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		to_host.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		to_host.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		to_host.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		to_host.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		to_host.buffer = ctx.readback_buffer;
+		to_host.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(ctx.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &to_host, 0, nullptr);
+
+		if (vkEndCommandBuffer(ctx.command_buffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to record command buffer");
+
+		submit_and_wait(ctx);
+
+		size_t size = (size_t)ctx.extent.width * ctx.extent.height * 4;
+		void* ptr = nullptr;
+
+		vkMapMemory(ctx.device, ctx.readback_memory, 0, size, 0, &ptr);
+		pixels.assign((const uint8_t*)ptr, (const uint8_t*)ptr + size);
+		vkUnmapMemory(ctx.device, ctx.readback_memory);
+	}
+}
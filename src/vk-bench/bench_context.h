@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+
+#include "gfx_device.h"
+
+namespace bench
+{
+	// Headless device with a single offscreen color target. No window or swap chain is needed so
+	// the benchmarks can run on machines without a display. Handles start out null, so a context that
+	// failed (or threw) half way through creation can still be passed to destroy_context().
+	struct Context
+	{
+		VkInstance		 instance		 { VK_NULL_HANDLE };
+		VkPhysicalDevice physical_device { VK_NULL_HANDLE };
+		VkDevice		 device			 { VK_NULL_HANDLE };
+		VkQueue			 queue			 { VK_NULL_HANDLE };
+		uint32_t		 queue_family	 { 0 };
+		VkCommandPool	 command_pool	 { VK_NULL_HANDLE };
+		VkCommandBuffer	 command_buffer	 { VK_NULL_HANDLE };
+		VkFence			 fence			 { VK_NULL_HANDLE };
+		VkExtent2D		 extent			 { 0, 0 };
+		VkFormat		 color_format	 { VK_FORMAT_UNDEFINED };
+		VkImage			 color_image	 { VK_NULL_HANDLE };
+		VkDeviceMemory	 color_memory	 { VK_NULL_HANDLE };
+		VkImageView		 color_view		 { VK_NULL_HANDLE };
+		VkRenderPass	 render_pass	 { VK_NULL_HANDLE };
+		VkFramebuffer	 framebuffer	 { VK_NULL_HANDLE };
+		// Host visible copy target for the color image, see read_color_target().
+		VkBuffer		 readback_buffer { VK_NULL_HANDLE };
+		VkDeviceMemory	 readback_memory { VK_NULL_HANDLE };
+		// Bytes of device memory allocated through the context so far, never decremented. Take the
+		// difference around a piece of work to get what it allocated.
+		VkDeviceSize	 allocated_bytes { 0 };
+	};
+
+	// Render pass a pipeline is created for when it is not the context's own (single sampled, no depth).
+	struct PipelineTarget
+	{
+		VkRenderPass		  render_pass;
+		VkSampleCountFlagBits samples;
+		bool				  depth;
+	};
+
+	extern bool create_context(Context& ctx, uint32_t width, uint32_t height);
+	extern void destroy_context(Context& ctx);
+
+	extern std::vector<char> read_file(const std::string& filename);
+	extern uint32_t find_memory_type(Context& ctx, uint32_t type_bits, VkMemoryPropertyFlags properties);
+	extern void create_buffer(Context& ctx, VkDeviceSize size, VkBufferUsageFlags usage, const void* data, VkBuffer& buffer, VkDeviceMemory& memory);
+
+	extern gfx::VertexBuffer* create_vertex_buffer(Context& ctx, const void* data, size_t size);
+	extern gfx::IndexBuffer* create_index_buffer(Context& ctx, const void* data, size_t size, uint32_t data_type);
+	extern void destroy_vertex_buffer(Context& ctx, gfx::VertexBuffer* vb);
+	extern void destroy_index_buffer(Context& ctx, gfx::IndexBuffer* ib);
+
+	extern VkShaderModule create_shader_module(Context& ctx, const std::vector<char>& code);
+	extern VkPipeline create_pipeline(Context& ctx, const char* vert_path, const char* frag_path, const VkPipelineVertexInputStateCreateInfo* input_state, VkPipelineLayout layout);
+	extern VkPipeline create_pipeline(Context& ctx, VkShaderModule vert_module, VkShaderModule frag_module, const VkPipelineVertexInputStateCreateInfo* input_state, VkPipelineLayout layout, VkPipelineCache cache = VK_NULL_HANDLE, const PipelineTarget* target = nullptr);
+
+	extern void begin_render_pass(Context& ctx);
+	extern void end_render_pass(Context& ctx);
+	extern void submit_and_wait(Context& ctx);
+
+	// Copies the color target (RGBA8, left in TRANSFER_SRC_OPTIMAL by the render pass) to pixels. Blocks.
+	extern void read_color_target(Context& ctx, std::vector<uint8_t>& pixels);
+}
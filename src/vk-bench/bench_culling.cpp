@@ -0,0 +1,150 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "worker_pool.h"
+#include "transform_hierarchy.h"
+#include "frustum_culling.h"
+#include "draw_stream.h"
+
+namespace bench
+{
+	// 10k roots, 9 children each, 10 grandchildren per child: a million nodes over 3 levels.
+	const uint32_t kCullRoots = 10000;
+	const uint32_t kCullChildren = 9;
+	const uint32_t kCullGrandChildren = 10;
+	const float	   kCullSpacing = 10.0f;
+
+	static void build_scene(TransformHierarchy& hierarchy)
+	{
+		uint32_t side = 100;
+		glm::vec3 unit(0.5f);
+
+		hierarchy.reserve(kCullRoots * (1 + kCullChildren * (1 + kCullGrandChildren)));
+
+		for (uint32_t r = 0; r < kCullRoots; r++)
+		{
+			glm::mat4 root_local = glm::translate(glm::mat4(1.0f), glm::vec3((r % side) * kCullSpacing, 0.0f, (r / side) * kCullSpacing));
+			uint32_t root = hierarchy.create(DW_TRANSFORM_NO_PARENT, root_local, glm::vec3(0.0f), unit);
+
+			for (uint32_t c = 0; c < kCullChildren; c++)
+			{
+				glm::mat4 child_local = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f)), c * 0.7f, glm::vec3(0.0f, 1.0f, 0.0f));
+				uint32_t child = hierarchy.create(root, child_local, glm::vec3(0.0f), unit);
+
+				for (uint32_t g = 0; g < kCullGrandChildren; g++)
+				{
+					glm::mat4 grand_local = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f * g, 1.0f)), glm::vec3(0.5f));
+					hierarchy.create(child, grand_local, glm::vec3(0.0f), unit);
+				}
+			}
+		}
+	}
+
+	void culling()
+	{
+		std::cout << std::endl << "--- Culling : SoA transform hierarchy and SIMD frustum culling ---" << std::endl;
+
+		WorkerPool pool;
+		pool.initialize();
+
+		TransformHierarchy hierarchy;
+		build_scene(hierarchy);
+
+		// The first update also sorts the nodes into levels.
+		hierarchy.update();
+
+		uint32_t count = hierarchy.size();
+		std::cout << "Nodes : " << count << " in " << hierarchy.level_count() << " levels, " << pool.thread_count() << " threads" << std::endl;
+
+		set_group("culling/transforms");
+
+		report(run("update (1 thread)", 2, 20, [&]() { hierarchy.update(); }, count));
+		std::string pool_name = "update (" + std::to_string(pool.thread_count()) + " threads)";
+		report(run(pool_name.c_str(), 2, 20, [&]() { hierarchy.update(&pool); }, count));
+
+		// Looking across the grid from one corner, roughly a quarter of it in view.
+		glm::vec3 eye(-20.0f, 30.0f, -20.0f);
+		glm::vec3 target(500.0f, 0.0f, 500.0f);
+		glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 800.0f);
+
+		Frustum frustum;
+		extract_frustum(projection * view, frustum);
+
+		std::vector<uint32_t> visible;
+
+		for (uint32_t kernel = CullKernel::SCALAR; kernel < CullKernel::COUNT; kernel++)
+		{
+			if (!cull_kernel_supported(kernel))
+			{
+				std::cout << std::endl << cull_kernel_name(kernel) << " : not supported" << std::endl;
+				continue;
+			}
+
+			set_group(std::string("culling/") + cull_kernel_name(kernel));
+			std::cout << std::endl << "Kernel : " << cull_kernel_name(kernel) << std::endl;
+
+			FrustumCuller single;
+			single.initialize(nullptr, kernel);
+
+			FrustumCuller parallel;
+			parallel.initialize(&pool, kernel);
+
+			uint32_t spheres = 0;
+			uint32_t boxes = 0;
+
+			report(run("spheres (1 thread)", 2, 20, [&]() { spheres = single.cull_spheres(frustum, hierarchy.bounds(), visible); }, count));
+			report(run("spheres (pool)", 2, 20, [&]() { spheres = parallel.cull_spheres(frustum, hierarchy.bounds(), visible); }, count));
+			report(run("aabbs (1 thread)", 2, 20, [&]() { boxes = single.cull_aabbs(frustum, hierarchy.bounds(), visible); }, count));
+			report(run("aabbs (pool)", 2, 20, [&]() { boxes = parallel.cull_aabbs(frustum, hierarchy.bounds(), visible); }, count));
+
+			std::cout << "Visible : " << spheres << " spheres, " << boxes << " aabbs of " << count << std::endl;
+		}
+
+		// The full per-frame CPU path: transforms, culling, then draw packets for the survivors.
+		set_group("culling/frame");
+		std::cout << std::endl << "Frame (update + cull + draw packets + sort)" << std::endl;
+
+		std::vector<DrawPacket> packets(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			packets[i] = {};
+			packets[i].pipeline = i % 4;
+			packets[i].material = i % 64;
+			packets[i].vertex_buffer = i % 16;
+			packets[i].index_buffer = DW_DRAW_NO_RESOURCE;
+			packets[i].count = 36;
+			packets[i].instance_count = 1;
+			packets[i].key = make_draw_key(0, packets[i].pipeline, packets[i].material, 0.0f) & ~(uint64_t)0xFFFFFFFF;
+		}
+
+		FrustumCuller culler;
+		culler.initialize(&pool);
+
+		RadixSorter sorter;
+		sorter.initialize();
+
+		DrawStream stream;
+		glm::vec3 forward = glm::normalize(target - eye);
+
+		report(run("frame", 2, 20, [&]()
+		{
+			hierarchy.update(&pool);
+			uint32_t visible_count = culler.cull_aabbs(frustum, hierarchy.bounds(), visible);
+
+			stream.clear();
+			push_visible_draws(stream, visible, visible_count, packets.data(), hierarchy.bounds(), eye, forward);
+			stream.sort(sorter);
+		}, count));
+
+		sorter.shutdown();
+		pool.shutdown();
+	}
+}
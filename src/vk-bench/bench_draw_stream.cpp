@@ -0,0 +1,222 @@
+#include <vector>
+#include <string>
+#include <random>
+#include <stdexcept>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "draw_stream.h"
+#include "draw_recorder.h"
+
+namespace bench
+{
+	const uint32_t kStreamSizes[] = { 10000, 100000 };
+	const uint32_t kStreamPipelines = 8;
+	const uint32_t kStreamMaterials = 64;
+	const uint32_t kStreamVertexBuffers = 16;
+
+	const float kStreamTriangle[] =
+	{
+		-0.01f, -0.01f, 0.0f,
+		 0.01f, -0.01f, 0.0f,
+		 0.01f,  0.01f, 0.0f
+	};
+
+	// Scene-like stream: state is random per draw, as it would be in submission (scene graph) order.
+	static void fill_stream(DrawStream& stream, uint32_t count, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> depth(0.1f, 100.0f);
+
+		stream.clear();
+		stream.reserve(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			DrawPacket packet = {};
+			packet.pipeline = rng() % kStreamPipelines;
+			packet.material = rng() % kStreamMaterials;
+			packet.vertex_buffer = rng() % kStreamVertexBuffers;
+			packet.index_buffer = DW_DRAW_NO_RESOURCE;
+			packet.count = 3;
+			packet.instance_count = 1;
+			packet.key = make_draw_key(0, packet.pipeline, packet.material, depth(rng));
+
+			stream.push(packet);
+		}
+	}
+
+	static void print_stats(const char* name, const DrawStreamStats& stats)
+	{
+		std::cout << name << " : " << stats.pipeline_binds << " pipeline, " << stats.descriptor_binds << " descriptor, " << stats.vertex_buffer_binds
+				  << " vertex buffer binds, " << stats.binds_eliminated << " of " << (stats.draws * 3) << " eliminated" << std::endl;
+	}
+
+	void draw_stream(Context& ctx)
+	{
+		std::cout << std::endl << "--- Draw stream : radix sort by state key, translation with redundant bind elimination ---" << std::endl;
+
+		gfx::InputElementDesc elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 }
+		};
+
+		gfx::InputLayoutCreateDesc desc = {};
+		desc.elements = elements;
+		desc.numElements = 1;
+		desc.vertexSize = sizeof(float) * 3;
+
+		gfx::Device device;
+		gfx::InputLayoutHandle layout = device.CreateInputLayout(desc);
+
+		VkDescriptorSetLayoutBinding binding = {};
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		binding.descriptorCount = 1;
+		binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+		VkDescriptorSetLayoutCreateInfo set_layout_info = {};
+		set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		set_layout_info.bindingCount = 1;
+		set_layout_info.pBindings = &binding;
+
+		VkDescriptorSetLayout set_layout;
+		if (vkCreateDescriptorSetLayout(ctx.device, &set_layout_info, nullptr, &set_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create descriptor set layout!");
+
+		VkPushConstantRange push_range = { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 16 };
+
+		VkPipelineLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layout_info.setLayoutCount = 1;
+		layout_info.pSetLayouts = &set_layout;
+		layout_info.pushConstantRangeCount = 1;
+		layout_info.pPushConstantRanges = &push_range;
+
+		VkPipelineLayout pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		VkDescriptorPoolSize pool_size = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, kStreamMaterials };
+
+		VkDescriptorPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		pool_info.maxSets = kStreamMaterials;
+		pool_info.poolSizeCount = 1;
+		pool_info.pPoolSizes = &pool_size;
+
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(ctx.device, &pool_info, nullptr, &pool) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create descriptor pool!");
+
+		DrawBindings bindings;
+		bindings.materials.resize(kStreamMaterials);
+
+		std::vector<VkDescriptorSetLayout> set_layouts(kStreamMaterials, set_layout);
+
+		VkDescriptorSetAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		alloc_info.descriptorPool = pool;
+		alloc_info.descriptorSetCount = kStreamMaterials;
+		alloc_info.pSetLayouts = set_layouts.data();
+
+		if (vkAllocateDescriptorSets(ctx.device, &alloc_info, bindings.materials.data()) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate descriptor sets!");
+
+		VkBuffer uniform_buffer;
+		VkDeviceMemory uniform_memory;
+		create_buffer(ctx, 256 * kStreamMaterials, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, nullptr, uniform_buffer, uniform_memory);
+
+		for (uint32_t i = 0; i < kStreamMaterials; i++)
+		{
+			VkDescriptorBufferInfo buffer_info = { uniform_buffer, 256 * (VkDeviceSize)i, 256 };
+
+			VkWriteDescriptorSet write = {};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = bindings.materials[i];
+			write.dstBinding = 0;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			write.pBufferInfo = &buffer_info;
+
+			vkUpdateDescriptorSets(ctx.device, 1, &write, 0, nullptr);
+		}
+
+		// Identical pipelines: the driver still treats every bind as a state change.
+		VkShaderModule vert_module = create_shader_module(ctx, read_file("shaders/object_vert.spv"));
+		VkShaderModule frag_module = create_shader_module(ctx, read_file("shaders/color_frag.spv"));
+
+		for (uint32_t i = 0; i < kStreamPipelines; i++)
+		{
+			bindings.pipelines.push_back(create_pipeline(ctx, vert_module, frag_module, &device.GetInputLayout(layout)->inputStateInfo, pipeline_layout));
+			bindings.pipeline_layouts.push_back(pipeline_layout);
+		}
+
+		std::vector<gfx::VertexBuffer*> vertex_buffers;
+
+		for (uint32_t i = 0; i < kStreamVertexBuffers; i++)
+		{
+			vertex_buffers.push_back(create_vertex_buffer(ctx, kStreamTriangle, sizeof(kStreamTriangle)));
+			bindings.vertex_buffers.push_back(vertex_buffers.back()->buffer);
+		}
+
+		RadixSorter single;
+		single.initialize(1);
+
+		RadixSorter parallel;
+		parallel.initialize();
+
+		std::mt19937 rng(1337);
+		DrawStream stream;
+
+		for (uint32_t count : kStreamSizes)
+		{
+			set_group("draw_stream/" + std::to_string(count));
+			std::cout << std::endl << "Draws : " << count << ", " << kStreamPipelines << " pipelines, " << kStreamMaterials << " materials, " << kStreamVertexBuffers << " vertex buffers" << std::endl;
+
+			fill_stream(stream, count, rng);
+
+			DrawStreamStats stats = {};
+
+			auto record = [&]()
+			{
+				stats = {};
+				begin_render_pass(ctx);
+				record_draw_stream(ctx.command_buffer, stream, 0, stream.size(), bindings, stats);
+				end_render_pass(ctx);
+				vkResetCommandBuffer(ctx.command_buffer, 0);
+			};
+
+			// Submission order first, before anything sorts the stream.
+			report(run("record unsorted", 5, 50, record, count));
+			print_stats("Unsorted", stats);
+
+			// Each iteration re-fills the stream so every sort starts from submission order.
+			report(run("fill", 5, 50, [&]() { fill_stream(stream, count, rng); }, count));
+			report(run("fill + sort (1 thread)", 5, 50, [&]() { fill_stream(stream, count, rng); stream.sort(single); }, count));
+
+			std::string parallel_name = "fill + sort (" + std::to_string(parallel.thread_count()) + " threads)";
+			report(run(parallel_name.c_str(), 5, 50, [&]() { fill_stream(stream, count, rng); stream.sort(parallel); }, count));
+
+			report(run("record sorted", 5, 50, record, count));
+			print_stats("Sorted", stats);
+		}
+
+		parallel.shutdown();
+		single.shutdown();
+
+		for (gfx::VertexBuffer* vb : vertex_buffers)
+			destroy_vertex_buffer(ctx, vb);
+
+		for (VkPipeline pipeline : bindings.pipelines)
+			vkDestroyPipeline(ctx.device, pipeline, nullptr);
+
+		vkDestroyShaderModule(ctx.device, frag_module, nullptr);
+		vkDestroyShaderModule(ctx.device, vert_module, nullptr);
+		vkDestroyBuffer(ctx.device, uniform_buffer, nullptr);
+		vkFreeMemory(ctx.device, uniform_memory, nullptr);
+		vkDestroyDescriptorPool(ctx.device, pool, nullptr);
+		vkDestroyPipelineLayout(ctx.device, pipeline_layout, nullptr);
+		vkDestroyDescriptorSetLayout(ctx.device, set_layout, nullptr);
+		device.DestroyInputLayout(layout);
+	}
+}
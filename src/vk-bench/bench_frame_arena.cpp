@@ -0,0 +1,85 @@
+#include <vector>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "frame_arena.h"
+#include "allocation_counter.h"
+
+namespace bench
+{
+	const uint32_t kArenaFrames = 200;
+	const uint32_t kArenaItems = 4096;
+
+	struct TransientItem
+	{
+		uint64_t key;
+		uint32_t index;
+		uint32_t flags;
+	};
+
+	// Builds what a frame typically throws away: a few lists that grow item by item without a reserve.
+	template <typename Vector>
+	static uint64_t build_frame(uint32_t items)
+	{
+		Vector packets;
+		Vector barriers;
+
+		for (uint32_t i = 0; i < items; i++)
+		{
+			packets.push_back({ (uint64_t)i * 2654435761u, i, 0 });
+
+			if (i % 16 == 0)
+				barriers.push_back({ 0, i, 1 });
+		}
+
+		uint64_t sum = 0;
+
+		for (const auto& item : packets)
+			sum += item.key;
+
+		return sum + barriers.size();
+	}
+
+	void arena_allocator()
+	{
+		set_group("frame_arena");
+		std::cout << std::endl << "--- Frame arena : transient containers on the heap vs a per-frame bump allocator (" << kArenaItems << " items) ---" << std::endl;
+
+		volatile uint64_t sink = 0;
+
+		// Only this bench counts; the others run with counting off so the replaced operator new costs them nothing.
+		set_allocation_counting(true);
+
+		uint64_t allocations = thread_allocation_count();
+
+		report(run("std::vector", 0, kArenaFrames, [&]()
+		{
+			sink = build_frame<std::vector<TransientItem>>(kArenaItems);
+		}, kArenaItems));
+
+		uint64_t heap_allocations = thread_allocation_count() - allocations;
+
+		// The warmup lets the arenas grow to the frame's size.
+		report(run("FrameVector", 10, kArenaFrames, [&]()
+		{
+			frame_arena_next_frame();
+			sink = build_frame<FrameVector<TransientItem>>(kArenaItems);
+		}, kArenaItems));
+
+		// Measured separately so the timed runs above don't include any warmup allocations in the count.
+		allocations = thread_allocation_count();
+
+		for (uint32_t i = 0; i < kArenaFrames; i++)
+		{
+			frame_arena_next_frame();
+			sink = build_frame<FrameVector<TransientItem>>(kArenaItems);
+		}
+
+		uint64_t arena_allocations = thread_allocation_count() - allocations;
+
+		set_allocation_counting(false);
+
+		std::cout << "Heap allocations per frame : std::vector " << (double)heap_allocations / kArenaFrames << ", FrameVector " << (double)arena_allocations / kArenaFrames << std::endl;
+		(void)sink;
+	}
+}
@@ -0,0 +1,125 @@
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "gfx_device.h"
+#include "handle_pool.h"
+
+namespace bench
+{
+	const uint32_t kHandleCount = 65536;
+
+	void handle_pool()
+	{
+		set_group("handle_pool");
+		std::cout << std::endl << "--- Handle pool : generational handles vs new/delete (" << kHandleCount << " InputLayouts) ---" << std::endl;
+
+		// Lookups and destroys happen in a shuffled order, as they would for resources referenced from a scene.
+		std::mt19937 rng(1337);
+		std::vector<uint32_t> order(kHandleCount);
+
+		for (uint32_t i = 0; i < kHandleCount; i++)
+			order[i] = i;
+
+		std::shuffle(order.begin(), order.end(), rng);
+
+		std::vector<gfx::InputLayout*> pointers(kHandleCount);
+		std::vector<gfx::InputLayoutHandle> handles(kHandleCount);
+		HandlePool<gfx::InputLayout> pool(kHandleCount);
+
+		// Keeps the lookup loops from being optimized away.
+		volatile uint32_t sink = 0;
+
+		report(run("new", 1, 10, [&]()
+		{
+			for (uint32_t i = 0; i < kHandleCount; i++)
+			{
+				pointers[i] = new gfx::InputLayout();
+				pointers[i]->numAttribs = i;
+			}
+
+			for (uint32_t i = 0; i < kHandleCount; i++)
+				delete pointers[i];
+		}));
+
+		report(run("pool create", 1, 10, [&]()
+		{
+			for (uint32_t i = 0; i < kHandleCount; i++)
+			{
+				gfx::InputLayout* il = nullptr;
+				handles[i] = pool.create(&il);
+				il->numAttribs = i;
+			}
+
+			for (uint32_t i = 0; i < kHandleCount; i++)
+				pool.destroy(handles[i]);
+		}));
+
+		for (uint32_t i = 0; i < kHandleCount; i++)
+		{
+			pointers[i] = new gfx::InputLayout();
+			pointers[i]->numAttribs = i;
+
+			gfx::InputLayout* il = nullptr;
+			handles[i] = pool.create(&il);
+			il->numAttribs = i;
+		}
+
+		report(run("new lookup", 1, 10, [&]()
+		{
+			uint32_t sum = 0;
+
+			for (uint32_t i : order)
+				sum += pointers[i]->numAttribs;
+
+			sink = sum;
+		}));
+
+		report(run("pool lookup", 1, 10, [&]()
+		{
+			uint32_t sum = 0;
+
+			for (uint32_t i : order)
+				sum += pool.lookup(handles[i]).numAttribs;
+
+			sink = sum;
+		}));
+
+		// Churn: free and reallocate every slot in shuffled order, as streaming resources would.
+		report(run("new churn", 1, 10, [&]()
+		{
+			for (uint32_t i : order)
+			{
+				delete pointers[i];
+				pointers[i] = new gfx::InputLayout();
+			}
+		}));
+
+		report(run("pool churn", 1, 10, [&]()
+		{
+			for (uint32_t i : order)
+			{
+				pool.destroy(handles[i]);
+				handles[i] = pool.create();
+			}
+		}));
+
+		for (uint32_t i = 0; i < kHandleCount; i++)
+		{
+			delete pointers[i];
+			pool.destroy(handles[i]);
+		}
+
+		// A handle to a destroyed slot must not resolve, even after the slot has been reused.
+		gfx::InputLayoutHandle stale = pool.create();
+		pool.destroy(stale);
+		gfx::InputLayoutHandle reused = pool.create();
+
+		std::cout << "Stale handle detected : " << (pool.try_lookup(stale) == nullptr ? "yes" : "no") << ", reused slot valid : " << (pool.is_valid(reused) ? "yes" : "no") << std::endl;
+
+		pool.destroy(reused);
+		(void)sink;
+	}
+}
@@ -0,0 +1,367 @@
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+#include "bench.h"
+#include "benchmarks.h"
+
+namespace bench
+{
+	const uint32_t kDrawCounts[] = { 1000, 10000 };
+	const uint32_t kSubmitBatch = 100;
+	const uint32_t kDescriptorSetCount = 1024;
+	const uint32_t kPipelineCount = 10;
+	const uint32_t kBarrierCount = 1000;
+
+	const float kHotPathQuad[] =
+	{
+		-0.01f, -0.01f, 0.0f,
+		 0.01f, -0.01f, 0.0f,
+		 0.01f,  0.01f, 0.0f
+	};
+
+	static void begin_commands(Context& ctx)
+	{
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(ctx.command_buffer, &begin_info);
+	}
+
+	static void end_commands(Context& ctx)
+	{
+		if (vkEndCommandBuffer(ctx.command_buffer) != VK_SUCCESS)
+			throw std::runtime_error("Failed to record command buffer");
+	}
+
+	static void command_record(Context& ctx)
+	{
+		gfx::InputElementDesc elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 }
+		};
+
+		gfx::InputLayoutCreateDesc desc = {};
+		desc.elements = elements;
+		desc.numElements = 1;
+		desc.vertexSize = sizeof(float) * 3;
+
+		gfx::Device device;
+		gfx::InputLayoutHandle layout = device.CreateInputLayout(desc);
+
+		VkPushConstantRange push_range = { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 16 };
+
+		VkPipelineLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layout_info.pushConstantRangeCount = 1;
+		layout_info.pPushConstantRanges = &push_range;
+
+		VkPipelineLayout pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		VkPipeline pipeline = create_pipeline(ctx, "shaders/object_vert.spv", "shaders/color_frag.spv", &device.GetInputLayout(layout)->inputStateInfo, pipeline_layout);
+
+		gfx::VertexBuffer* vb = create_vertex_buffer(ctx, kHotPathQuad, sizeof(kHotPathQuad));
+		VkDeviceSize offset = 0;
+
+		float transform[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+		for (uint32_t count : kDrawCounts)
+		{
+			set_group("command_record/" + std::to_string(count));
+			std::cout << std::endl << "Draws : " << count << std::endl;
+
+			auto record = [&](bool push_constants, bool rebind)
+			{
+				begin_render_pass(ctx);
+				vkCmdBindPipeline(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+				vkCmdBindVertexBuffers(ctx.command_buffer, 0, 1, &vb->buffer, &offset);
+
+				for (uint32_t i = 0; i < count; i++)
+				{
+					if (rebind)
+					{
+						vkCmdBindPipeline(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+						vkCmdBindVertexBuffers(ctx.command_buffer, 0, 1, &vb->buffer, &offset);
+					}
+
+					if (push_constants)
+						vkCmdPushConstants(ctx.command_buffer, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), transform);
+
+					vkCmdDraw(ctx.command_buffer, 3, 1, 0, 0);
+				}
+
+				end_render_pass(ctx);
+				vkResetCommandBuffer(ctx.command_buffer, 0);
+			};
+
+			report(run("draw", 5, 50, [&]() { record(false, false); }, count));
+			report(run("push constants + draw", 5, 50, [&]() { record(true, false); }, count));
+			report(run("rebind + push constants + draw", 5, 50, [&]() { record(true, true); }, count));
+		}
+
+		destroy_vertex_buffer(ctx, vb);
+		vkDestroyPipeline(ctx.device, pipeline, nullptr);
+		vkDestroyPipelineLayout(ctx.device, pipeline_layout, nullptr);
+		device.DestroyInputLayout(layout);
+	}
+
+	static void submit(Context& ctx)
+	{
+		set_group("submit");
+		std::cout << std::endl << "Submit (empty command buffers)" << std::endl;
+
+		// Resubmitted while earlier submissions are still pending.
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+
+		vkBeginCommandBuffer(ctx.command_buffer, &begin_info);
+		end_commands(ctx);
+
+		VkSubmitInfo submit_info = {};
+		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submit_info.commandBufferCount = 1;
+		submit_info.pCommandBuffers = &ctx.command_buffer;
+
+		// Round trip: what a frame pays when it waits for its own submission.
+		report(run("submit + wait", 10, 100, [&]()
+		{
+			vkQueueSubmit(ctx.queue, 1, &submit_info, ctx.fence);
+			vkWaitForFences(ctx.device, 1, &ctx.fence, VK_TRUE, UINT64_MAX);
+			vkResetFences(ctx.device, 1, &ctx.fence);
+		}));
+
+		// Pipelined: the per-submit CPU cost when nothing waits in between.
+		report(run("submit (batched wait)", 2, 20, [&]()
+		{
+			for (uint32_t i = 0; i < kSubmitBatch - 1; i++)
+				vkQueueSubmit(ctx.queue, 1, &submit_info, VK_NULL_HANDLE);
+
+			vkQueueSubmit(ctx.queue, 1, &submit_info, ctx.fence);
+			vkWaitForFences(ctx.device, 1, &ctx.fence, VK_TRUE, UINT64_MAX);
+			vkResetFences(ctx.device, 1, &ctx.fence);
+		}, kSubmitBatch));
+
+		vkResetCommandBuffer(ctx.command_buffer, 0);
+	}
+
+	static void descriptor_updates(Context& ctx)
+	{
+		set_group("descriptor_updates");
+		std::cout << std::endl << "Descriptor updates (" << kDescriptorSetCount << " sets, one uniform buffer each)" << std::endl;
+
+		VkDescriptorSetLayoutBinding binding = {};
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		binding.descriptorCount = 1;
+		binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+		VkDescriptorSetLayoutCreateInfo set_layout_info = {};
+		set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		set_layout_info.bindingCount = 1;
+		set_layout_info.pBindings = &binding;
+
+		VkDescriptorSetLayout set_layout;
+		if (vkCreateDescriptorSetLayout(ctx.device, &set_layout_info, nullptr, &set_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create descriptor set layout!");
+
+		VkDescriptorPoolSize pool_size = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, kDescriptorSetCount };
+
+		VkDescriptorPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		pool_info.maxSets = kDescriptorSetCount;
+		pool_info.poolSizeCount = 1;
+		pool_info.pPoolSizes = &pool_size;
+
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(ctx.device, &pool_info, nullptr, &pool) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create descriptor pool!");
+
+		std::vector<VkDescriptorSetLayout> layouts(kDescriptorSetCount, set_layout);
+		std::vector<VkDescriptorSet> sets(kDescriptorSetCount);
+
+		VkDescriptorSetAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		alloc_info.descriptorPool = pool;
+		alloc_info.descriptorSetCount = kDescriptorSetCount;
+		alloc_info.pSetLayouts = layouts.data();
+
+		if (vkAllocateDescriptorSets(ctx.device, &alloc_info, sets.data()) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate descriptor sets!");
+
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		create_buffer(ctx, 256 * kDescriptorSetCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, nullptr, buffer, memory);
+
+		std::vector<VkDescriptorBufferInfo> buffer_infos(kDescriptorSetCount);
+		std::vector<VkWriteDescriptorSet> writes(kDescriptorSetCount);
+
+		for (uint32_t i = 0; i < kDescriptorSetCount; i++)
+		{
+			buffer_infos[i] = { buffer, 256 * (VkDeviceSize)i, 256 };
+
+			writes[i] = {};
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = sets[i];
+			writes[i].dstBinding = 0;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			writes[i].pBufferInfo = &buffer_infos[i];
+		}
+
+		report(run("one write per call", 5, 50, [&]()
+		{
+			for (uint32_t i = 0; i < kDescriptorSetCount; i++)
+				vkUpdateDescriptorSets(ctx.device, 1, &writes[i], 0, nullptr);
+		}, kDescriptorSetCount));
+
+		report(run("all writes in one call", 5, 50, [&]()
+		{
+			vkUpdateDescriptorSets(ctx.device, kDescriptorSetCount, writes.data(), 0, nullptr);
+		}, kDescriptorSetCount));
+
+		vkDestroyBuffer(ctx.device, buffer, nullptr);
+		vkFreeMemory(ctx.device, memory, nullptr);
+		vkDestroyDescriptorPool(ctx.device, pool, nullptr);
+		vkDestroyDescriptorSetLayout(ctx.device, set_layout, nullptr);
+	}
+
+	static void pipeline_creation(Context& ctx)
+	{
+		set_group("pipeline_creation");
+		std::cout << std::endl << "Pipeline creation (" << kPipelineCount << " per iteration, driver side shader caches may still apply)" << std::endl;
+
+		gfx::InputElementDesc elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 }
+		};
+
+		gfx::InputLayoutCreateDesc desc = {};
+		desc.elements = elements;
+		desc.numElements = 1;
+		desc.vertexSize = sizeof(float) * 3;
+
+		gfx::Device device;
+		gfx::InputLayoutHandle layout = device.CreateInputLayout(desc);
+
+		VkPushConstantRange push_range = { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 16 };
+
+		VkPipelineLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layout_info.pushConstantRangeCount = 1;
+		layout_info.pPushConstantRanges = &push_range;
+
+		VkPipelineLayout pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		// Modules are created once so only pipeline compilation is measured, not file IO.
+		VkShaderModule vert_module = create_shader_module(ctx, read_file("shaders/object_vert.spv"));
+		VkShaderModule frag_module = create_shader_module(ctx, read_file("shaders/color_frag.spv"));
+		const VkPipelineVertexInputStateCreateInfo* input_state = &device.GetInputLayout(layout)->inputStateInfo;
+
+		VkPipelineCacheCreateInfo cache_info = {};
+		cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		VkPipelineCache cache;
+		if (vkCreatePipelineCache(ctx.device, &cache_info, nullptr, &cache) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline cache!");
+
+		auto create_batch = [&](VkPipelineCache batch_cache)
+		{
+			VkPipeline pipelines[kPipelineCount];
+
+			for (uint32_t i = 0; i < kPipelineCount; i++)
+				pipelines[i] = create_pipeline(ctx, vert_module, frag_module, input_state, pipeline_layout, batch_cache);
+
+			for (uint32_t i = 0; i < kPipelineCount; i++)
+				vkDestroyPipeline(ctx.device, pipelines[i], nullptr);
+		};
+
+		report(run("no cache", 1, 10, [&]() { create_batch(VK_NULL_HANDLE); }, kPipelineCount));
+
+		// The warmup fills the cache.
+		report(run("warm pipeline cache", 1, 10, [&]() { create_batch(cache); }, kPipelineCount));
+
+		size_t cache_size = 0;
+		vkGetPipelineCacheData(ctx.device, cache, &cache_size, nullptr);
+		std::cout << "Pipeline cache size : " << cache_size << " bytes" << std::endl;
+
+		vkDestroyPipelineCache(ctx.device, cache, nullptr);
+		vkDestroyShaderModule(ctx.device, frag_module, nullptr);
+		vkDestroyShaderModule(ctx.device, vert_module, nullptr);
+		vkDestroyPipelineLayout(ctx.device, pipeline_layout, nullptr);
+		device.DestroyInputLayout(layout);
+	}
+
+	static void barriers(Context& ctx)
+	{
+		set_group("barriers");
+		std::cout << std::endl << "Barriers (" << kBarrierCount << " per command buffer)" << std::endl;
+
+		VkImageMemoryBarrier image_barrier = {};
+		image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		image_barrier.image = ctx.color_image;
+		image_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		image_barrier.subresourceRange.levelCount = 1;
+		image_barrier.subresourceRange.layerCount = 1;
+
+		VkMemoryBarrier memory_barrier = {};
+		memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		// Ping-pongs the color target between two layouts, ending in TRANSFER_SRC_OPTIMAL where the render pass leaves it.
+		auto record_layout_transitions = [&]()
+		{
+			begin_commands(ctx);
+
+			image_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			image_barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			for (uint32_t i = 0; i < kBarrierCount; i++)
+			{
+				image_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+				image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+				vkCmdPipelineBarrier(ctx.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &image_barrier);
+
+				image_barrier.oldLayout = image_barrier.newLayout;
+				image_barrier.newLayout = image_barrier.newLayout == VK_IMAGE_LAYOUT_GENERAL ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+			}
+
+			end_commands(ctx);
+		};
+
+		auto record_memory_barriers = [&]()
+		{
+			begin_commands(ctx);
+
+			for (uint32_t i = 0; i < kBarrierCount; i++)
+				vkCmdPipelineBarrier(ctx.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+
+			end_commands(ctx);
+		};
+
+		report(run("image layout transition record", 5, 50, [&]() { record_layout_transitions(); vkResetCommandBuffer(ctx.command_buffer, 0); }, kBarrierCount));
+		report(run("image layout transition execute", 5, 50, [&]() { record_layout_transitions(); submit_and_wait(ctx); }, kBarrierCount));
+		report(run("memory barrier record", 5, 50, [&]() { record_memory_barriers(); vkResetCommandBuffer(ctx.command_buffer, 0); }, kBarrierCount));
+		report(run("memory barrier execute", 5, 50, [&]() { record_memory_barriers(); submit_and_wait(ctx); }, kBarrierCount));
+	}
+
+	void hot_paths(Context& ctx)
+	{
+		std::cout << std::endl << "--- Hot paths : command recording, submission, descriptors, pipelines, barriers ---" << std::endl;
+
+		command_record(ctx);
+		submit(ctx);
+		descriptor_updates(ctx);
+		pipeline_creation(ctx);
+		barriers(ctx);
+	}
+}
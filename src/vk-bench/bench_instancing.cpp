@@ -0,0 +1,150 @@
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "bench_meshes.h"
+
+namespace bench
+{
+	const uint32_t kObjectCounts[] = { 100, 1000, 10000 };
+
+	void instancing(Context& ctx)
+	{
+		std::cout << std::endl << "--- Instancing : per-object draws vs a single instanced draw ---" << std::endl;
+
+		// Per-object layout: positions only, transform comes from push constants.
+		gfx::InputElementDesc object_elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 }
+		};
+
+		gfx::InputLayoutCreateDesc object_desc = {};
+		object_desc.elements = object_elements;
+		object_desc.numElements = 1;
+		object_desc.vertexSize = sizeof(float) * 3;
+
+		// Instanced layout: binding 0 per-vertex positions, binding 1 per-instance mat4 over 4 locations.
+		gfx::InputElementDesc instanced_elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 },
+			{ 4, gfx::DataType::FLOAT, false, 0, "TRANSFORM", 1, 4 }
+		};
+
+		gfx::InputBindingDesc instanced_bindings[] =
+		{
+			{ sizeof(float) * 3, gfx::InputRate::PER_VERTEX },
+			{ sizeof(float) * 16, gfx::InputRate::PER_INSTANCE }
+		};
+
+		gfx::InputLayoutCreateDesc instanced_desc = {};
+		instanced_desc.elements = instanced_elements;
+		instanced_desc.numElements = 2;
+		instanced_desc.bindings = instanced_bindings;
+		instanced_desc.numBindings = 2;
+
+		gfx::Device device;
+		gfx::InputLayoutHandle object_layout = device.CreateInputLayout(object_desc);
+		gfx::InputLayoutHandle instanced_layout = device.CreateInputLayout(instanced_desc);
+
+		VkPushConstantRange push_range = { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 16 };
+
+		VkPipelineLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layout_info.pushConstantRangeCount = 1;
+		layout_info.pPushConstantRanges = &push_range;
+
+		VkPipelineLayout object_pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &object_pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		layout_info.pushConstantRangeCount = 0;
+		layout_info.pPushConstantRanges = nullptr;
+
+		VkPipelineLayout instanced_pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &instanced_pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		VkPipeline object_pipeline = create_pipeline(ctx, "shaders/object_vert.spv", "shaders/color_frag.spv", &device.GetInputLayout(object_layout)->inputStateInfo, object_pipeline_layout);
+		VkPipeline instanced_pipeline = create_pipeline(ctx, "shaders/instanced_vert.spv", "shaders/color_frag.spv", &device.GetInputLayout(instanced_layout)->inputStateInfo, instanced_pipeline_layout);
+
+		gfx::VertexBuffer* quad_vb = create_vertex_buffer(ctx, kQuadVertices, sizeof(kQuadVertices));
+		gfx::IndexBuffer* quad_ib = create_index_buffer(ctx, kQuadIndices, sizeof(kQuadIndices), gfx::DataType::UINT16);
+
+		gfx::CommandBuffer cmd(ctx.command_buffer);
+		std::mt19937 rng;
+
+		for (uint32_t count : kObjectCounts)
+		{
+			TransformDesc grid;
+			grid.count = count;
+
+			std::vector<float> transforms;
+			generate_transforms(grid, rng, transforms);
+
+			gfx::VertexBuffer* instance_vb = create_vertex_buffer(ctx, transforms.data(), transforms.size() * sizeof(float));
+
+			gfx::VertexArray object_va = {};
+			object_va.vertexBuffers[0] = quad_vb;
+			object_va.numVertexBuffers = 1;
+			object_va.indexBuffer = quad_ib;
+			object_va.layout = object_layout;
+
+			gfx::VertexArray instanced_va = {};
+			instanced_va.vertexBuffers[0] = quad_vb;
+			instanced_va.vertexBuffers[1] = instance_vb;
+			instanced_va.numVertexBuffers = 2;
+			instanced_va.indexBuffer = quad_ib;
+			instanced_va.layout = instanced_layout;
+
+			auto record_per_object = [&]()
+			{
+				begin_render_pass(ctx);
+				vkCmdBindPipeline(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, object_pipeline);
+				cmd.BindVertexArray(&object_va);
+
+				for (uint32_t i = 0; i < count; i++)
+				{
+					vkCmdPushConstants(ctx.command_buffer, object_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 16, &transforms[i * 16]);
+					cmd.DrawIndexed(6, 0, 0);
+				}
+
+				end_render_pass(ctx);
+			};
+
+			auto record_instanced = [&]()
+			{
+				begin_render_pass(ctx);
+				vkCmdBindPipeline(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instanced_pipeline);
+				cmd.BindVertexArray(&instanced_va);
+				cmd.DrawIndexedInstanced(6, count, 0, 0, 0);
+				end_render_pass(ctx);
+			};
+
+			set_group("instancing/" + std::to_string(count));
+			std::cout << std::endl << "Objects : " << count << std::endl;
+
+			// Record only: CPU cost of building the command buffer.
+			report(run("per-object record", 5, 50, [&]() { record_per_object(); vkResetCommandBuffer(ctx.command_buffer, 0); }, count));
+			report(run("instanced record", 5, 50, [&]() { record_instanced(); vkResetCommandBuffer(ctx.command_buffer, 0); }));
+
+			// Record + submit + wait: full frame cost including GPU execution.
+			report(run("per-object frame", 5, 50, [&]() { record_per_object(); submit_and_wait(ctx); }));
+			report(run("instanced frame", 5, 50, [&]() { record_instanced(); submit_and_wait(ctx); }));
+
+			destroy_vertex_buffer(ctx, instance_vb);
+		}
+
+		destroy_index_buffer(ctx, quad_ib);
+		destroy_vertex_buffer(ctx, quad_vb);
+
+		vkDestroyPipeline(ctx.device, instanced_pipeline, nullptr);
+		vkDestroyPipeline(ctx.device, object_pipeline, nullptr);
+		vkDestroyPipelineLayout(ctx.device, instanced_pipeline_layout, nullptr);
+		vkDestroyPipelineLayout(ctx.device, object_pipeline_layout, nullptr);
+
+		device.DestroyInputLayout(instanced_layout);
+		device.DestroyInputLayout(object_layout);
+	}
+}
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "bench_meshes.h"
+#include "json.h"
+#include "mesh_import.h"
+#include "mesh_optimizer.h"
+#include "mesh_cache.h"
+
+namespace bench
+{
+	const char* kObjPath = "vk-bench-mesh.obj";
+	const char* kGltfPath = "vk-bench-mesh.gltf";
+	const char* kGltfBinPath = "vk-bench-mesh.bin";
+	const char* kCachePath = "vk-bench-mesh.dwm";
+
+	static void write_obj(const char* path, const mesh::Mesh& m)
+	{
+		FILE* file = fopen(path, "w");
+
+		for (const auto& v : m.vertices)
+			fprintf(file, "v %f %f %f\n", v.position[0], v.position[1], v.position[2]);
+		for (const auto& v : m.vertices)
+			fprintf(file, "vt %f %f\n", v.uv[0], v.uv[1]);
+		for (const auto& v : m.vertices)
+			fprintf(file, "vn %f %f %f\n", v.normal[0], v.normal[1], v.normal[2]);
+
+		for (size_t i = 0; i < m.indices.size(); i += 3)
+		{
+			uint32_t a = m.indices[i] + 1, b = m.indices[i + 1] + 1, c = m.indices[i + 2] + 1;
+			fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+		}
+
+		fclose(file);
+	}
+
+	// Single primitive with interleaved position/normal/uv in one buffer view plus a 32-bit index view.
+	static void write_gltf(const char* path, const char* bin_path, const mesh::Mesh& m)
+	{
+		size_t vertex_bytes = m.vertices.size() * sizeof(mesh::Vertex);
+		size_t index_bytes = m.indices.size() * sizeof(uint32_t);
+
+		FILE* bin = fopen(bin_path, "wb");
+		fwrite(m.vertices.data(), 1, vertex_bytes, bin);
+		fwrite(m.indices.data(), 1, index_bytes, bin);
+		fclose(bin);
+
+		std::string text;
+		char buffer[1024];
+
+		snprintf(buffer, sizeof(buffer),
+			"{\"asset\":{\"version\":\"2.0\"},"
+			"\"buffers\":[{\"uri\":\"%s\",\"byteLength\":%zu}],"
+			"\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu,\"byteStride\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+			"\"accessors\":["
+			"{\"bufferView\":0,\"byteOffset\":0,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+			"{\"bufferView\":0,\"byteOffset\":12,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+			"{\"bufferView\":0,\"byteOffset\":24,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC2\"},"
+			"{\"bufferView\":1,\"byteOffset\":0,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}],"
+			"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}]}",
+			bin_path, vertex_bytes + index_bytes,
+			vertex_bytes, sizeof(mesh::Vertex), vertex_bytes, index_bytes,
+			m.vertices.size(), m.vertices.size(), m.vertices.size(), m.indices.size());
+
+		FILE* file = fopen(path, "w");
+		fputs(buffer, file);
+		fclose(file);
+	}
+
+	void mesh_cache()
+	{
+		set_group("mesh_cache");
+		std::cout << std::endl << "--- Mesh cache : mmap binary cache vs parsing OBJ / glTF ---" << std::endl;
+
+		mesh::Mesh source = generate_sphere_soup(256, 512);
+		mesh::optimize_mesh(source);
+
+		std::cout << "Mesh : " << source.vertices.size() << " vertices, " << source.indices.size() / 3 << " triangles" << std::endl;
+
+		write_obj(kObjPath, source);
+		write_gltf(kGltfPath, kGltfBinPath, source);
+
+		std::vector<mesh::Mesh> meshes(1, source);
+		mesh::write_mesh_cache(kCachePath, meshes, mesh::VertexFormat::FLOAT);
+
+		// Stand-in for a mapped staging buffer, so the benchmark runs without a GPU. The real upload from
+		// the mapping is timed by upload_policy.
+		std::vector<uint8_t> staging(source.vertices.size() * sizeof(mesh::Vertex) + source.indices.size() * sizeof(uint32_t));
+
+		report(run("parse obj", 1, 5, [&]()
+		{
+			mesh::Mesh m;
+
+			if (!mesh::load_obj(kObjPath, m))
+				throw std::runtime_error("failed to parse the obj");
+
+			memcpy(staging.data(), m.vertices.data(), m.vertices.size() * sizeof(mesh::Vertex));
+		}));
+
+		report(run("parse gltf", 1, 10, [&]()
+		{
+			std::vector<mesh::Mesh> m;
+
+			if (!mesh::load_gltf(kGltfPath, m) || m.empty())
+				throw std::runtime_error("failed to parse the gltf");
+
+			memcpy(staging.data(), m[0].vertices.data(), m[0].vertices.size() * sizeof(mesh::Vertex));
+		}));
+
+		report(run("mmap cache", 1, 10, [&]()
+		{
+			mesh::MeshCache cache;
+
+			if (!mesh::open_mesh_cache(kCachePath, cache))
+				throw std::runtime_error("failed to open the mesh cache");
+
+			memcpy(staging.data(), cache.vertex_data, (size_t)cache.header->vertex_data_size);
+			memcpy(staging.data() + cache.header->vertex_data_size, cache.index_data, (size_t)cache.header->index_data_size);
+			mesh::close_mesh_cache(cache);
+		}));
+
+		remove(kObjPath);
+		remove(kGltfPath);
+		remove(kGltfBinPath);
+		remove(kCachePath);
+	}
+}
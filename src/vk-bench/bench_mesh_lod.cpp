@@ -0,0 +1,244 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <string.h>
+#include <math.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "bench_meshes.h"
+#include "mesh_lod.h"
+#include "mesh_optimizer.h"
+
+namespace bench
+{
+	// Instances on a square grid running away from the camera, like props over open terrain.
+	const uint32_t kLodGridSize = 48;
+	const float kLodGridSpacing = 6.0f;
+	// Screen space error a level may show before a finer one is picked.
+	const float kLodMaxPixels = 1.0f;
+
+	void mesh_lod()
+	{
+		set_group("mesh_lod");
+		std::cout << std::endl << "--- Mesh LOD : quadric simplification into one shared index buffer ---" << std::endl;
+
+		std::mt19937 rng(1337);
+		std::vector<mesh::Mesh> corpus;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			corpus.push_back(generate_grid(64 + i * 16, rng));
+			corpus.push_back(generate_sphere_soup(32 + i * 8, 64 + i * 8));
+		}
+
+		mesh::optimize_meshes(corpus);
+
+		size_t triangle_count = 0;
+		for (const auto& m : corpus)
+			triangle_count += m.indices.size() / 3;
+
+		std::cout << "Corpus : " << corpus.size() << " meshes, " << triangle_count << " triangles" << std::endl;
+
+		std::vector<mesh::LodMesh> lod_meshes;
+
+		Result single = run("generate lods (1 thread)", 1, 5, [&]()
+		{
+			std::vector<mesh::LodMesh> out;
+			mesh::generate_lod_meshes(corpus, out, mesh::LodSettings(), 1);
+		}, triangle_count);
+
+		Result parallel = run("generate lods (all threads)", 1, 5, [&]()
+		{
+			mesh::generate_lod_meshes(corpus, lod_meshes, mesh::LodSettings(), 0);
+		}, triangle_count);
+
+		report(single);
+		report(parallel);
+
+		// Triangles left at each level over the whole corpus, meshes with fewer levels count their last.
+		for (uint32_t level = 0; level < DW_MESH_MAX_LODS; level++)
+		{
+			uint64_t triangles = 0;
+			float max_error = 0.0f;
+
+			for (const auto& m : lod_meshes)
+			{
+				const mesh::MeshLod& lod = m.lods[std::min<size_t>(level, m.lods.size() - 1)];
+				triangles += lod.index_count / 3;
+				max_error = std::max(max_error, lod.error / m.radius);
+			}
+
+			std::cout << "LOD " << level << " : " << triangles << " triangles, max error " << max_error * 100.0f << "% of radius" << std::endl;
+		}
+
+		std::vector<float> distances(1 << 20);
+		std::uniform_real_distribution<float> distance(1.0f, 1000.0f);
+
+		for (auto& d : distances)
+			d = distance(rng);
+
+		// Selection is per instance per frame, so it has to stay in the noise next to culling.
+		uint32_t sink = 0;
+		report(run("select_lod", 1, 10, [&]()
+		{
+			const mesh::LodMesh& m = lod_meshes[1];
+
+			for (float d : distances)
+				sink += mesh::select_lod(m, 1.0f, d, 720.0f, kLodMaxPixels);
+		}, distances.size()));
+
+		std::cout << "Selected level sum : " << sink << std::endl;
+	}
+
+	void lod(Context& ctx)
+	{
+		std::cout << std::endl << "--- LOD : full detail vs levels picked by projected error ---" << std::endl;
+
+		mesh::Mesh sphere = generate_sphere_soup(96, 192);
+		mesh::optimize_mesh(sphere);
+
+		mesh::LodMesh lod_mesh;
+		mesh::generate_lods(sphere, lod_mesh);
+
+		uint32_t lod_count = (uint32_t)lod_mesh.lods.size();
+
+		// Positions only, read straight out of mesh::Vertex; the transform is per instance.
+		gfx::InputElementDesc elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 },
+			{ 4, gfx::DataType::FLOAT, false, 0, "TRANSFORM", 1, 4 }
+		};
+
+		gfx::InputBindingDesc bindings[] =
+		{
+			{ sizeof(mesh::Vertex), gfx::InputRate::PER_VERTEX },
+			{ sizeof(float) * 16, gfx::InputRate::PER_INSTANCE }
+		};
+
+		gfx::InputLayoutCreateDesc desc = {};
+		desc.elements = elements;
+		desc.numElements = 2;
+		desc.bindings = bindings;
+		desc.numBindings = 2;
+
+		gfx::Device device;
+		gfx::InputLayoutHandle layout = device.CreateInputLayout(desc);
+
+		VkPipelineLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+		VkPipelineLayout pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		VkPipeline pipeline = create_pipeline(ctx, "shaders/instanced_vert.spv", "shaders/color_frag.spv", &device.GetInputLayout(layout)->inputStateInfo, pipeline_layout);
+
+		glm::vec3 eye(0.0f, 3.0f, -10.0f);
+		float tan_half_fov_y = tanf(glm::radians(30.0f));
+
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float)ctx.extent.width / (float)ctx.extent.height, 0.1f, 1000.0f);
+		projection[1][1] *= -1.0f;
+		glm::mat4 view_projection = projection * glm::lookAt(eye, eye + glm::vec3(0.0f, -0.1f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		float projection_scale = (float)ctx.extent.height / (2.0f * tan_half_fov_y);
+
+		// Pick each instance's level, then group the instances by level so every level is one
+		// instanced draw over its index range.
+		uint32_t instance_count = kLodGridSize * kLodGridSize;
+		std::vector<uint32_t> levels(instance_count);
+		std::vector<uint32_t> first_instance(lod_count + 1, 0);
+		std::vector<glm::vec3> positions(instance_count);
+
+		for (uint32_t i = 0; i < instance_count; i++)
+		{
+			float x = ((float)(i % kLodGridSize) - kLodGridSize * 0.5f) * kLodGridSpacing;
+			float z = (float)(i / kLodGridSize) * kLodGridSpacing;
+
+			positions[i] = glm::vec3(x, 0.0f, z);
+			levels[i] = mesh::select_lod(lod_mesh, 1.0f, glm::length(positions[i] - eye), projection_scale, kLodMaxPixels);
+			first_instance[levels[i] + 1]++;
+		}
+
+		for (uint32_t l = 0; l < lod_count; l++)
+			first_instance[l + 1] += first_instance[l];
+
+		std::vector<uint32_t> cursor(first_instance.begin(), first_instance.end() - 1);
+		std::vector<float> transforms(instance_count * 16);
+
+		for (uint32_t i = 0; i < instance_count; i++)
+		{
+			glm::mat4 m = view_projection * glm::translate(glm::mat4(1.0f), positions[i]);
+			memcpy(&transforms[cursor[levels[i]]++ * 16], glm::value_ptr(m), sizeof(float) * 16);
+		}
+
+		std::vector<uint8_t> index_data;
+		uint32_t index_type = mesh::encode_indices(lod_mesh.indices, lod_mesh.vertices.size(), index_data);
+
+		gfx::VertexBuffer* mesh_vb = create_vertex_buffer(ctx, lod_mesh.vertices.data(), lod_mesh.vertices.size() * sizeof(mesh::Vertex));
+		gfx::IndexBuffer* mesh_ib = create_index_buffer(ctx, index_data.data(), index_data.size(), index_type);
+		gfx::VertexBuffer* instance_vb = create_vertex_buffer(ctx, transforms.data(), transforms.size() * sizeof(float));
+
+		// Every level draws from the same buffers, only the index range changes.
+		gfx::VertexArray va = {};
+		va.vertexBuffers[0] = mesh_vb;
+		va.vertexBuffers[1] = instance_vb;
+		va.numVertexBuffers = 2;
+		va.indexBuffer = mesh_ib;
+		va.layout = layout;
+
+		gfx::CommandBuffer cmd(ctx.command_buffer);
+
+		uint64_t full_triangles = (uint64_t)lod_mesh.lods[0].index_count / 3 * instance_count;
+		uint64_t lod_triangles = 0;
+
+		for (uint32_t l = 0; l < lod_count; l++)
+			lod_triangles += (uint64_t)lod_mesh.lods[l].index_count / 3 * (first_instance[l + 1] - first_instance[l]);
+
+		auto record_full = [&]()
+		{
+			begin_render_pass(ctx);
+			vkCmdBindPipeline(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			cmd.BindVertexArray(&va);
+			cmd.DrawIndexedInstanced(lod_mesh.lods[0].index_count, instance_count, 0, 0, 0);
+			end_render_pass(ctx);
+		};
+
+		auto record_lod = [&]()
+		{
+			begin_render_pass(ctx);
+			vkCmdBindPipeline(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			cmd.BindVertexArray(&va);
+
+			for (uint32_t l = 0; l < lod_count; l++)
+			{
+				uint32_t count = first_instance[l + 1] - first_instance[l];
+
+				if (count > 0)
+					cmd.DrawIndexedInstanced(lod_mesh.lods[l].index_count, count, lod_mesh.lods[l].first_index, 0, first_instance[l]);
+			}
+
+			end_render_pass(ctx);
+		};
+
+		set_group("lod");
+		std::cout << "Instances : " << instance_count << ", levels : " << lod_count << std::endl;
+
+		report(run("full detail frame", 2, 20, [&]() { record_full(); submit_and_wait(ctx); }, instance_count));
+		report(run("screen-space lod frame", 2, 20, [&]() { record_lod(); submit_and_wait(ctx); }, instance_count));
+
+		std::cout << "Triangles per frame : " << full_triangles << " -> " << lod_triangles << std::endl;
+
+		destroy_vertex_buffer(ctx, instance_vb);
+		destroy_index_buffer(ctx, mesh_ib);
+		destroy_vertex_buffer(ctx, mesh_vb);
+
+		vkDestroyPipeline(ctx.device, pipeline, nullptr);
+		vkDestroyPipelineLayout(ctx.device, pipeline_layout, nullptr);
+		device.DestroyInputLayout(layout);
+	}
+}
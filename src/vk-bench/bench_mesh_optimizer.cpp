@@ -0,0 +1,64 @@
+#include <vector>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "mesh_optimizer.h"
+#include "bench_meshes.h"
+
+namespace bench
+{
+	void mesh_optimizer()
+	{
+		set_group("mesh_optimizer");
+		std::cout << std::endl << "--- Mesh optimizer : dedup, vertex cache, overdraw, vertex fetch ---" << std::endl;
+
+		std::mt19937 rng(1337);
+		std::vector<mesh::Mesh> corpus;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			corpus.push_back(generate_grid(64 + i * 16, rng));
+			corpus.push_back(generate_sphere_soup(32 + i * 8, 64 + i * 8));
+		}
+
+		size_t triangle_count = 0;
+		for (const auto& m : corpus)
+			triangle_count += m.indices.empty() ? m.vertices.size() / 3 : m.indices.size() / 3;
+
+		std::cout << "Corpus : " << corpus.size() << " meshes, " << triangle_count << " triangles" << std::endl;
+
+		std::vector<mesh::OptimizeStats> stats;
+
+		Result single = run("optimize (1 thread)", 1, 5, [&]()
+		{
+			std::vector<mesh::Mesh> meshes = corpus;
+			mesh::optimize_meshes(meshes, nullptr, 1);
+		});
+
+		Result parallel = run("optimize (all threads)", 1, 5, [&]()
+		{
+			std::vector<mesh::Mesh> meshes = corpus;
+			mesh::optimize_meshes(meshes, &stats, 0);
+		});
+
+		report(single);
+		report(parallel);
+
+		double acmr_before = 0.0;
+		double acmr_after = 0.0;
+		uint64_t vertices_before = 0;
+		uint64_t vertices_after = 0;
+
+		for (const auto& s : stats)
+		{
+			acmr_before += s.acmr_before;
+			acmr_after += s.acmr_after;
+			vertices_before += s.vertices_before;
+			vertices_after += s.vertices_after;
+		}
+
+		std::cout << "Mean ACMR : " << acmr_before / stats.size() << " -> " << acmr_after / stats.size() << std::endl;
+		std::cout << "Vertices : " << vertices_before << " -> " << vertices_after << std::endl;
+		std::cout << "Triangles/s (all threads) : " << triangle_count / (parallel.mean_ms / 1000.0) << std::endl;
+	}
+}
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <math.h>
+
+#include "bench_meshes.h"
+
+namespace bench
+{
+	const float kQuadVertices[12] =
+	{
+		-1.0f, -1.0f, 0.0f,
+		 1.0f, -1.0f, 0.0f,
+		 1.0f,  1.0f, 0.0f,
+		-1.0f,  1.0f, 0.0f
+	};
+
+	const float kFloorQuadVertices[12] =
+	{
+		-1.0f, 0.0f, -1.0f,
+		 1.0f, 0.0f, -1.0f,
+		 1.0f, 0.0f,  1.0f,
+		-1.0f, 0.0f,  1.0f
+	};
+
+	const uint16_t kQuadIndices[6] = { 0, 1, 2, 2, 3, 0 };
+
+	// Regular grid with the triangle order shuffled, the worst realistic case for the vertex cache.
+	mesh::Mesh generate_grid(uint32_t size, std::mt19937& rng)
+	{
+		mesh::Mesh m;
+
+		for (uint32_t y = 0; y <= size; y++)
+		{
+			for (uint32_t x = 0; x <= size; x++)
+			{
+				mesh::Vertex v = { { (float)x, 0.0f, (float)y }, { 0.0f, 1.0f, 0.0f }, { (float)x / size, (float)y / size } };
+				m.vertices.push_back(v);
+			}
+		}
+
+		std::vector<uint32_t> quads(size * size);
+		for (uint32_t i = 0; i < quads.size(); i++)
+			quads[i] = i;
+
+		std::shuffle(quads.begin(), quads.end(), rng);
+
+		for (uint32_t q : quads)
+		{
+			uint32_t x = q % size;
+			uint32_t y = q / size;
+			uint32_t i0 = y * (size + 1) + x;
+			uint32_t i1 = i0 + 1;
+			uint32_t i2 = i0 + size + 1;
+			uint32_t i3 = i2 + 1;
+
+			uint32_t quad[] = { i0, i2, i1, i1, i2, i3 };
+			m.indices.insert(m.indices.end(), quad, quad + 6);
+		}
+
+		return m;
+	}
+
+	// UV sphere emitted as an unindexed triangle soup, so deduplication has work to do.
+	mesh::Mesh generate_sphere_soup(uint32_t rings, uint32_t segments)
+	{
+		const float kPi = 3.14159265f;
+
+		std::vector<mesh::Vertex> grid;
+
+		for (uint32_t r = 0; r <= rings; r++)
+		{
+			for (uint32_t s = 0; s <= segments; s++)
+			{
+				float theta = kPi * r / rings;
+				float phi = 2.0f * kPi * s / segments;
+				float n[3] = { sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi) };
+
+				mesh::Vertex v = { { n[0], n[1], n[2] }, { n[0], n[1], n[2] }, { (float)s / segments, (float)r / rings } };
+				grid.push_back(v);
+			}
+		}
+
+		mesh::Mesh m;
+
+		for (uint32_t r = 0; r < rings; r++)
+		{
+			for (uint32_t s = 0; s < segments; s++)
+			{
+				uint32_t i0 = r * (segments + 1) + s;
+				uint32_t i1 = i0 + 1;
+				uint32_t i2 = i0 + segments + 1;
+				uint32_t i3 = i2 + 1;
+
+				uint32_t quad[] = { i0, i1, i2, i1, i3, i2 };
+
+				for (uint32_t i : quad)
+					m.vertices.push_back(grid[i]);
+			}
+		}
+
+		return m;
+	}
+
+	void generate_transforms(const TransformDesc& desc, std::mt19937& rng, std::vector<float>& transforms)
+	{
+		std::uniform_real_distribution<float> position(-desc.extent, desc.extent);
+		std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+		std::uniform_real_distribution<float> scale(desc.min_scale, desc.max_scale);
+		std::uniform_real_distribution<float> depth(desc.min_depth, desc.max_depth);
+
+		uint32_t grid = 1;
+		while (grid * grid < desc.count)
+			grid++;
+
+		float cell = 2.0f * desc.extent / grid;
+		size_t first = transforms.size();
+
+		transforms.resize(first + (size_t)desc.count * 16, 0.0f);
+
+		for (uint32_t i = 0; i < desc.count; i++)
+		{
+			float* m = &transforms[first + (size_t)i * 16];
+			float u, v, a, s;
+
+			if (desc.placement == Placement::GRID)
+			{
+				u = -desc.extent + cell * (i % grid + 0.5f);
+				v = -desc.extent + cell * (i / grid + 0.5f);
+				a = desc.angle_step * (i % 7);
+				s = desc.min_scale * desc.extent / grid;
+			}
+			else
+			{
+				u = position(rng);
+				v = position(rng);
+				a = angle(rng);
+				s = scale(rng);
+			}
+
+			float c = cosf(a) * s;
+			float n = sinf(a) * s;
+
+			// Column-major translation * rotation * scale. Clip space quads keep their depth unscaled.
+			if (desc.plane == Plane::XY)
+			{
+				m[0] = c;
+				m[1] = n;
+				m[4] = -n;
+				m[5] = c;
+				m[10] = 1.0f;
+				m[12] = u;
+				m[13] = v;
+				m[14] = desc.max_depth > desc.min_depth ? depth(rng) : desc.min_depth;
+			}
+			else if (desc.upright)
+			{
+				// Turned about y, then tipped up about x so the quad faces sideways and rests on the ground.
+				m[0] = c;
+				m[2] = -n;
+				m[4] = n;
+				m[6] = c;
+				m[9] = -s;
+				m[12] = u;
+				m[13] = s;
+				m[14] = v;
+			}
+			else
+			{
+				m[0] = c;
+				m[2] = -n;
+				m[5] = s;
+				m[8] = n;
+				m[10] = c;
+				m[12] = u;
+				m[14] = v;
+			}
+
+			m[15] = 1.0f;
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <random>
+
+#include "mesh.h"
+
+namespace bench
+{
+	// Quad in clip space, shrunk by the per-object transform.
+	extern const float kQuadVertices[12];
+	// Unit quad in the xz plane, facing +y.
+	extern const float kFloorQuadVertices[12];
+	extern const uint16_t kQuadIndices[6];
+
+	namespace Placement
+	{
+		enum
+		{
+			// Square grid over the plane, one object per cell.
+			GRID = 0,
+			// Uniformly random positions, rotations and scales.
+			SCATTER = 1
+		};
+	}
+
+	namespace Plane
+	{
+		enum
+		{
+			// Clip space, for kQuadVertices.
+			XY = 0,
+			// World space ground, for kFloorQuadVertices.
+			XZ = 1
+		};
+	}
+
+	struct TransformDesc
+	{
+		uint32_t count { 0 };
+		uint32_t placement { Placement::GRID };
+		uint32_t plane { Plane::XY };
+		// Objects are spread over [-extent, extent] on both axes of the plane.
+		float	 extent { 1.0f };
+		// GRID: share of its cell an object fills. SCATTER: range of the random uniform scale.
+		float	 min_scale { 1.0f };
+		float	 max_scale { 1.0f };
+		// GRID: object i turns by (i % 7) steps about the plane normal. SCATTER turns objects randomly.
+		float	 angle_step { 0.0f };
+		// XY: range of the random depth.
+		float	 min_depth { 0.0f };
+		float	 max_depth { 0.0f };
+		// XZ: stands the objects up on the ground instead of laying them flat.
+		bool	 upright { false };
+	};
+
+	extern mesh::Mesh generate_grid(uint32_t size, std::mt19937& rng);
+	extern mesh::Mesh generate_sphere_soup(uint32_t rings, uint32_t segments);
+	// Appends desc.count column-major mat4s to transforms. GRID placement draws nothing from rng.
+	extern void generate_transforms(const TransformDesc& desc, std::mt19937& rng, std::vector<float>& transforms);
+}
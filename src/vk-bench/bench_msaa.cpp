@@ -0,0 +1,167 @@
+#include <vector>
+#include <string>
+#include <random>
+#include <stdexcept>
+#include <math.h>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "bench_meshes.h"
+#include "render_targets.h"
+
+namespace bench
+{
+	const uint32_t kMsaaSampleCounts[] = { 1, 2, 4, 8 };
+	const uint32_t kMsaaObjects = 20000;
+
+	void msaa(Context& ctx)
+	{
+		std::cout << std::endl << "--- MSAA : transient multisampled targets resolved in the render pass ---" << std::endl;
+
+		VkFormat depth_format = choose_depth_format(ctx.physical_device);
+
+		if (depth_format == VK_FORMAT_UNDEFINED)
+			throw std::runtime_error("Failed to find a depth format!");
+
+		VkSampleCountFlagBits max_samples = max_sample_count(ctx.physical_device);
+		std::cout << "Max sample count : " << max_samples << std::endl;
+
+		gfx::InputElementDesc elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 },
+			{ 4, gfx::DataType::FLOAT, false, 0, "TRANSFORM", 1, 4 }
+		};
+
+		gfx::InputBindingDesc bindings[] =
+		{
+			{ sizeof(float) * 3, gfx::InputRate::PER_VERTEX },
+			{ sizeof(float) * 16, gfx::InputRate::PER_INSTANCE }
+		};
+
+		gfx::InputLayoutCreateDesc desc = {};
+		desc.elements = elements;
+		desc.numElements = 2;
+		desc.bindings = bindings;
+		desc.numBindings = 2;
+
+		gfx::Device device;
+		gfx::InputLayoutHandle layout = device.CreateInputLayout(desc);
+
+		VkPipelineLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+		VkPipelineLayout pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		VkShaderModule vert_module = create_shader_module(ctx, read_file("shaders/instanced_vert.spv"));
+		VkShaderModule frag_module = create_shader_module(ctx, read_file("shaders/color_frag.spv"));
+
+		// Small rotated quads at random depths: lots of slanted edges, which is where MSAA does its work.
+		TransformDesc scatter;
+		scatter.count = kMsaaObjects;
+		scatter.placement = Placement::SCATTER;
+		scatter.min_scale = 0.005f;
+		scatter.max_scale = 0.03f;
+		scatter.max_depth = 1.0f;
+
+		std::mt19937 rng(1337);
+		std::vector<float> transforms;
+		generate_transforms(scatter, rng, transforms);
+
+		gfx::VertexBuffer* quad_vb = create_vertex_buffer(ctx, kQuadVertices, sizeof(kQuadVertices));
+		gfx::IndexBuffer* quad_ib = create_index_buffer(ctx, kQuadIndices, sizeof(kQuadIndices), gfx::DataType::UINT16);
+		gfx::VertexBuffer* instance_vb = create_vertex_buffer(ctx, transforms.data(), transforms.size() * sizeof(float));
+
+		gfx::VertexArray va = {};
+		va.vertexBuffers[0] = quad_vb;
+		va.vertexBuffers[1] = instance_vb;
+		va.numVertexBuffers = 2;
+		va.indexBuffer = quad_ib;
+		va.layout = layout;
+
+		gfx::CommandBuffer cmd(ctx.command_buffer);
+
+		for (uint32_t count : kMsaaSampleCounts)
+		{
+			if (count > (uint32_t)max_samples)
+				break;
+
+			VkSampleCountFlagBits samples = (VkSampleCountFlagBits)count;
+
+			RenderTarget color = {};
+			RenderTarget depth = {};
+
+			if (samples != VK_SAMPLE_COUNT_1_BIT && !create_transient_target(ctx.physical_device, ctx.device, ctx.color_format, ctx.extent, samples, color))
+				throw std::runtime_error("Failed to create color target!");
+
+			if (!create_transient_target(ctx.physical_device, ctx.device, depth_format, ctx.extent, samples, depth))
+				throw std::runtime_error("Failed to create depth target!");
+
+			// Resolves into the context's color image, left ready for read_color_target().
+			VkRenderPass render_pass = create_msaa_render_pass(ctx.device, ctx.color_format, depth_format, samples, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+			VkFramebuffer framebuffer = create_msaa_framebuffer(ctx.device, render_pass, ctx.extent, samples, color.view, depth.view, ctx.color_view);
+
+			if (render_pass == VK_NULL_HANDLE || framebuffer == VK_NULL_HANDLE)
+				throw std::runtime_error("Failed to create render pass!");
+
+			PipelineTarget target = { render_pass, samples, true };
+			VkPipeline pipeline = create_pipeline(ctx, vert_module, frag_module, &device.GetInputLayout(layout)->inputStateInfo, pipeline_layout, VK_NULL_HANDLE, &target);
+
+			auto frame = [&]()
+			{
+				VkCommandBufferBeginInfo begin_info = {};
+				begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+				vkBeginCommandBuffer(ctx.command_buffer, &begin_info);
+
+				VkClearValue clear_values[2] = {};
+				clear_values[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+				clear_values[1].depthStencil = { 1.0f, 0 };
+
+				VkRenderPassBeginInfo render_pass_info = {};
+				render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				render_pass_info.renderPass = render_pass;
+				render_pass_info.framebuffer = framebuffer;
+				render_pass_info.renderArea.extent = ctx.extent;
+				render_pass_info.clearValueCount = 2;
+				render_pass_info.pClearValues = clear_values;
+
+				vkCmdBeginRenderPass(ctx.command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+				vkCmdBindPipeline(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+				cmd.BindVertexArray(&va);
+				cmd.DrawIndexedInstanced(6, kMsaaObjects, 0, 0, 0);
+				end_render_pass(ctx);
+
+				submit_and_wait(ctx);
+			};
+
+			set_group("msaa/" + std::to_string(count) + "x");
+
+			std::string name = std::to_string(count) + "x frame";
+			report(run(name.c_str(), 5, 50, frame, kMsaaObjects));
+
+			// Committed after rendering: lazily allocated memory is only backed once it is used, if at all.
+			VkDeviceSize allocated = color.size + depth.size;
+			VkDeviceSize committed = render_target_committed(ctx.device, color) + render_target_committed(ctx.device, depth);
+
+			std::cout << count << "x targets : " << allocated / 1024 << " KiB allocated, " << committed / 1024 << " KiB committed" << (depth.lazy ? " (lazily allocated)" : "") << std::endl;
+
+			vkDestroyPipeline(ctx.device, pipeline, nullptr);
+			vkDestroyFramebuffer(ctx.device, framebuffer, nullptr);
+			vkDestroyRenderPass(ctx.device, render_pass, nullptr);
+			destroy_render_target(ctx.device, depth);
+			destroy_render_target(ctx.device, color);
+		}
+
+		destroy_vertex_buffer(ctx, instance_vb);
+		destroy_index_buffer(ctx, quad_ib);
+		destroy_vertex_buffer(ctx, quad_vb);
+
+		vkDestroyShaderModule(ctx.device, frag_module, nullptr);
+		vkDestroyShaderModule(ctx.device, vert_module, nullptr);
+		vkDestroyPipelineLayout(ctx.device, pipeline_layout, nullptr);
+		device.DestroyInputLayout(layout);
+	}
+}
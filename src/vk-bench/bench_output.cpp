@@ -0,0 +1,81 @@
+#include <stdio.h>
+
+#include "bench.h"
+#include "json.h"
+
+namespace bench
+{
+	static void csv_field(FILE* file, const std::string& str)
+	{
+		fputc('"', file);
+
+		for (char c : str)
+		{
+			if (c == '"')
+				fputc('"', file);
+
+			fputc(c, file);
+		}
+
+		fputc('"', file);
+	}
+
+	bool write_csv(const char* path)
+	{
+		FILE* file = fopen(path, "w");
+
+		if (!file)
+			return false;
+
+		fprintf(file, "group,name,iterations,mean_ms,median_ms,min_ms,max_ms,items,ns_per_item\n");
+
+		for (const Record& record : records())
+		{
+			const Result& r = record.result;
+			double ns_per_item = r.items > 0 ? r.median_ms * 1e6 / r.items : 0.0;
+
+			csv_field(file, record.group);
+			fputc(',', file);
+			csv_field(file, record.name);
+			fprintf(file, ",%u,%.6f,%.6f,%.6f,%.6f,%llu,%.3f\n", r.iterations, r.mean_ms, r.median_ms, r.min_ms, r.max_ms, (unsigned long long)r.items, ns_per_item);
+		}
+
+		bool ok = ferror(file) == 0;
+		fclose(file);
+
+		return ok;
+	}
+
+	bool write_json(const char* path)
+	{
+		std::string out = "[";
+
+		for (size_t i = 0; i < records().size(); i++)
+		{
+			const Record& record = records()[i];
+			const Result& r = record.result;
+			char numbers[256];
+
+			snprintf(numbers, sizeof(numbers), ", \"iterations\": %u, \"mean_ms\": %.6f, \"median_ms\": %.6f, \"min_ms\": %.6f, \"max_ms\": %.6f, \"items\": %llu }",
+					 r.iterations, r.mean_ms, r.median_ms, r.min_ms, r.max_ms, (unsigned long long)r.items);
+
+			out += i == 0 ? "\n\t{ \"group\": " : ",\n\t{ \"group\": ";
+			json::write_string(out, record.group);
+			out += ", \"name\": ";
+			json::write_string(out, record.name);
+			out += numbers;
+		}
+
+		out += "\n]\n";
+
+		FILE* file = fopen(path, "w");
+
+		if (!file)
+			return false;
+
+		bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+		fclose(file);
+
+		return ok;
+	}
+}
@@ -0,0 +1,143 @@
+#include <string.h>
+#include <vector>
+#include <deque>
+#include <stdexcept>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "gfx_device.h"
+#include "residency_manager.h"
+
+namespace bench
+{
+	const VkDeviceSize kResidentBufferSize = 4 * 1024 * 1024;
+	// Streamable buffers alive at once, of which only the newest kTouchedBuffers are used each frame.
+	const uint32_t kResidentBuffers = 32;
+	const uint32_t kTouchedBuffers = 4;
+
+	// The device local heap is capped to fit half of the buffers, so filling it forces the manager to
+	// demote the idle half to host memory through the device's allocation path.
+	void residency(Context& ctx)
+	{
+		set_group("residency");
+		std::cout << std::endl << "--- Residency : demoting streamable buffers over budget ---" << std::endl;
+
+		QueueTimeline timeline;
+		timeline.initialize(ctx.device, ctx.queue, false);
+
+		ResidencyManager residency;
+		residency.initialize(ctx.instance, ctx.physical_device, false);
+
+		gfx::Device device;
+
+		if (!device.Init(ctx.physical_device, ctx.device, &timeline, ctx.queue_family, &residency))
+			throw std::runtime_error("failed to initialize gfx device");
+
+		std::vector<uint32_t> pattern((size_t)kResidentBufferSize / sizeof(uint32_t));
+
+		for (size_t i = 0; i < pattern.size(); i++)
+			pattern[i] = (uint32_t)i * 2654435761u;
+
+		gfx::BufferCreateDesc desc = {};
+		desc.size = kResidentBufferSize;
+		desc.usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		desc.usage = gfx::BufferUsage::STATIC;
+		desc.placement = gfx::Placement::DEVICE_LOCAL_STAGED;
+		desc.data = pattern.data();
+		desc.streamable = true;
+
+		std::deque<gfx::BufferHandle> buffers;
+		uint64_t frame = 0;
+
+		auto next_frame = [&]()
+		{
+			residency.update(++frame);
+
+			for (size_t i = buffers.size() - std::min<size_t>(buffers.size(), kTouchedBuffers); i < buffers.size(); i++)
+				device.TouchBuffer(buffers[i]);
+		};
+
+		auto create = [&]()
+		{
+			gfx::BufferHandle buffer = device.CreateBuffer(desc);
+
+			if (!buffer.valid())
+				throw std::runtime_error("failed to create streamable buffer");
+
+			buffers.push_back(buffer);
+		};
+
+		auto release = [&]()
+		{
+			while (!buffers.empty())
+			{
+				device.DestroyBuffer(buffers.front());
+				buffers.pop_front();
+			}
+
+			device.Shutdown();
+			timeline.shutdown();
+		};
+
+		create();
+
+		gfx::MemoryPlacement host;
+		uint32_t heap = residency.heap_for_memory_type(device.GetBuffer(buffers[0])->memoryType);
+		VkDeviceSize allocation = device.GetBuffer(buffers[0])->allocationSize;
+
+		if (!device.Memory().ChoosePlacement(gfx::Placement::HOST_MAPPED, ~0u, host) || residency.heap_for_memory_type(host.memoryType) == heap)
+		{
+			std::cout << "Device local and host memory share a heap, nothing to demote to" << std::endl;
+			release();
+			return;
+		}
+
+		ResidencyStats stats;
+		residency.stats(stats);
+
+		VkDeviceSize budget = (VkDeviceSize)((stats.heaps[heap].tracked_usage + allocation * (kResidentBuffers / 2 - 1)) / DW_RESIDENCY_HIGH_WATERMARK);
+		residency.cap_budget(heap, budget);
+
+		for (uint32_t i = 1; i < kResidentBuffers; i++)
+		{
+			next_frame();
+			create();
+		}
+
+		residency.stats(stats);
+
+		std::cout << "Evictions : " << stats.evictions << ", failed : " << stats.failed_evictions << ", demoted : " << (stats.bytes_demoted >> 20)
+				  << " MiB, heap " << heap << " : " << (stats.heaps[heap].tracked_usage >> 20) << " / " << (budget >> 20) << " MiB" << std::endl;
+
+		if (stats.evictions == 0 || stats.heaps[heap].tracked_usage > budget)
+		{
+			release();
+			throw std::runtime_error("over budget buffers were not demoted");
+		}
+
+		// The oldest buffer was idle the longest, so it is in host memory now with its contents intact.
+		gfx::Buffer* oldest = device.GetBuffer(buffers.front());
+		const void* contents = device.MapForRead(buffers.front());
+
+		if (oldest->placement != gfx::Placement::HOST_MAPPED || !contents || memcmp(contents, pattern.data(), (size_t)kResidentBufferSize) != 0)
+		{
+			release();
+			throw std::runtime_error("demoted buffer lost its contents");
+		}
+
+		// Steady state: every new buffer has to make room by demoting an idle one, which is a copy
+		// through the upload queue and a wait.
+		report(run("create with demotion", 2, 20, [&]()
+		{
+			next_frame();
+			create();
+
+			device.DestroyBuffer(buffers.front());
+			buffers.pop_front();
+		}, kResidentBufferSize));
+
+		residency.print_stats();
+
+		release();
+	}
+}
@@ -0,0 +1,246 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <vector>
+#include <string>
+#include <random>
+#include <stdexcept>
+#include <math.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "bench_meshes.h"
+#include "shadow_cascades.h"
+
+namespace bench
+{
+	const uint32_t kShadowStaticCasters = 20000;
+	const uint32_t kShadowDynamicCasters = 100;
+	const float kShadowSceneExtent = 200.0f;
+	// How far the camera moves per frame in the moving camera case.
+	const float kShadowCameraSpeed = 0.25f;
+
+	struct ShadowPushConstants
+	{
+		glm::mat4 view_projection;
+		glm::vec4 offset;
+	};
+
+	// Static casters first, then the dynamic ones, which circle around where they were placed.
+	static void make_shadow_scene(std::vector<float>& transforms, std::vector<ShadowCaster>& casters, std::mt19937& rng)
+	{
+		TransformDesc desc;
+		desc.count = kShadowStaticCasters + kShadowDynamicCasters;
+		desc.placement = Placement::SCATTER;
+		desc.plane = Plane::XZ;
+		desc.extent = kShadowSceneExtent;
+		desc.min_scale = 1.0f;
+		desc.max_scale = 4.0f;
+		desc.upright = true;
+
+		transforms.clear();
+		generate_transforms(desc, rng, transforms);
+
+		casters.resize(desc.count);
+
+		for (uint32_t i = 0; i < desc.count; i++)
+		{
+			// Standing quads rest on the ground, so their height is their scale.
+			const float* m = &transforms[i * 16];
+
+			casters[i].center = glm::vec3(m[12], m[13], m[14]);
+			casters[i].radius = m[13] * 1.415f;
+			casters[i].dynamic = i >= kShadowStaticCasters;
+		}
+	}
+
+	static glm::vec3 dynamic_offset(uint32_t caster, uint32_t frame)
+	{
+		float phase = (float)frame * 0.05f + (float)caster;
+		return glm::vec3(cosf(phase) * 2.0f, 0.0f, sinf(phase) * 2.0f);
+	}
+
+	void shadows(Context& ctx)
+	{
+		std::cout << std::endl << "--- Shadows : cascades redrawn only where casters or the cascade moved ---" << std::endl;
+
+		ShadowCascades shadows;
+
+		if (!shadows.initialize(ctx.physical_device, ctx.device))
+			throw std::runtime_error("Failed to create shadow cascades!");
+
+		gfx::InputElementDesc elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 },
+			{ 4, gfx::DataType::FLOAT, false, 0, "TRANSFORM", 1, 4 }
+		};
+
+		gfx::InputBindingDesc bindings[] =
+		{
+			{ sizeof(float) * 3, gfx::InputRate::PER_VERTEX },
+			{ sizeof(float) * 16, gfx::InputRate::PER_INSTANCE }
+		};
+
+		gfx::InputLayoutCreateDesc desc = {};
+		desc.elements = elements;
+		desc.numElements = 2;
+		desc.bindings = bindings;
+		desc.numBindings = 2;
+
+		gfx::Device device;
+		gfx::InputLayoutHandle layout = device.CreateInputLayout(desc);
+
+		VkPushConstantRange push_range = { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ShadowPushConstants) };
+
+		VkPipelineLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layout_info.pushConstantRangeCount = 1;
+		layout_info.pPushConstantRanges = &push_range;
+
+		VkPipelineLayout pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		VkShaderModule vert_module = create_shader_module(ctx, read_file("shaders/shadow_vert.spv"));
+		VkPipeline pipeline = shadows.create_caster_pipeline(vert_module, &device.GetInputLayout(layout)->inputStateInfo, pipeline_layout);
+
+		if (pipeline == VK_NULL_HANDLE)
+			throw std::runtime_error("Failed to create caster pipeline!");
+
+		std::mt19937 rng(1337);
+		std::vector<float> transforms;
+		std::vector<ShadowCaster> base_casters;
+		make_shadow_scene(transforms, base_casters, rng);
+
+		std::vector<ShadowCaster> casters = base_casters;
+		uint32_t caster_count = (uint32_t)casters.size();
+
+		gfx::VertexBuffer* quad_vb = create_vertex_buffer(ctx, kFloorQuadVertices, sizeof(kFloorQuadVertices));
+		gfx::IndexBuffer* quad_ib = create_index_buffer(ctx, kQuadIndices, sizeof(kQuadIndices), gfx::DataType::UINT16);
+		gfx::VertexBuffer* instance_vb = create_vertex_buffer(ctx, transforms.data(), transforms.size() * sizeof(float));
+
+		gfx::VertexArray va = {};
+		va.vertexBuffers[0] = quad_vb;
+		va.vertexBuffers[1] = instance_vb;
+		va.numVertexBuffers = 2;
+		va.indexBuffer = quad_ib;
+		va.layout = layout;
+
+		gfx::CommandBuffer cmd(ctx.command_buffer);
+
+		glm::vec3 light_direction = glm::normalize(glm::vec3(0.4f, -1.0f, 0.3f));
+		uint32_t frame_index = 0;
+
+		// One draw per caster, as a scene without instancing would issue them.
+		ShadowDrawFn draw = [&](VkCommandBuffer command_buffer, const glm::mat4& view_projection, const uint32_t* indices, uint32_t count)
+		{
+			ShadowPushConstants constants = { view_projection, glm::vec4(0.0f) };
+
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			cmd.BindVertexArray(&va);
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				uint32_t caster = indices[i];
+				constants.offset = glm::vec4(casters[caster].center - base_casters[caster].center, 0.0f);
+
+				vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+				cmd.DrawIndexedInstanced(6, 1, 0, 0, caster);
+			}
+		};
+
+		struct Case
+		{
+			const char* name;
+			bool		redraw_all;
+			bool		move_casters;
+			bool		move_camera;
+		};
+
+		const Case cases[] =
+		{
+			{ "full redraw", true, true, true },
+			{ "cached, still", false, false, false },
+			{ "cached, dynamic casters moving", false, true, false },
+			{ "cached, camera and casters moving", false, true, true }
+		};
+
+		set_group("shadows");
+
+		for (const Case& c : cases)
+		{
+			glm::vec3 eye(0.0f, 10.0f, 0.0f);
+			ShadowStats totals = {};
+			uint32_t frames = 0;
+
+			shadows.invalidate();
+
+			auto frame = [&]()
+			{
+				if (c.move_casters)
+				{
+					for (uint32_t i = kShadowStaticCasters; i < caster_count; i++)
+						casters[i].center = base_casters[i].center + dynamic_offset(i, frame_index);
+				}
+
+				if (c.move_camera)
+					eye.x += kShadowCameraSpeed;
+
+				ShadowCamera camera = {};
+				camera.view = glm::lookAt(eye, eye + glm::vec3(1.0f, -0.2f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+				camera.tan_half_fov_y = tanf(glm::radians(30.0f));
+				camera.aspect = (float)ctx.extent.width / (float)ctx.extent.height;
+				camera.near_plane = 0.1f;
+				camera.far_plane = 300.0f;
+
+				if (c.redraw_all)
+					shadows.invalidate();
+
+				shadows.update(camera, light_direction, casters.data(), caster_count);
+
+				VkCommandBufferBeginInfo begin_info = {};
+				begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+				vkBeginCommandBuffer(ctx.command_buffer, &begin_info);
+				shadows.record(ctx.command_buffer, draw);
+
+				if (vkEndCommandBuffer(ctx.command_buffer) != VK_SUCCESS)
+					throw std::runtime_error("Failed to record command buffer");
+
+				submit_and_wait(ctx);
+
+				const ShadowStats& stats = shadows.stats();
+				totals.static_redraws += stats.static_redraws;
+				totals.dynamic_redraws += stats.dynamic_redraws;
+				totals.casters_drawn += stats.casters_drawn;
+				frames++;
+				frame_index++;
+			};
+
+			// The first frame after invalidate() draws everything, keep it out of the counts.
+			frame();
+			totals = {};
+			frames = 0;
+
+			report(run(c.name, 2, 30, frame, caster_count));
+
+			std::cout << c.name << " : per frame " << (double)totals.static_redraws / frames << " static and " << (double)totals.dynamic_redraws / frames << " composited cascades redrawn, "
+					  << (double)totals.casters_drawn / frames << " caster draws" << std::endl;
+
+			casters = base_casters;
+		}
+
+		destroy_vertex_buffer(ctx, instance_vb);
+		destroy_index_buffer(ctx, quad_ib);
+		destroy_vertex_buffer(ctx, quad_vb);
+
+		vkDestroyPipeline(ctx.device, pipeline, nullptr);
+		vkDestroyShaderModule(ctx.device, vert_module, nullptr);
+		vkDestroyPipelineLayout(ctx.device, pipeline_layout, nullptr);
+		device.DestroyInputLayout(layout);
+		shadows.shutdown();
+	}
+}
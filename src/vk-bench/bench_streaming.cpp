@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <stdexcept>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "bench_meshes.h"
+#include "asset_streamer.h"
+#include "asset_upload.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+
+namespace bench
+{
+	// Every other asset is a mesh cache, the rest are raw RGBA8 textures, spread along the x axis.
+	const uint32_t kStreamedAssets = 64;
+	const float kStreamedAssetSpacing = 10.0f;
+	const uint32_t kStreamedTextureSize = 256;
+	const size_t kStreamFrameBudget = 1024 * 1024;
+	const double kStreamTimeoutMs = 30000.0;
+
+	// Streams the assets in while the camera moves along them, so the pending requests are re-ranked
+	// every frame, and uploads what completed within the per-frame byte budget.
+	void streaming(Context& ctx)
+	{
+		set_group("streaming");
+		std::cout << std::endl << "--- Streaming : per-frame uploads of streamed meshes and textures ---" << std::endl;
+
+		std::vector<mesh::Mesh> meshes(1, generate_sphere_soup(64, 128));
+		mesh::optimize_meshes(meshes);
+
+		std::vector<uint8_t> texels(kStreamedTextureSize * kStreamedTextureSize * 4, 0x80);
+		std::vector<std::string> paths(kStreamedAssets);
+
+		for (uint32_t i = 0; i < kStreamedAssets; i++)
+		{
+			bool is_mesh = i % 2 == 0;
+			paths[i] = "vk-bench-stream-" + std::to_string(i) + (is_mesh ? ".dwm" : ".tex");
+
+			bool written = false;
+
+			if (is_mesh)
+				written = mesh::write_mesh_cache(paths[i].c_str(), meshes, mesh::VertexFormat::PACKED);
+			else if (FILE* file = fopen(paths[i].c_str(), "wb"))
+			{
+				written = fwrite(texels.data(), 1, texels.size(), file) == texels.size();
+				fclose(file);
+			}
+
+			if (!written)
+				throw std::runtime_error("failed to write streamed asset");
+		}
+
+		QueueTimeline timeline;
+		timeline.initialize(ctx.device, ctx.queue, false);
+
+		gfx::Device device;
+
+		if (!device.Init(ctx.physical_device, ctx.device, &timeline, ctx.queue_family))
+			throw std::runtime_error("failed to initialize gfx device");
+
+		AssetStreamer streamer;
+		streamer.initialize();
+
+		float camera[3] = { 0.0f, 0.0f, 0.0f };
+		streamer.set_camera_position(camera);
+
+		for (uint32_t i = 0; i < kStreamedAssets; i++)
+		{
+			float position[3] = { i * kStreamedAssetSpacing, 0.0f, 0.0f };
+			streamer.request_at(paths[i].c_str(), i % 2 == 0 ? AssetType::MESH : AssetType::TEXTURE, position);
+		}
+
+		std::vector<UploadedAsset> uploaded;
+		std::vector<double> frame_ms;
+		uint32_t failures = 0;
+		uint64_t bytes = 0;
+		double start = now_ms();
+
+		while (uploaded.size() + failures < kStreamedAssets && now_ms() - start < kStreamTimeoutMs)
+		{
+			camera[0] += kStreamedAssetSpacing * 0.5f;
+			streamer.set_camera_position(camera);
+
+			double frame_start = now_ms();
+
+			uint32_t processed = streamer.process_completed(kStreamFrameBudget, [&](LoadedAsset& asset)
+			{
+				UploadedAsset result;
+
+				if (!upload_asset(device, asset, result))
+				{
+					failures++;
+					return;
+				}
+
+				bytes += asset.data.size();
+				uploaded.push_back(result);
+			});
+
+			// Frames that found nothing to do only measure the queue being empty.
+			if (processed > 0)
+				frame_ms.push_back(now_ms() - frame_start);
+			else
+				std::this_thread::yield();
+		}
+
+		double total_ms = now_ms() - start;
+
+		for (auto& asset : uploaded)
+			destroy_uploaded_asset(device, asset);
+
+		streamer.shutdown();
+		device.Shutdown();
+		timeline.shutdown();
+
+		for (const auto& path : paths)
+			remove(path.c_str());
+
+		if (failures > 0 || uploaded.size() < kStreamedAssets)
+			throw std::runtime_error("not every streamed asset was uploaded");
+
+		Result result = { "process_completed + upload", (uint32_t)frame_ms.size(), 0.0, 1e30, 0.0, 0.0, 0 };
+
+		for (double ms : frame_ms)
+		{
+			result.mean_ms += ms;
+			result.min_ms = std::min(result.min_ms, ms);
+			result.max_ms = std::max(result.max_ms, ms);
+		}
+
+		result.mean_ms /= frame_ms.size();
+		std::nth_element(frame_ms.begin(), frame_ms.begin() + frame_ms.size() / 2, frame_ms.end());
+		result.median_ms = frame_ms[frame_ms.size() / 2];
+
+		report(result);
+		std::cout << "  " << kStreamedAssets << " assets, " << (bytes >> 10) << " KiB in " << total_ms << " ms, "
+				  << (streamer.using_io_uring() ? "io_uring" : "pread") << ", " << (kStreamFrameBudget >> 10) << " KiB frame budget" << std::endl;
+	}
+}
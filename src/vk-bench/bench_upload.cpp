@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+#include "bench.h"
+#include "benchmarks.h"
+#include "bench_meshes.h"
+#include "mesh_optimizer.h"
+#include "mesh_upload.h"
+
+namespace bench
+{
+	const VkDeviceSize kUploadSizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024 };
+
+	const uint32_t kUploadPlacements[] =
+	{
+		gfx::Placement::DEVICE_LOCAL_STAGED,
+		gfx::Placement::DEVICE_LOCAL_MAPPED,
+		gfx::Placement::HOST_MAPPED
+	};
+
+	static const char* usage_name(uint32_t usage)
+	{
+		static const char* names[] = { "static", "dynamic", "readback", "staging" };
+		return names[usage];
+	}
+
+	void upload_policy(Context& ctx)
+	{
+		set_group("upload");
+		std::cout << std::endl << "--- Upload : cost of filling a buffer per memory placement ---" << std::endl;
+
+		// The headless context does not enable timeline semaphores, so this runs on the fence pool.
+		QueueTimeline timeline;
+		timeline.initialize(ctx.device, ctx.queue, false);
+
+		gfx::Device device;
+
+		if (!device.Init(ctx.physical_device, ctx.device, &timeline, ctx.queue_family))
+			throw std::runtime_error("failed to initialize gfx device");
+
+		const gfx::MemoryPolicy& policy = device.Memory();
+
+		std::cout << "UMA : " << (policy.IsUMA() ? "yes" : "no") << ", ReBAR : " << (policy.HasReBAR() ? "yes" : "no")
+				  << ", device local mapped : " << (policy.HasDeviceLocalMapped() ? "yes" : "no") << std::endl;
+
+		for (uint32_t usage = gfx::BufferUsage::STATIC; usage <= gfx::BufferUsage::STAGING; usage++)
+		{
+			gfx::MemoryPlacement placement;
+
+			if (policy.Choose(usage, ~0u, placement))
+				std::cout << "  " << usage_name(usage) << " -> " << gfx::PlacementName(placement.placement) << " (type " << placement.memoryType << ")" << std::endl;
+		}
+
+		for (VkDeviceSize size : kUploadSizes)
+		{
+			std::vector<uint8_t> data((size_t)size, 0x5a);
+
+			for (uint32_t p : kUploadPlacements)
+			{
+				gfx::BufferCreateDesc desc = {};
+				desc.size = size;
+				desc.usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+				desc.placement = p;
+
+				gfx::BufferHandle buffer = device.CreateBuffer(desc);
+
+				if (!buffer.valid())
+				{
+					std::cout << gfx::PlacementName(p) << " : not available" << std::endl;
+					continue;
+				}
+
+				// Staged uploads include the copy submission and the wait, which is what a blocking upload costs.
+				std::string name = std::string(gfx::PlacementName(p)) + ", " + std::to_string(size / 1024) + " KiB";
+
+				Result result = run(name.c_str(), 2, 20, [&]()
+				{
+					if (!device.UpdateBuffer(buffer, data.data(), size))
+						throw std::runtime_error("failed to update buffer");
+				}, size);
+
+				report(result);
+				std::cout << "  " << (size / (1024.0 * 1024.0)) / (result.median_ms / 1000.0) << " MiB/s" << std::endl;
+
+				device.DestroyBuffer(buffer);
+			}
+		}
+
+		// A mapped mesh cache goes into the staging buffer with a single copy per section.
+		const char* cache_path = "vk-bench-upload.dwm";
+		std::vector<mesh::Mesh> meshes(1, generate_sphere_soup(256, 512));
+		mesh::optimize_meshes(meshes);
+
+		mesh::MeshCache cache;
+
+		if (mesh::write_mesh_cache(cache_path, meshes, mesh::VertexFormat::PACKED) && mesh::open_mesh_cache(cache_path, cache))
+		{
+			uint64_t bytes = cache.header->vertex_data_size + cache.header->index_data_size;
+
+			report(run("mesh cache upload", 2, 20, [&]()
+			{
+				gfx::BufferHandle vertex_buffer;
+				gfx::BufferHandle index_buffer;
+
+				if (!mesh::upload_mesh_cache(device, cache, vertex_buffer, index_buffer))
+					throw std::runtime_error("failed to upload mesh cache");
+
+				device.DestroyBuffer(index_buffer);
+				device.DestroyBuffer(vertex_buffer);
+			}, bytes));
+
+			mesh::close_mesh_cache(cache);
+		}
+
+		remove(cache_path);
+
+		device.Shutdown();
+		timeline.shutdown();
+	}
+}
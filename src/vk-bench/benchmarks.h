@@ -0,0 +1,26 @@
+#pragma once
+
+#include "bench_context.h"
+
+namespace bench
+{
+	// CPU only
+	extern void mesh_optimizer();
+	extern void mesh_cache();
+	extern void mesh_lod();
+	extern void handle_pool();
+	extern void arena_allocator();
+	extern void culling();
+
+	// GPU
+	extern void instancing(Context& ctx);
+	extern void upload_policy(Context& ctx);
+	extern void residency(Context& ctx);
+	extern void streaming(Context& ctx);
+	extern void hot_paths(Context& ctx);
+	extern void draw_stream(Context& ctx);
+	extern void msaa(Context& ctx);
+	extern void clustered(Context& ctx);
+	extern void shadows(Context& ctx);
+	extern void lod(Context& ctx);
+}
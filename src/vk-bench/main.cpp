@@ -0,0 +1,137 @@
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+#include <string.h>
+#include <stdlib.h>
+
+#include "benchmarks.h"
+#include "regress.h"
+
+static void print_usage()
+{
+	std::cout << "Usage : vk-bench [--warmup <n>] [--iterations <n>] [--csv <file>] [--json <file>]" << std::endl;
+	std::cout << "        vk-bench --regress <dir> [--update] [--perf-threshold <fraction>]" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	bench::RegressOptions regress_options;
+	bool regress = false;
+	const char* csv_path = nullptr;
+	const char* json_path = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--regress") == 0 && i + 1 < argc)
+		{
+			regress = true;
+			regress_options.directory = argv[++i];
+		}
+		else if (strcmp(argv[i], "--update") == 0)
+			regress_options.update = true;
+		else if (strcmp(argv[i], "--perf-threshold") == 0 && i + 1 < argc)
+			regress_options.perf_threshold = atof(argv[++i]);
+		else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+			bench::settings().warmup = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+			bench::settings().iterations = (uint32_t)atoi(argv[++i]);
+		else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+			csv_path = argv[++i];
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			json_path = argv[++i];
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	// Regression runs only render the reference scenes; the exit code is the CI result.
+	if (regress)
+	{
+		bench::Context ctx;
+		uint32_t failures = 1;
+
+		try
+		{
+			if (bench::create_context(ctx, 640, 360))
+				failures = bench::regress(ctx, regress_options);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "Regression run failed : " << e.what() << std::endl;
+		}
+
+		bench::destroy_context(ctx);
+
+		return failures == 0 ? 0 : 1;
+	}
+
+	bool failed = false;
+
+	// Each benchmark runs on its own, so one that throws does not skip the rest.
+	auto guarded = [&](const std::function<void()>& benchmark)
+	{
+		try
+		{
+			benchmark();
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "Benchmark failed : " << e.what() << std::endl;
+			failed = true;
+		}
+	};
+
+	guarded(bench::mesh_optimizer);
+	guarded(bench::mesh_cache);
+	guarded(bench::mesh_lod);
+	guarded(bench::handle_pool);
+	guarded(bench::arena_allocator);
+	guarded(bench::culling);
+
+	// Context creation throws as well as returning false; either way the CPU results are still written.
+	bench::Context ctx;
+	bool context = false;
+
+	try
+	{
+		context = bench::create_context(ctx, 1280, 720);
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "Context creation failed : " << e.what() << std::endl;
+	}
+
+	if (context)
+	{
+		guarded([&]() { bench::instancing(ctx); });
+		guarded([&]() { bench::upload_policy(ctx); });
+		guarded([&]() { bench::residency(ctx); });
+		guarded([&]() { bench::streaming(ctx); });
+		guarded([&]() { bench::hot_paths(ctx); });
+		guarded([&]() { bench::draw_stream(ctx); });
+		guarded([&]() { bench::msaa(ctx); });
+		guarded([&]() { bench::clustered(ctx); });
+		guarded([&]() { bench::shadows(ctx); });
+		guarded([&]() { bench::lod(ctx); });
+	}
+	else
+		failed = true;
+
+	bench::destroy_context(ctx);
+
+	if (csv_path && !bench::write_csv(csv_path))
+	{
+		std::cout << "Failed to write " << csv_path << std::endl;
+		failed = true;
+	}
+
+	if (json_path && !bench::write_json(json_path))
+	{
+		std::cout << "Failed to write " << json_path << std::endl;
+		failed = true;
+	}
+
+	return failed ? 1 : 0;
+}
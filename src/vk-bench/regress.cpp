@@ -0,0 +1,441 @@
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include <stdexcept>
+#include <stdlib.h>
+#include <math.h>
+
+#include "bench.h"
+#include "regress.h"
+#include "bench_meshes.h"
+#include "image_writer.h"
+#include "json.h"
+
+namespace bench
+{
+	struct Scene
+	{
+		const char*			  name;
+		std::function<void()> setup;
+		// Records the full command buffer, render pass included. Returns the number of draws.
+		std::function<uint32_t()> record;
+		std::function<void()> teardown;
+	};
+
+	struct SceneResult
+	{
+		std::string	 name;
+		double		 frame_ms;
+		double		 mean_ms;
+		uint32_t	 draws;
+		VkDeviceSize memory_bytes;
+		bool		 image_ok;
+		double		 mismatch;
+		double		 psnr;
+		bool		 perf_ok;
+		std::string	 message;
+	};
+
+	static std::string golden_path(const RegressOptions& options, const std::string& scene, const char* suffix)
+	{
+		return options.directory + "/" + scene + suffix;
+	}
+
+	static bool load_golden(const std::string& path, RawFrameHeader& header, std::vector<uint8_t>& pixels)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+
+		if (!file)
+			return false;
+
+		bool ok = read_raw_frame(file, header, pixels);
+		fclose(file);
+
+		return ok;
+	}
+
+	static void compare_images(const RegressOptions& options, const std::vector<uint8_t>& actual, const std::vector<uint8_t>& golden, std::vector<uint8_t>& diff, SceneResult& result)
+	{
+		size_t pixel_count = actual.size() / 4;
+		size_t mismatched = 0;
+		double squared_error = 0.0;
+
+		diff.assign(actual.size(), 0);
+
+		for (size_t i = 0; i < pixel_count; i++)
+		{
+			uint32_t max_delta = 0;
+
+			for (size_t c = 0; c < 3; c++)
+			{
+				int delta = abs((int)actual[i * 4 + c] - (int)golden[i * 4 + c]);
+				max_delta = std::max(max_delta, (uint32_t)delta);
+				squared_error += delta * delta;
+			}
+
+			if (max_delta > options.channel_tolerance)
+				mismatched++;
+
+			// Amplified so single step differences are visible in the diff image.
+			uint8_t value = (uint8_t)std::min(255u, max_delta * 16);
+			diff[i * 4 + 0] = value;
+			diff[i * 4 + 1] = max_delta > options.channel_tolerance ? 0 : value;
+			diff[i * 4 + 2] = max_delta > options.channel_tolerance ? 0 : value;
+			diff[i * 4 + 3] = 255;
+		}
+
+		double mse = squared_error / (pixel_count * 3.0);
+
+		result.mismatch = (double)mismatched / pixel_count;
+		result.psnr = mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY;
+		result.image_ok = result.mismatch <= options.pixel_tolerance;
+	}
+
+	static bool load_baseline(const RegressOptions& options, json::Value& baseline)
+	{
+		std::ifstream file(golden_path(options, "baseline", ".json"), std::ios::binary);
+
+		if (!file.is_open())
+			return false;
+
+		std::stringstream text;
+		text << file.rdbuf();
+		std::string str = text.str();
+
+		return json::parse(str.c_str(), str.size(), baseline);
+	}
+
+	static void write_results(const std::string& path, const std::string& device, const std::vector<SceneResult>& results)
+	{
+		std::string out = "{\n\t\"device\": ";
+		json::write_string(out, device);
+		out += ",\n\t\"scenes\": {";
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const SceneResult& r = results[i];
+			char numbers[256];
+
+			snprintf(numbers, sizeof(numbers), ": { \"frame_ms\": %.4f, \"mean_ms\": %.4f, \"draws\": %u, \"memory_bytes\": %llu, \"mismatch\": %.6f }",
+					 r.frame_ms, r.mean_ms, r.draws, (unsigned long long)r.memory_bytes, r.mismatch);
+
+			out += i == 0 ? "\n\t\t" : ",\n\t\t";
+			json::write_string(out, r.name);
+			out += numbers;
+		}
+
+		out += "\n\t}\n}\n";
+
+		std::ofstream file(path, std::ios::binary);
+		file << out;
+	}
+
+	uint32_t regress(Context& ctx, const RegressOptions& options)
+	{
+		std::cout << std::endl << "--- Regression : " << (options.update ? "updating goldens in " : "comparing against ") << options.directory << " ---" << std::endl;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(ctx.physical_device, &properties);
+		std::string device_name = properties.deviceName;
+
+		// Shared by all scenes, allocated before any scene so it does not show up in their memory.
+		gfx::Device device;
+
+		gfx::InputElementDesc object_elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 }
+		};
+
+		gfx::InputLayoutCreateDesc object_desc = {};
+		object_desc.elements = object_elements;
+		object_desc.numElements = 1;
+		object_desc.vertexSize = sizeof(float) * 3;
+
+		gfx::InputElementDesc instanced_elements[] =
+		{
+			{ 3, gfx::DataType::FLOAT, false, 0, "POSITION", 0, 1 },
+			{ 4, gfx::DataType::FLOAT, false, 0, "TRANSFORM", 1, 4 }
+		};
+
+		gfx::InputBindingDesc instanced_bindings[] =
+		{
+			{ sizeof(float) * 3, gfx::InputRate::PER_VERTEX },
+			{ sizeof(float) * 16, gfx::InputRate::PER_INSTANCE }
+		};
+
+		gfx::InputLayoutCreateDesc instanced_desc = {};
+		instanced_desc.elements = instanced_elements;
+		instanced_desc.numElements = 2;
+		instanced_desc.bindings = instanced_bindings;
+		instanced_desc.numBindings = 2;
+
+		gfx::InputLayoutHandle object_layout = device.CreateInputLayout(object_desc);
+		gfx::InputLayoutHandle instanced_layout = device.CreateInputLayout(instanced_desc);
+
+		VkPushConstantRange push_range = { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 16 };
+
+		VkPipelineLayoutCreateInfo layout_info = {};
+		layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layout_info.pushConstantRangeCount = 1;
+		layout_info.pPushConstantRanges = &push_range;
+
+		VkPipelineLayout object_pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &object_pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		layout_info.pushConstantRangeCount = 0;
+		layout_info.pPushConstantRanges = nullptr;
+
+		VkPipelineLayout instanced_pipeline_layout;
+		if (vkCreatePipelineLayout(ctx.device, &layout_info, nullptr, &instanced_pipeline_layout) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create pipeline layout!");
+
+		VkPipeline object_pipeline = create_pipeline(ctx, "shaders/object_vert.spv", "shaders/color_frag.spv", &device.GetInputLayout(object_layout)->inputStateInfo, object_pipeline_layout);
+		VkPipeline instanced_pipeline = create_pipeline(ctx, "shaders/instanced_vert.spv", "shaders/color_frag.spv", &device.GetInputLayout(instanced_layout)->inputStateInfo, instanced_pipeline_layout);
+
+		gfx::CommandBuffer cmd(ctx.command_buffer);
+
+		// Per scene resources.
+		gfx::VertexBuffer* quad_vb = nullptr;
+		gfx::IndexBuffer* quad_ib = nullptr;
+		gfx::VertexBuffer* instance_vb = nullptr;
+		std::vector<float> transforms;
+		std::mt19937 rng;
+
+		// Objects on a grid, scaled to fit, with a slight per-object rotation so edges hit partial pixels.
+		auto make_grid = [&](uint32_t count)
+		{
+			TransformDesc desc;
+			desc.count = count;
+			desc.min_scale = 0.8f;
+			desc.angle_step = 0.05f;
+
+			transforms.clear();
+			generate_transforms(desc, rng, transforms);
+		};
+
+		auto create_quad = [&]()
+		{
+			quad_vb = create_vertex_buffer(ctx, kQuadVertices, sizeof(kQuadVertices));
+			quad_ib = create_index_buffer(ctx, kQuadIndices, sizeof(kQuadIndices), gfx::DataType::UINT16);
+		};
+
+		auto destroy_all = [&]()
+		{
+			if (instance_vb)
+				destroy_vertex_buffer(ctx, instance_vb);
+
+			if (quad_ib)
+				destroy_index_buffer(ctx, quad_ib);
+
+			if (quad_vb)
+				destroy_vertex_buffer(ctx, quad_vb);
+
+			instance_vb = nullptr;
+			quad_ib = nullptr;
+			quad_vb = nullptr;
+		};
+
+		auto per_object_scene = [&](const char* name, uint32_t count)
+		{
+			Scene scene;
+			scene.name = name;
+			scene.setup = [&, count]() { create_quad(); make_grid(count); };
+			scene.record = [&, count]()
+			{
+				gfx::VertexArray va = {};
+				va.vertexBuffers[0] = quad_vb;
+				va.numVertexBuffers = 1;
+				va.indexBuffer = quad_ib;
+				va.layout = object_layout;
+
+				begin_render_pass(ctx);
+				vkCmdBindPipeline(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, object_pipeline);
+				cmd.BindVertexArray(&va);
+
+				for (uint32_t i = 0; i < count; i++)
+				{
+					vkCmdPushConstants(ctx.command_buffer, object_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 16, &transforms[i * 16]);
+					cmd.DrawIndexed(6, 0, 0);
+				}
+
+				end_render_pass(ctx);
+				return count;
+			};
+			scene.teardown = destroy_all;
+			return scene;
+		};
+
+		auto instanced_scene = [&](const char* name, uint32_t count)
+		{
+			Scene scene;
+			scene.name = name;
+			scene.setup = [&, count]()
+			{
+				create_quad();
+				make_grid(count);
+				instance_vb = create_vertex_buffer(ctx, transforms.data(), transforms.size() * sizeof(float));
+			};
+			scene.record = [&, count]()
+			{
+				gfx::VertexArray va = {};
+				va.vertexBuffers[0] = quad_vb;
+				va.vertexBuffers[1] = instance_vb;
+				va.numVertexBuffers = 2;
+				va.indexBuffer = quad_ib;
+				va.layout = instanced_layout;
+
+				begin_render_pass(ctx);
+				vkCmdBindPipeline(ctx.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instanced_pipeline);
+				cmd.BindVertexArray(&va);
+				cmd.DrawIndexedInstanced(6, count, 0, 0, 0);
+				end_render_pass(ctx);
+				return 1u;
+			};
+			scene.teardown = destroy_all;
+			return scene;
+		};
+
+		std::vector<Scene> scenes;
+
+		Scene clear_scene;
+		clear_scene.name = "clear";
+		clear_scene.setup = []() {};
+		clear_scene.record = [&]() { begin_render_pass(ctx); end_render_pass(ctx); return 0u; };
+		clear_scene.teardown = []() {};
+
+		scenes.push_back(clear_scene);
+		scenes.push_back(per_object_scene("grid_100_per_object", 100));
+		scenes.push_back(instanced_scene("grid_100_instanced", 100));
+		scenes.push_back(instanced_scene("grid_10000_instanced", 10000));
+
+		json::Value baseline;
+		bool has_baseline = !options.update && load_baseline(options, baseline);
+		// Timings are only comparable on the device the baseline was recorded on.
+		bool compare_perf = has_baseline && baseline["device"].as_string() == device_name;
+
+		if (!options.update && !has_baseline)
+			std::cout << "No baseline.json, performance is not checked" << std::endl;
+		else if (has_baseline && !compare_perf)
+			std::cout << "Baseline was recorded on " << baseline["device"].as_string() << ", performance is not checked" << std::endl;
+
+		std::vector<SceneResult> results;
+		std::vector<uint8_t> pixels;
+		std::vector<uint8_t> golden;
+		std::vector<uint8_t> diff;
+		uint32_t failures = 0;
+
+		for (Scene& scene : scenes)
+		{
+			SceneResult result = {};
+			result.name = scene.name;
+			result.image_ok = true;
+			result.perf_ok = true;
+
+			VkDeviceSize allocated = ctx.allocated_bytes;
+			scene.setup();
+			result.memory_bytes = ctx.allocated_bytes - allocated;
+
+			Result timing = run(scene.name, options.warmup, options.iterations, [&]() { result.draws = scene.record(); submit_and_wait(ctx); });
+
+			// The minimum is far less sensitive to other load on a shared CI machine than the mean.
+			result.frame_ms = timing.min_ms;
+			result.mean_ms = timing.mean_ms;
+
+			result.draws = scene.record();
+			submit_and_wait(ctx);
+			read_color_target(ctx, pixels);
+
+			RawFrameHeader header = { DW_RAW_FRAME_MAGIC, ctx.extent.width, ctx.extent.height, (uint32_t)VK_FORMAT_R8G8B8A8_UNORM, 4, 0, 0 };
+			RawFrameHeader golden_header;
+
+			if (options.update)
+			{
+				write_raw(golden_path(options, scene.name, ".raw").c_str(), header, pixels.data());
+				write_png(golden_path(options, scene.name, ".png").c_str(), pixels.data(), ctx.extent.width, ctx.extent.height);
+			}
+			else if (!load_golden(golden_path(options, scene.name, ".raw"), golden_header, golden))
+			{
+				result.image_ok = false;
+				result.message = "missing golden image";
+			}
+			else if (golden_header.width != header.width || golden_header.height != header.height || golden_header.format != header.format)
+			{
+				result.image_ok = false;
+				result.message = "golden image size or format differs";
+			}
+			else
+			{
+				compare_images(options, pixels, golden, diff, result);
+
+				if (!result.image_ok)
+				{
+					write_png(golden_path(options, scene.name, "_actual.png").c_str(), pixels.data(), ctx.extent.width, ctx.extent.height);
+					write_png(golden_path(options, scene.name, "_diff.png").c_str(), diff.data(), ctx.extent.width, ctx.extent.height);
+					result.message = "image mismatch";
+				}
+			}
+
+			const json::Value& base = baseline["scenes"][scene.name];
+
+			if (compare_perf && !base.is_null())
+			{
+				double base_ms = base["frame_ms"].as_number();
+				double base_memory = base["memory_bytes"].as_number();
+
+				if (result.frame_ms > base_ms * (1.0 + options.perf_threshold))
+				{
+					result.perf_ok = false;
+					result.message += (result.message.empty() ? "" : ", ") + std::string("frame time ") + std::to_string(result.frame_ms) + " ms vs " + std::to_string(base_ms) + " ms";
+				}
+
+				if (result.memory_bytes > base_memory * (1.0 + options.perf_threshold))
+				{
+					result.perf_ok = false;
+					result.message += (result.message.empty() ? "" : ", ") + std::string("memory ") + std::to_string(result.memory_bytes) + " vs " + std::to_string((uint64_t)base_memory) + " bytes";
+				}
+
+				if (result.draws > base["draws"].as_uint())
+				{
+					result.perf_ok = false;
+					result.message += (result.message.empty() ? "" : ", ") + std::string("draws ") + std::to_string(result.draws) + " vs " + std::to_string(base["draws"].as_uint());
+				}
+			}
+
+			scene.teardown();
+
+			bool ok = options.update || (result.image_ok && result.perf_ok);
+
+			if (!ok)
+				failures++;
+
+			std::cout << (ok ? "PASS " : "FAIL ") << scene.name << " : " << result.frame_ms << " ms, " << result.draws << " draws, "
+					  << (result.memory_bytes >> 10) << " KiB";
+
+			if (!options.update && result.image_ok)
+				std::cout << ", mismatch " << result.mismatch * 100.0 << "%, PSNR " << result.psnr << " dB";
+
+			if (!result.message.empty())
+				std::cout << " (" << result.message << ")";
+
+			std::cout << std::endl;
+
+			results.push_back(result);
+		}
+
+		write_results(golden_path(options, options.update ? "baseline" : "results", ".json"), device_name, results);
+
+		vkDestroyPipeline(ctx.device, instanced_pipeline, nullptr);
+		vkDestroyPipeline(ctx.device, object_pipeline, nullptr);
+		vkDestroyPipelineLayout(ctx.device, instanced_pipeline_layout, nullptr);
+		vkDestroyPipelineLayout(ctx.device, object_pipeline_layout, nullptr);
+
+		device.DestroyInputLayout(instanced_layout);
+		device.DestroyInputLayout(object_layout);
+
+		std::cout << (failures == 0 ? "All scenes passed" : std::to_string(failures) + " scene(s) failed") << std::endl;
+
+		return failures;
+	}
+}
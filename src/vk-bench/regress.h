@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "bench_context.h"
+
+namespace bench
+{
+	struct RegressOptions
+	{
+		// Holds the golden images (<scene>.raw) and baseline.json.
+		std::string directory;
+		// Rewrite goldens and baseline from this run instead of comparing.
+		bool		update = false;
+		// A scene fails when its frame time or memory grows by more than this fraction.
+		double		perf_threshold = 0.15;
+		// Per channel difference (0-255) below which a pixel still counts as matching.
+		uint32_t	channel_tolerance = 3;
+		// Fraction of pixels allowed to exceed channel_tolerance.
+		double		pixel_tolerance = 0.001;
+		uint32_t	warmup = 5;
+		uint32_t	iterations = 50;
+	};
+
+	// Renders the reference scenes offscreen, compares them against the golden images and the perf
+	// baseline, and writes results.json next to the baseline. Returns the number of failed scenes.
+	extern uint32_t regress(Context& ctx, const RegressOptions& options);
+}
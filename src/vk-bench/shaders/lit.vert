@@ -0,0 +1,33 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Instanced geometry for clustered.frag: world position and normal, plus view depth to find the
+// cluster with.
+
+layout(location = 0) in vec3 inPosition;
+// Per-instance transform, one location per column. Scale must be uniform for the normal to hold.
+layout(location = 1) in mat4 inModel;
+
+layout(push_constant) uniform PushConstants {
+    mat4 viewProjection;
+    mat4 view;
+} pc;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+layout(location = 0) out vec3 fragPosition;
+layout(location = 1) out vec3 fragNormal;
+layout(location = 2) out vec3 fragAlbedo;
+layout(location = 3) out float fragViewDepth;
+
+void main() {
+    vec4 world = inModel * vec4(inPosition, 1.0);
+
+    gl_Position = pc.viewProjection * world;
+    fragPosition = world.xyz;
+    fragNormal = mat3(inModel) * vec3(0.0, 1.0, 0.0);
+    fragAlbedo = vec3(0.8);
+    fragViewDepth = -(pc.view * world).z;
+}
@@ -0,0 +1,19 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 inPosition;
+
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+} pc;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = pc.model * vec4(inPosition, 1.0);
+    fragColor = vec3(1.0, 0.5, 0.0);
+}
\ No newline at end of file
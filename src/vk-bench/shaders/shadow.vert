@@ -0,0 +1,23 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Depth-only caster pass: no outputs besides the position.
+
+layout(location = 0) in vec3 inPosition;
+// Per-instance transform, one location per column.
+layout(location = 1) in mat4 inModel;
+
+layout(push_constant) uniform PushConstants {
+    mat4 viewProjection;
+    // Added to the transformed position, for casters that move without rewriting their instance.
+    vec4 offset;
+} pc;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+void main() {
+    vec4 world = inModel * vec4(inPosition, 1.0) + vec4(pc.offset.xyz, 0.0);
+    gl_Position = pc.viewProjection * world;
+}